@@ -0,0 +1,177 @@
+#include "Tests.h"
+#include "../VulkanRenderer/JobSystem.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+//Every job runs exactly once and Wait returns only after the last one finished
+static void TestRunWait(JobSystem& jobs)
+{
+	const uint32_t jobCount = 10000;
+	std::atomic<uint32_t> ran{ 0 };
+	JobCounter counter;
+	for (uint32_t i = 0; i < jobCount; ++i)
+	{
+		jobs.Run([&ran]() { ran.fetch_add(1); }, &counter);
+	}
+	jobs.Wait(counter);
+	CHECK(counter.IsDone() == true);
+	CHECK(ran.load() == jobCount);
+
+	//A done counter can be reused
+	jobs.Run([&ran]() { ran.fetch_add(1); }, &counter);
+	jobs.Wait(counter);
+	CHECK(ran.load() == jobCount + 1);
+}
+
+//The ranges cover [0, count) without gaps or overlap, whatever the grain
+static void TestParallelFor(JobSystem& jobs)
+{
+	const uint32_t counts[] = { 0, 1, 63, 64, 65, 10007 };
+	const uint32_t grains[] = { 0, 1, 7, 64, 100000 };
+	for (uint32_t count : counts)
+	{
+		for (uint32_t grain : grains)
+		{
+			std::vector<uint32_t> visits(count, 0);
+			std::atomic<bool> badRange{ false };
+			JobCounter counter;
+			jobs.ParallelFor(count, grain, [&](uint32_t begin, uint32_t end)
+			{
+				if (begin >= end || end > count)
+				{
+					badRange = true;
+					return;
+				}
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					++visits[i];
+				}
+			}, &counter);
+			jobs.Wait(counter);
+			CHECK(badRange.load() == false);
+			bool once = true;
+			for (uint32_t visit : visits)
+			{
+				once = once && visit == 1;
+			}
+			CHECK(once == true);
+		}
+	}
+}
+
+//Jobs that wait on their own children, three levels deep. Waiting threads run other jobs instead of blocking,
+//so this finishes even with more waiting jobs than threads
+static void SpawnTree(JobSystem& jobs, uint32_t depth, std::atomic<uint32_t>& leaves)
+{
+	if (depth == 0)
+	{
+		leaves.fetch_add(1);
+		return;
+	}
+	JobCounter children;
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		jobs.Run([&jobs, depth, &leaves]() { SpawnTree(jobs, depth - 1, leaves); }, &children);
+	}
+	jobs.Wait(children);
+}
+
+static void TestNestedWait(JobSystem& jobs)
+{
+	std::atomic<uint32_t> leaves{ 0 };
+	JobCounter root;
+	jobs.Run([&jobs, &leaves]() { SpawnTree(jobs, 3, leaves); }, &root);
+	jobs.Wait(root);
+	CHECK(leaves.load() == 8 * 8 * 8);
+}
+
+//A continuation starts only once everything its dependency counts has finished
+static void TestRunAfter(JobSystem& jobs)
+{
+	const uint32_t jobCount = 256;
+	std::atomic<uint32_t> ran{ 0 };
+	std::atomic<uint32_t> seenByContinuation{ 0 };
+	JobCounter dependency;
+	JobCounter done;
+	for (uint32_t i = 0; i < jobCount; ++i)
+	{
+		jobs.Run([&ran]() { ran.fetch_add(1); }, &dependency);
+	}
+	jobs.RunAfter(dependency, [&ran, &seenByContinuation]() { seenByContinuation = ran.load(); }, &done);
+	jobs.Wait(done);
+	CHECK(seenByContinuation.load() == jobCount);
+
+	//Dependency already done, the job is queued right away
+	jobs.RunAfter(dependency, [&ran]() { ran.fetch_add(1); }, &done);
+	jobs.Wait(done);
+	CHECK(ran.load() == jobCount + 1);
+}
+
+//Background jobs only run on workers, so a Wait on frame jobs never picks one up
+static void TestRunBackground(JobSystem& jobs)
+{
+	std::atomic<bool> release{ false };
+	std::atomic<uint32_t> backgroundThread{ 0 };
+	JobCounter background;
+	jobs.RunBackground([&release, &backgroundThread]()
+	{
+		backgroundThread = JobSystem::ThreadIndex();
+		while (release.load() == false)
+		{
+			std::this_thread::yield();
+		}
+	}, &background);
+
+	std::atomic<uint32_t> ran{ 0 };
+	JobCounter frame;
+	for (uint32_t i = 0; i < 1000; ++i)
+	{
+		jobs.Run([&ran]() { ran.fetch_add(1); }, &frame);
+	}
+	jobs.Wait(frame);
+	CHECK(ran.load() == 1000);
+	CHECK(background.IsDone() == false);
+
+	release = true;
+	jobs.Wait(background);
+	CHECK(backgroundThread.load() != 0);
+
+	//Many at once all finish, whichever worker takes them
+	std::atomic<uint32_t> loaded{ 0 };
+	for (uint32_t i = 0; i < 100; ++i)
+	{
+		jobs.RunBackground([&loaded]() { loaded.fetch_add(1); }, &background);
+	}
+	jobs.Wait(background);
+	CHECK(loaded.load() == 100);
+}
+
+void RunJobSystemTests()
+{
+	//No workers, the main thread runs everything inside Wait
+	{
+		JobSystem jobs;
+		jobs.Init(0);
+		TestRunWait(jobs);
+		TestParallelFor(jobs);
+		TestNestedWait(jobs);
+		TestRunAfter(jobs);
+		jobs.Shutdown();
+	}
+
+	//Background jobs need a worker, the other tests also get stealing
+	for (uint32_t workers : { 1u, 3u, 7u })
+	{
+		JobSystem jobs;
+		jobs.Init(workers);
+		TestRunWait(jobs);
+		TestParallelFor(jobs);
+		TestNestedWait(jobs);
+		TestRunAfter(jobs);
+		TestRunBackground(jobs);
+		jobs.Shutdown();
+	}
+	std::cout << "JobSystem: done" << std::endl;
+}
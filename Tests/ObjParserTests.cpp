@@ -0,0 +1,258 @@
+#include "Tests.h"
+#include "../VulkanRenderer/JobSystem.h"
+#include "../VulkanRenderer/ObjParser.h"
+#include <tiny_obj_loader.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+static std::string WriteTemp(const std::string& name, const std::string& text)
+{
+	fs::path path = fs::temp_directory_path() / ("ObjParserTests_" + name + ".obj");
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(text.data(), static_cast<std::streamsize>(text.size()));
+	return path.string();
+}
+
+static std::string ReadText(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	std::ostringstream text;
+	text << file.rdbuf();
+	return text.str();
+}
+
+static bool SameIndex(const ObjParser::Index& a, const ObjParser::Index& b)
+{
+	return a.position == b.position && a.normal == b.normal && a.texcoord == b.texcoord;
+}
+
+//Both came out of the same float parser, so equal means bit for bit
+static bool SameResult(const ObjParser::Result& a, const ObjParser::Result& b)
+{
+	if (a.positions != b.positions || a.normals != b.normals || a.texcoords != b.texcoords || a.corners.size() != b.corners.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < a.corners.size(); ++i)
+	{
+		if (SameIndex(a.corners[i], b.corners[i]) == false)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//Parses path on the calling thread alone and cut into a chunk per thread, both have to agree
+static ObjParser::Result ParseBothWays(const std::string& path, JobSystem& jobs)
+{
+	ObjParser::Result sequential, chunked;
+	std::string error;
+	CHECK(ObjParser::Parse(path.c_str(), &jobs, sequential, &error, 1) == true);
+	CHECK(ObjParser::Parse(path.c_str(), &jobs, chunked, &error, 0) == true);
+	CHECK(SameResult(sequential, chunked) == true);
+	return sequential;
+}
+
+//Copies of text one after another until it is big enough for a chunk on every thread.
+//Positive indices of later copies still point into the first one
+static std::string Repeat(const std::string& text, size_t minimumSize)
+{
+	std::string repeated;
+	while (repeated.size() < minimumSize)
+	{
+		repeated += text;
+	}
+	return repeated;
+}
+
+static std::string ToCrlf(const std::string& text)
+{
+	std::string crlf;
+	crlf.reserve(text.size() + text.size() / 16);
+	for (char c : text)
+	{
+		if (c == '\n')
+		{
+			crlf += '\r';
+		}
+		crlf += c;
+	}
+	return crlf;
+}
+
+//A grid of quads with every attribute, all vertices first and the faces after them, so the faces sit in later
+//chunks than what they index. relative writes the indices as negative ones counting back from the end
+static std::string GridObj(uint32_t size, bool relative)
+{
+	std::ostringstream obj;
+	const uint32_t vertexCount = (size + 1) * (size + 1);
+	for (uint32_t y = 0; y <= size; ++y)
+	{
+		for (uint32_t x = 0; x <= size; ++x)
+		{
+			obj << "v " << x * 0.125f << " " << y * -0.5f << " " << (x ^ y) * 1e-3f << "\n";
+			obj << "vt " << x / static_cast<float>(size) << " " << y / static_cast<float>(size) << "\n";
+			obj << "vn 0 " << (x % 2 == 0 ? "1" : "-1") << " 0\n";
+		}
+	}
+	auto index = [&](uint32_t x, uint32_t y)
+	{
+		const int32_t i = static_cast<int32_t>(y * (size + 1) + x);
+		return relative == true ? i - static_cast<int32_t>(vertexCount) : i + 1;
+	};
+	for (uint32_t y = 0; y < size; ++y)
+	{
+		for (uint32_t x = 0; x < size; ++x)
+		{
+			obj << "f";
+			const int32_t corners[4] = { index(x, y), index(x + 1, y), index(x + 1, y + 1), index(x, y + 1) };
+			for (int32_t corner : corners)
+			{
+				obj << " " << corner << "/" << corner << "/" << corner;
+			}
+			obj << "\n";
+		}
+	}
+	return obj.str();
+}
+
+static void TestSmallFiles(JobSystem& jobs)
+{
+	//CRLF, negative indices and no newline after the last face
+	{
+		std::string path = WriteTemp("small", "# comment\r\nv 1 2 3\r\nv 4 5 6\r\nv 7 8 9\r\nvt 0.5 0.25\r\nvn 0 0 1\r\nf -3/-1/-1 -2/-1/-1 -1/-1/-1");
+		ObjParser::Result result = ParseBothWays(path, jobs);
+		CHECK(result.positions.size() == 3 && result.texcoords.size() == 1 && result.normals.size() == 1);
+		CHECK(result.positions.size() == 3 && result.positions[2] == glm::vec3(7.f, 8.f, 9.f));
+		CHECK(result.corners.size() == 3);
+		if (result.corners.size() == 3)
+		{
+			CHECK(SameIndex(result.corners[0], { 0, 0, 0 }) == true);
+			CHECK(SameIndex(result.corners[1], { 1, 0, 0 }) == true);
+			CHECK(SameIndex(result.corners[2], { 2, 0, 0 }) == true);
+		}
+	}
+
+	//Quads are fanned around their first corner, missing attributes are -1
+	{
+		std::string path = WriteTemp("quad", "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nf 1 2 3 4\n");
+		ObjParser::Result result = ParseBothWays(path, jobs);
+		CHECK(result.corners.size() == 6);
+		if (result.corners.size() == 6)
+		{
+			const int32_t expected[6] = { 0, 1, 2, 0, 2, 3 };
+			for (uint32_t i = 0; i < 6; ++i)
+			{
+				CHECK(SameIndex(result.corners[i], { expected[i], -1, -1 }) == true);
+			}
+		}
+	}
+
+	//Indices past the end and index 0 are errors, not clamped
+	{
+		ObjParser::Result result;
+		std::string error;
+		std::string path = WriteTemp("outofrange", "v 0 0 0\nv 1 0 0\nf 1 2 3\n");
+		CHECK(ObjParser::Parse(path.c_str(), &jobs, result, &error, 1) == false);
+		CHECK(ObjParser::Parse(path.c_str(), &jobs, result, &error, 0) == false);
+		path = WriteTemp("zero", "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 0 1 2\n");
+		CHECK(ObjParser::Parse(path.c_str(), &jobs, result, &error, 0) == false);
+		CHECK(ObjParser::Parse("ObjParserTests_missing.obj", &jobs, result, &error, 0) == false);
+	}
+}
+
+static void TestModel(JobSystem& jobs, const std::string& modelPath)
+{
+	std::string text = ReadText(modelPath);
+	CHECK(text.empty() == false);
+	if (text.empty() == true)
+	{
+		std::cout << "ObjParser: can't read " << modelPath << std::endl;
+		return;
+	}
+
+	//The model itself against tinyobjloader, the attributes have to match
+	ObjParser::Result model = ParseBothWays(modelPath, jobs);
+	{
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warning, error;
+		CHECK(tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, modelPath.c_str(), nullptr) == true);
+		CHECK(model.positions.size() * 3 == attrib.vertices.size());
+		CHECK(model.normals.size() * 3 == attrib.normals.size());
+		CHECK(model.texcoords.size() * 2 == attrib.texcoords.size());
+		bool samePositions = model.positions.size() * 3 == attrib.vertices.size();
+		for (size_t i = 0; samePositions == true && i < model.positions.size(); ++i)
+		{
+			samePositions = model.positions[i] == glm::vec3(attrib.vertices[i * 3], attrib.vertices[i * 3 + 1], attrib.vertices[i * 3 + 2]);
+		}
+		CHECK(samePositions == true);
+		size_t triangles = 0;
+		for (const tinyobj::shape_t& shape : shapes)
+		{
+			triangles += shape.mesh.indices.size() / 3;
+		}
+		CHECK(model.corners.size() / 3 == triangles);
+	}
+
+	//Big enough to be cut into chunks, then the same bytes with CRLF line ends and without the last newline
+	const std::string big = Repeat(text, 2 * 1024 * 1024);
+	ObjParser::Result lf = ParseBothWays(WriteTemp("model_lf", big), jobs);
+	ObjParser::Result crlf = ParseBothWays(WriteTemp("model_crlf", ToCrlf(big)), jobs);
+	CHECK(SameResult(lf, crlf) == true);
+	ObjParser::Result unterminated = ParseBothWays(WriteTemp("model_unterminated", big.substr(0, big.size() - 1)), jobs);
+	CHECK(SameResult(lf, unterminated) == true);
+	CHECK(lf.corners.size() % model.corners.size() == 0 && lf.positions.size() % model.positions.size() == 0);
+}
+
+static void TestNegativeIndices(JobSystem& jobs)
+{
+	//Faces index vertices several chunks back, with negative indices these only resolve after the merge
+	const uint32_t size = 200;
+	ObjParser::Result absolute = ParseBothWays(WriteTemp("grid_absolute", GridObj(size, false)), jobs);
+	ObjParser::Result relative = ParseBothWays(WriteTemp("grid_relative", GridObj(size, true)), jobs);
+	CHECK(absolute.corners.size() == size * size * 6);
+	CHECK(SameResult(absolute, relative) == true);
+
+	//The usual layout, every face right after its own vertices
+	std::string interleaved;
+	for (uint32_t i = 0; i < 40000; ++i)
+	{
+		interleaved += "v 0 0 0\nv 1 0 0\nv 0 1 0\nf -3 -2 -1\n";
+	}
+	ObjParser::Result result = ParseBothWays(WriteTemp("interleaved", ToCrlf(interleaved)), jobs);
+	bool sequential = result.corners.size() == 40000 * 3;
+	for (size_t i = 0; sequential == true && i < result.corners.size(); ++i)
+	{
+		sequential = result.corners[i].position == static_cast<int32_t>(i);
+	}
+	CHECK(sequential == true);
+}
+
+void RunObjParserTests(const std::string& modelDirectory)
+{
+	JobSystem jobs;
+	jobs.Init(7);
+	TestSmallFiles(jobs);
+	TestNegativeIndices(jobs);
+	TestModel(jobs, modelDirectory + "/Monkey.obj");
+	TestModel(jobs, modelDirectory + "/Torus.obj");
+	jobs.Shutdown();
+
+	for (const fs::directory_entry& entry : fs::directory_iterator(fs::temp_directory_path()))
+	{
+		if (entry.path().filename().string().rfind("ObjParserTests_", 0) == 0)
+		{
+			std::error_code error;
+			fs::remove(entry.path(), error);
+		}
+	}
+	std::cout << "ObjParser: done" << std::endl;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+//A failed check is reported and counted, the test it is in keeps going
+extern uint32_t gFailedChecks;
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if ((condition) == false) \
+		{ \
+			std::cout << __FILE__ << "(" << __LINE__ << "): check failed: " #condition << std::endl; \
+			++gFailedChecks; \
+		} \
+	} while (false)
+
+void RunJobSystemTests();
+//Sequential against chunked parses of the models in modelDirectory and of generated files
+void RunObjParserTests(const std::string& modelDirectory);
@@ -0,0 +1,20 @@
+#include "Tests.h"
+
+uint32_t gFailedChecks = 0;
+
+//CPU side checks of engine code that doesn't need a device. Exits with 1 when any check failed.
+//The only argument is the models directory, ../models by default like the renderer
+int main(int argc, char** argv)
+{
+	const std::string modelDirectory = argc > 1 ? argv[1] : "../models";
+	RunJobSystemTests();
+	RunObjParserTests(modelDirectory);
+
+	if (gFailedChecks != 0)
+	{
+		std::cout << gFailedChecks << " checks failed" << std::endl;
+		return 1;
+	}
+	std::cout << "All checks passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,235 @@
+#include "TextureBaker.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb_image_resize.h>
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+#include <ktx.h>
+#include "../lib/gl_format.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+static std::mutex logMutex;
+
+TextureBaker::TextureBaker(const Options& options)
+	: mOptions(options)
+{
+}
+
+bool TextureBaker::IsSourceImage(const std::string& file)
+{
+	std::string ext = fs::path(file).extension().string();
+	std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".tga" || ext == ".bmp";
+}
+
+std::string TextureBaker::GetBakedPath(const std::string& sourceFile)
+{
+	return fs::path(sourceFile).replace_extension(".ktx").string();
+}
+
+void TextureBaker::AddDirectory(const std::string& directory)
+{
+	std::error_code ec;
+	for (const fs::directory_entry& entry : fs::recursive_directory_iterator(directory, ec))
+	{
+		if (entry.is_regular_file() && IsSourceImage(entry.path().string()))
+		{
+			mFiles.push_back(entry.path().string());
+		}
+	}
+	if (ec)
+	{
+		std::cout << "WARN: cannot read " << directory << ": " << ec.message() << std::endl;
+	}
+}
+
+void TextureBaker::AddFile(const std::string& file)
+{
+	mFiles.push_back(file);
+}
+
+uint32_t TextureBaker::Run()
+{
+	uint32_t threadCount = mOptions.threadCount;
+	if (threadCount == 0)
+	{
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+	threadCount = std::min<uint32_t>(threadCount, static_cast<uint32_t>(mFiles.size()));
+
+	std::atomic<uint32_t> baked{ 0 };
+	std::atomic<uint32_t> skipped{ 0 };
+	std::atomic<uint32_t> failed{ 0 };
+	auto start = std::chrono::steady_clock::now();
+
+	//Files are independent, so workers just pull the next index until the list runs out
+	auto worker = [&]()
+	{
+		for (uint32_t i = mNextFile++; i < mFiles.size(); i = mNextFile++)
+		{
+			std::string message;
+			Result result = BakeFile(mFiles[i], message);
+			if (result == Result::Baked) ++baked;
+			else if (result == Result::UpToDate) ++skipped;
+			else ++failed;
+
+			std::lock_guard<std::mutex> lock(logMutex);
+			std::cout << (result == Result::Failed ? "FAIL: " : "") << mFiles[i] << " " << message << std::endl;
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (uint32_t i = 1; i < threadCount; ++i)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& t : threads)
+	{
+		t.join();
+	}
+
+	float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+	std::cout << baked << " baked, " << skipped << " up to date, " << failed << " failed in " << seconds << "s on "
+		<< std::max(threadCount, 1u) << " threads" << std::endl;
+	return failed;
+}
+
+TextureBaker::Result TextureBaker::BakeFile(const std::string& file, std::string& message)
+{
+	const std::string bakedPath = GetBakedPath(file);
+	std::error_code ec;
+	if (mOptions.force == false && fs::exists(bakedPath, ec) && fs::last_write_time(bakedPath, ec) >= fs::last_write_time(file, ec))
+	{
+		message = "up to date";
+		return Result::UpToDate;
+	}
+
+	//Same orientation the runtime decoder uses
+	int width, height, channels;
+	stbi_set_flip_vertically_on_load_thread(true);
+	stbi_uc* pixels = stbi_load(file.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+	if (pixels == nullptr)
+	{
+		message = std::string("decode failed: ") + stbi_failure_reason();
+		return Result::Failed;
+	}
+
+	bool hasAlpha = false;
+	const size_t pixelCount = static_cast<size_t>(width) * height;
+	for (size_t i = 0; i < pixelCount && hasAlpha == false; ++i)
+	{
+		hasAlpha = pixels[i * 4 + 3] != 255;
+	}
+
+	ktxTextureCreateInfo createInfo{};
+	createInfo.glInternalformat = hasAlpha ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+	createInfo.baseWidth = static_cast<ktx_uint32_t>(width);
+	createInfo.baseHeight = static_cast<ktx_uint32_t>(height);
+	createInfo.baseDepth = 1;
+	createInfo.numDimensions = 2;
+	createInfo.numLevels = static_cast<ktx_uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+	createInfo.numLayers = 1;
+	createInfo.numFaces = 1;
+	createInfo.isArray = KTX_FALSE;
+	createInfo.generateMipmaps = KTX_FALSE;
+
+	ktxTexture* texture;
+	if (ktxTexture_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture) != KTX_SUCCESS)
+	{
+		stbi_image_free(pixels);
+		message = "ktxTexture_Create failed";
+		return Result::Failed;
+	}
+
+	//Each level is filtered from the previous one in linear space, then compressed
+	std::vector<uint8_t> level(pixels, pixels + pixelCount * 4);
+	stbi_image_free(pixels);
+	std::vector<uint8_t> nextLevel;
+	std::vector<uint8_t> blocks;
+	uint32_t levelWidth = createInfo.baseWidth;
+	uint32_t levelHeight = createInfo.baseHeight;
+	for (uint32_t i = 0; i < createInfo.numLevels; ++i)
+	{
+		CompressLevel(level.data(), levelWidth, levelHeight, hasAlpha, blocks);
+		if (ktxTexture_SetImageFromMemory(texture, i, 0, 0, blocks.data(), blocks.size()) != KTX_SUCCESS)
+		{
+			ktxTexture_Destroy(texture);
+			message = "ktxTexture_SetImageFromMemory failed";
+			return Result::Failed;
+		}
+
+		if (i + 1 < createInfo.numLevels)
+		{
+			uint32_t nextWidth = std::max(1u, levelWidth / 2);
+			uint32_t nextHeight = std::max(1u, levelHeight / 2);
+			nextLevel.resize(static_cast<size_t>(nextWidth) * nextHeight * 4);
+			stbir_resize_uint8_srgb(level.data(), levelWidth, levelHeight, 0, nextLevel.data(), nextWidth, nextHeight, 0,
+				4, 3, 0);
+			level.swap(nextLevel);
+			levelWidth = nextWidth;
+			levelHeight = nextHeight;
+		}
+	}
+
+	//Written under a temporary name so the renderer never sees a half written file
+	const std::string tempPath = bakedPath + ".tmp";
+	KTX_error_code result = ktxTexture_WriteToNamedFile(texture, tempPath.c_str());
+	ktxTexture_Destroy(texture);
+	if (result != KTX_SUCCESS)
+	{
+		message = "write failed";
+		return Result::Failed;
+	}
+	fs::rename(tempPath, bakedPath, ec);
+	if (ec)
+	{
+		message = "rename failed: " + ec.message();
+		return Result::Failed;
+	}
+
+	message = "-> " + bakedPath + " (" + std::to_string(width) + "x" + std::to_string(height) + ", " +
+		std::to_string(createInfo.numLevels) + " mips, " + (hasAlpha ? "BC3" : "BC1") + ")";
+	return Result::Baked;
+}
+
+void TextureBaker::CompressLevel(const uint8_t* rgba, uint32_t width, uint32_t height, bool hasAlpha, std::vector<uint8_t>& out) const
+{
+	const uint32_t blocksX = (width + 3) / 4;
+	const uint32_t blocksY = (height + 3) / 4;
+	const uint32_t blockSize = hasAlpha ? 16 : 8;
+	const int mode = mOptions.highQuality ? STB_DXT_HIGHQUAL : STB_DXT_NORMAL;
+	out.resize(static_cast<size_t>(blocksX) * blocksY * blockSize);
+
+	uint8_t block[16 * 4];
+	for (uint32_t by = 0; by < blocksY; ++by)
+	{
+		for (uint32_t bx = 0; bx < blocksX; ++bx)
+		{
+			//Edge blocks of levels smaller than 4 texels repeat the last row/column
+			for (uint32_t y = 0; y < 4; ++y)
+			{
+				uint32_t sy = std::min(by * 4 + y, height - 1);
+				for (uint32_t x = 0; x < 4; ++x)
+				{
+					uint32_t sx = std::min(bx * 4 + x, width - 1);
+					std::memcpy(&block[(y * 4 + x) * 4], &rgba[(static_cast<size_t>(sy) * width + sx) * 4], 4);
+				}
+			}
+			stb_compress_dxt_block(&out[(static_cast<size_t>(by) * blocksX + bx) * blockSize], block, hasAlpha ? 1 : 0, mode);
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+//Offline counterpart of VkApp::CreateTextureImage: decodes source images once, builds the mip chain,
+//block compresses it and writes a .ktx next to the source so the renderer can upload it as is
+class TextureBaker
+{
+public:
+	struct Options
+	{
+		bool force = false;//Rebake even when the .ktx is newer than its source
+		bool highQuality = true;
+		uint32_t threadCount = 0;//0 = hardware concurrency
+	};
+
+	explicit TextureBaker(const Options& options);
+
+	void AddDirectory(const std::string& directory);
+	void AddFile(const std::string& file);
+
+	//Returns the number of files that failed
+	uint32_t Run();
+
+	static std::string GetBakedPath(const std::string& sourceFile);
+
+private:
+	enum class Result { Baked, UpToDate, Failed };
+
+	Result BakeFile(const std::string& file, std::string& message);
+	void CompressLevel(const uint8_t* rgba, uint32_t width, uint32_t height, bool hasAlpha, std::vector<uint8_t>& out) const;
+
+	static bool IsSourceImage(const std::string& file);
+
+	Options mOptions;
+	std::vector<std::string> mFiles;
+	std::atomic<uint32_t> mNextFile{ 0 };
+};
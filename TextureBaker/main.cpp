@@ -0,0 +1,53 @@
+#include "TextureBaker.h"
+#include <iostream>
+#include <filesystem>
+
+int main(int argc, char** argv)
+{
+	TextureBaker::Options options;
+	std::vector<std::string> inputs;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--force" || arg == "-f")
+		{
+			options.force = true;
+		}
+		else if (arg == "--fast")
+		{
+			options.highQuality = false;
+		}
+		else if ((arg == "--threads" || arg == "-j") && i + 1 < argc)
+		{
+			options.threadCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+		}
+		else if (arg == "--help" || arg == "-h")
+		{
+			std::cout << "usage: TextureBaker [--force] [--fast] [--threads N] [dir|file ...]\n"
+				<< "Bakes every image into a mipmapped BC1/BC3 .ktx next to it (default: ../textures)" << std::endl;
+			return 0;
+		}
+		else
+		{
+			inputs.push_back(arg);
+		}
+	}
+	if (inputs.empty())
+	{
+		inputs.push_back("../textures");
+	}
+
+	TextureBaker baker(options);
+	for (const std::string& input : inputs)
+	{
+		if (std::filesystem::is_directory(input))
+		{
+			baker.AddDirectory(input);
+		}
+		else
+		{
+			baker.AddFile(input);
+		}
+	}
+	return baker.Run() == 0 ? 0 : 1;
+}
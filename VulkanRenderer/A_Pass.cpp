@@ -0,0 +1,111 @@
+#include "A_Pass.h"
+#include "VkApp.h"
+#include "VulkanInitializers.hpp"
+#include "VulkanTools.h"
+
+void A_Pass::Init(VkApp* app, uint32_t width, uint32_t height)
+{
+	mApp = app;
+	mWidth = width;
+	mHeight = height;
+	mGroupsX = (width + 7) / 8;
+	mGroupsY = (height + 7) / 8;
+}
+
+void A_Pass::Destroy()
+{
+	VkDevice device = mApp->mVulkanDevice->logicalDevice;
+	for (FrameBufferAttachment& history : mHistory)
+	{
+		vkDestroyImageView(device, history.view, nullptr);
+		vkDestroyImage(device, history.image, nullptr);
+		vkFreeMemory(device, history.memory, nullptr);
+	}
+}
+
+void A_Pass::CreateFrameData()
+{
+	CreateHistory();
+}
+
+void A_Pass::CreatePipelineData(JobCounter* ready)
+{
+	CreatePipelineLayout();
+	mApp->mPipelineBuilder.Build("TAA", [this]() { return CreatePipeline(); }, &mPipeline, ready);
+}
+
+void A_Pass::CreateHistory()
+{
+	//Written as storage images, which the composition's packed B10G11R11 format doesn't have to support
+	for (FrameBufferAttachment& history : mHistory)
+	{
+		history.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+		mApp->CreateImage(mWidth, mHeight, history.format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, history.image, history.memory);
+		history.view = mApp->CreateImageView(history.image, history.format, VK_IMAGE_ASPECT_COLOR_BIT);
+	}
+}
+
+void A_Pass::CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes)
+{
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+
+	poolInfo.maxSets = 1;
+
+	if (vkCreateDescriptorPool(mApp->mVulkanDevice->logicalDevice, &poolInfo, nullptr, &mDescriptorPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create descriptor pool!");
+	}
+}
+
+void A_Pass::CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings)
+{
+	VkDescriptorSetLayoutCreateInfo taaDescriptorLayout = initializers::descriptorSetLayoutCreateInfo(setLayoutBindings);
+	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(mApp->mVulkanDevice->logicalDevice, &taaDescriptorLayout, nullptr, &mDescriptorLayout))
+}
+
+void A_Pass::CreateDescriptorSet()
+{
+	VkDescriptorSetAllocateInfo setAllocInfo{};
+	setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocInfo.descriptorPool = mDescriptorPool;
+	setAllocInfo.descriptorSetCount = 1;
+	setAllocInfo.pSetLayouts = &mDescriptorLayout;
+
+	if (vkAllocateDescriptorSets(mApp->mVulkanDevice->logicalDevice, &setAllocInfo, &mDescriptorSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate descriptor sets");
+	}
+}
+
+void A_Pass::UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets)
+{
+	vkUpdateDescriptorSets(mApp->mVulkanDevice->logicalDevice, static_cast<uint32_t>(writeDescSets.size()), writeDescSets.data(), 0, nullptr);
+}
+
+void A_Pass::CreatePipelineLayout()
+{
+	mPushConstants = mApp->mShaders.ReflectPushConstants({ "TAA.comp" });
+	if (mPushConstants.size != sizeof(TAAPushConstant))
+	{
+		throw std::runtime_error("failed to match TAAPushConstant with the TAA shader!");
+	}
+
+	VkPipelineLayoutCreateInfo pipelinelayoutCI = initializers::pipelineLayoutCreateInfo(&mDescriptorLayout, 1);
+	pipelinelayoutCI.pushConstantRangeCount = 1;
+	pipelinelayoutCI.pPushConstantRanges = &mPushConstants;
+
+	VK_CHECK_RESULT(vkCreatePipelineLayout(mApp->mVulkanDevice->logicalDevice, &pipelinelayoutCI, nullptr, &mPipelineLayout))
+}
+
+VkPipeline A_Pass::CreatePipeline()
+{
+	VkComputePipelineCreateInfo pipelineCI{};
+	pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineCI.layout = mPipelineLayout;
+	pipelineCI.stage = mApp->mPipelineBuilder.ShaderStage("TAA.comp");
+	return mApp->mPipelineBuilder.CreateComputePipeline(pipelineCI);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "Attachment.h"
+#include "UniformStructure.h"
+#include <vector>
+
+class VkApp;
+class JobCounter;
+//Temporal anti-aliasing. The projection is jittered every frame, the resolve blends the composition into the
+//history reprojected with the G-buffer's motion vectors. Two images take turns as history and output
+class A_Pass
+{
+private:
+	VkApp* mApp = nullptr;
+public:
+	void Init(VkApp* app, uint32_t width, uint32_t height);
+	void Destroy();
+
+	void CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes);
+	void CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings);
+	void CreateDescriptorSet();
+
+	void CreateFrameData();
+	//Layouts are created right away, pipelines are built as jobs that count on ready
+	void CreatePipelineData(JobCounter* ready);
+
+	void UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets);
+
+private:
+	void CreateHistory();
+
+	void CreatePipelineLayout();
+	VkPipeline CreatePipeline();
+
+public:
+	uint32_t mWidth, mHeight;
+	uint32_t mGroupsX, mGroupsY;
+
+	//Imported into the render graph as history and output, which swaps them every frame.
+	//Whichever is the output holds the anti-aliased frame the tonemap reads
+	FrameBufferAttachment mHistory[2];
+
+	VkDescriptorPool mDescriptorPool;
+	VkDescriptorSetLayout mDescriptorLayout;
+	VkDescriptorSet mDescriptorSet;
+
+	VkPipelineLayout mPipelineLayout;
+	VkPipeline mPipeline;
+	VkPushConstantRange mPushConstants{};//Reflected, pushes have to use its stage flags
+};
@@ -0,0 +1,128 @@
+#include "B_Pass.h"
+#include "VkApp.h"
+#include "VulkanInitializers.hpp"
+#include "VulkanTools.h"
+#include <algorithm>
+
+void B_Pass::Init(VkApp* app, uint32_t width, uint32_t height)
+{
+	mApp = app;
+	mWidth = width;
+	mHeight = height;
+}
+
+void B_Pass::Destroy()
+{
+	VkDevice device = mApp->mVulkanDevice->logicalDevice;
+	for (VkImageView view : mMipViews)
+	{
+		vkDestroyImageView(device, view, nullptr);
+	}
+	vkDestroyImageView(device, mChain.view, nullptr);
+	vkDestroyImage(device, mChain.image, nullptr);
+	vkFreeMemory(device, mChain.memory, nullptr);
+}
+
+uint32_t B_Pass::MipSize(uint32_t size, uint32_t mip)
+{
+	for (uint32_t i = 0; i <= mip; ++i)
+	{
+		size = std::max((size + 1) / 2, 1u);
+	}
+	return size;
+}
+
+void B_Pass::CreateFrameData()
+{
+	CreateChain();
+}
+
+void B_Pass::CreatePipelineData(JobCounter* ready)
+{
+	CreatePipelineLayout();
+	mApp->mPipelineBuilder.Build("BloomDownsample", [this]() { return CreatePipeline("BloomDownsample.comp"); }, &mDownsamplePipeline, ready);
+	mApp->mPipelineBuilder.Build("BloomUpsample", [this]() { return CreatePipeline("BloomUpsample.comp"); }, &mUpsamplePipeline, ready);
+}
+
+void B_Pass::CreateChain()
+{
+	//Same format as the TAA output it is made from, storage images can't be B10G11R11 everywhere
+	mChain.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+	mApp->CreateImage(MipSize(mWidth, 0), MipSize(mHeight, 0), mChain.format, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mChain.image, mChain.memory, BLOOM_MIPS);
+	mChain.view = mApp->CreateImageView(mChain.image, mChain.format, VK_IMAGE_ASPECT_COLOR_BIT, BLOOM_MIPS);
+
+	for (uint32_t mip = 0; mip < BLOOM_MIPS; ++mip)
+	{
+		VkImageViewCreateInfo viewInfo = initializers::imageViewCreateInfo();
+		viewInfo.image = mChain.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = mChain.format;
+		viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, mip, 1, 0, 1 };
+		VK_CHECK_RESULT(vkCreateImageView(mApp->mVulkanDevice->logicalDevice, &viewInfo, nullptr, &mMipViews[mip]))
+	}
+}
+
+void B_Pass::CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes)
+{
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+
+	poolInfo.maxSets = 1;
+
+	if (vkCreateDescriptorPool(mApp->mVulkanDevice->logicalDevice, &poolInfo, nullptr, &mDescriptorPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create descriptor pool!");
+	}
+}
+
+void B_Pass::CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings)
+{
+	VkDescriptorSetLayoutCreateInfo bloomDescriptorLayout = initializers::descriptorSetLayoutCreateInfo(setLayoutBindings);
+	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(mApp->mVulkanDevice->logicalDevice, &bloomDescriptorLayout, nullptr, &mDescriptorLayout))
+}
+
+void B_Pass::CreateDescriptorSet()
+{
+	VkDescriptorSetAllocateInfo setAllocInfo{};
+	setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocInfo.descriptorPool = mDescriptorPool;
+	setAllocInfo.descriptorSetCount = 1;
+	setAllocInfo.pSetLayouts = &mDescriptorLayout;
+
+	if (vkAllocateDescriptorSets(mApp->mVulkanDevice->logicalDevice, &setAllocInfo, &mDescriptorSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate descriptor sets");
+	}
+}
+
+void B_Pass::UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets)
+{
+	vkUpdateDescriptorSets(mApp->mVulkanDevice->logicalDevice, static_cast<uint32_t>(writeDescSets.size()), writeDescSets.data(), 0, nullptr);
+}
+
+void B_Pass::CreatePipelineLayout()
+{
+	mPushConstants = mApp->mShaders.ReflectPushConstants({ "BloomDownsample.comp", "BloomUpsample.comp" });
+	if (mPushConstants.size != sizeof(BloomPushConstant))
+	{
+		throw std::runtime_error("failed to match BloomPushConstant with the bloom shaders!");
+	}
+
+	VkPipelineLayoutCreateInfo pipelinelayoutCI = initializers::pipelineLayoutCreateInfo(&mDescriptorLayout, 1);
+	pipelinelayoutCI.pushConstantRangeCount = 1;
+	pipelinelayoutCI.pPushConstantRanges = &mPushConstants;
+
+	VK_CHECK_RESULT(vkCreatePipelineLayout(mApp->mVulkanDevice->logicalDevice, &pipelinelayoutCI, nullptr, &mPipelineLayout))
+}
+
+VkPipeline B_Pass::CreatePipeline(const char* source)
+{
+	VkComputePipelineCreateInfo pipelineCI{};
+	pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineCI.layout = mPipelineLayout;
+	pipelineCI.stage = mApp->mPipelineBuilder.ShaderStage(source);
+	return mApp->mPipelineBuilder.CreateComputePipeline(pipelineCI);
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "Attachment.h"
+#include "UniformStructure.h"
+#include <vector>
+
+class VkApp;
+class JobCounter;
+//Bloom on the resolved HDR frame. A chain of half size mips is filled by a 13 tap downsample, then walked back up
+//adding a tent filtered copy of each mip to the one above. Every dispatch reads its source once into shared memory
+//and writes one mip. Reads go through the sampler and the storage views are write only, the chain stays in the
+//general layout while the pass runs
+class B_Pass
+{
+private:
+	VkApp* mApp = nullptr;
+public:
+	void Init(VkApp* app, uint32_t width, uint32_t height);
+	void Destroy();
+
+	void CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes);
+	void CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings);
+	void CreateDescriptorSet();
+
+	void CreateFrameData();
+	//Layouts are created right away, pipelines are built as jobs that count on ready
+	void CreatePipelineData(JobCounter* ready);
+
+	void UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets);
+
+	//Size of a mip when the frame covers width x height
+	static uint32_t MipSize(uint32_t size, uint32_t mip);
+
+private:
+	void CreateChain();
+
+	void CreatePipelineLayout();
+	VkPipeline CreatePipeline(const char* source);
+
+public:
+	uint32_t mWidth, mHeight;//Of the frame, the first mip is half of it
+
+	//view covers every mip for sampling, imported into the render graph
+	FrameBufferAttachment mChain;
+	VkImageView mMipViews[BLOOM_MIPS];//Storage views of single mips
+
+	VkDescriptorPool mDescriptorPool;
+	VkDescriptorSetLayout mDescriptorLayout;
+	VkDescriptorSet mDescriptorSet;
+
+	VkPipelineLayout mPipelineLayout;//Shared by both dispatches
+	VkPipeline mDownsamplePipeline;
+	VkPipeline mUpsamplePipeline;
+	VkPushConstantRange mPushConstants{};//Reflected, pushes have to use its stage flags
+};
@@ -0,0 +1,125 @@
+#include "C_Pass.h"
+#include "VkApp.h"
+#include "VulkanInitializers.hpp"
+#include "VulkanTools.h"
+
+void C_Pass::Init(VkApp* app, uint32_t width, uint32_t height)
+{
+	mApp = app;
+	mWidth = width;
+	mHeight = height;
+	mTilesX = (width + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+	mTilesY = (height + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+}
+
+void C_Pass::Destroy()
+{
+	vkDestroyBuffer(mApp->mVulkanDevice->logicalDevice, mLightBins, nullptr);
+	vkFreeMemory(mApp->mVulkanDevice->logicalDevice, mLightBinsMemory, nullptr);
+}
+
+void C_Pass::CreateFrameData()
+{
+	CreateLightBins();
+}
+
+void C_Pass::CreatePipelineData(JobCounter* ready)
+{
+	CreatePipelineLayout();
+	mApp->mPipelineBuilder.Build("LightBinning", [this]() { return CreatePipeline(); }, &mPipeline, ready);
+}
+
+void C_Pass::CreateLightBins()
+{
+	VulkanDevice* device = mApp->mVulkanDevice;
+	uint32_t families[] = { device->queueFamilyIndices.graphics, device->queueFamilyIndices.compute };
+	mLightBinsSize = static_cast<VkDeviceSize>(mTilesX) * mTilesY * sizeof(uint32_t);
+
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = mLightBinsSize;
+	bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	if (families[0] != families[1])
+	{
+		bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		bufferInfo.queueFamilyIndexCount = 2;
+		bufferInfo.pQueueFamilyIndices = families;
+	}
+	else
+	{
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	}
+	VK_CHECK_RESULT(vkCreateBuffer(device->logicalDevice, &bufferInfo, nullptr, &mLightBins))
+
+	VkMemoryRequirements memReqs;
+	vkGetBufferMemoryRequirements(device->logicalDevice, mLightBins, &memReqs);
+	VkMemoryAllocateInfo memAlloc = initializers::memoryAllocateInfo();
+	memAlloc.allocationSize = memReqs.size;
+	memAlloc.memoryTypeIndex = device->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	VK_CHECK_RESULT(vkAllocateMemory(device->logicalDevice, &memAlloc, nullptr, &mLightBinsMemory))
+	VK_CHECK_RESULT(vkBindBufferMemory(device->logicalDevice, mLightBins, mLightBinsMemory, 0))
+}
+
+void C_Pass::CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes)
+{
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+
+	poolInfo.maxSets = 1;
+
+	if (vkCreateDescriptorPool(mApp->mVulkanDevice->logicalDevice, &poolInfo, nullptr, &mDescriptorPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create descriptor pool!");
+	}
+}
+
+void C_Pass::CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings)
+{
+	VkDescriptorSetLayoutCreateInfo binningDescriptorLayout = initializers::descriptorSetLayoutCreateInfo(setLayoutBindings);
+	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(mApp->mVulkanDevice->logicalDevice, &binningDescriptorLayout, nullptr, &mDescriptorLayout))
+}
+
+void C_Pass::CreateDescriptorSet()
+{
+	VkDescriptorSetAllocateInfo setAllocInfo{};
+	setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocInfo.descriptorPool = mDescriptorPool;
+	setAllocInfo.descriptorSetCount = 1;
+	setAllocInfo.pSetLayouts = &mDescriptorLayout;
+
+	if (vkAllocateDescriptorSets(mApp->mVulkanDevice->logicalDevice, &setAllocInfo, &mDescriptorSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate descriptor sets");
+	}
+}
+
+void C_Pass::UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets)
+{
+	vkUpdateDescriptorSets(mApp->mVulkanDevice->logicalDevice, static_cast<uint32_t>(writeDescSets.size()), writeDescSets.data(), 0, nullptr);
+}
+
+void C_Pass::CreatePipelineLayout()
+{
+	mPushConstants = mApp->mShaders.ReflectPushConstants({ "LightBinning.comp" });
+	if (mPushConstants.size != sizeof(LightBinPushConstant))
+	{
+		throw std::runtime_error("failed to match LightBinPushConstant with the light binning shader!");
+	}
+
+	VkPipelineLayoutCreateInfo pipelinelayoutCI = initializers::pipelineLayoutCreateInfo(&mDescriptorLayout, 1);
+	pipelinelayoutCI.pushConstantRangeCount = 1;
+	pipelinelayoutCI.pPushConstantRanges = &mPushConstants;
+
+	VK_CHECK_RESULT(vkCreatePipelineLayout(mApp->mVulkanDevice->logicalDevice, &pipelinelayoutCI, nullptr, &mPipelineLayout))
+}
+
+VkPipeline C_Pass::CreatePipeline()
+{
+	VkComputePipelineCreateInfo pipelineCI{};
+	pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineCI.layout = mPipelineLayout;
+	pipelineCI.stage = mApp->mPipelineBuilder.ShaderStage("LightBinning.comp");
+	return mApp->mPipelineBuilder.CreateComputePipeline(pipelineCI);
+}
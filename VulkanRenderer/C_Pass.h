@@ -0,0 +1,51 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "UniformStructure.h"
+#include <vector>
+
+class VkApp;
+class JobCounter;
+//Light binning on the async compute queue. Splits the screen into LIGHT_TILE_SIZE tiles and writes,
+//per tile, a bit mask of the point lights whose range touches it. Lighting only shades the lights of its tile
+class C_Pass
+{
+private:
+	VkApp* mApp = nullptr;
+public:
+	void Init(VkApp* app, uint32_t width, uint32_t height);
+	void Destroy();
+
+	void CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes);
+	void CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings);
+	void CreateDescriptorSet();
+
+	void CreateFrameData();
+	//Layouts are created right away, pipelines are built as jobs that count on ready
+	void CreatePipelineData(JobCounter* ready);
+
+	void UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets);
+
+private:
+	void CreateLightBins();
+
+	void CreatePipelineLayout();
+	VkPipeline CreatePipeline();
+
+public:
+	uint32_t mWidth, mHeight;
+	uint32_t mTilesX, mTilesY;
+
+	//One uint mask per tile. Written on the compute queue and read by lighting on the graphics queue,
+	//so it is shared concurrently when those are different families
+	VkBuffer mLightBins = VK_NULL_HANDLE;
+	VkDeviceMemory mLightBinsMemory = VK_NULL_HANDLE;
+	VkDeviceSize mLightBinsSize = 0;
+
+	VkDescriptorPool mDescriptorPool;
+	VkDescriptorSetLayout mDescriptorLayout;
+	VkDescriptorSet mDescriptorSet;
+
+	VkPipelineLayout mPipelineLayout;
+	VkPipeline mPipeline;
+	VkPushConstantRange mPushConstants{};//Reflected, pushes have to use its stage flags
+};
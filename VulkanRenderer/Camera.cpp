@@ -55,6 +55,12 @@ void Camera::ProcessMouseMovement(float xoffset, float yoffset, bool constrainPi
 	updateCameraVectors();
 }
 
+float Camera::ProjectedError(float worldError, const glm::vec4& bounds, float pixelsPerUnit, float nearPlane) const
+{
+	float distance = glm::max(glm::length(glm::vec3(bounds) - position) - bounds.w, nearPlane);
+	return worldError * pixelsPerUnit / distance;
+}
+
 void Camera::updateCameraVectors()
 {
 	glm::vec3 newFront;
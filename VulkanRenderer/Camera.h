@@ -22,6 +22,9 @@ public:
 	glm::mat4 getViewMatrix();
 	void ProcessKeyboard(Camera_Movement direction, float dt);
 	void ProcessMouseMovement(float xoffset, float yoffset, bool constrainPitch = true);
+	//Pixels a world space distance at the near side of bounds (xyz center, w radius) covers on screen.
+	//pixelsPerUnit is the viewport height over 2 tan(fovY / 2)
+	float ProjectedError(float worldError, const glm::vec4& bounds, float pixelsPerUnit, float nearPlane) const;
 	
 public:
 	glm::vec3 position;
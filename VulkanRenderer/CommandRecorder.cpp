@@ -0,0 +1,139 @@
+#include "CommandRecorder.h"
+#include "JobSystem.h"
+#include "VulkanDevice.h"
+#include "VulkanInitializers.hpp"
+#include "VulkanTools.h"
+
+#include <algorithm>
+
+void CommandRecorder::Init(VulkanDevice* device, JobSystem* jobSystem, uint32_t framesInFlight)
+{
+	mDevice = device;
+	mJobSystem = jobSystem;
+
+	mThreads.resize(jobSystem->GetThreadCount());
+	for (ThreadData& thread : mThreads)
+	{
+		thread.pools.resize(framesInFlight);
+		thread.buffers.resize(framesInFlight);
+		for (VkCommandPool& pool : thread.pools)
+		{
+			pool = device->createCommandPool(device->queueFamilyIndices.graphics, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+		}
+	}
+	mSlotValues.assign(framesInFlight, 0);
+	mThreadCount = GetMaxThreads();
+}
+
+void CommandRecorder::Destroy()
+{
+	//Destroying a pool frees its buffers
+	for (ThreadData& thread : mThreads)
+	{
+		for (VkCommandPool pool : thread.pools)
+		{
+			vkDestroyCommandPool(mDevice->logicalDevice, pool, nullptr);
+		}
+	}
+	mThreads.clear();
+}
+
+void CommandRecorder::BeginFrame(uint64_t completedValue)
+{
+	//The oldest submission is the first to complete
+	auto oldest = std::min_element(mSlotValues.begin(), mSlotValues.end());
+	if (*oldest > completedValue)
+	{
+		throw std::runtime_error("no command pool slot is free, wait for the frame timeline first!");
+	}
+
+	mFrameSlot = static_cast<uint32_t>(oldest - mSlotValues.begin());
+	for (ThreadData& thread : mThreads)
+	{
+		VK_CHECK_RESULT(vkResetCommandPool(mDevice->logicalDevice, thread.pools[mFrameSlot], 0))
+		thread.used = 0;
+	}
+}
+
+void CommandRecorder::EndFrame(uint64_t submitValue)
+{
+	mSlotValues[mFrameSlot] = submitValue;
+}
+
+std::vector<VkCommandBuffer> CommandRecorder::Record(VkRenderPass renderPass, VkFramebuffer framebuffer, uint32_t itemCount, const RecordFunc& record)
+{
+	std::vector<VkCommandBuffer> secondaries;
+	if (itemCount == 0)
+	{
+		return secondaries;
+	}
+
+	VkCommandBufferInheritanceInfo inheritance{};
+	inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance.renderPass = renderPass;
+	inheritance.subpass = 0;
+	inheritance.framebuffer = framebuffer;
+
+	const uint32_t chunkCount = std::min(mThreadCount, itemCount);
+	const uint32_t chunkSize = (itemCount + chunkCount - 1) / chunkCount;
+	std::vector<VkCommandBuffer> chunks(chunkCount, VK_NULL_HANDLE);
+
+	//Whichever thread picks a chunk up records it with its own pool
+	JobCounter recorded;
+	mJobSystem->ParallelFor(chunkCount, 1, [&](uint32_t firstChunk, uint32_t lastChunk)
+	{
+		for (uint32_t chunk = firstChunk; chunk < lastChunk; ++chunk)
+		{
+			uint32_t begin = std::min(chunk * chunkSize, itemCount);
+			uint32_t end = std::min(begin + chunkSize, itemCount);
+			if (begin == end)
+			{
+				continue;
+			}
+
+			VkCommandBuffer cmd = AcquireBuffer(JobSystem::ThreadIndex());
+			VkCommandBufferBeginInfo beginInfo = initializers::commandBufferBeginInfo();
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			beginInfo.pInheritanceInfo = &inheritance;
+			VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &beginInfo))
+			record(cmd, begin, end);
+			VK_CHECK_RESULT(vkEndCommandBuffer(cmd))
+			chunks[chunk] = cmd;
+		}
+	}, &recorded);
+	mJobSystem->Wait(recorded);
+
+	for (VkCommandBuffer cmd : chunks)
+	{
+		if (cmd != VK_NULL_HANDLE)
+		{
+			secondaries.push_back(cmd);
+		}
+	}
+	return secondaries;
+}
+
+void CommandRecorder::SetThreadCount(uint32_t count)
+{
+	mThreadCount = std::clamp(count, 1u, GetMaxThreads());
+}
+
+/*************************************************************************************************************/
+
+VkCommandBuffer CommandRecorder::AcquireBuffer(uint32_t thread)
+{
+	ThreadData& data = mThreads[thread];
+	std::vector<VkCommandBuffer>& buffers = data.buffers[mFrameSlot];
+	if (data.used == buffers.size())
+	{
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = data.pools[mFrameSlot];
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocInfo.commandBufferCount = 1;
+		VkCommandBuffer cmd;
+		VK_CHECK_RESULT(vkAllocateCommandBuffers(mDevice->logicalDevice, &allocInfo, &cmd))
+		buffers.push_back(cmd);
+	}
+	return buffers[data.used++];
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+struct VulkanDevice;
+class JobSystem;
+
+//Records draw lists into secondary command buffers as jobs.
+//Every job system thread owns one command pool per frame slot, so no pool is ever shared between threads.
+//A slot remembers the frame timeline value it was last submitted with and is only reset once the timeline got there.
+//Record may be called from several jobs at once.
+class CommandRecorder
+{
+public:
+	//Records items [begin, end) into cmd, which has already begun inside the render pass.
+	//Dynamic state and bindings are not inherited, each chunk sets its own.
+	using RecordFunc = std::function<void(VkCommandBuffer cmd, uint32_t begin, uint32_t end)>;
+
+	struct BenchmarkResult
+	{
+		uint32_t drawCount = 0;
+		uint32_t threadCount = 0;
+		float ms = 0.f;
+	};
+
+	void Init(VulkanDevice* device, JobSystem* jobSystem, uint32_t framesInFlight);
+	void Destroy();
+
+	//Picks a slot whose last submission is at or below completedValue of the frame timeline and resets its pools.
+	//No Record may be running
+	void BeginFrame(uint64_t completedValue);
+	//The buffers recorded since BeginFrame were submitted, the slot stays in use until submitValue completes.
+	//Frames that are dropped before their submit skip this and leave the slot free
+	void EndFrame(uint64_t submitValue);
+
+	//Splits [0, itemCount) into one chunk per active thread and records each chunk as a job.
+	//Returns the secondaries of the non-empty chunks in item order, ready for vkCmdExecuteCommands
+	std::vector<VkCommandBuffer> Record(VkRenderPass renderPass, VkFramebuffer framebuffer, uint32_t itemCount, const RecordFunc& record);
+
+	void SetThreadCount(uint32_t count);
+	uint32_t GetThreadCount() const { return mThreadCount; }
+	uint32_t GetMaxThreads() const { return static_cast<uint32_t>(mThreads.size()); }
+
+private:
+	struct alignas(64) ThreadData
+	{
+		std::vector<VkCommandPool> pools;//One per frame slot
+		std::vector<std::vector<VkCommandBuffer>> buffers;//Allocated from pools[slot], reused after each reset
+		uint32_t used = 0;//Buffers of the current slot already handed out
+	};
+
+	//Only ever called by the thread owning the data
+	VkCommandBuffer AcquireBuffer(uint32_t thread);
+
+	VulkanDevice* mDevice = nullptr;
+	JobSystem* mJobSystem = nullptr;
+	std::vector<ThreadData> mThreads;//Indexed by JobSystem::ThreadIndex()
+	uint32_t mThreadCount = 1;
+	uint32_t mFrameSlot = 0;
+	std::vector<uint64_t> mSlotValues;//Frame timeline value each slot was last submitted with
+};
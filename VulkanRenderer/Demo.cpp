@@ -2,13 +2,30 @@
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_vulkan.h>
 
-#include <ktxvulkan.h>
-
 #include "Demo.h"
 
 #include "VulkanTools.h"
 #include "VulkanInitializers.hpp"
 
+#include <cfloat>
+
+//Objects handled by one transform or culling job
+#define OBJECT_JOB_GRAIN 256
+
+//Radical inverse of index in base, a low discrepancy sequence in [0, 1)
+static float Halton(uint32_t index, uint32_t base)
+{
+	float result = 0.f;
+	float fraction = 1.f;
+	while (index > 0)
+	{
+		fraction /= static_cast<float>(base);
+		result += fraction * static_cast<float>(index % base);
+		index /= base;
+	}
+	return result;
+}
+
 void Demo::run()
 {
 	Init();
@@ -18,41 +35,71 @@ void Demo::run()
 
 void Demo::Init()
 {
+	initStart = std::chrono::steady_clock::now();
+	//Every other hardware thread becomes a worker, this one helps whenever it waits
+	jobSystem.Init(std::max(std::thread::hardware_concurrency(), 2u) - 1);
 	VkApp::Init();
 	SetupCallBacks();
 	
+	transforms.Init(mVulkanDevice, MAX_TRANSFORMS);
+	mShaders.Init("../shaders/", &jobSystem);
+	mPipelineBuilder.Init(mVulkanDevice->logicalDevice, mPipelineCache, &jobSystem, &mShaders);
+	textureStreamer.Init(this, &jobSystem, mTransferQueue, TextureStreamer::Settings{});
+	resources.Init(mVulkanDevice, &jobSystem, &textureStreamer);
 	LoadMeshAndObjects();
 	LoadTextures();
 	CreateLight();
-	LoadCubemap("../textures/cubemap_yokohama_rgba.ktx", VK_FORMAT_R8G8B8A8_UNORM, false);
 	CreateCamera();
 	CreateSyncObjects();
 
-	shadow_pass.Init(this, WIDTH, HEIGHT);
+	shadow_pass.Init(this, TEX_DIM, TEX_DIM);
 	geometry_pass.Init(this, WIDTH, HEIGHT);
 	lighting_pass.Init(this, WIDTH, HEIGHT);
 	post_pass.Init(this, WIDTH, HEIGHT, &lighting_pass.mComposition, &geometry_pass.mDepth);
+	compute_pass.Init(this, WIDTH, HEIGHT);
+	tonemap_pass.Init(this, WIDTH, HEIGHT, mSwapChain->mSwapChainRenderPass);
+	taa_pass.Init(this, WIDTH, HEIGHT);
+	bloom_pass.Init(this, WIDTH, HEIGHT);
+	cluster_pass.Init(this, WIDTH, HEIGHT);
 
 	InitDescriptorPool();
 	InitDescriptorLayout();
 	InitDescriptorSet();
 
 	shadow_pass.CreateFrameData();
-	shadow_pass.CreatePipelineData();
-
+	compute_pass.CreateFrameData();
+	tonemap_pass.CreateFrameData();
+	taa_pass.CreateFrameData();
+	bloom_pass.CreateFrameData();
+	//Meshes are still loading, so the buffers are sized up front and filled as they arrive
+	cluster_pass.CreateFrameData(static_cast<uint32_t>(objects.size()), CLUSTER_MAX_DRAWN_INDICES);
+	cluster_pass.CreateMeshletData(CLUSTER_MAX_MESHLETS, CLUSTER_MAX_MESHLET_INDICES);
+	//Creates the G-buffer and composition, the passes build their framebuffers on top
+	SetupRenderGraph();
 	geometry_pass.CreateFrameData();
-	geometry_pass.CreatePipelineData();
-
 	lighting_pass.CreateFrameData();
-	lighting_pass.CreatePipelineData();
-
 	post_pass.CreateFrameData();
-	post_pass.CreatePipelineData();
+	cluster_pass.CreateDepthView(geometry_pass.mDepth);
+
+	//Pipelines compile on the workers while the rest of Init runs, each pass only waits for its own before recording
+	shadow_pass.CreatePipelineData(&shadowPipelines);
+	geometry_pass.CreatePipelineData(&gPipelines);
+	lighting_pass.CreatePipelineData(&lightPipelines);
+	post_pass.CreatePipelineData(&postPipelines);
+	compute_pass.CreatePipelineData(&computePipelines);
+	tonemap_pass.CreatePipelineData(&tonemapPipelines);
+	taa_pass.CreatePipelineData(&taaPipelines);
+	bloom_pass.CreatePipelineData(&bloomPipelines);
+	cluster_pass.CreatePipelineData(&clusterPipelines);
 
 	CreateUniformBuffers();
 	CreateSampler();
 	CreateShadowDepthSampler();
 	CreateCommandBuffers();
+	commandRecorder.Init(mVulkanDevice, &jobSystem, MAX_FRAMES_IN_FLIGHT);
+
+	gpuProfiler.Init(mVulkanDevice);
+	dynamicResolution.Init(DynamicResolution::Settings{});
 
 	InitGUI();
 }
@@ -79,17 +126,56 @@ void Demo::Update()
 void Demo::Draw()
 {
 	VkApp::Draw();
-	vkWaitForFences(mVulkanDevice->logicalDevice, 1, &inFlightFence, VK_TRUE, UINT64_MAX);
+	//At most MAX_FRAMES_IN_FLIGHT submits are unfinished, what the older ones used can be recycled after this
+	const uint64_t submitted = frameTimeline.GetSubmitted();
+	gpuFramesBehind = static_cast<uint32_t>(submitted - frameTimeline.GetCompleted());
+	frameTimeline.Wait(submitted >= MAX_FRAMES_IN_FLIGHT ? submitted + 1 - MAX_FRAMES_IN_FLIGHT : 0);
+	frameWaitMs += (frameTimeline.GetLastWaitMs() - frameWaitMs) * 0.1f;
+	++frameNumber;
+	gpuProfiler.CollectResults();
+	//The last frame's GPU time decides how many pixels this one renders
+	prevRenderWidth = renderWidth;
+	prevRenderHeight = renderHeight;
+	float renderScale = fixedRenderScale;
+	if (DynamicResolutionOn == true)
+	{
+		renderScale = dynamicResolution.Update(gpuProfiler.GetFrameMs());
+	}
+	else
+	{
+		dynamicResolution.SetScale(fixedRenderScale);
+	}
+	renderWidth = DynamicResolution::ScaledSize(WIDTH, renderScale);
+	renderHeight = DynamicResolution::ScaledSize(HEIGHT, renderScale);
+	textureStreamer.Update(frameNumber);
+	resources.Update(frameNumber);
+	ResolveMeshes();
+	//Edited shaders recompile in the background, their pipelines are swapped in here once rebuilt
+	mShaders.Poll();
+	mPipelineBuilder.Update();
+
+	//The benchmark borrows this frame's pools, they are reset again right after
+	if (runRecordBenchmark == true)
+	{
+		runRecordBenchmark = false;
+		RunRecordBenchmark();
+	}
+	commandRecorder.BeginFrame(frameTimeline.GetCompleted());
+	if (runJobBenchmark == true)
+	{
+		runJobBenchmark = false;
+		RunJobBenchmark();
+	}
+	if (runObjBenchmark == true)
+	{
+		runObjBenchmark = false;
+		RunObjBenchmark();
+	}
 
 	uint32_t imageindex;
 	VkResult result = vkAcquireNextImageKHR(mVulkanDevice->logicalDevice, mSwapChain->mSwapChain, UINT64_MAX, presentComplete, VK_NULL_HANDLE, &imageindex);
-
-	UpdateUniformBuffer();
-	UpdateDescriptorSet();
-	BuildShadowCommandBuffer();
-	BuildGCommandBuffer();
-	BuildLightCommandBuffer();//TODO: Can transfer to Init. Not draw.
-
+	//A dropped frame must not reach the graph, Execute moves the tracked layouts of the imported images and SwapImported
+	//the TAA history as if the GPU had run it
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized)
 	{
 		framebufferResized = false;
@@ -101,67 +187,49 @@ void Demo::Draw()
 		throw std::runtime_error("failed to acquire swap chain image!");
 	}
 
-	vkResetFences(mVulkanDevice->logicalDevice, 1, &inFlightFence);
-
-	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-
-	VkSubmitInfo SSubmitInfo = {};
-	SSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	SSubmitInfo.pWaitSemaphores = &presentComplete;
-	SSubmitInfo.waitSemaphoreCount = 1;
-	SSubmitInfo.pSignalSemaphores = &ShadowComplete;
-	SSubmitInfo.signalSemaphoreCount = 1;
-	SSubmitInfo.commandBufferCount = 1;
-	SSubmitInfo.pCommandBuffers = &ShadowCommandBuffer;
-	SSubmitInfo.pWaitDstStageMask = waitStages;
-
-	VK_CHECK_RESULT(vkQueueSubmit(mGraphicsQueue, 1, &SSubmitInfo, nullptr))
-
-
-	VkSubmitInfo GSubmitInfo = {};
-	GSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	GSubmitInfo.pWaitSemaphores = &ShadowComplete;
-	GSubmitInfo.waitSemaphoreCount = 1;
-	GSubmitInfo.pSignalSemaphores = &GBufferComplete;
-	GSubmitInfo.signalSemaphoreCount = 1;
-	GSubmitInfo.commandBufferCount = 1;
-	GSubmitInfo.pCommandBuffers = &GCommandBuffer;
-	GSubmitInfo.pWaitDstStageMask = waitStages;
+	if (SpinObjects == true)
+	{
+		transforms.SetRotation(objects[1]->mTransform, glm::angleAxis(accumulatingDT, glm::vec3(0.f, 1.f, 0.f)));
+		transforms.SetRotation(objects[2]->mTransform, glm::angleAxis(accumulatingDT, glm::vec3(1.f, 0.f, 0.f)));
+	}
 
-	VK_CHECK_RESULT(vkQueueSubmit(mGraphicsQueue, 1, &GSubmitInfo, nullptr))
+	//Transforms -> culling -> texture demand run as a job chain while this thread fills the uniform buffers
+	UpdateFrameCamera();
+	const float viewportHeight = static_cast<float>(mSwapChain->mSwapChainExtent.height);
+	JobCounter transformStage;
+	jobSystem.Run([this, viewportHeight]() { UpdateTransforms(); SelectLods(viewportHeight); }, &transformStage);
+	JobCounter cullStage;
+	jobSystem.RunAfter(transformStage, [this]() { CullObjects(); }, &cullStage);
+	JobCounter uploadStage;
+	jobSystem.RunAfter(cullStage, [this, viewportHeight]() { UpdateTextureDemand(viewportHeight); }, &uploadStage);
+	//Point shadow caching looks at which objects moved this frame
+	jobSystem.Wait(transformStage);
+	UpdateUniformBuffer();
+	//Last frame's TAA output is this frame's history
+	renderGraph.SwapImported(taaHistory, taaOutput);
+	taaOutputIndex ^= 1;
+	jobSystem.Wait(uploadStage);
+	UpdateClusterDraws();
+	UpdateDescriptorSet();
 
-	VkSubmitInfo lightSubmitInfo = {};
-	lightSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	lightSubmitInfo.pWaitSemaphores = &GBufferComplete;
-	lightSubmitInfo.waitSemaphoreCount = 1;
-	lightSubmitInfo.pSignalSemaphores = &renderComplete;
-	lightSubmitInfo.signalSemaphoreCount = 1;
-	lightSubmitInfo.commandBufferCount = 1;
-	lightSubmitInfo.pCommandBuffers = &LightingCommandBuffer;
-	lightSubmitInfo.pWaitDstStageMask = waitStages;
-	VK_CHECK_RESULT(vkQueueSubmit(mGraphicsQueue, 1, &lightSubmitInfo, nullptr))
+	//Passes are recorded by jobs side by side, the graph puts the barriers between them
+	swapchainIndex = imageindex;
+	renderGraph.SetImage(swapchainImage, mSwapChain->mSwapChainRenderDatas[imageindex].mFrameBufferData.mColorAttachment.image);
+	renderGraph.Execute();
+	pyramidValid = EnableClusterCulling == true && EnableOcclusionCulling == true;
+	//A pipeline that failed to build is reported before anything gets submitted
+	mPipelineBuilder.RethrowFailure();
 
-	
-	BuildPostCommandBuffer(0);
-	VkSubmitInfo postSubmitInfo = {};
-	postSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	postSubmitInfo.pWaitSemaphores = &renderComplete;
-	postSubmitInfo.waitSemaphoreCount = 1;
-	postSubmitInfo.pSignalSemaphores = &PostComplete;
-	postSubmitInfo.signalSemaphoreCount = 1;
-	postSubmitInfo.commandBufferCount = 1;
-	postSubmitInfo.pCommandBuffers = &PostCommandBuffer;
-	postSubmitInfo.pWaitDstStageMask = waitStages;
-	VK_CHECK_RESULT(vkQueueSubmit(mGraphicsQueue, 1, &postSubmitInfo, inFlightFence))
-
-	CopyImage(post_pass.mLColorResult->image, VK_ACCESS_MEMORY_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-			mSwapChain->mSwapChainRenderDatas[imageindex].mFrameBufferData.mColorAttachment.image, VK_ACCESS_MEMORY_READ_BIT, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+	//The whole frame is one submit, the acquire is only waited for where the swapchain image is first written
+	const uint64_t frameValue = frameTimeline.Advance();
+	renderGraph.Submit(presentComplete, renderComplete, frameTimeline, frameValue);
+	commandRecorder.EndFrame(frameValue);
 
 	VkPresentInfoKHR presentInfo {};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
 	presentInfo.waitSemaphoreCount = 1;
-	presentInfo.pWaitSemaphores = &PostComplete;
+	presentInfo.pWaitSemaphores = &renderComplete;
 
 	VkSwapchainKHR swapChains[] = { mSwapChain->mSwapChain };
 	presentInfo.swapchainCount = 1;
@@ -171,6 +239,10 @@ void Demo::Draw()
 	presentInfo.pResults = nullptr;
 
 	result = vkQueuePresentKHR(mPresentQueue, &presentInfo);
+	if (frameNumber == 1)
+	{
+		firstFrameMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - initStart).count();
+	}
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR)
 	{
@@ -185,6 +257,40 @@ void Demo::Draw()
 
 void Demo::CleanUp()
 {
+	for (Object* object : objects)
+	{
+		resources.Release(object->mMeshHandle);
+	}
+	textureStreamer.Destroy();
+	resources.Destroy();
+	commandRecorder.Destroy();
+	gpuProfiler.Destroy();
+	materialSSBO.destroy();
+	transforms.Destroy();
+	jobSystem.Wait(shadowPipelines);
+	jobSystem.Wait(gPipelines);
+	jobSystem.Wait(lightPipelines);
+	jobSystem.Wait(postPipelines);
+	jobSystem.Wait(computePipelines);
+	jobSystem.Wait(tonemapPipelines);
+	jobSystem.Wait(taaPipelines);
+	jobSystem.Wait(bloomPipelines);
+	jobSystem.Wait(clusterPipelines);
+	compute_pass.Destroy();
+	tonemap_pass.Destroy();
+	taa_pass.Destroy();
+	bloom_pass.Destroy();
+	cluster_pass.Destroy();
+	mShaders.Destroy();
+	mPipelineBuilder.Destroy();
+	renderGraph.Destroy();
+	frameTimeline.Destroy();
+	vkDestroyCommandPool(mVulkanDevice->logicalDevice, ShadowCommandPool, nullptr);
+	vkDestroyCommandPool(mVulkanDevice->logicalDevice, GCommandPool, nullptr);
+	vkDestroyCommandPool(mVulkanDevice->logicalDevice, LightingCommandPool, nullptr);
+	vkDestroyCommandPool(mVulkanDevice->logicalDevice, ComputeCommandPool, nullptr);
+	//Streamer decodes are done by now, nothing is left to run
+	jobSystem.Shutdown();
 	VkApp::CleanUp();
 }
 
@@ -219,211 +325,54 @@ void Demo::MouseCallBack(GLFWwindow* window, double xposIn, double yposIn)
 
 void Demo::LoadMeshAndObjects()
 {
-	redMesh = new Mesh;
-	redMesh->loadAndCreateMesh("../models/Sphere.obj", mVulkanDevice, glm::vec3(0.5, 0.5, 0.5));
-
-	greenMesh = new Mesh;
-	greenMesh->loadAndCreateMesh("../models/Monkey.obj", mVulkanDevice, glm::vec3(0.5, 0.5, 0.5));
-
-	BlueMesh = new Mesh;
-	BlueMesh->loadAndCreateMesh("../models/Torus.obj", mVulkanDevice, glm::vec3(0.8, 0.8, 0.8));
-
-	floor = new Mesh;
-	floor->loadAndCreateMesh("../models/Plane.obj", mVulkanDevice, glm::vec3(0.8, 0.8, 0.8));
-
-	Skybox = new Mesh;
-	Skybox->loadAndCreateMesh("../models/Skybox.obj", mVulkanDevice, glm::vec3(0.8, 0.8, 0.8));
-
-	objects.push_back(new Object(redMesh, glm::vec3(0.f, 3.f, 3.f)));
-	objects.push_back(new Object(greenMesh, glm::vec3(3.f, 3.f, 0.f)));
-	objects.push_back(new Object(BlueMesh, glm::vec3(-3.f, 3.f, 0.f)));
-	objects.push_back(new Object(floor, glm::vec3(0, 0.0, 0)));
-}
-
-void Demo::LoadCubemap(std::string filename, VkFormat format, bool forceLinearTiling)
-{
-	ktxResult result;
-	ktxTexture* ktxTexture;
-
-	if (!vks::tools::fileExists(filename)) 
-	{
-		assert("Failed to load cubemap");
-	}
-	result = ktxTexture_CreateFromNamedFile(filename.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &ktxTexture);
-	assert(result == KTX_SUCCESS);
-
-	// Get properties required for using and upload texture data from the ktx texture object
-	testCubemap.width = ktxTexture->baseWidth;
-	testCubemap.height = ktxTexture->baseHeight;
-	testCubemap.mipLevels = ktxTexture->numLevels;
-	ktx_uint8_t* ktxTextureData = ktxTexture_GetData(ktxTexture);
-	ktx_size_t ktxTextureSize = ktxTexture_GetSize(ktxTexture);
-
-	VkMemoryAllocateInfo memAllocInfo = initializers::memoryAllocateInfo();
-	VkMemoryRequirements memReqs;
-
-	// Create a host-visible staging buffer that contains the raw image data
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingMemory;
-
-	VkBufferCreateInfo bufferCreateInfo = initializers::bufferCreateInfo();
-	bufferCreateInfo.size = ktxTextureSize;
-	// This buffer is used as a transfer source for the buffer copy
-	bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-	bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-	VK_CHECK_RESULT(vkCreateBuffer(mVulkanDevice->logicalDevice, &bufferCreateInfo, nullptr, &stagingBuffer));
-
-	// Get memory requirements for the staging buffer (alignment, memory type bits)
-	vkGetBufferMemoryRequirements(mVulkanDevice->logicalDevice, stagingBuffer, &memReqs);
-	memAllocInfo.allocationSize = memReqs.size;
-	// Get memory type index for a host visible buffer
-	memAllocInfo.memoryTypeIndex = mVulkanDevice->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-	VK_CHECK_RESULT(vkAllocateMemory(mVulkanDevice->logicalDevice, &memAllocInfo, nullptr, &stagingMemory));
-	VK_CHECK_RESULT(vkBindBufferMemory(mVulkanDevice->logicalDevice, stagingBuffer, stagingMemory, 0));
-
-	// Copy texture data into staging buffer
-	uint8_t* data;
-	VK_CHECK_RESULT(vkMapMemory(mVulkanDevice->logicalDevice, stagingMemory, 0, memReqs.size, 0, (void**)&data));
-	memcpy(data, ktxTextureData, ktxTextureSize);
-	vkUnmapMemory(mVulkanDevice->logicalDevice, stagingMemory);
-
-	// Create optimal tiled target image
-	VkImageCreateInfo imageCreateInfo = initializers::imageCreateInfo();
-	imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
-	imageCreateInfo.format = format;
-	imageCreateInfo.mipLevels = testCubemap.mipLevels;
-	imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-	imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-	imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-	imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	imageCreateInfo.extent = { testCubemap.width, testCubemap.height, 1 };
-	imageCreateInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-	// Cube faces count as array layers in Vulkan
-	imageCreateInfo.arrayLayers = 6;
-	// This flag is required for cube map images
-	imageCreateInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
-
-	VK_CHECK_RESULT(vkCreateImage(mVulkanDevice->logicalDevice, &imageCreateInfo, nullptr, &testCubemap.image));
-
-	vkGetImageMemoryRequirements(mVulkanDevice->logicalDevice, testCubemap.image, &memReqs);
-
-	memAllocInfo.allocationSize = memReqs.size;
-	memAllocInfo.memoryTypeIndex = mVulkanDevice->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	VK_CHECK_RESULT(vkAllocateMemory(mVulkanDevice->logicalDevice, &memAllocInfo, nullptr, &testCubemap.memory));
-	VK_CHECK_RESULT(vkBindImageMemory(mVulkanDevice->logicalDevice, testCubemap.image, testCubemap.memory, 0));
-
-	VkCommandBuffer copyCmd = mVulkanDevice->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-	// Setup buffer copy regions for each face including all of its miplevels
-	std::vector<VkBufferImageCopy> bufferCopyRegions;
-	uint32_t offset = 0;
-
-	for (uint32_t face = 0; face < 6; face++)
-	{
-		for (uint32_t level = 0; level < testCubemap.mipLevels; level++)
-		{
-			// Calculate offset into staging buffer for the current mip level and face
-			ktx_size_t offset;
-			KTX_error_code ret = ktxTexture_GetImageOffset(ktxTexture, level, 0, face, &offset);
-			assert(ret == KTX_SUCCESS);
-			VkBufferImageCopy bufferCopyRegion = {};
-			bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-			bufferCopyRegion.imageSubresource.mipLevel = level;
-			bufferCopyRegion.imageSubresource.baseArrayLayer = face;
-			bufferCopyRegion.imageSubresource.layerCount = 1;
-			bufferCopyRegion.imageExtent.width = ktxTexture->baseWidth >> level;
-			bufferCopyRegion.imageExtent.height = ktxTexture->baseHeight >> level;
-			bufferCopyRegion.imageExtent.depth = 1;
-			bufferCopyRegion.bufferOffset = offset;
-			bufferCopyRegions.push_back(bufferCopyRegion);
-		}
+	//Nothing waits for the files, every object draws the placeholder cube until its mesh is uploaded
+	auto addObject = [this](const char* file, const glm::vec3& position)
+	{
+		MeshHandle handle = resources.LoadMesh(file);
+		objects.push_back(new Object(resources.GetMesh(handle), transforms.Create(position), handle));
+	};
+	addObject("../models/Sphere.obj", glm::vec3(0.f, 3.f, 3.f));
+	addObject("../models/Monkey.obj", glm::vec3(3.f, 3.f, 0.f));
+	addObject("../models/Torus.obj", glm::vec3(-3.f, 3.f, 0.f));
+	addObject("../models/Plane.obj", glm::vec3(0, 0.0, 0));
+	//A ring of spheres sharing the first one's mesh, the path is spelled differently and still the file is read once
+	const uint32_t ringCount = 8;
+	for (uint32_t i = 0; i < ringCount; ++i)
+	{
+		const float angle = glm::radians(360.f * static_cast<float>(i) / static_cast<float>(ringCount));
+		addObject("../models/../models/Sphere.obj", glm::vec3(std::cos(angle) * 8.f, 1.f, std::sin(angle) * 8.f));
 	}
 
-	// Image barrier for optimal image (target)
-	// Set initial layout for all array layers (faces) of the optimal (target) tiled texture
-	VkImageSubresourceRange subresourceRange = {};
-	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	subresourceRange.baseMipLevel = 0;
-	subresourceRange.levelCount = testCubemap.mipLevels;
-	subresourceRange.layerCount = 6;
-
-	vks::tools::setImageLayout(
-		copyCmd,
-		testCubemap.image,
-		VK_IMAGE_LAYOUT_UNDEFINED,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		subresourceRange);
-
-	// Copy the cube map faces from the staging buffer to the optimal tiled image
-	vkCmdCopyBufferToImage(
-		copyCmd,
-		stagingBuffer,
-		testCubemap.image,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		static_cast<uint32_t>(bufferCopyRegions.size()),
-		bufferCopyRegions.data()
-	);
-
-	// Change texture image layout to shader read after all faces have been copied
-	testCubemap.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	vks::tools::setImageLayout(
-		copyCmd,
-		testCubemap.image,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		testCubemap.imageLayout,
-		subresourceRange);
-
-	mVulkanDevice->flushCommandBuffer(copyCmd, mGraphicsQueue, true);
-
-	// Create sampler
-	VkSamplerCreateInfo sampler = initializers::samplerCreateInfo();
-	sampler.magFilter = VK_FILTER_LINEAR;
-	sampler.minFilter = VK_FILTER_LINEAR;
-	sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-	sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-	sampler.addressModeV = sampler.addressModeU;
-	sampler.addressModeW = sampler.addressModeU;
-	sampler.mipLodBias = 0.0f;
-	sampler.compareOp = VK_COMPARE_OP_NEVER;
-	sampler.minLod = 0.0f;
-	sampler.maxLod = testCubemap.mipLevels;
-	sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-	sampler.maxAnisotropy = 1.0f;
-	if (mVulkanDevice->features.samplerAnisotropy)
-	{
-		sampler.maxAnisotropy = mVulkanDevice->properties.limits.maxSamplerAnisotropy;
-		sampler.anisotropyEnable = VK_TRUE;
-	}
-	VK_CHECK_RESULT(vkCreateSampler(mVulkanDevice->logicalDevice, &sampler, nullptr, &testCubemap.sampler));
-
-	// Create image view
-	VkImageViewCreateInfo view = initializers::imageViewCreateInfo();
-	// Cube map view type
-	view.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
-	view.format = format;
-	view.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A };
-	view.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
-	// 6 array layers (faces)
-	view.subresourceRange.layerCount = 6;
-	// Set number of mip levels
-	view.subresourceRange.levelCount = testCubemap.mipLevels;
-	view.image = testCubemap.image;
-	VK_CHECK_RESULT(vkCreateImageView(mVulkanDevice->logicalDevice, &view, nullptr, &testCubemap.imageView));
-
-	// Clean up staging resources
-	vkFreeMemory(mVulkanDevice->logicalDevice, stagingMemory, nullptr);
-	vkDestroyBuffer(mVulkanDevice->logicalDevice, stagingBuffer, nullptr);
-	ktxTexture_Destroy(ktxTexture);
+	objectBounds.resize(objects.size());
+	objectVisible.resize(objects.size());
 }
 
 void Demo::LoadTextures()
 {
-	CreateTextureImage("../textures/block.jpg", testImage.image, testImage.memory);
-	testImage.imageView = CreateImageView(testImage.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
-	testImage.sampler = CreateTextureSampler();
-	testImage.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	//Nothing is decoded here, the streamer shows placeholders until the data arrives
+	uint32_t blockTexture = resources.GetTextureSlot(resources.LoadTexture("../textures/block.jpg"));
+	uint32_t niceTexture = resources.GetTextureSlot(resources.LoadTexture("../textures/nice.jpg"));
+	uint32_t paintTexture = resources.GetTextureSlot(resources.LoadTexture("../textures/02.png"));
+	skyTexture = resources.GetTextureSlot(resources.LoadTexture("../textures/cubemap_yokohama_rgba.ktx", true));
+	if (textureStreamer.GetTextureCount() > MAX_BINDLESS_TEXTURES)
+	{
+		throw std::runtime_error("bindless texture table is full!");
+	}
+
+	//Every object reaches its textures through the material table, nothing is rebound per draw
+	materials.push_back({ glm::vec4(1.f), static_cast<int32_t>(blockTexture) });
+	materials.push_back({ glm::vec4(1.f), static_cast<int32_t>(niceTexture) });
+	materials.push_back({ glm::vec4(1.f), static_cast<int32_t>(paintTexture) });
+	materials.push_back({ glm::vec4(0.6f, 0.8f, 1.f, 1.f), static_cast<int32_t>(blockTexture) });
+
+	objects[0]->mMaterial = 1;
+	objects[1]->mMaterial = 2;
+	objects[2]->mMaterial = 3;
+	objects[3]->mMaterial = 0;
+	for (size_t i = 4; i < objects.size(); ++i)
+	{
+		objects[i]->mMaterial = static_cast<uint32_t>(i % 3) + 1;
+	}
 }
 
 void Demo::CreateLight()
@@ -431,6 +380,10 @@ void Demo::CreateLight()
 	lightsData.point_light[0] = PointLight(glm::vec3(0.1f, 0.5f, 0.1f), glm::vec3(-10.f, -10.f, -10.f));
 	lightsData.point_light[1] = PointLight(glm::vec3(0.5f, 0.1f, 0.1), glm::vec3(10.f, 10.f, 10.f));
 	lightsData.point_light[2] = PointLight(glm::vec3(0.1f, 0.1f, 0.5f), glm::vec3(-10.f, 10.f, 10.f));
+
+	lightsData.dir_light = DirLight(glm::vec3(0.6f, 0.6f, 0.55f), glm::normalize(glm::vec3(-0.4f, -1.f, -0.3f)));
+
+	pointShadowAtlas.Init(POINT_SHADOW_SLOTS);
 }
 
 void Demo::CreateCamera()
@@ -443,19 +396,12 @@ void Demo::CreateSyncObjects()
 	VkSemaphoreCreateInfo semaphoreInfo{};
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-	VkFenceCreateInfo fenceInfo{};
-	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-	if (vkCreateSemaphore(mVulkanDevice->logicalDevice, &semaphoreInfo, nullptr, &GBufferComplete) != VK_SUCCESS ||
-		vkCreateSemaphore(mVulkanDevice->logicalDevice, &semaphoreInfo, nullptr, &renderComplete) != VK_SUCCESS ||
-		vkCreateSemaphore(mVulkanDevice->logicalDevice, &semaphoreInfo, nullptr, &presentComplete) != VK_SUCCESS ||
-		vkCreateSemaphore(mVulkanDevice->logicalDevice, &semaphoreInfo, nullptr, &PostComplete) != VK_SUCCESS ||
-		vkCreateSemaphore(mVulkanDevice->logicalDevice, &semaphoreInfo, nullptr, &ShadowComplete) != VK_SUCCESS ||
-		vkCreateFence(mVulkanDevice->logicalDevice, &fenceInfo, nullptr, &inFlightFence) != VK_SUCCESS)
+	if (vkCreateSemaphore(mVulkanDevice->logicalDevice, &semaphoreInfo, nullptr, &renderComplete) != VK_SUCCESS ||
+		vkCreateSemaphore(mVulkanDevice->logicalDevice, &semaphoreInfo, nullptr, &presentComplete) != VK_SUCCESS)
 	{
 		throw std::runtime_error("failed to create semaphores!");
 	}
+	frameTimeline.Init(mVulkanDevice->logicalDevice);
 }
 
 void Demo::CreateUniformBuffers()
@@ -468,6 +414,16 @@ void Demo::CreateUniformBuffers()
 
 	VkDeviceSize LightMatSize = sizeof(LightMatUBO);
 	mVulkanDevice->createBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &lightMatUBO, LightMatSize);
+
+	VkDeviceSize PointShadowSize = sizeof(PointShadowUBO);
+	mVulkanDevice->createBuffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &pointShadowUBO, PointShadowSize);
+
+	if (materials.size() > MAX_MATERIALS)
+	{
+		throw std::runtime_error("too many materials!");
+	}
+	VkDeviceSize MaterialSize = sizeof(Material) * materials.size();
+	mVulkanDevice->createBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &materialSSBO, MaterialSize, materials.data());
 }
 
 void Demo::CreateSampler()
@@ -485,6 +441,10 @@ void Demo::CreateSampler()
 	sampler.maxLod = 1.0f;
 	sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
 	VK_CHECK_RESULT(vkCreateSampler(mVulkanDevice->logicalDevice, &sampler, nullptr, &colorSampler));
+
+	sampler.magFilter = VK_FILTER_LINEAR;
+	sampler.minFilter = VK_FILTER_LINEAR;
+	VK_CHECK_RESULT(vkCreateSampler(mVulkanDevice->logicalDevice, &sampler, nullptr, &hdrSampler));
 }
 
 void Demo::CreateShadowDepthSampler()
@@ -502,30 +462,189 @@ void Demo::CreateShadowDepthSampler()
 	sampler.minLod = 0.0f;
 	sampler.maxLod = 1.0f;
 	VK_CHECK_RESULT(vkCreateSampler(mVulkanDevice->logicalDevice, &sampler, nullptr, &shadowDepthSampler));
+
+	//Hardware PCF: the sampler compares against the reference depth and filters the results bilinearly
+	sampler.magFilter = VK_FILTER_LINEAR;
+	sampler.minFilter = VK_FILTER_LINEAR;
+	sampler.compareEnable = VK_TRUE;
+	sampler.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	VK_CHECK_RESULT(vkCreateSampler(mVulkanDevice->logicalDevice, &sampler, nullptr, &shadowCompareSampler));
 }
 
 void Demo::CreateCommandBuffers()
 {
+	//A pool may only be used by one thread at a time
+	ShadowCommandPool = mVulkanDevice->createCommandPool(mVulkanDevice->queueFamilyIndices.graphics);
+	GCommandPool = mVulkanDevice->createCommandPool(mVulkanDevice->queueFamilyIndices.graphics);
+	LightingCommandPool = mVulkanDevice->createCommandPool(mVulkanDevice->queueFamilyIndices.graphics);
+	ComputeCommandPool = mVulkanDevice->createCommandPool(mVulkanDevice->queueFamilyIndices.compute);
+
 	VkCommandBufferAllocateInfo allocInfo{};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	allocInfo.commandPool = mVulkanDevice->mCommandPool;
 	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 	allocInfo.commandBufferCount = 1;
 
+	allocInfo.commandPool = ShadowCommandPool;
+	if (vkAllocateCommandBuffers(mVulkanDevice->logicalDevice, &allocInfo, &ShadowCommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate command buffers!");
+	}
+
+	allocInfo.commandPool = GCommandPool;
 	if (vkAllocateCommandBuffers(mVulkanDevice->logicalDevice, &allocInfo, &GCommandBuffer) != VK_SUCCESS)
 	{
 		throw std::runtime_error("failed to allocate command buffers!");
 	}
 
+	allocInfo.commandPool = LightingCommandPool;
 	if (vkAllocateCommandBuffers(mVulkanDevice->logicalDevice, &allocInfo, &LightingCommandBuffer) != VK_SUCCESS)
 	{
 		throw std::runtime_error("failed to allocate command buffers!");
 	}
 
+	allocInfo.commandPool = ComputeCommandPool;
+	if (vkAllocateCommandBuffers(mVulkanDevice->logicalDevice, &allocInfo, &ComputeCommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate command buffers!");
+	}
+
+	allocInfo.commandPool = mVulkanDevice->mCommandPool;
 	if (vkAllocateCommandBuffers(mVulkanDevice->logicalDevice, &allocInfo, &PostCommandBuffer) != VK_SUCCESS)
 	{
 		throw std::runtime_error("failed to allocate command buffers!");
 	}
+
+	if (vkAllocateCommandBuffers(mVulkanDevice->logicalDevice, &allocInfo, &TAACommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate command buffers!");
+	}
+
+	if (vkAllocateCommandBuffers(mVulkanDevice->logicalDevice, &allocInfo, &BloomCommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate command buffers!");
+	}
+
+	if (vkAllocateCommandBuffers(mVulkanDevice->logicalDevice, &allocInfo, &ExposureCommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate command buffers!");
+	}
+
+	if (vkAllocateCommandBuffers(mVulkanDevice->logicalDevice, &allocInfo, &TonemapCommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate command buffers!");
+	}
+
+	if (vkAllocateCommandBuffers(mVulkanDevice->logicalDevice, &allocInfo, &ClusterCullCommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate command buffers!");
+	}
+
+	if (vkAllocateCommandBuffers(mVulkanDevice->logicalDevice, &allocInfo, &DepthPyramidCommandBuffer) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate command buffers!");
+	}
+}
+
+void Demo::SetupRenderGraph()
+{
+	renderGraph.Init(mVulkanDevice, &jobSystem, mGraphicsQueue, mComputeQueue);
+
+	//Shadow maps are kept between frames, cascades and cubes that didn't change are not rendered again
+	RenderGraph::ResourceHandle cascades = renderGraph.ImportImage("Cascades", &shadow_pass.mDepth, VK_IMAGE_LAYOUT_UNDEFINED);
+	RenderGraph::ResourceHandle pointShadows = renderGraph.ImportImage("PointShadows", &shadow_pass.mPointDepth, VK_IMAGE_LAYOUT_UNDEFINED);
+
+	const VkImageUsageFlags gBufferUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	RenderGraph::ResourceHandle position = renderGraph.CreateImage("GPosition", { VK_FORMAT_R16G16B16A16_SFLOAT, WIDTH, HEIGHT, gBufferUsage }, &geometry_pass.mPosition);
+	RenderGraph::ResourceHandle normal = renderGraph.CreateImage("GNormal", { VK_FORMAT_R16G16B16A16_SFLOAT, WIDTH, HEIGHT, gBufferUsage }, &geometry_pass.mNormal);
+	RenderGraph::ResourceHandle albedo = renderGraph.CreateImage("GAlbedo", { VK_FORMAT_R8G8B8A8_UNORM, WIDTH, HEIGHT, gBufferUsage }, &geometry_pass.mAlbedo);
+	RenderGraph::ResourceHandle velocity = renderGraph.CreateImage("GVelocity", { VK_FORMAT_R16G16_SFLOAT, WIDTH, HEIGHT, gBufferUsage }, &geometry_pass.mVelocity);
+	//Sampled by the depth pyramid
+	RenderGraph::ResourceHandle depth = renderGraph.CreateImage("GDepth", { FindDepthFormat(), WIDTH, HEIGHT,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT }, &geometry_pass.mDepth);
+	//HDR, the tonemap brings it to the swapchain
+	RenderGraph::ResourceHandle composition = renderGraph.CreateImage("Composition", { FindHDRFormat(), WIDTH, HEIGHT,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT }, &lighting_pass.mComposition);
+	swapchainImage = renderGraph.ImportAcquiredImage("Swapchain", mSwapChain->mSwapChainFormat.format);
+	renderGraph.SetFinalUsage(swapchainImage, RenderGraph::Usage::Present);
+	RenderGraph::ResourceHandle lightBins = renderGraph.ImportBuffer("LightBins", compute_pass.mLightBins);
+	RenderGraph::ResourceHandle exposureData = renderGraph.ImportBuffer("Exposure", tonemap_pass.mExposureBuffer);
+	//Swapped every frame before anything is recorded, Draw keeps taaOutputIndex in step
+	taaHistory = renderGraph.ImportImage("TAAHistory", &taa_pass.mHistory[1], VK_IMAGE_LAYOUT_UNDEFINED);
+	taaOutput = renderGraph.ImportImage("TAAOutput", &taa_pass.mHistory[0], VK_IMAGE_LAYOUT_UNDEFINED);
+	RenderGraph::ResourceHandle bloomChain = renderGraph.ImportImage("Bloom", &bloom_pass.mChain, VK_IMAGE_LAYOUT_UNDEFINED);
+	RenderGraph::ResourceHandle clusterCommands = renderGraph.ImportBuffer("ClusterCommands", cluster_pass.mCommands.buffer);
+	RenderGraph::ResourceHandle clusterIndices = renderGraph.ImportBuffer("ClusterIndices", cluster_pass.mIndices.buffer);
+	//Written at the end of a frame, culled against by the next one
+	RenderGraph::ResourceHandle depthPyramid = renderGraph.ImportImage("DepthPyramid", &cluster_pass.mPyramid, VK_IMAGE_LAYOUT_UNDEFINED);
+
+	//Only needs the camera and the lights, so it runs on the compute queue while shadows and the G-buffer render
+	RenderGraph::PassHandle lightBinning = renderGraph.AddAsyncComputePass("LightBinning", &ComputeCommandBuffer, [this](VkCommandBuffer cmd) { RecordLightBinningPass(cmd); });
+	renderGraph.Write(lightBinning, lightBins, RenderGraph::Usage::StorageBufferCompute);
+
+	RenderGraph::PassHandle shadow = renderGraph.AddPass("Shadow", &ShadowCommandBuffer, [this](VkCommandBuffer cmd) { RecordShadowPass(cmd); });
+	renderGraph.Write(shadow, cascades, RenderGraph::Usage::DepthAttachment);
+	renderGraph.Write(shadow, pointShadows, RenderGraph::Usage::DepthAttachment);
+
+	//Small enough to record on the main thread, the G-buffer draws what it leaves
+	RenderGraph::PassHandle clusterCull = renderGraph.AddPass("ClusterCull", &ClusterCullCommandBuffer, [this](VkCommandBuffer cmd) { RecordClusterCullPass(cmd); }, true);
+	renderGraph.Read(clusterCull, depthPyramid, RenderGraph::Usage::SampledCompute);
+	renderGraph.Write(clusterCull, clusterCommands, RenderGraph::Usage::StorageBufferCompute);
+	renderGraph.Write(clusterCull, clusterIndices, RenderGraph::Usage::StorageBufferCompute);
+
+	RenderGraph::PassHandle gBuffer = renderGraph.AddPass("GBuffer", &GCommandBuffer, [this](VkCommandBuffer cmd) { RecordGPass(cmd); });
+	renderGraph.Read(gBuffer, clusterCommands, RenderGraph::Usage::DrawIndirect);
+	renderGraph.Read(gBuffer, clusterIndices, RenderGraph::Usage::DrawIndirect);
+	renderGraph.Write(gBuffer, position, RenderGraph::Usage::ColorAttachment);
+	renderGraph.Write(gBuffer, normal, RenderGraph::Usage::ColorAttachment);
+	renderGraph.Write(gBuffer, albedo, RenderGraph::Usage::ColorAttachment);
+	renderGraph.Write(gBuffer, velocity, RenderGraph::Usage::ColorAttachment);
+	renderGraph.Write(gBuffer, depth, RenderGraph::Usage::DepthAttachment);
+
+	RenderGraph::PassHandle lighting = renderGraph.AddPass("Lighting", &LightingCommandBuffer, [this](VkCommandBuffer cmd) { RecordLightingPass(cmd); });
+	renderGraph.Read(lighting, position, RenderGraph::Usage::SampledFragment);
+	renderGraph.Read(lighting, normal, RenderGraph::Usage::SampledFragment);
+	renderGraph.Read(lighting, albedo, RenderGraph::Usage::SampledFragment);
+	renderGraph.Read(lighting, cascades, RenderGraph::Usage::SampledFragment);
+	renderGraph.Read(lighting, pointShadows, RenderGraph::Usage::SampledFragment);
+	renderGraph.Read(lighting, lightBins, RenderGraph::Usage::StorageBufferFragment);
+	renderGraph.Write(lighting, composition, RenderGraph::Usage::ColorAttachment);
+
+	//Post, TAA, bloom, exposure, tonemap and the meshlet passes share one pool, so they are all recorded on the main thread.
+	//ImGui::Render has to happen there anyway
+	RenderGraph::PassHandle post = renderGraph.AddPass("Post", &PostCommandBuffer, [this](VkCommandBuffer cmd) { RecordPostPass(cmd); }, true);
+	renderGraph.Write(post, composition, RenderGraph::Usage::ColorAttachment);
+	renderGraph.Write(post, depth, RenderGraph::Usage::DepthAttachment);
+
+	//Every mip is written and read within the pass, like the bloom chain
+	RenderGraph::PassHandle pyramid = renderGraph.AddPass("DepthPyramid", &DepthPyramidCommandBuffer, [this](VkCommandBuffer cmd) { RecordDepthPyramidPass(cmd); }, true);
+	renderGraph.Read(pyramid, depth, RenderGraph::Usage::SampledCompute);
+	renderGraph.Write(pyramid, depthPyramid, RenderGraph::Usage::StorageCompute);
+
+	//Position only tells the sky apart, its motion comes from the camera
+	RenderGraph::PassHandle taa = renderGraph.AddPass("TAA", &TAACommandBuffer, [this](VkCommandBuffer cmd) { RecordTAAPass(cmd); }, true);
+	renderGraph.Read(taa, composition, RenderGraph::Usage::SampledCompute);
+	renderGraph.Read(taa, position, RenderGraph::Usage::SampledCompute);
+	renderGraph.Read(taa, velocity, RenderGraph::Usage::SampledCompute);
+	renderGraph.Read(taa, taaHistory, RenderGraph::Usage::SampledCompute);
+	renderGraph.Write(taa, taaOutput, RenderGraph::Usage::StorageCompute);
+
+	//Every mip of the chain is written and read within the pass, it stays in the general layout until the tonemap samples it
+	RenderGraph::PassHandle bloom = renderGraph.AddPass("Bloom", &BloomCommandBuffer, [this](VkCommandBuffer cmd) { RecordBloomPass(cmd); }, true);
+	renderGraph.Read(bloom, taaOutput, RenderGraph::Usage::SampledCompute);
+	renderGraph.Write(bloom, bloomChain, RenderGraph::Usage::StorageCompute);
+
+	//Needs the finished frame, so it runs on the graphics queue rather than next to other passes
+	RenderGraph::PassHandle exposure = renderGraph.AddPass("Exposure", &ExposureCommandBuffer, [this](VkCommandBuffer cmd) { RecordExposurePass(cmd); }, true);
+	renderGraph.Read(exposure, taaOutput, RenderGraph::Usage::SampledCompute);
+	renderGraph.Write(exposure, exposureData, RenderGraph::Usage::StorageBufferCompute);
+
+	RenderGraph::PassHandle tonemap = renderGraph.AddPass("Tonemap", &TonemapCommandBuffer, [this](VkCommandBuffer cmd) { RecordTonemapPass(cmd); }, true);
+	renderGraph.Read(tonemap, taaOutput, RenderGraph::Usage::SampledFragment);
+	renderGraph.Read(tonemap, bloomChain, RenderGraph::Usage::SampledFragment);
+	renderGraph.Read(tonemap, exposureData, RenderGraph::Usage::StorageBufferFragment);
+	renderGraph.Write(tonemap, swapchainImage, RenderGraph::Usage::ColorAttachment);
+
+	renderGraph.Compile();
 }
 
 void Demo::InitDescriptorPool()
@@ -544,7 +663,23 @@ void Demo::InitDescriptorPool()
 
 	VkDescriptorPoolSize ModelTexturesSize{};
 	ModelTexturesSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	ModelTexturesSize.descriptorCount = 1;//1 for diffuse
+	ModelTexturesSize.descriptorCount = MAX_BINDLESS_TEXTURES;//Whole bindless texture table
+
+	VkDescriptorPoolSize MaterialSize{};
+	MaterialSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	MaterialSize.descriptorCount = 1;//1 for material table
+
+	VkDescriptorPoolSize TransformSize{};
+	TransformSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	TransformSize.descriptorCount = 1;//1 for world matrices
+
+	VkDescriptorPoolSize PrevTransformSize{};
+	PrevTransformSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	PrevTransformSize.descriptorCount = 1;//1 for last frame's world matrices
+
+	VkDescriptorPoolSize ShadowTransformSize{};
+	ShadowTransformSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	ShadowTransformSize.descriptorCount = 2;//2 for world matrices of cascade & point shadow sets
 
 	VkDescriptorPoolSize cubemapSize{};
 	cubemapSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -558,98 +693,104 @@ void Demo::InitDescriptorPool()
 	ShadowDepthTextureSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	ShadowDepthTextureSize.descriptorCount = 1;//1 for depth
 
-	std::vector<VkDescriptorPoolSize> sPoolSizes = { shadowMatSize };
-	std::vector<VkDescriptorPoolSize> gPoolSizes = { matPoolsize, ModelTexturesSize };
-	std::vector<VkDescriptorPoolSize> lPoolSizes = { Lightpoolsize, GBufferAttachmentSize, shadowMatSize, ShadowDepthTextureSize };
-	std::vector<VkDescriptorPoolSize> pPoolSizes = { matPoolsize, cubemapSize };
+	VkDescriptorPoolSize pointShadowMatSize{};
+	pointShadowMatSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	pointShadowMatSize.descriptorCount = 1;//1 for cube face matrices of every atlas slot
+
+	VkDescriptorPoolSize PointShadowTextureSize{};
+	PointShadowTextureSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	PointShadowTextureSize.descriptorCount = 1;//1 for cube array depth
+
+	VkDescriptorPoolSize LightBinsSize{};
+	LightBinsSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	LightBinsSize.descriptorCount = 1;//1 for light masks per tile
+
+	VkDescriptorPoolSize HDRTextureSize{};
+	HDRTextureSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	HDRTextureSize.descriptorCount = 2;//2 for TAA output in histogram & tonemap sets
+
+	VkDescriptorPoolSize BloomTextureSize{};
+	BloomTextureSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	BloomTextureSize.descriptorCount = 3;//3 for TAA output & chain in bloom set, chain in tonemap set
+
+	VkDescriptorPoolSize BloomMipSize{};
+	BloomMipSize.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	BloomMipSize.descriptorCount = BLOOM_MIPS;//1 per mip of the chain
+
+	VkDescriptorPoolSize TAATextureSize{};
+	TAATextureSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	TAATextureSize.descriptorCount = 4;//4 for composition, position, velocity & history
+
+	VkDescriptorPoolSize TAAOutputSize{};
+	TAAOutputSize.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	TAAOutputSize.descriptorCount = 1;//1 for the resolved frame
+
+	VkDescriptorPoolSize ExposureSize{};
+	ExposureSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	ExposureSize.descriptorCount = 2;//2 for exposure data in histogram & tonemap sets
+
+	VkDescriptorPoolSize ShadowCompareTextureSize{};
+	ShadowCompareTextureSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	ShadowCompareTextureSize.descriptorCount = 1;//1 for cascades with compare sampler
+
+	VkDescriptorPoolSize ClusterBufferSize{};
+	ClusterBufferSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	ClusterBufferSize.descriptorCount = 5;//5 for meshlets, their indices, draws, commands & culled indices
+
+	VkDescriptorPoolSize DepthPyramidTextureSize{};
+	DepthPyramidTextureSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	DepthPyramidTextureSize.descriptorCount = 2;//2 for G-buffer depth & pyramid
+
+	VkDescriptorPoolSize DepthPyramidMipSize{};
+	DepthPyramidMipSize.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	DepthPyramidMipSize.descriptorCount = HIZ_MIPS;//1 per mip of the pyramid
+
+	std::vector<VkDescriptorPoolSize> sPoolSizes = { shadowMatSize, pointShadowMatSize, ShadowTransformSize };
+	std::vector<VkDescriptorPoolSize> gPoolSizes = { matPoolsize, ModelTexturesSize, MaterialSize, TransformSize, PrevTransformSize };
+	std::vector<VkDescriptorPoolSize> lPoolSizes = { matPoolsize, Lightpoolsize, GBufferAttachmentSize, cubemapSize, shadowMatSize, ShadowDepthTextureSize, PointShadowTextureSize, ShadowCompareTextureSize, LightBinsSize };
+	std::vector<VkDescriptorPoolSize> pPoolSizes = { matPoolsize, TransformSize };
+	std::vector<VkDescriptorPoolSize> cPoolSizes = { matPoolsize, Lightpoolsize, LightBinsSize };
+	std::vector<VkDescriptorPoolSize> tPoolSizes = { HDRTextureSize, BloomTextureSize, ExposureSize };
+	std::vector<VkDescriptorPoolSize> aPoolSizes = { matPoolsize, TAATextureSize, TAAOutputSize };
+	std::vector<VkDescriptorPoolSize> bPoolSizes = { BloomTextureSize, BloomMipSize };
+	std::vector<VkDescriptorPoolSize> mPoolSizes = { matPoolsize, TransformSize, ClusterBufferSize, DepthPyramidTextureSize, DepthPyramidMipSize };
 	
 	shadow_pass.CreateDescriptorPool(sPoolSizes);
-	geometry_pass.CreateDescriptorPool(gPoolSizes);
+	geometry_pass.CreateDescriptorPool(gPoolSizes, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
 	lighting_pass.CreateDescriptorPool(lPoolSizes);
 	post_pass.CreateDescriptorPool(pPoolSizes);
+	compute_pass.CreateDescriptorPool(cPoolSizes);
+	tonemap_pass.CreateDescriptorPool(tPoolSizes);
+	taa_pass.CreateDescriptorPool(aPoolSizes);
+	bloom_pass.CreateDescriptorPool(bPoolSizes);
+	cluster_pass.CreateDescriptorPool(mPoolSizes);
 }
 
 void Demo::InitDescriptorLayout()
 {
-	//Binding 0: view/projection mat & view vector
-	VkDescriptorSetLayoutBinding matLayoutBinding{};
-	matLayoutBinding.binding = 0;
-	matLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	matLayoutBinding.descriptorCount = 1;
-	matLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_GEOMETRY_BIT;
-	matLayoutBinding.pImmutableSamplers = nullptr;
-
-	//Binding 1: view/projection mat & view vector
-	VkDescriptorSetLayoutBinding lightLayoutBinding{};
-	lightLayoutBinding.binding = 1;
-	lightLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	lightLayoutBinding.descriptorCount = 1;
-	lightLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_GEOMETRY_BIT;
-	lightLayoutBinding.pImmutableSamplers = nullptr;
-
-	VkDescriptorSetLayoutBinding positionTextureBinding{};
-	positionTextureBinding.binding = 2;
-	positionTextureBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	positionTextureBinding.descriptorCount = 1;
-	positionTextureBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-	positionTextureBinding.pImmutableSamplers = nullptr;
-
-	VkDescriptorSetLayoutBinding normalTextureBinding{};
-	normalTextureBinding.binding = 3;
-	normalTextureBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	normalTextureBinding.descriptorCount = 1;
-	normalTextureBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-	normalTextureBinding.pImmutableSamplers = nullptr;
-
-	VkDescriptorSetLayoutBinding albedoTextureBinding{};
-	albedoTextureBinding.binding = 4;
-	albedoTextureBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	albedoTextureBinding.descriptorCount = 1;
-	albedoTextureBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-	albedoTextureBinding.pImmutableSamplers = nullptr;
-
-	VkDescriptorSetLayoutBinding diffuseTextureBinding{};
-	diffuseTextureBinding.binding = 5;
-	diffuseTextureBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	diffuseTextureBinding.descriptorCount = 1;
-	diffuseTextureBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-	diffuseTextureBinding.pImmutableSamplers = nullptr;
-
-	VkDescriptorSetLayoutBinding cubemapBinding{};
-	cubemapBinding.binding = 6;
-	cubemapBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	cubemapBinding.descriptorCount = 1;
-	cubemapBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-	cubemapBinding.pImmutableSamplers = nullptr;
-
-	VkDescriptorSetLayoutBinding lightMVPBinding{};
-	lightMVPBinding.binding = 7;
-	lightMVPBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	lightMVPBinding.descriptorCount = 1;
-	lightMVPBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-	lightMVPBinding.pImmutableSamplers = nullptr;
-
-	VkDescriptorSetLayoutBinding shadowDepthbinding{};
-	shadowDepthbinding.binding = 8;
-	shadowDepthbinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	shadowDepthbinding.descriptorCount = 1;
-	shadowDepthbinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-	shadowDepthbinding.pImmutableSamplers = nullptr;
-
-	std::vector<VkDescriptorSetLayoutBinding> SLayoutBinding = { lightMVPBinding };
-	shadow_pass.CreateDescriptorLayout(SLayoutBinding);
-
-	std::vector<VkDescriptorSetLayoutBinding> GLayoutBinding = { matLayoutBinding, diffuseTextureBinding };
-	geometry_pass.CreateDescriptorLayout(GLayoutBinding);
-
-	std::vector<VkDescriptorSetLayoutBinding> LLayoutBindings = { lightLayoutBinding, positionTextureBinding, normalTextureBinding, albedoTextureBinding, lightMVPBinding, shadowDepthbinding };
-	lighting_pass.CreateDescriptorLayout(LLayoutBindings);
-
-	std::vector<VkDescriptorSetLayoutBinding> PLayoutBindings = { matLayoutBinding };
-	post_pass.CreateDescriptorLayout(PLayoutBindings);
-
-	std::vector<VkDescriptorSetLayoutBinding> PSkyLayoutBindings = { matLayoutBinding, cubemapBinding };
-	post_pass.CreateSkyDescriptorLayout(PSkyLayoutBindings);
+	//Bindings and their stages come from the shaders, every pass uses set 0
+	shadow_pass.CreateDescriptorLayout(mShaders.ReflectSetLayout({ "Shadow.vert", "Shadow.frag" }));
+	shadow_pass.CreatePointDescriptorLayout(mShaders.ReflectSetLayout({ "PointShadow.vert", "PointShadow.geom", "PointShadow.frag" }));
+
+	//The runtime sized texture array is the bindless table, slots are texture streamer handles
+	std::vector<VkDescriptorBindingFlags> GBindingFlags;
+	std::vector<VkDescriptorSetLayoutBinding> GLayoutBinding = mShaders.ReflectSetLayout({ "GBuffer.vert", "GBuffer.frag" }, 0, MAX_BINDLESS_TEXTURES, &GBindingFlags);
+	geometry_pass.CreateDescriptorLayout(GLayoutBinding, GBindingFlags);
+
+	lighting_pass.CreateDescriptorLayout(mShaders.ReflectSetLayout({ "Lighting.vert", "Lighting.frag" }));
+
+	post_pass.CreateDescriptorLayout(mShaders.ReflectSetLayout({ "Base.vert", "NormalDebug.geom", "Base.frag" }));
+
+	compute_pass.CreateDescriptorLayout(mShaders.ReflectSetLayout({ "LightBinning.comp" }));
+
+	tonemap_pass.CreateDescriptorLayout(mShaders.ReflectSetLayout({ "Lighting.vert", "Tonemap.frag" }));
+	tonemap_pass.CreateExposureDescriptorLayout(mShaders.ReflectSetLayout({ "Histogram.comp", "Exposure.comp" }));
+
+	taa_pass.CreateDescriptorLayout(mShaders.ReflectSetLayout({ "TAA.comp" }));
+
+	bloom_pass.CreateDescriptorLayout(mShaders.ReflectSetLayout({ "BloomDownsample.comp", "BloomUpsample.comp" }));
+
+	cluster_pass.CreateDescriptorLayout(mShaders.ReflectSetLayout({ "ClusterCull.comp", "DepthPyramid.comp" }));
 }
 
 void Demo::InitDescriptorSet()
@@ -659,17 +800,24 @@ void Demo::InitDescriptorSet()
 	lighting_pass.CreateDescriptorSet();
 
 	post_pass.CreateDescriptorSet();
-	post_pass.CreateSkyDescriptorSet();
 
 	shadow_pass.CreateDescriptorSet();
-}
+	shadow_pass.CreatePointDescriptorSet();
 
-void Demo::BuildShadowCommandBuffer()
-{
-	ShadowCommandBuffer = mVulkanDevice->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, false);
+	compute_pass.CreateDescriptorSet();
+
+	tonemap_pass.CreateDescriptorSet();
+	tonemap_pass.CreateExposureDescriptorSet();
 
-	VkCommandBufferBeginInfo cmdBufInfo = initializers::commandBufferBeginInfo();
+	taa_pass.CreateDescriptorSet();
 
+	bloom_pass.CreateDescriptorSet();
+
+	cluster_pass.CreateDescriptorSet();
+}
+
+void Demo::RecordShadowPass(VkCommandBuffer commandBuffer)
+{
 	// Clear values for all attachments written in the fragment shader
 	std::array<VkClearValue, 1> clearValues;
 	clearValues[0].depthStencil = { 1.0f, 0 };
@@ -677,101 +825,305 @@ void Demo::BuildShadowCommandBuffer()
 
 	VkRenderPassBeginInfo renderPassBeginInfo = initializers::renderPassBeginInfo();
 	renderPassBeginInfo.renderPass = shadow_pass.mRenderPass;
-	renderPassBeginInfo.framebuffer = shadow_pass.mFrameBuffer;
 	renderPassBeginInfo.renderArea.extent.width = shadow_pass.mWidth;
 	renderPassBeginInfo.renderArea.extent.height = shadow_pass.mHeight;
 	renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 	renderPassBeginInfo.pClearValues = clearValues.data();
 
-	VK_CHECK_RESULT(vkBeginCommandBuffer(ShadowCommandBuffer, &cmdBufInfo))
-
-	vkCmdBeginRenderPass(ShadowCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-	VkViewport viewport = initializers::viewport((float)shadow_pass.mWidth, (float)shadow_pass.mHeight, 0.0f, 1.0f);
-	vkCmdSetViewport(ShadowCommandBuffer, 0, 1, &viewport);
+	jobSystem.Wait(shadowPipelines);
+	uint32_t shadowScope = gpuProfiler.BeginScope(commandBuffer, "Shadow");
 
-	VkRect2D scissor = initializers::rect2D(shadow_pass.mWidth, shadow_pass.mHeight, 0, 0);
-	vkCmdSetScissor(ShadowCommandBuffer, 0, 1, &scissor);
+	for (uint32_t cascade = 0; cascade < SHADOW_MAP_CASCADE_COUNT; ++cascade)
+	{
+		//Cascades not due this frame keep the depth they were rendered with last time
+		if ((cascadeUpdateMask & (1u << cascade)) == 0)
+		{
+			continue;
+		}
 
-	vkCmdBindPipeline(ShadowCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadow_pass.mPipeline);
+		renderPassBeginInfo.framebuffer = shadow_pass.mCascadeFrameBuffers[cascade];
+		vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-	vkCmdBindDescriptorSets(ShadowCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadow_pass.mPipelineLayout, 0, 1, &shadow_pass.mDescriptorSet, 0, nullptr);
+		std::vector<VkCommandBuffer> secondaries = commandRecorder.Record(shadow_pass.mRenderPass, shadow_pass.mCascadeFrameBuffers[cascade], static_cast<uint32_t>(objects.size()),
+			[this, cascade](VkCommandBuffer cmd, uint32_t begin, uint32_t end)
+		{
+			VkViewport viewport = initializers::viewport((float)shadow_pass.mWidth, (float)shadow_pass.mHeight, 0.0f, 1.0f);
+			vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+			VkRect2D scissor = initializers::rect2D(shadow_pass.mWidth, shadow_pass.mHeight, 0, 0);
+			vkCmdSetScissor(cmd, 0, 1, &scissor);
+
+			vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, shadow_pass.mPipeline);
+
+			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, shadow_pass.mPipelineLayout, 0, 1, &shadow_pass.mDescriptorSet, 0, nullptr);
+
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				Object* object = objects[i];
+				VkBuffer vertexBuffers[] = { object->mMesh->vertexBuffer };
+				VkDeviceSize offsets[] = { 0 };
+				vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
+				vkCmdBindIndexBuffer(cmd, object->mMesh->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+				CascadePushConstant pushConstant{ object->mTransform, cascade };
+				vkCmdPushConstants(cmd, shadow_pass.mPipelineLayout, shadow_pass.mPushConstants.stageFlags, 0, sizeof(CascadePushConstant), &pushConstant);
+				const Mesh::Lod& lod = object->mMesh->lods[object->mLod];
+				vkCmdDrawIndexed(cmd, lod.indexCount, 1, lod.firstIndex, 0, 0);
+			}
+		});
+		vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+		vkCmdEndRenderPass(commandBuffer);
+	}
 
-	for (Object* object : objects)
+	//Point light cubes, only the slots whose light or casters changed. Everything else stays cached in the atlas
+	if (pointShadowDirtyMask != 0)
 	{
-		VkBuffer vertexBuffers[] = { object->mMesh->vertexBuffer };
-		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(ShadowCommandBuffer, 0, 1, vertexBuffers, offsets);
-		glm::mat4 modelMat = object->BuildModelMat();
-		vkCmdPushConstants(ShadowCommandBuffer, shadow_pass.mPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &modelMat);
-		vkCmdDraw(ShadowCommandBuffer, static_cast<uint32_t>(object->mMesh->vertices.size()), 1, 0, 0);
+		VkRenderPassBeginInfo pointBeginInfo = initializers::renderPassBeginInfo();
+		pointBeginInfo.renderPass = shadow_pass.mPointRenderPass;
+		pointBeginInfo.framebuffer = shadow_pass.mPointFrameBuffer;
+		pointBeginInfo.renderArea.extent.width = shadow_pass.mPointSize;
+		pointBeginInfo.renderArea.extent.height = shadow_pass.mPointSize;
+		pointBeginInfo.clearValueCount = 0;
+		pointBeginInfo.pClearValues = nullptr;
+		vkCmdBeginRenderPass(commandBuffer, &pointBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+		std::vector<VkCommandBuffer> secondaries = commandRecorder.Record(shadow_pass.mPointRenderPass, shadow_pass.mPointFrameBuffer, static_cast<uint32_t>(objects.size()),
+			[this](VkCommandBuffer cmd, uint32_t begin, uint32_t end)
+		{
+			VkViewport viewport = initializers::viewport((float)shadow_pass.mPointSize, (float)shadow_pass.mPointSize, 0.0f, 1.0f);
+			vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+			VkRect2D scissor = initializers::rect2D(shadow_pass.mPointSize, shadow_pass.mPointSize, 0, 0);
+			vkCmdSetScissor(cmd, 0, 1, &scissor);
+
+			//The first chunk executes first, so it clears the dirty slots before anyone draws into them
+			if (begin == 0)
+			{
+				for (uint32_t slot = 0; slot < POINT_SHADOW_SLOTS; ++slot)
+				{
+					if ((pointShadowDirtyMask & (1u << slot)) == 0)
+					{
+						continue;
+					}
+
+					VkClearAttachment clearAttachment{};
+					clearAttachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+					clearAttachment.clearValue.depthStencil = { 1.0f, 0 };
+					VkClearRect clearRect{};
+					clearRect.rect = scissor;
+					clearRect.baseArrayLayer = slot * 6;
+					clearRect.layerCount = 6;
+					vkCmdClearAttachments(cmd, 1, &clearAttachment, 1, &clearRect);
+				}
+			}
+
+			vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, shadow_pass.mPointPipeline);
+			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, shadow_pass.mPointPipelineLayout, 0, 1, &shadow_pass.mPointDescriptorSet, 0, nullptr);
+
+			for (uint32_t slot = 0; slot < POINT_SHADOW_SLOTS; ++slot)
+			{
+				if ((pointShadowDirtyMask & (1u << slot)) == 0)
+				{
+					continue;
+				}
+
+				const glm::vec4& light = pointShadowData.lightPosRadius[slot];
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					//Casters outside the light range can't touch its cube
+					Object* object = objects[i];
+					const glm::vec4& bounds = objectBounds[i];
+					if (glm::length(glm::vec3(bounds) - glm::vec3(light)) > bounds.w + light.w)
+					{
+						continue;
+					}
+
+					VkBuffer vertexBuffers[] = { object->mMesh->vertexBuffer };
+					VkDeviceSize offsets[] = { 0 };
+					vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
+					vkCmdBindIndexBuffer(cmd, object->mMesh->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+					PointShadowPushConstant pushConstant{ object->mTransform, slot };
+					vkCmdPushConstants(cmd, shadow_pass.mPointPipelineLayout, shadow_pass.mPointPushConstants.stageFlags, 0, sizeof(PointShadowPushConstant), &pushConstant);
+					const Mesh::Lod& lod = object->mMesh->lods[object->mLod];
+					vkCmdDrawIndexed(cmd, lod.indexCount, 1, lod.firstIndex, 0, 0);
+				}
+			}
+		});
+		vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+		vkCmdEndRenderPass(commandBuffer);
 	}
-	vkCmdEndRenderPass(ShadowCommandBuffer);
 
-	VK_CHECK_RESULT(vkEndCommandBuffer(ShadowCommandBuffer));
+	gpuProfiler.EndScope(commandBuffer, shadowScope);
 }
 
-void Demo::BuildGCommandBuffer()
+void Demo::RecordGPass(VkCommandBuffer commandBuffer)
 {
-	GCommandBuffer = mVulkanDevice->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, false);
-
-	VkCommandBufferBeginInfo cmdBufInfo = initializers::commandBufferBeginInfo();
-
 	// Clear values for all attachments written in the fragment shader
-	std::array<VkClearValue, 4> clearValues;
+	std::array<VkClearValue, 5> clearValues;
 	clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
 	clearValues[1].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
 	clearValues[2].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
-	clearValues[3].depthStencil = { 1.0f, 0 };
+	clearValues[3].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+	clearValues[4].depthStencil = { 1.0f, 0 };
 
 	VkRenderPassBeginInfo renderPassBeginInfo = initializers::renderPassBeginInfo();
 	renderPassBeginInfo.renderPass = geometry_pass.mRenderPass;
 	renderPassBeginInfo.framebuffer = geometry_pass.mFrameBuffer;
-	renderPassBeginInfo.renderArea.extent.width = geometry_pass.mWidth;
-	renderPassBeginInfo.renderArea.extent.height = geometry_pass.mHeight;
+	renderPassBeginInfo.renderArea.extent.width = renderWidth;
+	renderPassBeginInfo.renderArea.extent.height = renderHeight;
 	renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 	renderPassBeginInfo.pClearValues = clearValues.data();
 
-	VK_CHECK_RESULT(vkBeginCommandBuffer(GCommandBuffer, &cmdBufInfo))
+	jobSystem.Wait(gPipelines);
 
-		vkCmdBeginRenderPass(GCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	uint32_t gScope = gpuProfiler.BeginScope(commandBuffer, "GBuffer");
+		vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 
-	VkViewport viewport = initializers::viewport((float)geometry_pass.mWidth, (float)geometry_pass.mHeight, 0.0f, 1.0f);
-	vkCmdSetViewport(GCommandBuffer, 0, 1, &viewport);
-
-	VkRect2D scissor = initializers::rect2D(geometry_pass.mWidth, geometry_pass.mHeight, 0, 0);
-	vkCmdSetScissor(GCommandBuffer, 0, 1, &scissor);
-
-	vkCmdBindPipeline(GCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, geometry_pass.mPipeline);
-
-	vkCmdBindDescriptorSets(GCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, geometry_pass.mPipelineLayout, 0, 1, &geometry_pass.mDescriptorSet, 0, nullptr);
+	const bool clusterCulled = clusterDrawCount > 0;
+	std::vector<VkCommandBuffer> secondaries = commandRecorder.Record(geometry_pass.mRenderPass, geometry_pass.mFrameBuffer, static_cast<uint32_t>(visibleObjects.size()),
+		[this, clusterCulled](VkCommandBuffer cmd, uint32_t begin, uint32_t end)
+	{
+		RecordGDraws(cmd, visibleObjects, begin, end, clusterCulled);
+	});
+	vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
 
 	int accumulatingVertices = 0;
 	int accumulatingFaces = 0;
-	for (Object* object : objects)
+	uint32_t accumulatingLods[MAX_MESH_LODS] = {};
+	for (uint32_t objectIndex : visibleObjects)
 	{
+		Object* object = objects[objectIndex];
 		accumulatingVertices += object->mMesh->vertexNum;
-		accumulatingFaces += object->mMesh->faceNum;
+		accumulatingFaces += static_cast<int>(object->mMesh->lods[object->mLod].indexCount / 3);
+		++accumulatingLods[object->mLod];
+	}
+	totalVertices = accumulatingVertices;
+	totalFaces = accumulatingFaces;
+	for (uint32_t level = 0; level < MAX_MESH_LODS; ++level)
+	{
+		lodCounts[level] = accumulatingLods[level];
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+	gpuProfiler.EndScope(commandBuffer, gScope);
+}
+
+void Demo::RecordGDraws(VkCommandBuffer cmd, const std::vector<uint32_t>& drawList, uint32_t begin, uint32_t end, bool clusterCulled)
+{
+	VkViewport viewport = initializers::viewport((float)renderWidth, (float)renderHeight, 0.0f, 1.0f);
+	vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+	VkRect2D scissor = initializers::rect2D(renderWidth, renderHeight, 0, 0);
+	vkCmdSetScissor(cmd, 0, 1, &scissor);
 
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, geometry_pass.mPipeline);
+
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, geometry_pass.mPipelineLayout, 0, 1, &geometry_pass.mDescriptorSet, 0, nullptr);
+
+	//drawList holds object indices, the recording benchmark repeats them to fake large scenes
+	for (uint32_t i = begin; i < end; ++i)
+	{
+		const uint32_t objectIndex = drawList[i];
+		Object* object = objects[objectIndex];
 		VkBuffer vertexBuffers[] = { object->mMesh->vertexBuffer };
 		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(GCommandBuffer, 0, 1, vertexBuffers, offsets);
-		glm::mat4 modelMat = object->BuildModelMat();
-		vkCmdPushConstants(GCommandBuffer, geometry_pass.mPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_GEOMETRY_BIT, 0, sizeof(glm::mat4), &modelMat);
-		vkCmdDraw(GCommandBuffer, static_cast<uint32_t>(object->mMesh->vertices.size()), 1, 0, 0);
+		vkCmdBindVertexBuffers(cmd, 0, 1, vertexBuffers, offsets);
+		GPushConstant pushConstant{};
+		pushConstant.transformIndex = object->mTransform;
+		pushConstant.materialIndex = object->mMaterial;
+		vkCmdPushConstants(cmd, geometry_pass.mPipelineLayout, geometry_pass.mPushConstants.stageFlags, 0, sizeof(GPushConstant), &pushConstant);
+		//Culled indices still point into the mesh's own vertex buffer, the command holds their count and offset
+		if (clusterCulled == true)
+		{
+			vkCmdBindIndexBuffer(cmd, cluster_pass.mIndices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdDrawIndexedIndirect(cmd, cluster_pass.mCommands.buffer, i * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+			continue;
+		}
+		vkCmdBindIndexBuffer(cmd, object->mMesh->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		const Mesh::Lod& lod = object->mMesh->lods[object->mLod];
+		vkCmdDrawIndexed(cmd, lod.indexCount, 1, lod.firstIndex, 0, 0);
 	}
-	totalVertices = accumulatingVertices;
-	totalFaces = accumulatingFaces;
+}
+
+void Demo::RunRecordBenchmark()
+{
+	//CPU cost of recording the G-buffer draw list only, nothing recorded here is submitted
+	static const uint32_t drawCounts[] = { 10000, 25000, 50000, 100000 };
+	const uint32_t repeats = 3;
+	const uint32_t savedThreads = commandRecorder.GetThreadCount();
+
+	jobSystem.Wait(gPipelines);
+	recordBenchmark.clear();
+	std::cout << "Command recording benchmark (best of " << repeats << ")\n";
+	for (uint32_t drawCount : drawCounts)
+	{
+		std::vector<uint32_t> drawList(drawCount);
+		for (uint32_t i = 0; i < drawCount; ++i)
+		{
+			drawList[i] = i % static_cast<uint32_t>(objects.size());
+		}
+		for (uint32_t threads = 1; threads <= commandRecorder.GetMaxThreads(); ++threads)
+		{
+			commandRecorder.SetThreadCount(threads);
+			float bestMs = FLT_MAX;
+			for (uint32_t repeat = 0; repeat < repeats; ++repeat)
+			{
+				commandRecorder.BeginFrame(frameTimeline.GetCompleted());
+				auto start = std::chrono::steady_clock::now();
+				commandRecorder.Record(geometry_pass.mRenderPass, geometry_pass.mFrameBuffer, drawCount,
+					[this, &drawList](VkCommandBuffer cmd, uint32_t begin, uint32_t end)
+				{
+					RecordGDraws(cmd, drawList, begin, end);
+				});
+				bestMs = std::min(bestMs, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+			}
+			recordBenchmark.push_back({ drawCount, threads, bestMs });
+			std::cout << "  " << drawCount << " draws, " << threads << " threads: " << bestMs << " ms\n";
+		}
+	}
+	commandRecorder.SetThreadCount(savedThreads);
+}
 
-	vkCmdEndRenderPass(GCommandBuffer);
+void Demo::RunJobBenchmark()
+{
+	//Scheduler overhead only, every job is empty
+	jobBenchmark = jobSystem.RunBenchmarks();
+	std::cout << "Job system benchmark (" << jobSystem.GetThreadCount() << " threads)\n";
+	for (const JobSystem::BenchmarkResult& result : jobBenchmark)
+	{
+		std::cout << "  " << result.name << ": " << result.nsPerJob << " ns/job over " << result.jobCount << " jobs\n";
+	}
+}
 
-	VK_CHECK_RESULT(vkEndCommandBuffer(GCommandBuffer));
+void Demo::RunObjBenchmark()
+{
+	//Parsing only, nothing is deduplicated or uploaded
+	objBenchmark = ObjParser::RunBenchmarks(objBenchmarkFile, &jobSystem, 3);
+	std::cout << "OBJ parsing benchmark of " << objBenchmarkFile << " (best of 3)\n";
+	for (const ObjParser::BenchmarkResult& result : objBenchmark)
+	{
+		std::cout << "  " << result.name << ", " << result.threadCount << " threads: " << result.ms << " ms\n";
+	}
 }
 
-void Demo::BuildLightCommandBuffer()
+void Demo::RecordLightBinningPass(VkCommandBuffer commandBuffer)
 {
-	VkCommandBufferBeginInfo cmdBufInfo = initializers::commandBufferBeginInfo();
+	LightBinPushConstant pushConstant{};
+	pushConstant.tileCount = glm::uvec2(compute_pass.mTilesX, compute_pass.mTilesY);
+	//Tiles past the rendered corner are binned too but never read
+	pushConstant.screenSize = glm::vec2(static_cast<float>(renderWidth), static_cast<float>(renderHeight));
+
+	jobSystem.Wait(computePipelines);
+	uint32_t binningScope = gpuProfiler.BeginScope(commandBuffer, "Light Binning");
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pass.mPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pass.mPipelineLayout, 0, 1, &compute_pass.mDescriptorSet, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, compute_pass.mPipelineLayout, compute_pass.mPushConstants.stageFlags, 0, sizeof(LightBinPushConstant), &pushConstant);
+	//8x8 tiles per workgroup
+	vkCmdDispatch(commandBuffer, (compute_pass.mTilesX + 7) / 8, (compute_pass.mTilesY + 7) / 8, 1);
+	gpuProfiler.EndScope(commandBuffer, binningScope);
+}
 
+void Demo::RecordLightingPass(VkCommandBuffer commandBuffer)
+{
 	VkClearValue clearValues[2];
 	clearValues[0].color = { {0.f, 0.f, 0.2f, 0.f} };
 	clearValues[1].depthStencil = { 1.f, 0 };
@@ -780,34 +1132,35 @@ void Demo::BuildLightCommandBuffer()
 	renderPassBeginInfo.renderPass = lighting_pass.mRenderPass;
 	renderPassBeginInfo.renderArea.offset.x = 0;
 	renderPassBeginInfo.renderArea.offset.y = 0;
-	renderPassBeginInfo.renderArea.extent.width = lighting_pass.mWidth;
-	renderPassBeginInfo.renderArea.extent.height = lighting_pass.mHeight;
+	renderPassBeginInfo.renderArea.extent.width = renderWidth;
+	renderPassBeginInfo.renderArea.extent.height = renderHeight;
 	renderPassBeginInfo.clearValueCount = 2;
 	renderPassBeginInfo.pClearValues = clearValues;
 
 	renderPassBeginInfo.framebuffer = lighting_pass.mFrameBuffer;
 
-	VK_CHECK_RESULT(vkBeginCommandBuffer(LightingCommandBuffer, &cmdBufInfo))
-		vkCmdBeginRenderPass(LightingCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-	VkViewport viewport = initializers::viewport((float)lighting_pass.mWidth, (float)lighting_pass.mHeight, 0.f, 1.f);
-	vkCmdSetViewport(LightingCommandBuffer, 0, 1, &viewport);
-	VkRect2D scissor = initializers::rect2D(lighting_pass.mWidth, lighting_pass.mHeight, 0, 0);
-	vkCmdSetScissor(LightingCommandBuffer, 0, 1, &scissor);
+	//Lighting is timed per shadow filter mode so the modes can be compared side by side
+	static const char* lightingScopeNames[SHADOW_FILTER_COUNT] = { "Lighting (Hard)", "Lighting (HW PCF)", "Lighting (Poisson)", "Lighting (PCSS)" };
 
-	vkCmdBindDescriptorSets(LightingCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lighting_pass.mPipelineLayout, 0, 1, &lighting_pass.mDescriptorSet, 0, nullptr);
+	jobSystem.Wait(lightPipelines);
+	uint32_t lightingScope = gpuProfiler.BeginScope(commandBuffer, lightingScopeNames[shadowFilterMode]);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	VkViewport viewport = initializers::viewport((float)renderWidth, (float)renderHeight, 0.f, 1.f);
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	VkRect2D scissor = initializers::rect2D(renderWidth, renderHeight, 0, 0);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-	vkCmdBindPipeline(LightingCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lighting_pass.mPipeline);
-	vkCmdDraw(LightingCommandBuffer, 3, 1, 0, 0);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lighting_pass.mPipelineLayout, 0, 1, &lighting_pass.mDescriptorSet, 0, nullptr);
 
-	vkCmdEndRenderPass(LightingCommandBuffer);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lighting_pass.mPipeline);
+	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
 
-	VK_CHECK_RESULT(vkEndCommandBuffer(LightingCommandBuffer));
+	vkCmdEndRenderPass(commandBuffer);
+	gpuProfiler.EndScope(commandBuffer, lightingScope);
 }
 
-void Demo::BuildPostCommandBuffer(int swapChianIndex)
+void Demo::RecordPostPass(VkCommandBuffer commandBuffer)
 {
-	VkCommandBufferBeginInfo cmdBufInfo = initializers::commandBufferBeginInfo();
-
 	// Clear values for all attachments written in the fragment shader
 	std::array<VkClearValue, 2> clearValues;
 	clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
@@ -816,24 +1169,25 @@ void Demo::BuildPostCommandBuffer(int swapChianIndex)
 	VkRenderPassBeginInfo renderPassBeginInfo = initializers::renderPassBeginInfo();
 	renderPassBeginInfo.renderPass = post_pass.mRenderPass;
 	renderPassBeginInfo.framebuffer = post_pass.mFrameBuffer;
-	renderPassBeginInfo.renderArea.extent.width = post_pass.mWidth;
-	renderPassBeginInfo.renderArea.extent.height = post_pass.mHeight;
+	renderPassBeginInfo.renderArea.extent.width = renderWidth;
+	renderPassBeginInfo.renderArea.extent.height = renderHeight;
 	renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 	renderPassBeginInfo.pClearValues = clearValues.data();
 
-	VK_CHECK_RESULT(vkBeginCommandBuffer(PostCommandBuffer, &cmdBufInfo))
+	jobSystem.Wait(postPipelines);
 
-	vkCmdBeginRenderPass(PostCommandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	uint32_t postScope = gpuProfiler.BeginScope(commandBuffer, "Post");
+	vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-	VkViewport viewport = initializers::viewport((float)post_pass.mWidth, (float)post_pass.mHeight, 0.0f, 1.0f);
-	vkCmdSetViewport(PostCommandBuffer, 0, 1, &viewport);
+	VkViewport viewport = initializers::viewport((float)renderWidth, (float)renderHeight, 0.0f, 1.0f);
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
-	VkRect2D scissor = initializers::rect2D(post_pass.mWidth, post_pass.mHeight, 0, 0);
-	vkCmdSetScissor(PostCommandBuffer, 0, 1, &scissor);
+	VkRect2D scissor = initializers::rect2D(renderWidth, renderHeight, 0, 0);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
 	//
-	vkCmdBindPipeline(PostCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, post_pass.mPipeline);
-	vkCmdBindDescriptorSets(PostCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, post_pass.mPipelineLayout, 0, 1, &post_pass.mDescriptorSet, 0, nullptr);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, post_pass.mPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, post_pass.mPipelineLayout, 0, 1, &post_pass.mDescriptorSet, 0, nullptr);
 
 	if (DrawNormal == true)
 	{
@@ -841,30 +1195,291 @@ void Demo::BuildPostCommandBuffer(int swapChianIndex)
 		{
 			VkBuffer vertexBuffers[] = { object->mMesh->vertexBuffer };
 			VkDeviceSize offsets[] = { 0 };
-			vkCmdBindVertexBuffers(PostCommandBuffer, 0, 1, vertexBuffers, offsets);
-			glm::mat4 modelMat = object->BuildModelMat();
-			vkCmdPushConstants(PostCommandBuffer, post_pass.mPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_GEOMETRY_BIT, 0, sizeof(glm::mat4), &modelMat);
-			vkCmdDraw(PostCommandBuffer, static_cast<uint32_t>(object->mMesh->vertices.size()), 1, 0, 0);
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+			vkCmdBindIndexBuffer(commandBuffer, object->mMesh->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdPushConstants(commandBuffer, post_pass.mPipelineLayout, post_pass.mPushConstants.stageFlags, 0, sizeof(uint32_t), &object->mTransform);
+			//Normals of the full mesh, the debug view shows the surface as authored
+			vkCmdDrawIndexed(commandBuffer, object->mMesh->lods[0].indexCount, 1, 0, 0, 0);
 		}
 	}
 	//
 
+	vkCmdEndRenderPass(commandBuffer);
+	gpuProfiler.EndScope(commandBuffer, postScope);
+}
 
-	//
-	vkCmdBindPipeline(PostCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, post_pass.mSkyPipeline);
-	vkCmdBindDescriptorSets(PostCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, post_pass.mSkyPipelineLayout, 0, 1, &post_pass.mSkyDescriptorSet, 0, nullptr);
-	VkBuffer vertexBuffers[] = { Skybox->vertexBuffer };
-	VkDeviceSize offsets[] = { 0 };
-	vkCmdBindVertexBuffers(PostCommandBuffer, 0, 1, vertexBuffers, offsets);
-	vkCmdDraw(PostCommandBuffer, static_cast<uint32_t>(Skybox->vertices.size()), 1, 0, 0);
-	//
+void Demo::RecordTAAPass(VkCommandBuffer commandBuffer)
+{
+	//Switched off, the pass only copies the frame so the graph stays the same
+	TAAPushConstant pushConstant{};
+	pushConstant.renderSize = glm::uvec2(renderWidth, renderHeight);
+	pushConstant.historyScale = glm::vec2(static_cast<float>(prevRenderWidth) / taa_pass.mWidth, static_cast<float>(prevRenderHeight) / taa_pass.mHeight);
+	pushConstant.blend = EnableTAA == true ? taaBlend : 1.f;
+	pushConstant.reset = taaReset == true ? 1u : 0u;
+	taaReset = false;
+
+	jobSystem.Wait(taaPipelines);
+	uint32_t taaScope = gpuProfiler.BeginScope(commandBuffer, "TAA");
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, taa_pass.mPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, taa_pass.mPipelineLayout, 0, 1, &taa_pass.mDescriptorSet, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, taa_pass.mPipelineLayout, taa_pass.mPushConstants.stageFlags, 0, sizeof(TAAPushConstant), &pushConstant);
+	vkCmdDispatch(commandBuffer, (renderWidth + 7) / 8, (renderHeight + 7) / 8, 1);
+	gpuProfiler.EndScope(commandBuffer, taaScope);
+}
+
+void Demo::RecordBloomPass(VkCommandBuffer commandBuffer)
+{
+	BloomPushConstant pushConstant{};
+	pushConstant.threshold = bloomThreshold;
+	pushConstant.knee = bloomThreshold * 0.5f;
+
+	//Each dispatch reads what the one before it wrote
+	VkMemoryBarrier mipBarrier{};
+	mipBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	mipBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	mipBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	jobSystem.Wait(bloomPipelines);
+	uint32_t bloomScope = gpuProfiler.BeginScope(commandBuffer, "Bloom");
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, bloom_pass.mPipelineLayout, 0, 1, &bloom_pass.mDescriptorSet, 0, nullptr);
+
+	//Down the chain, the first mip comes from the resolved frame
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, bloom_pass.mDownsamplePipeline);
+	for (uint32_t mip = 0; mip < BLOOM_MIPS; ++mip)
+	{
+		pushConstant.sourceSize = mip == 0 ? glm::uvec2(renderWidth, renderHeight)
+			: glm::uvec2(B_Pass::MipSize(renderWidth, mip - 1), B_Pass::MipSize(renderHeight, mip - 1));
+		pushConstant.targetSize = glm::uvec2(B_Pass::MipSize(renderWidth, mip), B_Pass::MipSize(renderHeight, mip));
+		pushConstant.sourceMip = mip == 0 ? 0 : mip - 1;
+		pushConstant.targetMip = mip;
+		vkCmdPushConstants(commandBuffer, bloom_pass.mPipelineLayout, bloom_pass.mPushConstants.stageFlags, 0, sizeof(BloomPushConstant), &pushConstant);
+		vkCmdDispatch(commandBuffer, (pushConstant.targetSize.x + 7) / 8, (pushConstant.targetSize.y + 7) / 8, 1);
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+			1, &mipBarrier, 0, nullptr, 0, nullptr);
+	}
 
+	//And back up, each mip gets everything below it added
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, bloom_pass.mUpsamplePipeline);
+	for (uint32_t mip = BLOOM_MIPS - 1; mip > 0; --mip)
+	{
+		pushConstant.sourceSize = glm::uvec2(B_Pass::MipSize(renderWidth, mip), B_Pass::MipSize(renderHeight, mip));
+		pushConstant.targetSize = glm::uvec2(B_Pass::MipSize(renderWidth, mip - 1), B_Pass::MipSize(renderHeight, mip - 1));
+		pushConstant.sourceMip = mip;
+		pushConstant.targetMip = mip - 1;
+		vkCmdPushConstants(commandBuffer, bloom_pass.mPipelineLayout, bloom_pass.mPushConstants.stageFlags, 0, sizeof(BloomPushConstant), &pushConstant);
+		vkCmdDispatch(commandBuffer, (pushConstant.targetSize.x + 7) / 8, (pushConstant.targetSize.y + 7) / 8, 1);
+		if (mip > 1)
+		{
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+				1, &mipBarrier, 0, nullptr, 0, nullptr);
+		}
+	}
+	gpuProfiler.EndScope(commandBuffer, bloomScope);
+}
+
+void Demo::RecordClusterCullPass(VkCommandBuffer commandBuffer)
+{
+	if (clusterDrawCount == 0)
+	{
+		return;
+	}
+
+	ClusterCullPushConstant pushConstant{};
+	pushConstant.cameraPosition = glm::vec4(camera->position, 1.f);
+	pushConstant.hiZSize = glm::uvec2(prevRenderWidth, prevRenderHeight);
+	pushConstant.coneCulling = EnableConeCulling == true ? 1 : 0;
+	pushConstant.occlusionCulling = EnableOcclusionCulling == true && pyramidValid == true ? 1 : 0;
+
+	//The next frame reads the index counts back for the GUI
+	VkMemoryBarrier readbackBarrier{};
+	readbackBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	readbackBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	readbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+	jobSystem.Wait(clusterPipelines);
+	uint32_t cullScope = gpuProfiler.BeginScope(commandBuffer, "ClusterCull");
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cluster_pass.mPipelineLayout, 0, 1, &cluster_pass.mDescriptorSet, 0, nullptr);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cluster_pass.mCullPipeline);
+	vkCmdPushConstants(commandBuffer, cluster_pass.mPipelineLayout, cluster_pass.mPushConstants.stageFlags, 0, sizeof(ClusterCullPushConstant), &pushConstant);
+	vkCmdDispatch(commandBuffer, clusterDrawCount, 1, 1);
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+		1, &readbackBarrier, 0, nullptr, 0, nullptr);
+	gpuProfiler.EndScope(commandBuffer, cullScope);
+}
+
+void Demo::RecordDepthPyramidPass(VkCommandBuffer commandBuffer)
+{
+	if (EnableClusterCulling == false || EnableOcclusionCulling == false)
+	{
+		return;
+	}
+
+	//Each dispatch reads the mip the one before it wrote
+	VkMemoryBarrier mipBarrier{};
+	mipBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	mipBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	mipBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	jobSystem.Wait(clusterPipelines);
+	uint32_t pyramidScope = gpuProfiler.BeginScope(commandBuffer, "DepthPyramid");
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cluster_pass.mPipelineLayout, 0, 1, &cluster_pass.mDescriptorSet, 0, nullptr);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cluster_pass.mPyramidPipeline);
+	for (uint32_t mip = 0; mip < HIZ_MIPS; ++mip)
+	{
+		DepthPyramidPushConstant pushConstant{};
+		pushConstant.sourceSize = mip == 0 ? glm::uvec2(renderWidth, renderHeight)
+			: glm::uvec2(M_Pass::PyramidSize(renderWidth, mip - 1), M_Pass::PyramidSize(renderHeight, mip - 1));
+		pushConstant.targetSize = glm::uvec2(M_Pass::PyramidSize(renderWidth, mip), M_Pass::PyramidSize(renderHeight, mip));
+		pushConstant.targetMip = mip;
+		vkCmdPushConstants(commandBuffer, cluster_pass.mPipelineLayout, cluster_pass.mPushConstants.stageFlags, 0, sizeof(DepthPyramidPushConstant), &pushConstant);
+		vkCmdDispatch(commandBuffer, (pushConstant.targetSize.x + 7) / 8, (pushConstant.targetSize.y + 7) / 8, 1);
+		if (mip + 1 < HIZ_MIPS)
+		{
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+				1, &mipBarrier, 0, nullptr, 0, nullptr);
+		}
+	}
+	gpuProfiler.EndScope(commandBuffer, pyramidScope);
+}
+
+void Demo::RecordExposurePass(VkCommandBuffer commandBuffer)
+{
+	//The histogram covers 2^-10 to 2^2, darker pixels go to the black bin and brighter ones to the last
+	ExposurePushConstant pushConstant{};
+	pushConstant.minLogLuminance = -10.f;
+	pushConstant.logLuminanceRange = 12.f;
+	//Covers the same share of the way every second whatever the frame rate
+	pushConstant.adaptation = 1.f - std::exp(-deltaTime * exposureAdaptRate);
+	pushConstant.compensation = exposureCompensation;
+	pushConstant.renderSize = glm::uvec2(renderWidth, renderHeight);
+
+	jobSystem.Wait(tonemapPipelines);
+	uint32_t exposureScope = gpuProfiler.BeginScope(commandBuffer, "Exposure");
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, tonemap_pass.mExposurePipelineLayout, 0, 1, &tonemap_pass.mExposureDescriptorSet, 0, nullptr);
+	vkCmdPushConstants(commandBuffer, tonemap_pass.mExposurePipelineLayout, tonemap_pass.mExposurePushConstants.stageFlags, 0, sizeof(ExposurePushConstant), &pushConstant);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, tonemap_pass.mHistogramPipeline);
+	vkCmdDispatch(commandBuffer, ((renderWidth + 1) / 2 + 15) / 16, ((renderHeight + 1) / 2 + 15) / 16, 1);
+
+	//Both dispatches are in the same pass, the graph only orders it against the others
+	VkMemoryBarrier histogramBarrier{};
+	histogramBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	histogramBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	histogramBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+		1, &histogramBarrier, 0, nullptr, 0, nullptr);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, tonemap_pass.mExposurePipeline);
+	vkCmdDispatch(commandBuffer, 1, 1, 1);
+	gpuProfiler.EndScope(commandBuffer, exposureScope);
+}
+
+void Demo::RecordTonemapPass(VkCommandBuffer commandBuffer)
+{
+	VkRenderPassBeginInfo renderPassBeginInfo = initializers::renderPassBeginInfo();
+	renderPassBeginInfo.renderPass = tonemap_pass.mRenderPass;
+	renderPassBeginInfo.framebuffer = mSwapChain->mSwapChainRenderDatas[swapchainIndex].mFrameBufferData.mFramebuffer;
+	renderPassBeginInfo.renderArea.extent.width = tonemap_pass.mWidth;
+	renderPassBeginInfo.renderArea.extent.height = tonemap_pass.mHeight;
+
+	jobSystem.Wait(tonemapPipelines);
+	vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	VkViewport viewport = initializers::viewport((float)tonemap_pass.mWidth, (float)tonemap_pass.mHeight, 0.f, 1.f);
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	VkRect2D scissor = initializers::rect2D(tonemap_pass.mWidth, tonemap_pass.mHeight, 0, 0);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	uint32_t tonemapScope = gpuProfiler.BeginScope(commandBuffer, "Tonemap");
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, tonemap_pass.mPipelineLayout, 0, 1, &tonemap_pass.mDescriptorSet, 0, nullptr);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, tonemap_pass.mPipeline);
+	//Bilinear upscale of the rendered corner to the whole swapchain
+	TonemapPushConstant pushConstant{};
+	pushConstant.uvScale = glm::vec2(static_cast<float>(renderWidth) / taa_pass.mWidth, static_cast<float>(renderHeight) / taa_pass.mHeight);
+	pushConstant.uvMax = pushConstant.uvScale - glm::vec2(0.5f / taa_pass.mWidth, 0.5f / taa_pass.mHeight);
+	pushConstant.sharpness = (renderWidth < taa_pass.mWidth) ? upscaleSharpness : 0.f;
+	//The first bloom mip holds half the rendered corner
+	glm::vec2 bloomSize = glm::vec2(B_Pass::MipSize(bloom_pass.mWidth, 0), B_Pass::MipSize(bloom_pass.mHeight, 0));
+	pushConstant.bloomScale = glm::vec2(bloom_pass.mWidth, bloom_pass.mHeight) * 0.5f / bloomSize;
+	pushConstant.bloomMax = (glm::vec2(B_Pass::MipSize(renderWidth, 0), B_Pass::MipSize(renderHeight, 0)) - 0.5f) / bloomSize;
+	//Every mip adds its own share into the first
+	pushConstant.bloomIntensity = EnableBloom == true ? bloomIntensity / BLOOM_MIPS : 0.f;
+	vkCmdPushConstants(commandBuffer, tonemap_pass.mPipelineLayout, tonemap_pass.mPushConstants.stageFlags, 0, sizeof(TonemapPushConstant), &pushConstant);
+	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+	gpuProfiler.EndScope(commandBuffer, tonemapScope);
+
+	//Drawn over the tonemapped image so the UI keeps its colors
 	ImGui::Render();
-	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), PostCommandBuffer);
+	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
 
-	vkCmdEndRenderPass(PostCommandBuffer);
+	vkCmdEndRenderPass(commandBuffer);
+}
 
-	VK_CHECK_RESULT(vkEndCommandBuffer(PostCommandBuffer));
+void Demo::UpdateFrameCamera()
+{
+	frameView = camera->getViewMatrix();
+	frameProj = glm::perspective(cameraFovY, mSwapChain->mSwapChainExtent.width / (float)mSwapChain->mSwapChainExtent.height, cameraNear, cameraFar);
+	frameProj[1][1] *= -1;
+}
+
+void Demo::UpdateTransforms()
+{
+	//Only dirty world matrices are rebuilt, the bounds are cheap enough to refresh for everyone
+	transforms.Update();
+
+	JobCounter boundsDone;
+	jobSystem.ParallelFor(static_cast<uint32_t>(objects.size()), OBJECT_JOB_GRAIN, [this](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			objectBounds[i] = objects[i]->GetWorldBounds(transforms.GetWorld(objects[i]->mTransform));
+		}
+	}, &boundsDone);
+	jobSystem.Wait(boundsDone);
+}
+
+void Demo::CullObjects()
+{
+	//Frustum planes straight from the rows of view-projection, depth runs from 0 to 1
+	const glm::mat4 viewProj = frameProj * frameView;
+	glm::vec4 rows[4];
+	for (int row = 0; row < 4; ++row)
+	{
+		rows[row] = glm::vec4(viewProj[0][row], viewProj[1][row], viewProj[2][row], viewProj[3][row]);
+	}
+	std::array<glm::vec4, 6> planes = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[2], rows[3] - rows[2] };
+	for (glm::vec4& plane : planes)
+	{
+		plane /= glm::length(glm::vec3(plane));
+	}
+
+	JobCounter culled;
+	jobSystem.ParallelFor(static_cast<uint32_t>(objects.size()), OBJECT_JOB_GRAIN, [this, &planes](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const glm::vec4& bounds = objectBounds[i];
+			uint8_t visible = 1;
+			for (const glm::vec4& plane : planes)
+			{
+				if (glm::dot(glm::vec3(plane), glm::vec3(bounds)) + plane.w < -bounds.w)
+				{
+					visible = 0;
+					break;
+				}
+			}
+			objectVisible[i] = visible;
+		}
+	}, &culled);
+	jobSystem.Wait(culled);
+
+	visibleObjects.clear();
+	for (uint32_t i = 0; i < objectVisible.size(); ++i)
+	{
+		if (objectVisible[i] != 0)
+		{
+			visibleObjects.push_back(i);
+		}
+	}
 }
 
 void Demo::UpdateUniformBuffer()
@@ -875,9 +1490,19 @@ void Demo::UpdateUniformBuffer()
 	float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
 
 	UniformBufferMat ubo{};
-	ubo.view = camera->getViewMatrix();
-	ubo.proj = glm::perspective(glm::radians(45.f), mSwapChain->mSwapChainExtent.width / (float)mSwapChain->mSwapChainExtent.height, 0.1f, 500.f);
-	ubo.proj[1][1] *= -1;
+	ubo.view = frameView;
+	ubo.proj = frameProj;
+	ubo.viewProj = frameProj * frameView;
+	ubo.prevViewProj = taaReset == true ? ubo.viewProj : prevViewProj;
+	ubo.invViewProj = glm::inverse(ubo.viewProj);
+	prevViewProj = ubo.viewProj;
+	if (EnableTAA == true)
+	{
+		//Sub-pixel offset from a Halton(2, 3) sequence, the resolve gathers the samples over frames
+		const uint32_t phase = static_cast<uint32_t>(frameNumber % TAA_JITTER_PHASES) + 1;
+		ubo.proj[2][0] += (Halton(phase, 2) - 0.5f) * 2.f / static_cast<float>(renderWidth);
+		ubo.proj[2][1] += (Halton(phase, 3) - 0.5f) * 2.f / static_cast<float>(renderHeight);
+	}
 	float radius = 10.f;
 	float rotateAmount = 0.f;
 	if (RotatingLight == true)
@@ -890,14 +1515,8 @@ void Demo::UpdateUniformBuffer()
 	}
 
 	//Calculate shadowing view & projection mat
-
-	glm::vec3 lightPos = lightsData.point_light[0].mPos + glm::vec3(0.f, 15.f, 0.f);
-	glm::mat4 lightProjection = glm::perspective(glm::radians(45.f), mSwapChain->mSwapChainExtent.width / (float)mSwapChain->mSwapChainExtent.height, 1.f, 96.f);
-	lightProjection[1][1] *= -1;
-	glm::mat4 lightView = glm::lookAt(lightPos, glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
-
-	lightMatData.lightMVP = lightProjection * lightView;
-	//lightMatData.lightMVP = ubo.proj * ubo.view;
+	UpdateCascades(frameView, frameProj, cameraNear, cameraFar);
+	UpdatePointShadows();
 	
 	//Update data
 	void* Matdata;
@@ -915,6 +1534,336 @@ void Demo::UpdateUniformBuffer()
 	vkMapMemory(mVulkanDevice->logicalDevice, lightMatUBO.memory, 0, sizeof(LightMatUBO), 0, &LightMVP);
 	memcpy(LightMVP, &lightMatData, sizeof(lightMatData));
 	vkUnmapMemory(mVulkanDevice->logicalDevice, lightMatUBO.memory);
+
+	void* PointShadowMat;
+	vkMapMemory(mVulkanDevice->logicalDevice, pointShadowUBO.memory, 0, sizeof(PointShadowUBO), 0, &PointShadowMat);
+	memcpy(PointShadowMat, &pointShadowData, sizeof(pointShadowData));
+	vkUnmapMemory(mVulkanDevice->logicalDevice, pointShadowUBO.memory);
+}
+
+void Demo::UpdateCascades(const glm::mat4& view, const glm::mat4& proj, float nearClip, float farClip)
+{
+	glm::vec3 sunDir = glm::normalize(lightsData.dir_light.mDir);
+
+	//Cached cascades are only valid while the light and the split scheme stay the same
+	bool updateAll = (cascadesValid == false) || (StaggerCascades == false)
+		|| (glm::dot(sunDir, cachedSunDir) < 0.9999f) || (cascadeSplitLambda != cachedSplitLambda);
+
+	//The nearest cascade refreshes every frame, the rest take turns
+	cascadeUpdateMask = 1u;
+	if (updateAll == true)
+	{
+		cascadeUpdateMask = (1u << SHADOW_MAP_CASCADE_COUNT) - 1u;
+	}
+	else
+	{
+		cascadeUpdateMask |= 1u << cascadeRoundRobin;
+		cascadeRoundRobin = (cascadeRoundRobin % (SHADOW_MAP_CASCADE_COUNT - 1)) + 1;
+	}
+	cascadesValid = true;
+	cachedSunDir = sunDir;
+	cachedSplitLambda = cascadeSplitLambda;
+
+	//Split the shadowed range with a blend of logarithmic and uniform distribution
+	float cascadeSplits[SHADOW_MAP_CASCADE_COUNT];
+	float shadowFar = std::min(farClip, cascadeMaxDistance);
+	float ratio = shadowFar / nearClip;
+	for (uint32_t i = 0; i < SHADOW_MAP_CASCADE_COUNT; ++i)
+	{
+		float p = (i + 1) / static_cast<float>(SHADOW_MAP_CASCADE_COUNT);
+		float logSplit = nearClip * std::pow(ratio, p);
+		float uniformSplit = nearClip + (shadowFar - nearClip) * p;
+		float d = cascadeSplitLambda * (logSplit - uniformSplit) + uniformSplit;
+		cascadeSplits[i] = (d - nearClip) / (farClip - nearClip);
+	}
+
+	glm::mat4 invCam = glm::inverse(proj * view);
+	//Bounding sphere of the slice of the view frustum each cascade covers this frame
+	glm::vec4 sliceBounds[SHADOW_MAP_CASCADE_COUNT];
+	float lastSplitDist = 0.f;
+	for (uint32_t i = 0; i < SHADOW_MAP_CASCADE_COUNT; ++i)
+	{
+		float splitDist = cascadeSplits[i];
+		lightMatData.cascadeSplits[i] = -(nearClip + splitDist * (farClip - nearClip));
+
+		glm::vec3 frustumCorners[8] = {
+			glm::vec3(-1.f,  1.f, 0.f),
+			glm::vec3( 1.f,  1.f, 0.f),
+			glm::vec3( 1.f, -1.f, 0.f),
+			glm::vec3(-1.f, -1.f, 0.f),
+			glm::vec3(-1.f,  1.f, 1.f),
+			glm::vec3( 1.f,  1.f, 1.f),
+			glm::vec3( 1.f, -1.f, 1.f),
+			glm::vec3(-1.f, -1.f, 1.f),
+		};
+
+		for (uint32_t j = 0; j < 8; ++j)
+		{
+			glm::vec4 corner = invCam * glm::vec4(frustumCorners[j], 1.f);
+			frustumCorners[j] = glm::vec3(corner) / corner.w;
+		}
+
+		//Cut the slice of the view frustum covered by this cascade
+		for (uint32_t j = 0; j < 4; ++j)
+		{
+			glm::vec3 dist = frustumCorners[j + 4] - frustumCorners[j];
+			frustumCorners[j + 4] = frustumCorners[j] + (dist * splitDist);
+			frustumCorners[j] = frustumCorners[j] + (dist * lastSplitDist);
+		}
+
+		glm::vec3 center = glm::vec3(0.f);
+		for (uint32_t j = 0; j < 8; ++j)
+		{
+			center += frustumCorners[j];
+		}
+		center /= 8.f;
+
+		//Bounding sphere keeps the cascade size constant while the camera rotates
+		float radius = 0.f;
+		for (uint32_t j = 0; j < 8; ++j)
+		{
+			radius = std::max(radius, glm::length(frustumCorners[j] - center));
+		}
+		sliceBounds[i] = glm::vec4(center, radius);
+		lastSplitDist = splitDist;
+	}
+
+	//Waiting cascades are fitted larger by how far the camera can get until their next turn. One the slice has
+	//left anyway, say after a turn of the camera, is refitted right away rather than clipping the shadows at its edge
+	const glm::vec3 cameraPos = glm::vec3(glm::inverse(view)[3]);
+	const float staggerMargin = updateAll == true ? 0.f : glm::length(cameraPos - cascadeCameraPos) * static_cast<float>(SHADOW_MAP_CASCADE_COUNT - 1);
+	cascadeCameraPos = cameraPos;
+	for (uint32_t i = 0; i < SHADOW_MAP_CASCADE_COUNT; ++i)
+	{
+		const glm::vec4& cached = cachedCascadeBounds[i];
+		if (glm::length(glm::vec3(sliceBounds[i]) - glm::vec3(cached)) + sliceBounds[i].w > cached.w)
+		{
+			cascadeUpdateMask |= 1u << i;
+		}
+	}
+
+	for (uint32_t i = 0; i < SHADOW_MAP_CASCADE_COUNT; ++i)
+	{
+		if ((cascadeUpdateMask & (1u << i)) != 0)
+		{
+			glm::vec3 center = glm::vec3(sliceBounds[i]);
+			float radius = sliceBounds[i].w;
+			if (i > 0)
+			{
+				radius += staggerMargin;
+			}
+			radius = std::ceil(radius * 16.f) / 16.f;
+			cachedCascadeBounds[i] = glm::vec4(center, radius);
+
+			glm::vec3 up = std::abs(sunDir.y) > 0.99f ? glm::vec3(0.f, 0.f, 1.f) : glm::vec3(0.f, 1.f, 0.f);
+			glm::mat4 lightView = glm::lookAt(center - sunDir * radius, center, up);
+			glm::mat4 lightOrtho = glm::ortho(-radius, radius, -radius, radius, 0.f, 2.f * radius);
+			lightOrtho[1][1] *= -1;
+
+			//Snap the projection to whole shadow map texels so edges don't shimmer while the camera moves
+			glm::vec4 shadowOrigin = (lightOrtho * lightView) * glm::vec4(0.f, 0.f, 0.f, 1.f);
+			shadowOrigin *= shadow_pass.mWidth / 2.f;
+			glm::vec4 roundOffset = (glm::round(shadowOrigin) - shadowOrigin) * (2.f / shadow_pass.mWidth);
+			roundOffset.z = 0.f;
+			roundOffset.w = 0.f;
+			lightOrtho[3] += roundOffset;
+
+			lightMatData.cascadeViewProj[i] = lightOrtho * lightView;
+		}
+	}
+
+	lightMatData.cameraView = view;
+	lightMatData.shadowFilter = glm::vec4(static_cast<float>(shadowFilterMode), static_cast<float>(shadowFilterTaps), shadowFilterRadius, shadowLightSize);
+}
+
+void Demo::UpdatePointShadows()
+{
+	//Cube face orientation matching the cube map sampling convention. The projection is not y-flipped for these.
+	static const glm::vec3 faceDirs[6] = {
+		glm::vec3( 1.f,  0.f,  0.f), glm::vec3(-1.f,  0.f,  0.f),
+		glm::vec3( 0.f,  1.f,  0.f), glm::vec3( 0.f, -1.f,  0.f),
+		glm::vec3( 0.f,  0.f,  1.f), glm::vec3( 0.f,  0.f, -1.f),
+	};
+	static const glm::vec3 faceUps[6] = {
+		glm::vec3(0.f, -1.f,  0.f), glm::vec3(0.f, -1.f,  0.f),
+		glm::vec3(0.f,  0.f,  1.f), glm::vec3(0.f,  0.f, -1.f),
+		glm::vec3(0.f, -1.f,  0.f), glm::vec3(0.f, -1.f,  0.f),
+	};
+
+	auto overlaps = [](const glm::vec4& a, const glm::vec4& b)
+	{
+		return glm::length(glm::vec3(a) - glm::vec3(b)) <= a.w + b.w;
+	};
+
+	pointShadowDirtyMask = 0;
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		PointLight& light = lightsData.point_light[i];
+		int slot = pointShadowAtlas.Acquire(i, frameNumber);
+		light.mShadowIndex = slot;
+		if (slot < 0)
+		{
+			continue;
+		}
+
+		glm::vec4 lightPosRadius = glm::vec4(light.mPos, light.mRadius);
+		bool dirty = pointShadowAtlas.IsDirty(slot) || (lightPosRadius != pointShadowAtlas.GetCachedLight(slot));
+
+		//A static light keeps its cube until a caster moves into, out of or within its range
+		for (size_t j = 0; j < objects.size() && dirty == false; ++j)
+		{
+			Object* object = objects[j];
+			if (transforms.WasUpdated(object->mTransform) == true || object->mLodChanged == true)
+			{
+				dirty = overlaps(objectBounds[j], lightPosRadius) || overlaps(object->mLastBounds, lightPosRadius);
+			}
+		}
+
+		if (dirty == false)
+		{
+			continue;
+		}
+
+		glm::mat4 faceProj = glm::perspective(glm::radians(90.f), 1.f, 0.05f, light.mRadius);
+		for (uint32_t face = 0; face < 6; ++face)
+		{
+			pointShadowData.faceViewProj[slot * 6 + face] = faceProj * glm::lookAt(light.mPos, light.mPos + faceDirs[face], faceUps[face]);
+		}
+		pointShadowData.lightPosRadius[slot] = lightPosRadius;
+
+		pointShadowAtlas.Store(slot, lightPosRadius);
+		pointShadowDirtyMask |= 1u << slot;
+	}
+
+	for (size_t i = 0; i < objects.size(); ++i)
+	{
+		objects[i]->mLastBounds = objectBounds[i];
+	}
+}
+
+void Demo::SelectLods(float viewportHeight)
+{
+	const float pixelsPerUnit = viewportHeight / (2.f * std::tan(cameraFovY * 0.5f));
+	JobCounter selected;
+	jobSystem.ParallelFor(static_cast<uint32_t>(objects.size()), OBJECT_JOB_GRAIN, [this, pixelsPerUnit](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			Object* object = objects[i];
+			const Mesh* mesh = object->mMesh;
+			const glm::vec4& bounds = objectBounds[i];
+			//Level errors are in mesh space, the world bounds carry the object's scale
+			const float scale = mesh->boundRadius > 0.f ? bounds.w / mesh->boundRadius : 1.f;
+
+			//Coarsest level whose error stays under the threshold. Going coarser needs some margin so an
+			//object sitting on a boundary doesn't pop back and forth, going finer happens right away
+			uint32_t lod = 0;
+			if (EnableLod == true)
+			{
+				for (uint32_t level = 1; level < static_cast<uint32_t>(mesh->lods.size()); ++level)
+				{
+					float threshold = level > object->mLod ? lodErrorPixels * lodHysteresis : lodErrorPixels;
+					if (camera->ProjectedError(mesh->lods[level].error * scale, bounds, pixelsPerUnit, cameraNear) > threshold)
+					{
+						break;
+					}
+					lod = level;
+				}
+			}
+			object->mLodChanged = lod != object->mLod || object->mMeshChanged == true;
+			object->mMeshChanged = false;
+			object->mLod = lod;
+		}
+	}, &selected);
+	jobSystem.Wait(selected);
+}
+
+void Demo::UpdateClusterDraws()
+{
+	//The last frame is finished, so are the commands its culling wrote
+	uint32_t triangles = 0;
+	for (uint32_t i = 0; i < clusterDrawCount; ++i)
+	{
+		triangles += cluster_pass.mMappedCommands[i].indexCount / 3;
+	}
+	clusterTriangles = triangles;
+
+	clusterDrawCount = 0;
+	if (EnableClusterCulling == false)
+	{
+		return;
+	}
+	//Every visible object is culled or none is, so a mesh without meshlets in the SSBO or too many indices
+	//drawn at once send the whole frame down the plain path
+	uint32_t drawnIndices = 0;
+	for (uint32_t objectIndex : visibleObjects)
+	{
+		const Object* object = objects[objectIndex];
+		if (object->mMesh->meshletBase == UINT32_MAX)
+		{
+			return;
+		}
+		drawnIndices += object->mMesh->lods[object->mLod].indexCount;
+	}
+	if (drawnIndices > cluster_pass.mMaxIndices)
+	{
+		return;
+	}
+	//Objects get their level's share of the compacted index buffer one after another
+	uint32_t firstIndex = 0;
+	for (uint32_t objectIndex : visibleObjects)
+	{
+		const Object* object = objects[objectIndex];
+		const Mesh::Lod& lod = object->mMesh->lods[object->mLod];
+		ClusterDraw& draw = cluster_pass.mMappedDraws[clusterDrawCount++];
+		draw.transformIndex = object->mTransform;
+		draw.firstMeshlet = object->mMesh->meshletBase + lod.firstMeshlet;
+		draw.meshletCount = lod.meshletCount;
+		draw.firstIndex = firstIndex;
+		firstIndex += lod.indexCount;
+	}
+}
+
+void Demo::ResolveMeshes()
+{
+	//Full SSBOs only cost the culling, those meshes keep drawing without it
+	for (Mesh* mesh : resources.TakeReadyMeshes())
+	{
+		cluster_pass.AddMesh(mesh);
+	}
+	Mesh* placeholder = resources.GetPlaceholderMesh();
+	for (Object* object : objects)
+	{
+		if (object->mMesh != placeholder || resources.IsReady(object->mMeshHandle) == false)
+		{
+			continue;
+		}
+		//Levels of the placeholder mean nothing for the new mesh, selection starts over
+		object->mMesh = resources.GetMesh(object->mMeshHandle);
+		object->mLod = 0;
+		object->mMeshChanged = true;
+	}
+}
+
+void Demo::UpdateTextureDemand(float viewportHeight)
+{
+	//Projected size of each visible object's bounding sphere decides how fine its texture needs to be
+	const float pixelsPerUnit = viewportHeight / (2.f * std::tan(cameraFovY * 0.5f));
+	for (uint32_t objectIndex : visibleObjects)
+	{
+		Object* object = objects[objectIndex];
+		const glm::vec4& bounds = objectBounds[objectIndex];
+		glm::vec3 toObject = glm::vec3(bounds) - camera->position;
+		float distance = glm::length(toObject);
+		float screenPixels = distance > bounds.w ? 2.f * bounds.w * pixelsPerUnit / distance : viewportHeight;
+		const Material& material = materials[object->mMaterial];
+		if (material.diffuseTexture >= 0)
+		{
+			textureStreamer.RequestPixels(static_cast<uint32_t>(material.diffuseTexture), screenPixels, frameNumber);
+		}
+	}
+	//The sky spans the screen whenever it is visible
+	textureStreamer.RequestMip(skyTexture, 0.f, frameNumber);
 }
 
 void Demo::UpdateDescriptorSet()
@@ -944,15 +1893,15 @@ void Demo::UpdateDescriptorSet()
 	texColorDisc.imageView = geometry_pass.mAlbedo.view;
 	texColorDisc.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-	VkDescriptorImageInfo modelDiffuseDisc;
-	modelDiffuseDisc.sampler = testImage.sampler;
-	modelDiffuseDisc.imageView = testImage.imageView;
-	modelDiffuseDisc.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	VkDescriptorBufferInfo MaterialBufferInfo{};
+	MaterialBufferInfo.buffer = materialSSBO.buffer;
+	MaterialBufferInfo.offset = 0;
+	MaterialBufferInfo.range = sizeof(Material) * materials.size();
+
+	VkDescriptorBufferInfo TransformBufferInfo = transforms.Descriptor();
+	VkDescriptorBufferInfo PrevTransformBufferInfo = transforms.PreviousDescriptor();
 
-	VkDescriptorImageInfo cubemapDisc;
-	cubemapDisc.sampler = testCubemap.sampler;
-	cubemapDisc.imageView = testCubemap.imageView;
-	cubemapDisc.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	VkDescriptorImageInfo cubemapDisc = textureStreamer.Descriptor(skyTexture);
 
 	VkDescriptorBufferInfo LightMatBufferInfo{};
 	LightMatBufferInfo.buffer = lightMatUBO.buffer;
@@ -964,42 +1913,213 @@ void Demo::UpdateDescriptorSet()
 	shadowDepthDisc.imageView = shadow_pass.mDepth.view;
 	shadowDepthDisc.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
+	VkDescriptorImageInfo shadowCompareDisc{};
+	shadowCompareDisc.sampler = shadowCompareSampler;
+	shadowCompareDisc.imageView = shadow_pass.mDepth.view;
+	shadowCompareDisc.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkDescriptorImageInfo pointShadowDepthDisc{};
+	pointShadowDepthDisc.sampler = shadowDepthSampler;
+	pointShadowDepthDisc.imageView = shadow_pass.mPointDepth.view;
+	pointShadowDepthDisc.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkDescriptorBufferInfo LightBinsBufferInfo{};
+	LightBinsBufferInfo.buffer = compute_pass.mLightBins;
+	LightBinsBufferInfo.offset = 0;
+	LightBinsBufferInfo.range = compute_pass.mLightBinsSize;
+
+	VkDescriptorImageInfo hdrCompositionDisc{};
+	hdrCompositionDisc.sampler = hdrSampler;
+	hdrCompositionDisc.imageView = lighting_pass.mComposition.view;
+	hdrCompositionDisc.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkDescriptorImageInfo texVelocityDisc{};
+	texVelocityDisc.sampler = colorSampler;
+	texVelocityDisc.imageView = geometry_pass.mVelocity.view;
+	texVelocityDisc.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	//The history slots trade places every frame
+	VkDescriptorImageInfo taaHistoryDisc{};
+	taaHistoryDisc.sampler = hdrSampler;
+	taaHistoryDisc.imageView = taa_pass.mHistory[taaOutputIndex ^ 1].view;
+	taaHistoryDisc.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkDescriptorImageInfo taaOutputDisc{};
+	taaOutputDisc.imageView = taa_pass.mHistory[taaOutputIndex].view;
+	taaOutputDisc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	VkDescriptorImageInfo taaResolvedDisc{};
+	taaResolvedDisc.sampler = hdrSampler;
+	taaResolvedDisc.imageView = taa_pass.mHistory[taaOutputIndex].view;
+	taaResolvedDisc.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	//Sampled by the tonemap, read and written mip by mip in the general layout by the bloom pass
+	VkDescriptorImageInfo bloomChainDisc{};
+	bloomChainDisc.sampler = hdrSampler;
+	bloomChainDisc.imageView = bloom_pass.mChain.view;
+	bloomChainDisc.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkDescriptorImageInfo bloomSourceDisc = bloomChainDisc;
+	bloomSourceDisc.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	std::array<VkDescriptorImageInfo, BLOOM_MIPS> bloomMipDiscs{};
+	for (uint32_t mip = 0; mip < BLOOM_MIPS; ++mip)
+	{
+		bloomMipDiscs[mip].imageView = bloom_pass.mMipViews[mip];
+		bloomMipDiscs[mip].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	}
+
+	VkDescriptorBufferInfo MeshletBufferInfo = { cluster_pass.mMeshlets.buffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo MeshletIndexBufferInfo = { cluster_pass.mMeshletIndices.buffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo ClusterDrawBufferInfo = { cluster_pass.mDraws.buffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo ClusterCommandBufferInfo = { cluster_pass.mCommands.buffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo ClusterIndexBufferInfo = { cluster_pass.mIndices.buffer, 0, VK_WHOLE_SIZE };
+
+	//The pyramid is sampled by the culling and written mip by mip in the general layout
+	VkDescriptorImageInfo sceneDepthDisc{};
+	sceneDepthDisc.sampler = colorSampler;
+	sceneDepthDisc.imageView = cluster_pass.mDepthView;
+	sceneDepthDisc.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkDescriptorImageInfo depthPyramidDisc{};
+	depthPyramidDisc.sampler = colorSampler;
+	depthPyramidDisc.imageView = cluster_pass.mPyramid.view;
+	depthPyramidDisc.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	std::array<VkDescriptorImageInfo, HIZ_MIPS> depthPyramidMipDiscs{};
+	for (uint32_t mip = 0; mip < HIZ_MIPS; ++mip)
+	{
+		depthPyramidMipDiscs[mip].imageView = cluster_pass.mMipViews[mip];
+		depthPyramidMipDiscs[mip].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	}
+
+	VkDescriptorBufferInfo ExposureBufferInfo{};
+	ExposureBufferInfo.buffer = tonemap_pass.mExposureBuffer;
+	ExposureBufferInfo.offset = 0;
+	ExposureBufferInfo.range = sizeof(ExposureData);
+
+	VkDescriptorBufferInfo PointShadowBufferInfo{};
+	PointShadowBufferInfo.buffer = pointShadowUBO.buffer;
+	PointShadowBufferInfo.offset = 0;
+	PointShadowBufferInfo.range = sizeof(PointShadowUBO);
+
 	std::vector<VkWriteDescriptorSet> GBufWriteDescriptorSets;
 	GBufWriteDescriptorSets = {
 		initializers::writeDescriptorSet(geometry_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &MatBufferInfo),
-		initializers::writeDescriptorSet(geometry_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 5, &modelDiffuseDisc)
+		initializers::writeDescriptorSet(geometry_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 12, &MaterialBufferInfo),
+		initializers::writeDescriptorSet(geometry_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 13, &TransformBufferInfo),
+		initializers::writeDescriptorSet(geometry_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 17, &PrevTransformBufferInfo)
 	};
+	//Bindless slots are only rewritten when the streamer swapped the texture's image
+	std::vector<uint32_t> changedTextures = textureStreamer.TakeChangedTextures();
+	std::vector<VkDescriptorImageInfo> bindlessDiscs;
+	bindlessDiscs.reserve(changedTextures.size());
+	for (uint32_t handle : changedTextures)
+	{
+		if (textureStreamer.IsCubemap(handle) == true)
+		{
+			continue;//Sampled through binding 6
+		}
+		bindlessDiscs.push_back(textureStreamer.Descriptor(handle));
+		VkWriteDescriptorSet bindlessWrite = initializers::writeDescriptorSet(geometry_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 5, &bindlessDiscs.back());
+		bindlessWrite.dstArrayElement = handle;
+		GBufWriteDescriptorSets.push_back(bindlessWrite);
+	}
 	geometry_pass.UpdateDescriptorSet(GBufWriteDescriptorSets);
 
 	std::vector<VkWriteDescriptorSet> lightWriteDescriptorSets;
 	lightWriteDescriptorSets = {
+		initializers::writeDescriptorSet(lighting_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &MatBufferInfo),
 		initializers::writeDescriptorSet(lighting_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, &LightbufferInfo),
 		initializers::writeDescriptorSet(lighting_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2, &texPosDisc),
 		initializers::writeDescriptorSet(lighting_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3, &texNormalDisc),
 		initializers::writeDescriptorSet(lighting_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4, &texColorDisc),
+		initializers::writeDescriptorSet(lighting_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 6, &cubemapDisc),
 		initializers::writeDescriptorSet(lighting_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 7, &LightMatBufferInfo),
-		initializers::writeDescriptorSet(lighting_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 8, &shadowDepthDisc)
+		initializers::writeDescriptorSet(lighting_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 8, &shadowDepthDisc),
+		initializers::writeDescriptorSet(lighting_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 9, &pointShadowDepthDisc),
+		initializers::writeDescriptorSet(lighting_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 11, &shadowCompareDisc),
+		initializers::writeDescriptorSet(lighting_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 14, &LightBinsBufferInfo)
 	};
 	lighting_pass.UpdateDescriptorSet(lightWriteDescriptorSets);
+
+	std::vector<VkWriteDescriptorSet> CBufWriteDescriptorSets;
+	CBufWriteDescriptorSets = {
+		initializers::writeDescriptorSet(compute_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &MatBufferInfo),
+		initializers::writeDescriptorSet(compute_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, &LightbufferInfo),
+		initializers::writeDescriptorSet(compute_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 14, &LightBinsBufferInfo)
+	};
+	compute_pass.UpdateDescriptorSet(CBufWriteDescriptorSets);
+
+	std::vector<VkWriteDescriptorSet> TBufWriteDescriptorSets;
+	TBufWriteDescriptorSets = {
+		initializers::writeDescriptorSet(tonemap_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 15, &taaResolvedDisc),
+		initializers::writeDescriptorSet(tonemap_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 16, &ExposureBufferInfo),
+		initializers::writeDescriptorSet(tonemap_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 21, &bloomChainDisc)
+	};
+	tonemap_pass.UpdateDescriptorSet(TBufWriteDescriptorSets);
+
+	std::vector<VkWriteDescriptorSet> TExposureWriteDescriptorSets;
+	TExposureWriteDescriptorSets = {
+		initializers::writeDescriptorSet(tonemap_pass.mExposureDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 15, &taaResolvedDisc),
+		initializers::writeDescriptorSet(tonemap_pass.mExposureDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 16, &ExposureBufferInfo)
+	};
+	tonemap_pass.UpdateExposureDescriptorSet(TExposureWriteDescriptorSets);
+
+	std::vector<VkWriteDescriptorSet> ABufWriteDescriptorSets;
+	ABufWriteDescriptorSets = {
+		initializers::writeDescriptorSet(taa_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &MatBufferInfo),
+		initializers::writeDescriptorSet(taa_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2, &texPosDisc),
+		initializers::writeDescriptorSet(taa_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 15, &hdrCompositionDisc),
+		initializers::writeDescriptorSet(taa_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 18, &texVelocityDisc),
+		initializers::writeDescriptorSet(taa_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 19, &taaHistoryDisc),
+		initializers::writeDescriptorSet(taa_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 20, &taaOutputDisc)
+	};
+	taa_pass.UpdateDescriptorSet(ABufWriteDescriptorSets);
+
+	std::vector<VkWriteDescriptorSet> BBufWriteDescriptorSets;
+	BBufWriteDescriptorSets = {
+		initializers::writeDescriptorSet(bloom_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 15, &taaResolvedDisc),
+		initializers::writeDescriptorSet(bloom_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 21, &bloomSourceDisc),
+		initializers::writeDescriptorSet(bloom_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 22, bloomMipDiscs.data(), BLOOM_MIPS)
+	};
+	bloom_pass.UpdateDescriptorSet(BBufWriteDescriptorSets);
+
+	std::vector<VkWriteDescriptorSet> MBufWriteDescriptorSets;
+	MBufWriteDescriptorSets = {
+		initializers::writeDescriptorSet(cluster_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &MatBufferInfo),
+		initializers::writeDescriptorSet(cluster_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 13, &TransformBufferInfo),
+		initializers::writeDescriptorSet(cluster_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 23, &MeshletBufferInfo),
+		initializers::writeDescriptorSet(cluster_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 24, &MeshletIndexBufferInfo),
+		initializers::writeDescriptorSet(cluster_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 25, &ClusterDrawBufferInfo),
+		initializers::writeDescriptorSet(cluster_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 26, &ClusterCommandBufferInfo),
+		initializers::writeDescriptorSet(cluster_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 27, &ClusterIndexBufferInfo),
+		initializers::writeDescriptorSet(cluster_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 28, &sceneDepthDisc),
+		initializers::writeDescriptorSet(cluster_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 29, &depthPyramidDisc),
+		initializers::writeDescriptorSet(cluster_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 30, depthPyramidMipDiscs.data(), HIZ_MIPS)
+	};
+	cluster_pass.UpdateDescriptorSet(MBufWriteDescriptorSets);
 	
 	std::vector<VkWriteDescriptorSet> PBufWriteDescriptorSets;
 	PBufWriteDescriptorSets = {
 		initializers::writeDescriptorSet(post_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &MatBufferInfo),
+		initializers::writeDescriptorSet(post_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 13, &TransformBufferInfo),
 	};
 	post_pass.UpdateDescriptorSet(PBufWriteDescriptorSets);
 
-	std::vector<VkWriteDescriptorSet> PSkyBufWriteDescriptorSets;
-	PSkyBufWriteDescriptorSets = {
-		initializers::writeDescriptorSet(post_pass.mSkyDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &MatBufferInfo),
-		initializers::writeDescriptorSet(post_pass.mSkyDescriptorSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 6, &cubemapDisc)
-	};
-	post_pass.UpdateSkyDescriptorSet(PSkyBufWriteDescriptorSets);
-
 	std::vector<VkWriteDescriptorSet> SBufWriteDescriptorSets;
 	SBufWriteDescriptorSets = {
 		initializers::writeDescriptorSet(shadow_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 7, &LightMatBufferInfo),
+		initializers::writeDescriptorSet(shadow_pass.mDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 13, &TransformBufferInfo),
 	};
 	shadow_pass.UpdateDescriptorSet(SBufWriteDescriptorSets);
+
+	std::vector<VkWriteDescriptorSet> SPointBufWriteDescriptorSets;
+	SPointBufWriteDescriptorSets = {
+		initializers::writeDescriptorSet(shadow_pass.mPointDescriptorSet, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 10, &PointShadowBufferInfo),
+		initializers::writeDescriptorSet(shadow_pass.mPointDescriptorSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 13, &TransformBufferInfo),
+	};
+	shadow_pass.UpdatePointDescriptorSet(SPointBufWriteDescriptorSets);
 	//TODO: UpdateԼ ⼭ °  ƺδ.
 }
 
@@ -1046,7 +2166,7 @@ void Demo::InitGUI()
 	init_info.Device = mVulkanDevice->logicalDevice;
 	init_info.QueueFamily = mVulkanDevice->getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT);
 	init_info.Queue = mGraphicsQueue;
-	init_info.PipelineCache = VK_NULL_HANDLE;
+	init_info.PipelineCache = mPipelineCache;
 	init_info.DescriptorPool = mImguiDescPool;
 	init_info.Subpass = subpassID;
 	init_info.MinImageCount = 2;
@@ -1073,8 +2193,252 @@ void Demo::DrawGUI()
 	ImGui::Text("Total Vertices: %d", totalVertices);
 	ImGui::Text("Total Faces: %d", totalFaces);
 
+	if (ImGui::CollapsingHeader("Job System"))
+	{
+		JobSystem::Stats jobStats = jobSystem.GetStats();
+		ImGui::Text("Threads: %u, visible objects: %u / %u", jobSystem.GetThreadCount(),
+			static_cast<uint32_t>(visibleObjects.size()), static_cast<uint32_t>(objects.size()));
+		ImGui::Text("Jobs executed: %llu, stolen: %llu", static_cast<unsigned long long>(jobStats.executed),
+			static_cast<unsigned long long>(jobStats.stolen));
+		if (ImGui::Button("Run Job Benchmarks"))
+		{
+			runJobBenchmark = true;
+		}
+		for (const JobSystem::BenchmarkResult& result : jobBenchmark)
+		{
+			ImGui::Text("%s: %.1f ns/job (%u jobs)", result.name.c_str(), result.nsPerJob, result.jobCount);
+		}
+	}
+
+	if (ImGui::CollapsingHeader("Model Loading"))
+	{
+		ResourceManager::Stats resourceStats = resources.GetStats();
+		ImGui::Text("Meshes: %u loaded from %u requests, %u loading, %u failed", resourceStats.meshCount - resourceStats.meshesLoading - resourceStats.meshesFailed,
+			resourceStats.meshRequests, resourceStats.meshesLoading, resourceStats.meshesFailed);
+		ImGui::Text("Textures: %u from %u requests", resourceStats.textureCount, resourceStats.textureRequests);
+		ImGui::Text("Last mesh loaded in %.2f ms", resourceStats.lastLoadMs);
+		ImGui::InputText("OBJ File", objBenchmarkFile, sizeof(objBenchmarkFile));
+		if (ImGui::Button("Run Parsing Benchmark"))
+		{
+			runObjBenchmark = true;
+		}
+		for (const ObjParser::BenchmarkResult& result : objBenchmark)
+		{
+			ImGui::Text("%s, %2u threads: %.2f ms", result.name.c_str(), result.threadCount, result.ms);
+		}
+	}
+
+	if (ImGui::CollapsingHeader("Pipelines"))
+	{
+		ImGui::Text("All pipelines built in %.1f ms, %u shader modules", mPipelineBuilder.GetWallMs(), mPipelineBuilder.GetModuleCount());
+		for (const PipelineBuildService::BuildTiming& timing : mPipelineBuilder.GetTimings())
+		{
+			ImGui::Text("%s: %.2f ms", timing.name.c_str(), timing.ms);
+		}
+		ImGui::Text("Watching %u shaders, %u reloads, %u pipelines rebuilt", mShaders.GetSourceCount(), mShaders.GetReloadCount(), mPipelineBuilder.GetRebuildCount());
+		std::string shaderError = mShaders.GetLastError();
+		if (shaderError.empty() == false)
+		{
+			ImGui::TextWrapped("Last error: %s", shaderError.c_str());
+		}
+		std::string rebuildError = mPipelineBuilder.GetLastRebuildError();
+		if (rebuildError.empty() == false)
+		{
+			ImGui::TextWrapped("Last failed rebuild: %s", rebuildError.c_str());
+		}
+		if (ImGui::TreeNode("Shader Log"))
+		{
+			for (const std::string& line : mShaders.GetLog())
+			{
+				ImGui::TextUnformatted(line.c_str());
+			}
+			ImGui::TreePop();
+		}
+	}
+
+	if (ImGui::CollapsingHeader("Render Graph"))
+	{
+		const RenderGraph::Stats& graphStats = renderGraph.GetStats();
+		ImGui::Text("Passes: %u, culled: %u", graphStats.passCount, graphStats.culledCount);
+		for (const std::string& name : graphStats.culledPasses)
+		{
+			ImGui::BulletText("%s culled, nothing uses its results", name.c_str());
+		}
+		ImGui::Text("Barriers: %u in %u batches, 1 submit", graphStats.barrierCount, graphStats.batchCount);
+		ImGui::Text("Async compute passes: %u on a %s queue", graphStats.asyncPassCount,
+			mVulkanDevice->queueFamilyIndices.compute != mVulkanDevice->queueFamilyIndices.graphics ? "dedicated" : "shared");
+		ImGui::Text("Transients: %u, %u aliased, %.1f MB in %.1f MB", graphStats.transientCount, graphStats.aliasedCount,
+			graphStats.transientBytes / (1024.f * 1024.f), graphStats.allocatedBytes / (1024.f * 1024.f));
+	}
+
+	if (ImGui::CollapsingHeader("Exposure"))
+	{
+		ImGui::SliderFloat("Compensation (EV)", &exposureCompensation, -4.f, 4.f);
+		ImGui::SliderFloat("Adaptation Rate", &exposureAdaptRate, 0.1f, 10.f);
+		ImGui::Text("Composition: %s", lighting_pass.mComposition.format == VK_FORMAT_B10G11R11_UFLOAT_PACK32 ? "B10G11R11" : "RGBA16F");
+		float hdrMs = gpuProfiler.GetScopeMs("Exposure") + gpuProfiler.GetScopeMs("Tonemap");
+		ImGui::Text("Histogram + exposure + tonemap: %.3f / %.3f ms%s", hdrMs, hdrBudgetMs, hdrMs > hdrBudgetMs ? " (over budget)" : "");
+	}
+
+	if (ImGui::CollapsingHeader("Anti-aliasing"))
+	{
+		if (ImGui::Checkbox("TAA", &EnableTAA) && EnableTAA == true)
+		{
+			taaReset = true;
+		}
+		ImGui::SliderFloat("Blend", &taaBlend, 0.02f, 0.5f);
+		ImGui::Text("Resolve: %.3f ms", gpuProfiler.GetScopeMs("TAA"));
+	}
+
+	if (ImGui::CollapsingHeader("Bloom"))
+	{
+		ImGui::Checkbox("Enable Bloom", &EnableBloom);
+		ImGui::SliderFloat("Intensity", &bloomIntensity, 0.f, 1.f);
+		ImGui::SliderFloat("Threshold", &bloomThreshold, 0.f, 4.f);
+		ImGui::Text("%u mips: %.3f ms", BLOOM_MIPS, gpuProfiler.GetScopeMs("Bloom"));
+	}
+
+	if (ImGui::CollapsingHeader("Level of Detail"))
+	{
+		ImGui::Checkbox("Enable LOD", &EnableLod);
+		ImGui::SliderFloat("Error (pixels)", &lodErrorPixels, 0.25f, 8.f);
+		ImGui::SliderFloat("Hysteresis", &lodHysteresis, 0.25f, 1.f);
+		for (uint32_t level = 0; level < MAX_MESH_LODS; ++level)
+		{
+			ImGui::Text("LOD %u: %u objects", level, lodCounts[level]);
+		}
+	}
+
+	if (ImGui::CollapsingHeader("Meshlet Culling"))
+	{
+		ImGui::Checkbox("Enable Meshlet Culling", &EnableClusterCulling);
+		ImGui::Checkbox("Cone Culling", &EnableConeCulling);
+		ImGui::Checkbox("Occlusion Culling", &EnableOcclusionCulling);
+		ImGui::Text("Triangles drawn: %u of %d", clusterTriangles, totalFaces);
+		ImGui::Text("Culling: %.3f ms", gpuProfiler.GetScopeMs("ClusterCull"));
+		ImGui::Text("Depth pyramid: %.3f ms", gpuProfiler.GetScopeMs("DepthPyramid"));
+	}
+
+	if (ImGui::CollapsingHeader("Dynamic Resolution"))
+	{
+		DynamicResolution::Settings& settings = dynamicResolution.GetSettings();
+		ImGui::Checkbox("Controller", &DynamicResolutionOn);
+		if (DynamicResolutionOn == true)
+		{
+			ImGui::SliderFloat("Target (ms)", &settings.targetMs, 4.f, 33.f);
+			ImGui::SliderFloat("Min Scale", &settings.minScale, 0.25f, 1.f);
+		}
+		else
+		{
+			ImGui::SliderFloat("Scale", &fixedRenderScale, settings.minScale, settings.maxScale);
+		}
+		ImGui::SliderFloat("Sharpen", &upscaleSharpness, 0.f, 1.f);
+		ImGui::Text("Render: %u x %u (%.0f%%)", renderWidth, renderHeight, dynamicResolution.GetScale() * 100.f);
+		ImGui::Text("GPU frame: %.2f ms", gpuProfiler.GetFrameMs());
+	}
+
+	if (ImGui::CollapsingHeader("Frame Pacing"))
+	{
+		ImGui::Text("Timeline: %llu submitted, %llu completed", static_cast<unsigned long long>(frameTimeline.GetSubmitted()),
+			static_cast<unsigned long long>(frameTimeline.GetCompleted()));
+		ImGui::Text("GPU behind at frame start: %u of %u frames", gpuFramesBehind, MAX_FRAMES_IN_FLIGHT);
+		ImGui::Text("CPU waiting on GPU: %.2f ms", frameWaitMs);
+	}
+
+	if (ImGui::CollapsingHeader("Command Recording"))
+	{
+		int recordThreads = static_cast<int>(commandRecorder.GetThreadCount());
+		if (ImGui::SliderInt("Record Threads", &recordThreads, 1, static_cast<int>(commandRecorder.GetMaxThreads())))
+		{
+			commandRecorder.SetThreadCount(static_cast<uint32_t>(recordThreads));
+		}
+		if (ImGui::Button("Run Scaling Benchmark"))
+		{
+			runRecordBenchmark = true;
+		}
+		for (const CommandRecorder::BenchmarkResult& result : recordBenchmark)
+		{
+			ImGui::Text("%6u draws, %2u threads: %.2f ms", result.drawCount, result.threadCount, result.ms);
+		}
+	}
+
 	ImGui::Checkbox("Debug Normals", &DrawNormal);
 	ImGui::Checkbox("Rotate Lights", &RotatingLight);
+	ImGui::Checkbox("Spin Objects", &SpinObjects);
+	ImGui::Text("Transforms rebuilt: %u / %u", transforms.GetLastUpdateCount(), transforms.GetCount());
+	ImGui::SliderFloat("Cascade Split Lambda", &cascadeSplitLambda, 0.f, 1.f);
+	ImGui::Checkbox("Stagger Far Cascades", &StaggerCascades);
+	int renderedCubes = 0;
+	for (uint32_t slot = 0; slot < POINT_SHADOW_SLOTS; ++slot)
+	{
+		renderedCubes += (pointShadowDirtyMask >> slot) & 1u;
+	}
+	ImGui::Text("Point Shadow Cubes Rendered: %d / %d", renderedCubes, POINT_SHADOW_SLOTS);
+
+	const char* shadowFilterNames[SHADOW_FILTER_COUNT] = { "Hard", "Hardware PCF", "Poisson PCF", "PCSS" };
+	ImGui::Combo("Shadow Filter", &shadowFilterMode, shadowFilterNames, SHADOW_FILTER_COUNT);
+	if (shadowFilterMode == SHADOW_FILTER_POISSON || shadowFilterMode == SHADOW_FILTER_PCSS)
+	{
+		ImGui::SliderInt("Filter Taps", &shadowFilterTaps, 4, 32);
+	}
+	if (shadowFilterMode == SHADOW_FILTER_HW_PCF || shadowFilterMode == SHADOW_FILTER_POISSON)
+	{
+		ImGui::SliderFloat("Filter Radius (texels)", &shadowFilterRadius, 0.5f, 8.f);
+	}
+	if (shadowFilterMode == SHADOW_FILTER_PCSS)
+	{
+		ImGui::SliderFloat("Light Size", &shadowLightSize, 0.001f, 0.1f);
+	}
+
+	if (gpuProfiler.IsSupported() == true)
+	{
+		for (const GPUProfiler::ScopeResult& result : gpuProfiler.GetResults())
+		{
+			ImGui::Text("GPU %s: %.3f ms (%.3f - %.3f)", result.name.c_str(), result.ms, result.startMs, result.endMs);
+		}
+		ImGui::Text("Light Binning overlapping Shadow: %.3f ms", gpuProfiler.GetOverlapMs("Light Binning", "Shadow"));
+	}
+	else
+	{
+		ImGui::Text("GPU timestamps not supported on the graphics or compute queue");
+	}
+
+	if (ImGui::CollapsingHeader("Texture Streaming"))
+	{
+		ImGui::Text("Time to first frame: %.1f ms", firstFrameMs);
+		const TextureStreamer::Stats& streamStats = textureStreamer.GetStats();
+		TextureStreamer::Settings& streamSettings = textureStreamer.GetSettings();
+		ImGui::Text("Resident: %u / %u textures, %.1f MB", streamStats.residentCount, streamStats.textureCount,
+			streamStats.residentBytes / (1024.f * 1024.f));
+		ImGui::Text("Decodes pending: %u, uploads in flight: %u, uploaded %.1f KB this frame", streamStats.decodesPending,
+			streamStats.batchesInFlight, streamStats.uploadedBytes / 1024.f);
+		int budgetMB = static_cast<int>(streamSettings.budgetBytes >> 20);
+		if (ImGui::SliderInt("VRAM Budget (MB)", &budgetMB, 1, 1024))
+		{
+			streamSettings.budgetBytes = static_cast<VkDeviceSize>(budgetMB) << 20;
+		}
+		int uploadKB = static_cast<int>(streamSettings.uploadBytesPerFrame >> 10);
+		if (ImGui::SliderInt("Upload / Frame (KB)", &uploadKB, 64, 32768))
+		{
+			streamSettings.uploadBytesPerFrame = static_cast<VkDeviceSize>(uploadKB) << 10;
+		}
+		for (uint32_t i = 0; i < textureStreamer.GetTextureCount(); ++i)
+		{
+			TextureStreamer::TextureInfo info = textureStreamer.GetTextureInfo(i);
+			if (info.failed == true)
+			{
+				ImGui::Text("%s: failed", info.file.c_str());
+			}
+			else if (info.mipLevels == 0)
+			{
+				ImGui::Text("%s: decoding", info.file.c_str());
+			}
+			else
+			{
+				ImGui::Text("%s: mip %u resident, %u wanted (%u levels)", info.file.c_str(), info.residentMip, info.wantedMip, info.mipLevels);
+			}
+		}
+	}
 
 	ImGui::ColorPicker3("Light1", &lightsData.point_light[0].mColor[0]);
 	ImGui::ColorPicker3("Light2", &lightsData.point_light[1].mColor[0]);
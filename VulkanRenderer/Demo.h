@@ -9,6 +9,23 @@
 #include "G_Pass.h"
 #include "L_Pass.h"
 #include "P_Pass.h"
+#include "C_Pass.h"
+#include "T_Pass.h"
+#include "A_Pass.h"
+#include "B_Pass.h"
+#include "M_Pass.h"
+#include "ShadowAtlas.h"
+#include "GPUProfiler.h"
+#include "TextureStreamer.h"
+#include "CommandRecorder.h"
+#include "JobSystem.h"
+#include "TransformStore.h"
+#include "RenderGraph.h"
+#include "TimelineSemaphore.h"
+#include "DynamicResolution.h"
+#include "ObjParser.h"
+#include "ResourceManager.h"
+#include <chrono>
 
 struct MouseInfo
 {
@@ -36,13 +53,22 @@ private:
 	void CreateLight();
 	void CreateCamera();
 	void CreateSyncObjects();
-	void LoadCubemap(std::string filename, VkFormat format, bool forceLinearTiling);
 
 	void InitDescriptorPool();
 	void InitDescriptorLayout();
 	void InitDescriptorSet();
 
+	void UpdateFrameCamera();
+	void UpdateTransforms();
+	void CullObjects();
 	void UpdateUniformBuffer();
+	void UpdateCascades(const glm::mat4& view, const glm::mat4& proj, float nearClip, float farClip);
+	void UpdatePointShadows();
+	void UpdateTextureDemand(float viewportHeight);
+	void SelectLods(float viewportHeight);
+	void UpdateClusterDraws();
+	//Hands loaded meshes to the cluster pass and swaps them in for the placeholders of their objects
+	void ResolveMeshes();
 	void UpdateDescriptorSet();
 
 	void CreateSampler();
@@ -51,11 +77,25 @@ private:
 	void CreateUniformBuffers();
 
 	void CreateCommandBuffers();
+	void SetupRenderGraph();
 
-	void BuildShadowCommandBuffer();
-	void BuildGCommandBuffer();
-	void BuildLightCommandBuffer();
-	void BuildPostCommandBuffer(int swapChianIndex);
+	//Pass contents only, the render graph begins and ends the command buffers around them
+	void RecordShadowPass(VkCommandBuffer commandBuffer);
+	void RecordGPass(VkCommandBuffer commandBuffer);
+	//clusterCulled draws entry i with the i-th command of the cluster culling pass, drawList has to be visibleObjects then
+	void RecordGDraws(VkCommandBuffer cmd, const std::vector<uint32_t>& drawList, uint32_t begin, uint32_t end, bool clusterCulled = false);
+	void RunRecordBenchmark();
+	void RunJobBenchmark();
+	void RunObjBenchmark();
+	void RecordLightBinningPass(VkCommandBuffer commandBuffer);
+	void RecordClusterCullPass(VkCommandBuffer commandBuffer);
+	void RecordDepthPyramidPass(VkCommandBuffer commandBuffer);
+	void RecordLightingPass(VkCommandBuffer commandBuffer);
+	void RecordPostPass(VkCommandBuffer commandBuffer);
+	void RecordTAAPass(VkCommandBuffer commandBuffer);
+	void RecordBloomPass(VkCommandBuffer commandBuffer);
+	void RecordExposurePass(VkCommandBuffer commandBuffer);
+	void RecordTonemapPass(VkCommandBuffer commandBuffer);
 
 private:
 	VkDescriptorPool mImguiDescPool{ VK_NULL_HANDLE };
@@ -74,51 +114,167 @@ private:
 private:
 	MouseInfo mouseInfo;
 
-	Mesh* redMesh;
-	Mesh* greenMesh;
-	Mesh* BlueMesh;
-	Mesh* floor;
+	ResourceManager resources;
 	std::vector<Object*> objects;
+	TransformStore transforms;
 
-	Mesh* Skybox;
 
 	Camera* camera;
+	float cameraFovY = glm::radians(45.f);
+	float cameraNear = 0.1f;
+	float cameraFar = 500.f;
 	UniformBufferLights lightsData;
 	LightMatUBO lightMatData;
+
+//Cascaded shadow
+	float cascadeMaxDistance = 100.f;
+	uint32_t cascadeUpdateMask = 0;
+	uint32_t cascadeRoundRobin = 1;
+	bool cascadesValid = false;
+	glm::vec3 cachedSunDir = glm::vec3(0.f);
+	float cachedSplitLambda = 0.f;
+	glm::vec4 cachedCascadeBounds[SHADOW_MAP_CASCADE_COUNT] = {};//Sphere each cascade was last fitted to, xyz center & w radius
+	glm::vec3 cascadeCameraPos = glm::vec3(0.f);//Of the last update, the distance to it estimates how far the camera moves a frame
+
+//Point light shadow
+	ShadowAtlas pointShadowAtlas;
+	PointShadowUBO pointShadowData;
+	uint32_t pointShadowDirtyMask = 0;//Atlas slots re-rendered this frame
+	uint64_t frameNumber = 0;
+
 	VkDescriptorPool descriptorPool;
 
 	VkSampler colorSampler;
+	VkSampler hdrSampler;//Linear, the histogram averages 2x2 pixels per fetch
 	VkSampler shadowDepthSampler;
+	VkSampler shadowCompareSampler;
 //Texture
-	ImageWrap testImage;
-	ImageWrap testCubemap;
+	TextureStreamer textureStreamer;
+	std::vector<Material> materials;//Indexed by Object::mMaterial, diffuse textures are streamer handles
+	uint32_t skyTexture = 0;
+	std::chrono::steady_clock::time_point initStart;
+	float firstFrameMs = 0.f;
 
 //FrameBuffer & Render related
 	Buffer textureUBO;
 	Buffer matUBO;
 	Buffer lightUBO;
 	Buffer lightMatUBO;
+	Buffer pointShadowUBO;
+	Buffer materialSSBO;
+
+	//Done once the pass's pipelines exist
+	JobCounter shadowPipelines;
+	JobCounter gPipelines;
+	JobCounter lightPipelines;
+	JobCounter postPipelines;
+	JobCounter computePipelines;
+	JobCounter tonemapPipelines;
+	JobCounter taaPipelines;
+	JobCounter bloomPipelines;
+	JobCounter clusterPipelines;
 
 	S_Pass shadow_pass;
 	G_Pass geometry_pass;
 	L_Pass lighting_pass;
 	P_Pass post_pass;
+	C_Pass compute_pass;
+	T_Pass tonemap_pass;
+	A_Pass taa_pass;
+	B_Pass bloom_pass;
+	M_Pass cluster_pass;
 
+//Frame stages, written by jobs every frame
+	JobSystem jobSystem;
+	glm::mat4 frameView;
+	glm::mat4 frameProj;//Without TAA jitter
+	glm::mat4 prevViewProj;//Last frame's, for motion vectors
+	std::vector<glm::vec4> objectBounds;//World space bounding spheres, indexed like objects
+	std::vector<uint8_t> objectVisible;
+	std::vector<uint32_t> visibleObjects;//Objects inside the camera frustum, in object order
+	std::vector<JobSystem::BenchmarkResult> jobBenchmark;
+	bool runJobBenchmark = false;
+	std::vector<ObjParser::BenchmarkResult> objBenchmark;
+	bool runObjBenchmark = false;
+	char objBenchmarkFile[260] = "../models/Monkey.obj";
+
+	GPUProfiler gpuProfiler;
+	CommandRecorder commandRecorder;
+	std::vector<CommandRecorder::BenchmarkResult> recordBenchmark;
+	bool runRecordBenchmark = false;
+
+	//Shadow, G and lighting are recorded by concurrent jobs, so each has its own pool
+	VkCommandPool ShadowCommandPool;
+	VkCommandPool GCommandPool;
+	VkCommandPool LightingCommandPool;
 	VkCommandBuffer ShadowCommandBuffer;
 	VkCommandBuffer GCommandBuffer;
 	VkCommandBuffer LightingCommandBuffer;
 	VkCommandBuffer PostCommandBuffer;
+	VkCommandBuffer TAACommandBuffer;
+	VkCommandBuffer BloomCommandBuffer;
+	VkCommandBuffer ExposureCommandBuffer;
+	VkCommandBuffer TonemapCommandBuffer;
+	VkCommandBuffer ClusterCullCommandBuffer;
+	VkCommandBuffer DepthPyramidCommandBuffer;
+	//Light binning runs on the compute queue, its pool comes from that family
+	VkCommandPool ComputeCommandPool;
+	VkCommandBuffer ComputeCommandBuffer;
+
+	//Declares the passes above and the images between them, records barriers and submits the frame
+	RenderGraph renderGraph;
+	RenderGraph::ResourceHandle swapchainImage = 0;
+	uint32_t swapchainIndex = 0;//Of the acquired image, picks the tonemap's framebuffer
+	RenderGraph::ResourceHandle taaHistory = 0;
+	RenderGraph::ResourceHandle taaOutput = 0;
+	uint32_t taaOutputIndex = 0;//taa_pass.mHistory slot written this frame
+	bool taaReset = true;//History holds nothing usable, e.g. before the first frame
+	uint32_t clusterDrawCount = 0;//One per visible object, in the same order
+	uint32_t clusterTriangles = 0;//Drawn by the last frame after meshlet culling
+	bool pyramidValid = false;//Last frame built the depth pyramid, at prevRenderWidth x prevRenderHeight
+
+//Dynamic resolution, the scene passes render into the top left corner of their full size attachments
+	DynamicResolution dynamicResolution;
+	uint32_t renderWidth = WIDTH;
+	uint32_t renderHeight = HEIGHT;
+	uint32_t prevRenderWidth = WIDTH;//Of the frame the TAA history comes from
+	uint32_t prevRenderHeight = HEIGHT;
 
 //Synchronize
-	VkSemaphore ShadowComplete;
-	VkSemaphore GBufferComplete;
+	//Binary ones are only left for the swapchain, the presentation engine can't wait on a timeline
 	VkSemaphore renderComplete;
-	VkSemaphore PostComplete;
 	VkSemaphore presentComplete;
-	VkFence inFlightFence;
+	TimelineSemaphore frameTimeline;//Signaled with the frame's value by its submit
+	float frameWaitMs = 0.f;//CPU blocked on the timeline, smoothed
+	uint32_t gpuFramesBehind = 0;//Submitted but unfinished frames when the last one began
 
 //GUI
 	bool DrawNormal = false;
 	bool RotatingLight = false;
+	bool SpinObjects = false;
+	bool StaggerCascades = true;
+	float cascadeSplitLambda = 0.95f;
+	int shadowFilterMode = SHADOW_FILTER_PCSS;
+	int shadowFilterTaps = 16;
+	float shadowFilterRadius = 1.5f;
+	float shadowLightSize = 0.02f;
+	float exposureCompensation = 0.f;//EV
+	float exposureAdaptRate = 1.5f;//Per second
+	const float hdrBudgetMs = 0.2f;//Histogram, exposure and tonemap at 1080p
+	bool EnableTAA = true;
+	float taaBlend = 0.1f;//Share of the new frame in the history
+	bool EnableBloom = true;
+	float bloomIntensity = 0.3f;
+	float bloomThreshold = 1.f;//Luminance, before exposure
+	bool DynamicResolutionOn = true;
+	float fixedRenderScale = 1.f;//While the controller is off
+	float upscaleSharpness = 0.5f;
+	bool EnableLod = true;
+	float lodErrorPixels = 1.f;//Screen space error a level may show
+	float lodHysteresis = 0.75f;//Share of the threshold a coarser level must get under before switching
+	uint32_t lodCounts[MAX_MESH_LODS] = {};
+	bool EnableClusterCulling = true;
+	bool EnableConeCulling = true;
+	bool EnableOcclusionCulling = true;
 };
 
@@ -0,0 +1,41 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+void DynamicResolution::Init(const Settings& settings)
+{
+	mSettings = settings;
+	mScale = settings.maxScale;
+}
+
+float DynamicResolution::Update(float gpuMs)
+{
+	//No timing yet, e.g. the first frame or without timestamp support
+	if (gpuMs <= 0.f)
+	{
+		return mScale;
+	}
+
+	//Pixel count is the square of the scale
+	const float wanted = std::clamp(mScale * std::sqrt(mSettings.targetMs * mSettings.headroom / gpuMs), mSettings.minScale, mSettings.maxScale);
+	const float rate = wanted < mScale ? mSettings.dropRate : mSettings.raiseRate;
+	mScale += (wanted - mScale) * rate;
+	return mScale;
+}
+
+void DynamicResolution::SetScale(float scale)
+{
+	mScale = std::clamp(scale, mSettings.minScale, mSettings.maxScale);
+}
+
+uint32_t DynamicResolution::ScaledSize(uint32_t size, float scale, uint32_t minimum)
+{
+	//Full size stays exact even when odd, so scale 1 renders natively. Below it sizes are kept even
+	const uint32_t scaled = static_cast<uint32_t>(static_cast<float>(size) * scale);
+	if (scaled >= size)
+	{
+		return size;
+	}
+	return std::min(std::max(scaled & ~1u, minimum), size);
+}
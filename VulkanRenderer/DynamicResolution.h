@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+
+//Picks the render scale of each frame from the GPU time of the last one, so the frame rate holds under load.
+//GPU time is taken to grow with the pixel count, the scale moves towards the one that would just meet the target.
+//Drops are taken quickly, raises slowly so the scale doesn't oscillate around the budget
+class DynamicResolution
+{
+public:
+	struct Settings
+	{
+		float targetMs = 16.6f;
+		float minScale = 0.5f;
+		float maxScale = 1.f;
+		float headroom = 0.9f;//Share of the target aimed at, leaves room for spikes
+		float dropRate = 0.5f;//Share of the way to the wanted scale covered per frame
+		float raiseRate = 0.05f;
+	};
+
+	void Init(const Settings& settings);
+
+	//Once per frame with the GPU time of the frame rendered at the last returned scale. Returns this frame's scale
+	float Update(float gpuMs);
+	//Overrides the controller, it goes on from here with the next Update
+	void SetScale(float scale);
+	float GetScale() const { return mScale; }
+
+	Settings& GetSettings() { return mSettings; }
+
+	//Width and height at the scale, even below full size so half resolution passes line up. Never below minimum,
+	//full size comes back unchanged
+	static uint32_t ScaledSize(uint32_t size, float scale, uint32_t minimum = 8);
+
+private:
+	Settings mSettings;
+	float mScale = 1.f;
+};
@@ -0,0 +1,157 @@
+#include "GPUProfiler.h"
+#include "VulkanDevice.h"
+#include "VulkanTools.h"
+
+#include <algorithm>
+
+void GPUProfiler::Init(VulkanDevice* device, uint32_t maxScopes)
+{
+	mDevice = device;
+	mMaxScopes = maxScopes;
+	mTimestampPeriod = device->properties.limits.timestampPeriod;
+
+	uint32_t graphicsFamily = device->queueFamilyIndices.graphics;
+	uint32_t computeFamily = device->queueFamilyIndices.compute;
+	mSupported = device->properties.limits.timestampComputeAndGraphics == VK_TRUE
+		&& device->queueFamilyProperties[graphicsFamily].timestampValidBits != 0
+		&& device->queueFamilyProperties[computeFamily].timestampValidBits != 0;
+	if (mSupported == false)
+	{
+		return;
+	}
+
+	VkQueryPoolCreateInfo queryPoolInfo{};
+	queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = mMaxScopes * 2;
+	VK_CHECK_RESULT(vkCreateQueryPool(device->logicalDevice, &queryPoolInfo, nullptr, &mQueryPool))
+	vkResetQueryPool(device->logicalDevice, mQueryPool, 0, mMaxScopes * 2);
+}
+
+void GPUProfiler::Destroy()
+{
+	if (mQueryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(mDevice->logicalDevice, mQueryPool, nullptr);
+		mQueryPool = VK_NULL_HANDLE;
+	}
+}
+
+void GPUProfiler::CollectResults()
+{
+	//Taken even when they can't be read, the next frame starts with no scopes
+	std::vector<std::string> frameScopes;
+	{
+		std::lock_guard<std::mutex> lock(mScopeMutex);
+		frameScopes.swap(mFrameScopes);
+	}
+	if (mSupported == false || frameScopes.empty() == true)
+	{
+		return;
+	}
+
+	uint32_t queryCount = static_cast<uint32_t>(frameScopes.size()) * 2;
+	std::vector<uint64_t> timestamps(queryCount);
+	VkResult result = vkGetQueryPoolResults(mDevice->logicalDevice, mQueryPool, 0, queryCount,
+		timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+	vkResetQueryPool(mDevice->logicalDevice, mQueryPool, 0, queryCount);
+	if (result != VK_SUCCESS)
+	{
+		return;
+	}
+
+	uint64_t frameStart = UINT64_MAX;
+	uint64_t frameEnd = 0;
+	for (size_t i = 0; i < frameScopes.size(); ++i)
+	{
+		frameStart = std::min(frameStart, timestamps[i * 2]);
+		frameEnd = std::max(frameEnd, timestamps[i * 2 + 1]);
+	}
+	mFrameMs = static_cast<float>(frameEnd - frameStart) * mTimestampPeriod / 1000000.f;
+
+	for (size_t i = 0; i < frameScopes.size(); ++i)
+	{
+		float ms = static_cast<float>(timestamps[i * 2 + 1] - timestamps[i * 2]) * mTimestampPeriod / 1000000.f;
+		float startMs = static_cast<float>(timestamps[i * 2] - frameStart) * mTimestampPeriod / 1000000.f;
+
+		ScopeResult* scopeResult = nullptr;
+		for (ScopeResult& existing : mResults)
+		{
+			if (existing.name == frameScopes[i])
+			{
+				scopeResult = &existing;
+				break;
+			}
+		}
+
+		if (scopeResult == nullptr)
+		{
+			mResults.push_back({ frameScopes[i], ms, startMs, startMs + ms });
+		}
+		else
+		{
+			scopeResult->ms += (ms - scopeResult->ms) * 0.1f;
+			scopeResult->startMs += (startMs - scopeResult->startMs) * 0.1f;
+			scopeResult->endMs = scopeResult->startMs + scopeResult->ms;
+		}
+	}
+}
+
+uint32_t GPUProfiler::BeginScope(VkCommandBuffer cmd, const char* name)
+{
+	uint32_t scope = 0;
+	{
+		std::lock_guard<std::mutex> lock(mScopeMutex);
+		scope = static_cast<uint32_t>(mFrameScopes.size());
+		if (mSupported == false || scope >= mMaxScopes)
+		{
+			return UINT32_MAX;
+		}
+		mFrameScopes.push_back(name);
+	}
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mQueryPool, scope * 2);
+	return scope;
+}
+
+void GPUProfiler::EndScope(VkCommandBuffer cmd, uint32_t scope)
+{
+	if (scope == UINT32_MAX)
+	{
+		return;
+	}
+	vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mQueryPool, scope * 2 + 1);
+}
+
+float GPUProfiler::GetScopeMs(const std::string& name) const
+{
+	for (const ScopeResult& result : mResults)
+	{
+		if (result.name == name)
+		{
+			return result.ms;
+		}
+	}
+	return 0.f;
+}
+
+float GPUProfiler::GetOverlapMs(const std::string& a, const std::string& b) const
+{
+	const ScopeResult* first = nullptr;
+	const ScopeResult* second = nullptr;
+	for (const ScopeResult& result : mResults)
+	{
+		if (result.name == a)
+		{
+			first = &result;
+		}
+		else if (result.name == b)
+		{
+			second = &result;
+		}
+	}
+	if (first == nullptr || second == nullptr)
+	{
+		return 0.f;
+	}
+	return std::max(0.f, std::min(first->endMs, second->endMs) - std::max(first->startMs, second->startMs));
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct VulkanDevice;
+
+//Timestamp queries around named scopes of a frame.
+//Results are read back one frame later, after the frame timeline has been waited on.
+//Scopes may be opened from several recording threads at once and on the graphics and compute queues,
+//their start and end within the frame show which ones ran at the same time.
+class GPUProfiler
+{
+public:
+	struct ScopeResult
+	{
+		std::string name;
+		float ms = 0.f;//Smoothed over frames
+		float startMs = 0.f;//From the earliest timestamp of the frame, smoothed
+		float endMs = 0.f;
+	};
+
+	void Init(VulkanDevice* device, uint32_t maxScopes = 32);
+	void Destroy();
+
+	//Call once the previous frame completed on the frame timeline. Resets the queries from the host,
+	//a reset recorded on one queue would not be ordered against timestamps written on another
+	void CollectResults();
+
+	uint32_t BeginScope(VkCommandBuffer cmd, const char* name);
+	void EndScope(VkCommandBuffer cmd, uint32_t scope);
+
+	const std::vector<ScopeResult>& GetResults() const { return mResults; }
+	float GetScopeMs(const std::string& name) const;
+	//Time both scopes were running at once
+	float GetOverlapMs(const std::string& a, const std::string& b) const;
+	//From the first scope's start to the last one's end in the last collected frame, not smoothed
+	float GetFrameMs() const { return mFrameMs; }
+	bool IsSupported() const { return mSupported; }
+
+private:
+	VulkanDevice* mDevice = nullptr;
+	VkQueryPool mQueryPool = VK_NULL_HANDLE;
+	uint32_t mMaxScopes = 0;
+	float mTimestampPeriod = 1.f;//Nanoseconds per tick
+	bool mSupported = false;
+
+	std::vector<std::string> mFrameScopes;//Scopes recorded in the frame in flight
+	std::mutex mScopeMutex;
+	std::vector<ScopeResult> mResults;
+	float mFrameMs = 0.f;
+};
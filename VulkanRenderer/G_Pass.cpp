@@ -7,6 +7,7 @@
 #include <glm/glm.hpp>
 
 #include "Mesh.h"
+#include "UniformStructure.h"
 
 void G_Pass::Init(VkApp* app, uint32_t width, uint32_t height)
 {
@@ -17,63 +18,55 @@ void G_Pass::Init(VkApp* app, uint32_t width, uint32_t height)
 
 void G_Pass::CreateFrameData()
 {
-	CreateAttachment();
 	CreateRenderPass();
 	CreateFrameBuffer();
 }
 
-void G_Pass::CreatePipelineData()
+void G_Pass::CreatePipelineData(JobCounter* ready)
 {
 	CreatePipelineLayout();
-	CreatePipeline();
-}
-
-void G_Pass::CreateAttachment()
-{
-	mApp->CreateAttachment(VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, &mPosition);
-	mApp->CreateAttachment(VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, &mNormal);
-	mApp->CreateAttachment(VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, &mAlbedo);
-
-	VkFormat attDepthFormat = mApp->FindDepthFormat();
-	mApp->CreateAttachment(attDepthFormat, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, &mDepth);
+	mApp->mPipelineBuilder.Build("GBuffer", [this]() { return CreatePipeline(); }, &mPipeline, ready);
 }
 
 void G_Pass::CreateRenderPass()
 {
-	std::array<VkAttachmentDescription, 4> attachmentDescs = {};
+	std::array<VkAttachmentDescription, 5> attachmentDescs = {};
 
 	// Init attachment properties
-	for (uint32_t i = 0; i < 4; ++i)
+	for (uint32_t i = 0; i < 5; ++i)
 	{
 		attachmentDescs[i].samples = VK_SAMPLE_COUNT_1_BIT;
 		attachmentDescs[i].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		attachmentDescs[i].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		attachmentDescs[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		attachmentDescs[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		if (i == 3)//Deal with depth buffer
+		//The render graph transitions the attachments around the pass
+		if (i == 4)//Deal with depth buffer
 		{
-			attachmentDescs[i].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			attachmentDescs[i].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 			attachmentDescs[i].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 		}
 		else
 		{
-			attachmentDescs[i].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-			attachmentDescs[i].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			attachmentDescs[i].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			attachmentDescs[i].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 		}
 	}
 
 	attachmentDescs[0].format = mPosition.format;
 	attachmentDescs[1].format = mNormal.format;
 	attachmentDescs[2].format = mAlbedo.format;
-	attachmentDescs[3].format = mDepth.format;
+	attachmentDescs[3].format = mVelocity.format;
+	attachmentDescs[4].format = mDepth.format;
 
 	std::vector<VkAttachmentReference> colorReferences;
 	colorReferences.push_back({ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
 	colorReferences.push_back({ 1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
 	colorReferences.push_back({ 2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+	colorReferences.push_back({ 3, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
 
 	VkAttachmentReference depthReference = {};
-	depthReference.attachment = 3;
+	depthReference.attachment = 4;
 	depthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 	VkSubpassDescription subpass = {};
@@ -82,43 +75,23 @@ void G_Pass::CreateRenderPass()
 	subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
 	subpass.pDepthStencilAttachment = &depthReference;
 
-	// Use subpass dependencies for attachment layout transitions
-	std::array<VkSubpassDependency, 2> dependencies;
-
-	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependencies[0].dstSubpass = 0;
-	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;// color attachment ٿ MTR Ҽ ְ Ѵ.
-	dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-	dependencies[1].srcSubpass = 0;
-	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;//Write color attachment readؼ  lighting shader ִ´.
-	dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
 	VkRenderPassCreateInfo renderPassInfo = {};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	renderPassInfo.pAttachments = attachmentDescs.data();
 	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachmentDescs.size());
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 2;
-	renderPassInfo.pDependencies = dependencies.data();
 	VK_CHECK_RESULT(vkCreateRenderPass(mApp->mVulkanDevice->logicalDevice, &renderPassInfo, nullptr, &mRenderPass))
 }
 
 void G_Pass::CreateFrameBuffer()
 {
-	std::array<VkImageView, 4> attachments;
+	std::array<VkImageView, 5> attachments;
 	attachments[0] = mPosition.view;
 	attachments[1] = mNormal.view;
 	attachments[2] = mAlbedo.view;
-	attachments[3] = mDepth.view;
+	attachments[3] = mVelocity.view;
+	attachments[4] = mDepth.view;
 
 	VkFramebufferCreateInfo fbufCreateInfo = {};
 	fbufCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -132,13 +105,14 @@ void G_Pass::CreateFrameBuffer()
 	VK_CHECK_RESULT(vkCreateFramebuffer(mApp->mVulkanDevice->logicalDevice, &fbufCreateInfo, nullptr, &mFrameBuffer));
 }
 
-void G_Pass::CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes)
+void G_Pass::CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes, VkDescriptorPoolCreateFlags flags)
 {
 	//G_Pass use matrix for Uniform data and push constant.
 	//Later, maybe use diffuse, normal, specular map.
 
 	VkDescriptorPoolCreateInfo poolInfo{};
 	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = flags;
 	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
 	poolInfo.pPoolSizes = poolSizes.data();
 
@@ -150,9 +124,26 @@ void G_Pass::CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolS
 	}
 }
 
-void G_Pass::CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings)
+void G_Pass::CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings, const std::vector<VkDescriptorBindingFlags>& bindingFlags)
 {
 	VkDescriptorSetLayoutCreateInfo lightDescriptorLayout = initializers::descriptorSetLayoutCreateInfo(setLayoutBindings);
+
+	//One flag per binding, the bindless texture array is partially bound and written while the set is in use
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+	bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+	if (bindingFlags.empty() == false)
+	{
+		lightDescriptorLayout.pNext = &bindingFlagsInfo;
+		for (VkDescriptorBindingFlags flag : bindingFlags)
+		{
+			if (flag & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT)
+			{
+				lightDescriptorLayout.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+			}
+		}
+	}
 	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(mApp->mVulkanDevice->logicalDevice, &lightDescriptorLayout, nullptr, &mDescriptorLayout))
 }
 
@@ -177,19 +168,20 @@ void G_Pass::UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeD
 
 void G_Pass::CreatePipelineLayout()
 {
-	VkPushConstantRange pushConstant;
-	pushConstant.offset = 0;
-	pushConstant.size = sizeof(glm::mat4);
-	pushConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_GEOMETRY_BIT;
+	mPushConstants = mApp->mShaders.ReflectPushConstants({ "GBuffer.vert", "GBuffer.frag" });
+	if (mPushConstants.size != sizeof(GPushConstant))
+	{
+		throw std::runtime_error("failed to match GPushConstant with the G-buffer shaders!");
+	}
 
 	VkPipelineLayoutCreateInfo pipelinelayoutCI = initializers::pipelineLayoutCreateInfo(&mDescriptorLayout, 1);
 	pipelinelayoutCI.pushConstantRangeCount = 1;
-	pipelinelayoutCI.pPushConstantRanges = &pushConstant;
+	pipelinelayoutCI.pPushConstantRanges = &mPushConstants;
 
 	VK_CHECK_RESULT(vkCreatePipelineLayout(mApp->mVulkanDevice->logicalDevice, &pipelinelayoutCI, nullptr, &mPipelineLayout))
 }
 
-void G_Pass::CreatePipeline()
+VkPipeline G_Pass::CreatePipeline()
 {
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState =
 		initializers::pipelineInputAssemblyStateCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
@@ -237,15 +229,16 @@ void G_Pass::CreatePipeline()
 	pipelineCI.pVertexInputState = &vertexInputInfo;
 	rasterizationState.cullMode = VK_CULL_MODE_BACK_BIT;
 
-	shaderStages[0] = createShaderStageCreateInfo("../shaders/GBufferVert.spv", VK_SHADER_STAGE_VERTEX_BIT, mApp->mVulkanDevice->logicalDevice);
-	shaderStages[1] = createShaderStageCreateInfo("../shaders/GBufferFrag.spv", VK_SHADER_STAGE_FRAGMENT_BIT, mApp->mVulkanDevice->logicalDevice);
+	shaderStages[0] = mApp->mPipelineBuilder.ShaderStage("GBuffer.vert");
+	shaderStages[1] = mApp->mPipelineBuilder.ShaderStage("GBuffer.frag");
 
 	pipelineCI.renderPass = mRenderPass;
 
 	// Blend attachment states required for all color attachments
 	// This is important, as color write mask will otherwise be 0x0 and you
 	// won't see anything rendered to the attachment
-	std::array<VkPipelineColorBlendAttachmentState, 3> blendAttachmentStates = {
+	std::array<VkPipelineColorBlendAttachmentState, 4> blendAttachmentStates = {
+		initializers::pipelineColorBlendAttachmentState(0xf, VK_FALSE),
 		initializers::pipelineColorBlendAttachmentState(0xf, VK_FALSE),
 		initializers::pipelineColorBlendAttachmentState(0xf, VK_FALSE),
 		initializers::pipelineColorBlendAttachmentState(0xf, VK_FALSE)
@@ -254,7 +247,7 @@ void G_Pass::CreatePipeline()
 	colorBlendState.attachmentCount = static_cast<uint32_t>(blendAttachmentStates.size());
 	colorBlendState.pAttachments = blendAttachmentStates.data();
 
-	VK_CHECK_RESULT(vkCreateGraphicsPipelines(mApp->mVulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &mPipeline))
+	return mApp->mPipelineBuilder.CreateGraphicsPipeline(pipelineCI);
 }
 
 void G_Pass::Update()
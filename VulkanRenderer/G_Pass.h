@@ -3,6 +3,7 @@
 #include "Attachment.h"
 
 class VkApp;
+class JobCounter;
 class G_Pass
 {
 private:
@@ -11,29 +12,31 @@ public:
 	void Init(VkApp* app, uint32_t width, uint32_t height);
 	void Update();
 
-	void CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes);
-	void CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings);
+	void CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes, VkDescriptorPoolCreateFlags flags = 0);
+	void CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings, const std::vector<VkDescriptorBindingFlags>& bindingFlags = {});
 	void CreateDescriptorSet();
 
 	void CreateFrameData();
-	void CreatePipelineData();
+	//Layouts are created right away, pipelines are built as jobs that count on ready
+	void CreatePipelineData(JobCounter* ready);
 
 	void UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets);
 
 private:
-	void CreateAttachment();
 	void CreateRenderPass();
 	void CreateFrameBuffer();
 
 	void CreatePipelineLayout();
-	void CreatePipeline();
+	VkPipeline CreatePipeline();
 
 public:
 	uint32_t mWidth, mHeight;
 
 	VkFramebuffer mFrameBuffer;
 	VkRenderPass mRenderPass;
+	//Created by the render graph, which only keeps them alive within a frame
 	FrameBufferAttachment mPosition, mNormal, mAlbedo;
+	FrameBufferAttachment mVelocity;//Screen UV motion since last frame, for TAA
 	FrameBufferAttachment mDepth;
 
 	VkDescriptorPool mDescriptorPool;
@@ -42,6 +45,7 @@ public:
 
 	VkPipelineLayout mPipelineLayout;
 	VkPipeline mPipeline;
+	VkPushConstantRange mPushConstants{};//Reflected, pushes have to use its stage flags
 
 	/*VkShaderModule mVertexShader;
 	VkShaderModule mGeometryShader;
@@ -0,0 +1,319 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+
+static thread_local uint32_t tThreadIndex = 0;
+
+void JobSystem::Init(uint32_t workerCount)
+{
+	tThreadIndex = 0;
+	mStopWorkers = false;
+	for (uint32_t i = 0; i < workerCount + 1; ++i)
+	{
+		mQueues.push_back(std::make_unique<WorkerQueue>());
+	}
+	for (uint32_t i = 1; i < workerCount + 1; ++i)
+	{
+		mWorkers.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+void JobSystem::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mStopWorkers = true;
+	}
+	mSleepCondition.notify_all();
+	for (std::thread& worker : mWorkers)
+	{
+		worker.join();
+	}
+	mWorkers.clear();
+	mQueues.clear();
+	mBackgroundJobs.clear();
+}
+
+void JobSystem::Run(JobFunc func, JobCounter* counter)
+{
+	if (counter != nullptr)
+	{
+		counter->mPending.fetch_add(1);
+	}
+	Push({ std::move(func), counter });
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, JobFunc func, JobCounter* counter)
+{
+	if (counter != nullptr)
+	{
+		counter->mPending.fetch_add(1);
+	}
+	{
+		//Finish decrements under the same lock, so the dependency can't complete in between
+		std::lock_guard<std::mutex> lock(dependency.mMutex);
+		if (dependency.mPending.load() != 0)
+		{
+			dependency.mContinuations.push_back({ std::move(func), counter });
+			return;
+		}
+	}
+	Push({ std::move(func), counter });
+}
+
+void JobSystem::RunBackground(JobFunc func, JobCounter* counter)
+{
+	if (counter != nullptr)
+	{
+		counter->mPending.fetch_add(1);
+	}
+	{
+		std::lock_guard<std::mutex> lock(mBackgroundMutex);
+		mBackgroundJobs.push_back({ std::move(func), counter });
+	}
+	mQueuedJobs.fetch_add(1);
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+	}
+	mSleepCondition.notify_one();
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, RangeFunc func, JobCounter* counter)
+{
+	grainSize = std::max(grainSize, 1u);
+	std::shared_ptr<RangeFunc> shared = std::make_shared<RangeFunc>(std::move(func));
+	for (uint32_t begin = 0; begin < count; begin += grainSize)
+	{
+		uint32_t end = std::min(begin + grainSize, count);
+		Run([shared, begin, end]() { (*shared)(begin, end); }, counter);
+	}
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	const uint32_t thread = ThreadIndex();
+	while (counter.mPending.load() != 0)
+	{
+		Job job;
+		if (PopOrSteal(thread, job) == true)
+		{
+			Execute(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+	//The thread that finished the last job may still be releasing continuations under this lock
+	std::lock_guard<std::mutex> lock(counter.mMutex);
+}
+
+uint32_t JobSystem::ThreadIndex()
+{
+	return tThreadIndex;
+}
+
+/*************************************************************************************************************/
+
+void JobSystem::WorkerLoop(uint32_t thread)
+{
+	tThreadIndex = thread;
+	while (true)
+	{
+		Job job;
+		if (PopOrSteal(thread, job) == true || PopBackground(job) == true)
+		{
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mSleepCondition.wait(lock, [this]() { return mStopWorkers == true || mQueuedJobs.load() != 0; });
+		if (mStopWorkers == true)
+		{
+			return;
+		}
+	}
+}
+
+void JobSystem::Push(Job job)
+{
+	WorkerQueue& queue = *mQueues[ThreadIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+	mQueuedJobs.fetch_add(1);
+	{
+		//Pairs with the sleep predicate so a worker about to sleep can't miss this job
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+	}
+	mSleepCondition.notify_one();
+}
+
+bool JobSystem::PopOrSteal(uint32_t thread, Job& job)
+{
+	//Newest own job first, it is the most likely to still be in cache
+	{
+		WorkerQueue& own = *mQueues[thread];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (own.jobs.empty() == false)
+		{
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+			mQueuedJobs.fetch_sub(1);
+			return true;
+		}
+	}
+
+	//Oldest job of someone else, usually the biggest piece of work left there
+	const uint32_t threadCount = GetThreadCount();
+	for (uint32_t i = 1; i < threadCount; ++i)
+	{
+		WorkerQueue& victim = *mQueues[(thread + i) % threadCount];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (victim.jobs.empty() == false)
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			mQueuedJobs.fetch_sub(1);
+			mStolen.fetch_add(1);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool JobSystem::PopBackground(Job& job)
+{
+	std::lock_guard<std::mutex> lock(mBackgroundMutex);
+	if (mBackgroundJobs.empty() == true)
+	{
+		return false;
+	}
+	job = std::move(mBackgroundJobs.front());
+	mBackgroundJobs.pop_front();
+	mQueuedJobs.fetch_sub(1);
+	return true;
+}
+
+void JobSystem::Execute(Job& job)
+{
+	job.func();
+	mExecuted.fetch_add(1);
+	if (job.counter != nullptr)
+	{
+		Finish(*job.counter);
+	}
+}
+
+void JobSystem::Finish(JobCounter& counter)
+{
+	std::vector<Job> continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter.mMutex);
+		if (counter.mPending.fetch_sub(1) == 1)
+		{
+			continuations.swap(counter.mContinuations);
+		}
+	}
+	//The counter may be gone from here on
+	for (Job& continuation : continuations)
+	{
+		Push(std::move(continuation));
+	}
+}
+
+/*************************************************************************************************************/
+
+std::vector<JobSystem::BenchmarkResult> JobSystem::RunBenchmarks()
+{
+	using Clock = std::chrono::steady_clock;
+	auto nsPerJob = [](Clock::time_point start, uint32_t jobs)
+	{
+		return std::chrono::duration<float, std::nano>(Clock::now() - start).count() / static_cast<float>(jobs);
+	};
+	std::vector<BenchmarkResult> results;
+
+	//Spawned from this thread and waited on with help
+	{
+		const uint32_t jobs = 100000;
+		JobCounter counter;
+		Clock::time_point start = Clock::now();
+		for (uint32_t i = 0; i < jobs; ++i)
+		{
+			Run([]() {}, &counter);
+		}
+		Wait(counter);
+		results.push_back({ "Spawn + run", jobs, nsPerJob(start, jobs) });
+	}
+
+	//Same jobs, but this thread only spins so every one of them has to be stolen
+	if (GetThreadCount() > 1)
+	{
+		const uint32_t jobs = 100000;
+		JobCounter counter;
+		uint64_t stolenBefore = mStolen.load();
+		Clock::time_point start = Clock::now();
+		for (uint32_t i = 0; i < jobs; ++i)
+		{
+			Run([]() {}, &counter);
+		}
+		while (counter.IsDone() == false)
+		{
+			std::this_thread::yield();
+		}
+		{
+			std::lock_guard<std::mutex> lock(counter.mMutex);
+		}
+		results.push_back({ "Steal", static_cast<uint32_t>(mStolen.load() - stolenBefore), nsPerJob(start, jobs) });
+	}
+
+	{
+		const uint32_t items = 100000;
+		JobCounter counter;
+		Clock::time_point start = Clock::now();
+		ParallelFor(items, 1, [](uint32_t, uint32_t) {}, &counter);
+		Wait(counter);
+		results.push_back({ "ParallelFor, grain 1", items, nsPerJob(start, items) });
+	}
+
+	//Strictly serial chain, measures the dependency release path
+	{
+		const uint32_t links = 10000;
+		std::vector<JobCounter> counters(links);
+		Clock::time_point start = Clock::now();
+		Run([]() {}, &counters[0]);
+		for (uint32_t i = 1; i < links; ++i)
+		{
+			RunAfter(counters[i - 1], []() {}, &counters[i]);
+		}
+		Wait(counters[links - 1]);
+		results.push_back({ "Continuation chain", links, nsPerJob(start, links) });
+	}
+
+	//Binary tree of jobs spawning jobs from whichever thread runs them
+	{
+		const uint32_t depth = 16;
+		const uint32_t jobs = (1u << depth) - 2;
+		JobCounter counter;
+		std::function<void(uint32_t)> spawn = [&](uint32_t level)
+		{
+			if (level == 0)
+			{
+				return;
+			}
+			for (int child = 0; child < 2; ++child)
+			{
+				Run([&spawn, level]() { spawn(level - 1); }, &counter);
+			}
+		};
+		Clock::time_point start = Clock::now();
+		spawn(depth - 1);
+		Wait(counter);
+		results.push_back({ "Nested spawn", jobs, nsPerJob(start, jobs) });
+	}
+
+	return results;
+}
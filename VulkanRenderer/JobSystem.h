@@ -0,0 +1,109 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class JobCounter;
+
+struct Job
+{
+	std::function<void()> func;
+	JobCounter* counter = nullptr;//Finished once func returned
+};
+
+//Counts jobs that have not finished yet. Continuations registered on it are released when it reaches zero.
+//A counter may be reused once it is done, it must outlive every job counted on it.
+class JobCounter
+{
+public:
+	uint32_t Pending() const { return mPending.load(); }
+	bool IsDone() const { return mPending.load() == 0; }
+
+private:
+	friend class JobSystem;
+	std::atomic<uint32_t> mPending{ 0 };
+	std::mutex mMutex;
+	std::vector<Job> mContinuations;
+};
+
+//Work-stealing scheduler for engine side CPU work. Vulkan free, so it runs anywhere.
+//Every thread owns a deque, it pops its newest job and idle threads steal the oldest ones of others.
+//There are no fibers, a job that needs results waits by running other jobs (Wait) or hands the rest of
+//its work to a continuation (RunAfter).
+//Background jobs (file decoding and such) sit in a shared queue only worker threads take from, so a
+//frame never ends up waiting on a long load picked up while helping.
+class JobSystem
+{
+public:
+	using JobFunc = std::function<void()>;
+	using RangeFunc = std::function<void(uint32_t begin, uint32_t end)>;
+
+	struct Stats
+	{
+		uint64_t executed = 0;
+		uint64_t stolen = 0;
+	};
+
+	struct BenchmarkResult
+	{
+		std::string name;
+		uint32_t jobCount = 0;
+		float nsPerJob = 0.f;
+	};
+
+	//The calling thread becomes thread 0 and only runs jobs inside Wait
+	void Init(uint32_t workerCount);
+	void Shutdown();
+
+	void Run(JobFunc func, JobCounter* counter = nullptr);
+	//Queued once dependency reaches zero, counter already counts it from now on
+	void RunAfter(JobCounter& dependency, JobFunc func, JobCounter* counter = nullptr);
+	void RunBackground(JobFunc func, JobCounter* counter = nullptr);
+	//One job per grainSize items of [0, count)
+	void ParallelFor(uint32_t count, uint32_t grainSize, RangeFunc func, JobCounter* counter);
+
+	//Runs frame jobs until counter is done. Safe inside a job
+	void Wait(JobCounter& counter);
+
+	//Index of the calling thread in [0, GetThreadCount()), 0 for threads the system does not own
+	static uint32_t ThreadIndex();
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(mQueues.size()); }
+	Stats GetStats() const { return { mExecuted.load(), mStolen.load() }; }
+
+	//Spawn, steal, dependency and nesting overhead with empty jobs. Call while no other jobs are queued
+	std::vector<BenchmarkResult> RunBenchmarks();
+
+private:
+	struct alignas(64) WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	void WorkerLoop(uint32_t thread);
+	void Push(Job job);
+	bool PopOrSteal(uint32_t thread, Job& job);
+	bool PopBackground(Job& job);
+	void Execute(Job& job);
+	void Finish(JobCounter& counter);
+
+	std::vector<std::unique_ptr<WorkerQueue>> mQueues;//One per thread, index 0 belongs to the initializing thread
+	std::mutex mBackgroundMutex;
+	std::deque<Job> mBackgroundJobs;
+
+	std::vector<std::thread> mWorkers;
+	std::atomic<uint32_t> mQueuedJobs{ 0 };
+	std::mutex mSleepMutex;
+	std::condition_variable mSleepCondition;
+	bool mStopWorkers = false;
+
+	std::atomic<uint64_t> mExecuted{ 0 };
+	std::atomic<uint64_t> mStolen{ 0 };
+};
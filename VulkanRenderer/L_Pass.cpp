@@ -17,22 +17,15 @@ void L_Pass::Init(VkApp* app, uint32_t width, uint32_t height)
 
 void L_Pass::CreateFrameData()
 {
-	CreateAttachment();
 	CreateRenderPass();
 	CreateFrameBuffer();
 
 }
 
-void L_Pass::CreatePipelineData()
+void L_Pass::CreatePipelineData(JobCounter* ready)
 {
 	CreatePipelineLayout();
-	CreatePipeline();
-}
-
-void L_Pass::CreateAttachment()
-{
-	VkImageUsageFlagBits lightAttachmentUsage = static_cast<VkImageUsageFlagBits>(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
-	mApp->CreateAttachment(VK_FORMAT_B8G8R8A8_SRGB, lightAttachmentUsage, &mComposition);
+	mApp->mPipelineBuilder.Build("Lighting", [this]() { return CreatePipeline(); }, &mPipeline, ready);
 }
 
 void L_Pass::CreateRenderPass()
@@ -44,8 +37,9 @@ void L_Pass::CreateRenderPass()
 	compositionDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	compositionDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
-	compositionDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	compositionDesc.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	//The render graph transitions the composition around the pass
+	compositionDesc.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	compositionDesc.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 	compositionDesc.format = mComposition.format;
 
@@ -59,42 +53,12 @@ void L_Pass::CreateRenderPass()
 	subpass.colorAttachmentCount = 1;
 	subpass.pDepthStencilAttachment = VK_NULL_HANDLE;
 
-	// Use subpass dependencies for attachment layout transitions
-	// src: Before render
-	// dst: After render
-	std::array<VkSubpassDependency, 2> dependencies;
-
-	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependencies[0].dstSubpass = 0;
-
-	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-
-	dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-	dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-
-	dependencies[1].srcSubpass = 0;
-	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-
-	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-
-	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-
-	dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
 	VkRenderPassCreateInfo renderPassInfo = {};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	renderPassInfo.pAttachments = &compositionDesc;
 	renderPassInfo.attachmentCount = 1;
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 2;
-	renderPassInfo.pDependencies = dependencies.data();
 	VK_CHECK_RESULT(vkCreateRenderPass(mApp->mVulkanDevice->logicalDevice, &renderPassInfo, nullptr, &mRenderPass))
 }
 
@@ -160,7 +124,7 @@ void L_Pass::CreatePipelineLayout()
 	VK_CHECK_RESULT(vkCreatePipelineLayout(mApp->mVulkanDevice->logicalDevice, &LightpipelineLayoutCreateInfo, nullptr, &mPipelineLayout))
 }
 
-void L_Pass::CreatePipeline()
+VkPipeline L_Pass::CreatePipeline()
 {
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState =
 		initializers::pipelineInputAssemblyStateCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
@@ -194,12 +158,12 @@ void L_Pass::CreatePipeline()
 	pipelineCI.pStages = shaderStages.data();
 
 	rasterizationState.cullMode = VK_CULL_MODE_FRONT_BIT;
-	shaderStages[0] = createShaderStageCreateInfo("../shaders/LightingVert.spv", VK_SHADER_STAGE_VERTEX_BIT, mApp->mVulkanDevice->logicalDevice);
-	shaderStages[1] = createShaderStageCreateInfo("../shaders/LightingFrag.spv", VK_SHADER_STAGE_FRAGMENT_BIT, mApp->mVulkanDevice->logicalDevice);
+	shaderStages[0] = mApp->mPipelineBuilder.ShaderStage("Lighting.vert");
+	shaderStages[1] = mApp->mPipelineBuilder.ShaderStage("Lighting.frag");
 
 	VkPipelineVertexInputStateCreateInfo emptyInput = initializers::pipelineVertexInputStateCreateInfo();
 	pipelineCI.pVertexInputState = &emptyInput;
-	VK_CHECK_RESULT(vkCreateGraphicsPipelines(mApp->mVulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &mPipeline))
+	return mApp->mPipelineBuilder.CreateGraphicsPipeline(pipelineCI);
 }
 
 void L_Pass::Update()
@@ -3,6 +3,7 @@
 #include "Attachment.h"
 
 class VkApp;
+class JobCounter;
 class L_Pass
 {
 private:
@@ -16,24 +17,24 @@ public:
 	void CreateDescriptorSet();
 
 	void CreateFrameData();
-	void CreatePipelineData();
+	//Layouts are created right away, pipelines are built as jobs that count on ready
+	void CreatePipelineData(JobCounter* ready);
 
 	void UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets);
 
 private:
-	void CreateAttachment();
 	void CreateRenderPass();
 	void CreateFrameBuffer();
 
 	void CreatePipelineLayout();
-	void CreatePipeline();
+	VkPipeline CreatePipeline();
 
 public:
 	uint32_t mWidth, mHeight;
 
 	VkFramebuffer mFrameBuffer;
 	VkRenderPass mRenderPass;
-	FrameBufferAttachment mComposition;
+	FrameBufferAttachment mComposition;//Created by the render graph
 
 	VkDescriptorPool mDescriptorPool;
 	VkDescriptorSetLayout mDescriptorLayout;
@@ -0,0 +1,202 @@
+#include "M_Pass.h"
+#include "VkApp.h"
+#include "Mesh.h"
+#include "VulkanInitializers.hpp"
+#include "VulkanTools.h"
+#include <algorithm>
+
+void M_Pass::Init(VkApp* app, uint32_t width, uint32_t height)
+{
+	mApp = app;
+	mWidth = width;
+	mHeight = height;
+}
+
+void M_Pass::Destroy()
+{
+	VkDevice device = mApp->mVulkanDevice->logicalDevice;
+	mDraws.Unmap();
+	mCommands.Unmap();
+	mMeshlets.Unmap();
+	mMeshletIndices.Unmap();
+	mMeshlets.destroy();
+	mMeshletIndices.destroy();
+	mDraws.destroy();
+	mCommands.destroy();
+	mIndices.destroy();
+	for (VkImageView view : mMipViews)
+	{
+		vkDestroyImageView(device, view, nullptr);
+	}
+	vkDestroyImageView(device, mPyramid.view, nullptr);
+	vkDestroyImage(device, mPyramid.image, nullptr);
+	vkFreeMemory(device, mPyramid.memory, nullptr);
+	vkDestroyImageView(device, mDepthView, nullptr);
+}
+
+uint32_t M_Pass::PyramidSize(uint32_t size, uint32_t mip)
+{
+	//Halving and rounding up mip + 1 times is one division rounded up
+	return std::max((size + (2u << mip) - 1) >> (mip + 1), 1u);
+}
+
+void M_Pass::CreateFrameData(uint32_t maxDraws, uint32_t maxIndices)
+{
+	VulkanDevice* device = mApp->mVulkanDevice;
+	mMaxDraws = maxDraws;
+	mMaxIndices = std::max(maxIndices, 1u);
+
+	VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		&mDraws, sizeof(ClusterDraw) * maxDraws))
+	VK_CHECK_RESULT(mDraws.map())
+	mMappedDraws = static_cast<ClusterDraw*>(mDraws.mapped);
+
+	VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &mCommands, sizeof(VkDrawIndexedIndirectCommand) * maxDraws))
+	VK_CHECK_RESULT(mCommands.map())
+	mMappedCommands = static_cast<VkDrawIndexedIndirectCommand*>(mCommands.mapped);
+	std::fill(mMappedCommands, mMappedCommands + maxDraws, VkDrawIndexedIndirectCommand{});
+
+	VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		&mIndices, sizeof(uint32_t) * mMaxIndices))
+
+	CreatePyramid();
+}
+
+void M_Pass::CreateMeshletData(uint32_t maxMeshlets, uint32_t maxIndices)
+{
+	VulkanDevice* device = mApp->mVulkanDevice;
+	mMaxMeshlets = maxMeshlets;
+	mMaxMeshletIndices = maxIndices;
+	VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		&mMeshlets, sizeof(Meshlet) * maxMeshlets))
+	VK_CHECK_RESULT(mMeshlets.map())
+	mMappedMeshlets = static_cast<Meshlet*>(mMeshlets.mapped);
+	VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		&mMeshletIndices, sizeof(uint32_t) * maxIndices))
+	VK_CHECK_RESULT(mMeshletIndices.map())
+	mMappedMeshletIndices = static_cast<uint32_t*>(mMeshletIndices.mapped);
+}
+
+bool M_Pass::AddMesh(Mesh* mesh)
+{
+	if (mMeshletCount + mesh->meshlets.size() > mMaxMeshlets || mMeshletIndexCount + mesh->indices.size() > mMaxMeshletIndices)
+	{
+		return false;
+	}
+
+	//Meshlet indices of a mesh keep pointing into its own vertex buffer, only their position in the SSBO moves
+	mesh->meshletBase = mMeshletCount;
+	for (Meshlet meshlet : mesh->meshlets)
+	{
+		meshlet.firstIndex += mMeshletIndexCount;
+		mMappedMeshlets[mMeshletCount++] = meshlet;
+	}
+	std::copy(mesh->indices.begin(), mesh->indices.end(), mMappedMeshletIndices + mMeshletIndexCount);
+	mMeshletIndexCount += static_cast<uint32_t>(mesh->indices.size());
+	return true;
+}
+
+void M_Pass::CreateDepthView(const FrameBufferAttachment& depth)
+{
+	VkImageViewCreateInfo viewInfo = initializers::imageViewCreateInfo();
+	viewInfo.image = depth.image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = depth.format;
+	viewInfo.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+	VK_CHECK_RESULT(vkCreateImageView(mApp->mVulkanDevice->logicalDevice, &viewInfo, nullptr, &mDepthView))
+}
+
+void M_Pass::CreatePipelineData(JobCounter* ready)
+{
+	CreatePipelineLayout();
+	mApp->mPipelineBuilder.Build("ClusterCull", [this]() { return CreatePipeline("ClusterCull.comp"); }, &mCullPipeline, ready);
+	mApp->mPipelineBuilder.Build("DepthPyramid", [this]() { return CreatePipeline("DepthPyramid.comp"); }, &mPyramidPipeline, ready);
+}
+
+void M_Pass::CreatePyramid()
+{
+	mPyramid.format = VK_FORMAT_R32_SFLOAT;
+	mApp->CreateImage(PyramidSize(mWidth, 0), PyramidSize(mHeight, 0), mPyramid.format, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mPyramid.image, mPyramid.memory, HIZ_MIPS);
+	mPyramid.view = mApp->CreateImageView(mPyramid.image, mPyramid.format, VK_IMAGE_ASPECT_COLOR_BIT, HIZ_MIPS);
+
+	for (uint32_t mip = 0; mip < HIZ_MIPS; ++mip)
+	{
+		VkImageViewCreateInfo viewInfo = initializers::imageViewCreateInfo();
+		viewInfo.image = mPyramid.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = mPyramid.format;
+		viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, mip, 1, 0, 1 };
+		VK_CHECK_RESULT(vkCreateImageView(mApp->mVulkanDevice->logicalDevice, &viewInfo, nullptr, &mMipViews[mip]))
+	}
+}
+
+void M_Pass::CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes)
+{
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+
+	poolInfo.maxSets = 1;
+
+	if (vkCreateDescriptorPool(mApp->mVulkanDevice->logicalDevice, &poolInfo, nullptr, &mDescriptorPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create descriptor pool!");
+	}
+}
+
+void M_Pass::CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings)
+{
+	VkDescriptorSetLayoutCreateInfo cullDescriptorLayout = initializers::descriptorSetLayoutCreateInfo(setLayoutBindings);
+	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(mApp->mVulkanDevice->logicalDevice, &cullDescriptorLayout, nullptr, &mDescriptorLayout))
+}
+
+void M_Pass::CreateDescriptorSet()
+{
+	VkDescriptorSetAllocateInfo setAllocInfo{};
+	setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocInfo.descriptorPool = mDescriptorPool;
+	setAllocInfo.descriptorSetCount = 1;
+	setAllocInfo.pSetLayouts = &mDescriptorLayout;
+
+	if (vkAllocateDescriptorSets(mApp->mVulkanDevice->logicalDevice, &setAllocInfo, &mDescriptorSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate descriptor sets");
+	}
+}
+
+void M_Pass::UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets)
+{
+	vkUpdateDescriptorSets(mApp->mVulkanDevice->logicalDevice, static_cast<uint32_t>(writeDescSets.size()), writeDescSets.data(), 0, nullptr);
+}
+
+void M_Pass::CreatePipelineLayout()
+{
+	//Both dispatches share the layout, its push constant range is the larger of the two
+	if (mApp->mShaders.ReflectPushConstants({ "ClusterCull.comp" }).size != sizeof(ClusterCullPushConstant))
+	{
+		throw std::runtime_error("failed to match ClusterCullPushConstant with the cluster culling shader!");
+	}
+	if (mApp->mShaders.ReflectPushConstants({ "DepthPyramid.comp" }).size != sizeof(DepthPyramidPushConstant))
+	{
+		throw std::runtime_error("failed to match DepthPyramidPushConstant with the depth pyramid shader!");
+	}
+	mPushConstants = mApp->mShaders.ReflectPushConstants({ "ClusterCull.comp", "DepthPyramid.comp" });
+
+	VkPipelineLayoutCreateInfo pipelinelayoutCI = initializers::pipelineLayoutCreateInfo(&mDescriptorLayout, 1);
+	pipelinelayoutCI.pushConstantRangeCount = 1;
+	pipelinelayoutCI.pPushConstantRanges = &mPushConstants;
+
+	VK_CHECK_RESULT(vkCreatePipelineLayout(mApp->mVulkanDevice->logicalDevice, &pipelinelayoutCI, nullptr, &mPipelineLayout))
+}
+
+VkPipeline M_Pass::CreatePipeline(const char* source)
+{
+	VkComputePipelineCreateInfo pipelineCI{};
+	pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineCI.layout = mPipelineLayout;
+	pipelineCI.stage = mApp->mPipelineBuilder.ShaderStage(source);
+	return mApp->mPipelineBuilder.CreateComputePipeline(pipelineCI);
+}
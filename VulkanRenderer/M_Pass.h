@@ -0,0 +1,90 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "Attachment.h"
+#include "UniformStructure.h"
+#include "VulkanBuffer.h"
+#include <vector>
+
+//Meshes added once these are full are drawn without meshlet culling
+#define CLUSTER_MAX_MESHLETS (32 * 1024)
+#define CLUSTER_MAX_MESHLET_INDICES (4 * 1024 * 1024)
+//Indices all drawn objects may leave after culling together, more than that and the frame draws without it
+#define CLUSTER_MAX_DRAWN_INDICES (4 * 1024 * 1024)
+
+class VkApp;
+class JobCounter;
+struct Mesh;
+//Meshlet culling on the GPU, without mesh shaders. One group per drawn object tests the meshlets of its level against
+//the frustum, their normal cone and last frame's depth pyramid, and copies the triangles of the survivors into a compacted
+//index buffer. The G-buffer draws each object with vkCmdDrawIndexedIndirect from the command the group wrote.
+//The pyramid is built at the end of the frame from the G-buffer depth, every texel keeps the farthest depth below it
+class M_Pass
+{
+private:
+	VkApp* mApp = nullptr;
+public:
+	void Init(VkApp* app, uint32_t width, uint32_t height);
+	void Destroy();
+
+	void CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes);
+	void CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings);
+	void CreateDescriptorSet();
+
+	//Room for maxDraws objects whose levels add up to at most maxIndices indices
+	void CreateFrameData(uint32_t maxDraws, uint32_t maxIndices);
+	//The meshlets of every mesh share one SSBO, meshes are added as they finish loading
+	void CreateMeshletData(uint32_t maxMeshlets, uint32_t maxIndices);
+	//Appends the mesh's meshlets and sets Mesh::meshletBase, false once there is no room left for them.
+	//Nothing is ever removed, the GPU may still read the ranges of meshes freed since
+	bool AddMesh(Mesh* mesh);
+	//The pyramid samples the G-buffer depth through a view of its depth aspect, once the render graph created it
+	void CreateDepthView(const FrameBufferAttachment& depth);
+	//Layouts are created right away, pipelines are built as jobs that count on ready
+	void CreatePipelineData(JobCounter* ready);
+
+	void UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets);
+
+	//Size of a pyramid mip when the depth covers width x height
+	static uint32_t PyramidSize(uint32_t size, uint32_t mip);
+
+private:
+	void CreatePyramid();
+
+	void CreatePipelineLayout();
+	VkPipeline CreatePipeline(const char* source);
+
+public:
+	uint32_t mWidth, mHeight;//Of the depth, the first mip is half of it
+	uint32_t mMaxDraws = 0;
+	uint32_t mMaxIndices = 0;//Of the compacted index buffer
+
+	//Host visible, meshes are appended while earlier frames are done with what is there
+	Buffer mMeshlets;
+	Meshlet* mMappedMeshlets = nullptr;
+	uint32_t mMeshletCount = 0;
+	uint32_t mMaxMeshlets = 0;
+	Buffer mMeshletIndices;//Every mesh's indices, meshlet by meshlet
+	uint32_t* mMappedMeshletIndices = nullptr;
+	uint32_t mMeshletIndexCount = 0;
+	uint32_t mMaxMeshletIndices = 0;
+	Buffer mDraws;//ClusterDraw per object, written by the host every frame
+	ClusterDraw* mMappedDraws = nullptr;
+	//Host visible so the GUI can read back what the last frame drew, it is a few bytes per object
+	Buffer mCommands;
+	VkDrawIndexedIndirectCommand* mMappedCommands = nullptr;
+	Buffer mIndices;//Compacted triangles of the surviving meshlets
+
+	//view covers every mip for sampling, imported into the render graph
+	FrameBufferAttachment mPyramid;
+	VkImageView mMipViews[HIZ_MIPS];//Storage views of single mips
+	VkImageView mDepthView = VK_NULL_HANDLE;
+
+	VkDescriptorPool mDescriptorPool;
+	VkDescriptorSetLayout mDescriptorLayout;
+	VkDescriptorSet mDescriptorSet;
+
+	VkPipelineLayout mPipelineLayout;//Shared by both dispatches
+	VkPipeline mCullPipeline;
+	VkPipeline mPyramidPipeline;
+	VkPushConstantRange mPushConstants{};//Reflected, pushes have to use its stage flags
+};
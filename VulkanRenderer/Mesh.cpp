@@ -1,9 +1,12 @@
-#define TINYOBJLOADER_IMPLEMENTATION
 #include "Mesh.h"
-#include <tiny_obj_loader.h>
 #include <iostream>
+#include <algorithm>
+#include <unordered_map>
 
 #include "VulkanDevice.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "ObjParser.h"
 
 VkVertexInputBindingDescription Vertex::getBindingDescription()
 {
@@ -37,87 +40,166 @@ std::array<VkVertexInputAttributeDescription, 3> Vertex::getAttributeDescription
 
 /*******************************************************************/
 
-bool Mesh::loadFromObj(const char* filename, glm::vec3 assignedColor, bool flip_y)
+bool Mesh::loadFromObj(const char* filename, glm::vec3 assignedColor, bool flip_y, JobSystem* jobSystem)
 {
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-
-	std::string warning;
+	ObjParser::Result obj;
 	std::string error;
-
-	tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, filename, nullptr);
-
-	if(warning.empty() == false)
+	if (ObjParser::Parse(filename, jobSystem, obj, &error) == false)
 	{
-		std::cout << "WARN: " << warning << std::endl;
+		std::cerr << error << std::endl;
+		return false;
 	}
 
-	if (warning.empty() == false)
+	//Corners that use the same position, normal and UV become one vertex
+	struct IndexHash
 	{
-		std::cerr << error << std::endl;
-		return false;
+		size_t operator()(const ObjParser::Index& index) const
+		{
+			return (static_cast<size_t>(index.position) * 73856093u) ^ (static_cast<size_t>(index.normal) * 19349663u)
+				^ (static_cast<size_t>(index.texcoord) * 83492791u);
+		}
+	};
+	struct IndexEqual
+	{
+		bool operator()(const ObjParser::Index& l, const ObjParser::Index& r) const
+		{
+			return l.position == r.position && l.normal == r.normal && l.texcoord == r.texcoord;
+		}
+	};
+	std::unordered_map<ObjParser::Index, uint32_t, IndexHash, IndexEqual> uniqueVertices;
+	uniqueVertices.reserve(obj.positions.size());
+	vertices.reserve(obj.positions.size());
+	indices.reserve(obj.corners.size());
+	faceNum += static_cast<int>(obj.corners.size() / 3);
+
+	//Scans often come without normals, those vertices get the area weighted normals of their triangles below
+	std::vector<uint32_t> unnormalized;
+	for (const ObjParser::Index& corner : obj.corners)
+	{
+		auto unique = uniqueVertices.find(corner);
+		if (unique != uniqueVertices.end())
+		{
+			indices.push_back(unique->second);
+			continue;
+		}
+
+		Vertex new_vert;
+		new_vert.position = obj.positions[corner.position];
+		new_vert.normal = corner.normal >= 0 ? obj.normals[corner.normal] : glm::vec3(0.f);
+		new_vert.UV = corner.texcoord >= 0 ? obj.texcoords[corner.texcoord] : glm::vec2(0.f);
+		if (flip_y == true)
+		{
+			new_vert.position.y = -new_vert.position.y;
+			new_vert.normal.y = -new_vert.normal.y;
+		}
+		if (corner.normal < 0)
+		{
+			unnormalized.push_back(static_cast<uint32_t>(vertices.size()));
+		}
+
+		uniqueVertices.emplace(corner, static_cast<uint32_t>(vertices.size()));
+		indices.push_back(static_cast<uint32_t>(vertices.size()));
+		vertices.push_back(new_vert);
 	}
 
-	// Loop over shapes
-	for (size_t s = 0; s < shapes.size(); s++) {
-		// Loop over faces(polygon)
-		size_t index_offset = 0;
-		faceNum += shapes[s].mesh.num_face_vertices.size();
-		for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
-
-			//hardcode loading to triangles
-			int fv = 3;
-
-			// Loop over vertices in the face.
-			for (size_t v = 0; v < fv; v++) {
-				// access to vertex
-				tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-
-				//vertex position
-				tinyobj::real_t vx = attrib.vertices[3 * idx.vertex_index + 0];
-				tinyobj::real_t vy = attrib.vertices[3 * idx.vertex_index + 1];
-				tinyobj::real_t vz = attrib.vertices[3 * idx.vertex_index + 2];
-				//vertex normal
-				tinyobj::real_t nx = attrib.normals[3 * idx.normal_index + 0];
-				tinyobj::real_t ny = attrib.normals[3 * idx.normal_index + 1];
-				tinyobj::real_t nz = attrib.normals[3 * idx.normal_index + 2];
-				//vertex uv
-				tinyobj::real_t UV_u = attrib.texcoords[2 * idx.texcoord_index + 0];
-				tinyobj::real_t UV_v = attrib.texcoords[2 * idx.texcoord_index + 1];
-
-				
-				//copy it into our vertex
-				Vertex new_vert;
-				if (flip_y == true)
-				{
-					new_vert.position.y = -vy;
-					new_vert.normal.y = -ny;
-				}
-				else
+	if (unnormalized.empty() == false)
+	{
+		std::vector<uint8_t> needsNormal(vertices.size(), 0);
+		for (uint32_t vertex : unnormalized)
+		{
+			needsNormal[vertex] = 1;
+		}
+		//Mirroring y turns the winding around, the cross product has to follow
+		const float winding = flip_y == true ? -1.f : 1.f;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const glm::vec3& p0 = vertices[indices[i]].position;
+			glm::vec3 faceNormal = glm::cross(vertices[indices[i + 1]].position - p0, vertices[indices[i + 2]].position - p0) * winding;
+			for (size_t corner = i; corner < i + 3; ++corner)
+			{
+				if (needsNormal[indices[corner]] != 0)
 				{
-					new_vert.position.y = vy;
-					new_vert.normal.y = ny;
+					vertices[indices[corner]].normal += faceNormal;
 				}
-				new_vert.position.x = vx;
-				new_vert.position.z = vz;
-
-				new_vert.normal.x = nx;
-				new_vert.normal.z = nz;
+			}
+		}
+		for (uint32_t vertex : unnormalized)
+		{
+			float length = glm::length(vertices[vertex].normal);
+			vertices[vertex].normal = length > 0.f ? vertices[vertex].normal / length : glm::vec3(0.f, 1.f, 0.f);
+		}
+	}
 
-				new_vert.UV.x = UV_u;
-				new_vert.UV.y = UV_v;
+	vertexNum = static_cast<int>(vertices.size());
 
-				vertices.push_back(new_vert);
-			}
-			index_offset += fv;
+	if (vertices.empty() == false)
+	{
+		glm::vec3 minPos = vertices[0].position;
+		glm::vec3 maxPos = vertices[0].position;
+		for (const Vertex& vertex : vertices)
+		{
+			minPos = glm::min(minPos, vertex.position);
+			maxPos = glm::max(maxPos, vertex.position);
+		}
+		boundCenter = (minPos + maxPos) * 0.5f;
+		for (const Vertex& vertex : vertices)
+		{
+			boundRadius = std::max(boundRadius, glm::length(vertex.position - boundCenter));
 		}
 	}
-	vertexNum = faceNum * 3;
 
 	return true;
 }
 
+void Mesh::buildLods()
+{
+	const uint32_t fullCount = static_cast<uint32_t>(indices.size());
+	lods.clear();
+	lods.push_back({ 0, fullCount, 0.f });
+
+	std::vector<glm::vec3> positions(vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		positions[i] = vertices[i].position;
+	}
+
+	//Every level starts again from the full mesh so its error is measured against the real surface.
+	//Beyond a quarter of the bounds the shape itself would change, that is left to the coarsest level there is
+	const std::vector<uint32_t> full = indices;
+	for (uint32_t level = 1; level < MAX_MESH_LODS; ++level)
+	{
+		float error = 0.f;
+		std::vector<uint32_t> simplified = MeshSimplifier::Simplify(positions, full, (fullCount >> level) / 3 * 3, boundRadius * 0.25f, &error);
+		if (simplified.empty() == true || simplified.size() * 4 > static_cast<size_t>(lods.back().indexCount) * 3)
+		{
+			break;
+		}
+		lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), std::max(error, lods.back().error) });
+		indices.insert(indices.end(), simplified.begin(), simplified.end());
+	}
+}
+
+void Mesh::buildMeshlets()
+{
+	std::vector<glm::vec3> positions(vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		positions[i] = vertices[i].position;
+	}
+
+	meshlets.clear();
+	for (Lod& lod : lods)
+	{
+		lod.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+		MeshletBuilder::Build(positions, &indices[lod.firstIndex], lod.indexCount, meshlets);
+		lod.meshletCount = static_cast<uint32_t>(meshlets.size()) - lod.firstMeshlet;
+		for (uint32_t i = lod.firstMeshlet; i < lod.firstMeshlet + lod.meshletCount; ++i)
+		{
+			meshlets[i].firstIndex += lod.firstIndex;
+		}
+	}
+}
+
 void Mesh::createVertexBuffer(VulkanDevice* vulkanDevice)
 {
 	VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
@@ -127,16 +209,41 @@ void Mesh::createVertexBuffer(VulkanDevice* vulkanDevice)
 }
 
 
-bool Mesh::loadAndCreateMesh(const char* filename, VulkanDevice* vulkan_device, glm::vec3 assignedColor)
+void Mesh::createIndexBuffer(VulkanDevice* vulkanDevice)
+{
+	VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
+
+	vulkanDevice->createBuffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		bufferSize, &indexBuffer, &indexBufferMemory, indices.data());
+}
+
+bool Mesh::loadAndCreateMesh(const char* filename, VulkanDevice* vulkan_device, glm::vec3 assignedColor, JobSystem* jobSystem)
 {
-	loadFromObj(filename, assignedColor, false);
+	if (loadFromObj(filename, assignedColor, false, jobSystem) == false)
+	{
+		return false;
+	}
+	createMesh(vulkan_device);
+	return true;
+}
+
+void Mesh::createMesh(VulkanDevice* vulkan_device)
+{
+	buildLods();
+	buildMeshlets();
 	createVertexBuffer(vulkan_device);
+	createIndexBuffer(vulkan_device);
 	logicalDevice = vulkan_device->logicalDevice;
-	return true;
 }
 
 Mesh::~Mesh()
 {
+	if (logicalDevice == VK_NULL_HANDLE)
+	{
+		return;
+	}
 	vkDestroyBuffer(logicalDevice, vertexBuffer, nullptr);
 	vkFreeMemory(logicalDevice, vertexBufferMemory, nullptr);
+	vkDestroyBuffer(logicalDevice, indexBuffer, nullptr);
+	vkFreeMemory(logicalDevice, indexBufferMemory, nullptr);
 }
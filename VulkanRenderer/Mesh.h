@@ -4,8 +4,12 @@
 #include <glm/glm.hpp>
 #include <vulkan/vulkan_core.h>
 #include <array>
+#include "UniformStructure.h"
+
+#define MAX_MESH_LODS 4
 
 struct VulkanDevice;
+class JobSystem;
 
 struct Vertex
 {
@@ -20,18 +24,46 @@ struct Vertex
 struct Mesh
 {
 public:
+	//A range of the index buffer, all levels index the same vertices
+	struct Lod
+	{
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		float error;//Object space distance to the full mesh's surface
+		uint32_t firstMeshlet = 0;
+		uint32_t meshletCount = 0;
+	};
+
 	std::vector<Vertex> vertices;
-	bool loadAndCreateMesh(const char* filename, VulkanDevice* vulkan_device, glm::vec3 assignedColor);
-	bool loadFromObj(const char* filename, glm::vec3 assignedColor, bool flip_y = true);
+	std::vector<uint32_t> indices;//Every level one after another, the full mesh first
+	std::vector<Lod> lods;
+	std::vector<Meshlet> meshlets;//Every level's, each one a range of its level's indices
+	uint32_t meshletBase = UINT32_MAX;//Where meshlets start in the cluster culling pass's SSBO, UINT32_MAX until added there
+	//jobSystem splits the parsing of large files across its threads, without it the calling thread does it all
+	bool loadAndCreateMesh(const char* filename, VulkanDevice* vulkan_device, glm::vec3 assignedColor, JobSystem* jobSystem = nullptr);
+	bool loadFromObj(const char* filename, glm::vec3 assignedColor, bool flip_y = true, JobSystem* jobSystem = nullptr);
+	//Levels, meshlets and buffers of the vertices and indices already filled in
+	void createMesh(VulkanDevice* vulkan_device);
+	//Halves the triangle count per level until simplifying stops paying off
+	void buildLods();
+	//Reorders each level's triangles into meshlets
+	void buildMeshlets();
 	void createVertexBuffer(VulkanDevice* vulkanDevice);
+	void createIndexBuffer(VulkanDevice* vulkanDevice);
 	~Mesh();
 	//TODO: Ҹ Ȥ destroy  Buffer Ҵ  ؾ!
 public:
-	VkBuffer vertexBuffer;
-	VkDeviceMemory vertexBufferMemory;
+	VkBuffer vertexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
+	VkBuffer indexBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory indexBufferMemory = VK_NULL_HANDLE;
 
 	int vertexNum = 0;
 	int faceNum = 0;
+
+	//Object space bounding sphere
+	glm::vec3 boundCenter = glm::vec3(0.f);
+	float boundRadius = 0.f;
 private:
-	VkDevice logicalDevice;
+	VkDevice logicalDevice = VK_NULL_HANDLE;//Stays null until the buffers exist
 };
\ No newline at end of file
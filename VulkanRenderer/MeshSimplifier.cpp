@@ -0,0 +1,255 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+void MeshSimplifier::Quadric::AddPlane(const glm::dvec4& plane, double planeWeight)
+{
+	a2 += plane.x * plane.x * planeWeight;
+	ab += plane.x * plane.y * planeWeight;
+	ac += plane.x * plane.z * planeWeight;
+	ad += plane.x * plane.w * planeWeight;
+	b2 += plane.y * plane.y * planeWeight;
+	bc += plane.y * plane.z * planeWeight;
+	bd += plane.y * plane.w * planeWeight;
+	c2 += plane.z * plane.z * planeWeight;
+	cd += plane.z * plane.w * planeWeight;
+	d2 += plane.w * plane.w * planeWeight;
+	weight += planeWeight;
+}
+
+void MeshSimplifier::Quadric::Add(const Quadric& other)
+{
+	a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+	b2 += other.b2; bc += other.bc; bd += other.bd;
+	c2 += other.c2; cd += other.cd;
+	d2 += other.d2;
+	weight += other.weight;
+}
+
+double MeshSimplifier::Quadric::Evaluate(const glm::vec3& point) const
+{
+	const double x = point.x, y = point.y, z = point.z;
+	double sum = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+		+ b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+		+ c2 * z * z + 2.0 * cd * z
+		+ d2;
+	return weight > 0.0 ? std::max(sum, 0.0) / weight : 0.0;
+}
+
+std::vector<uint32_t> MeshSimplifier::Simplify(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices,
+	size_t targetIndexCount, float maxError, float* error)
+{
+	const uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+	std::vector<uint32_t> result = indices;
+	*error = 0.f;
+
+	//Vertices that share a position are one point of the surface, topology and quadrics are worked out on those
+	struct PositionHash
+	{
+		size_t operator()(const glm::vec3& p) const
+		{
+			uint32_t bits[3];
+			std::memcpy(bits, &p, sizeof(bits));
+			return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+		}
+	};
+	std::unordered_map<glm::vec3, uint32_t, PositionHash> firstAtPosition;
+	firstAtPosition.reserve(vertexCount);
+	std::vector<uint32_t> point(vertexCount);
+	std::vector<uint32_t> pointVertices(vertexCount, 0);
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		point[v] = firstAtPosition.emplace(positions[v], v).first->second;
+		++pointVertices[point[v]];
+	}
+
+	std::vector<uint8_t> locked(vertexCount, 0);
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		locked[v] = pointVertices[point[v]] > 1 ? 1 : 0;
+	}
+
+	//An edge of a single triangle is on an open border
+	std::unordered_map<uint64_t, uint32_t> edgeUse;
+	edgeUse.reserve(result.size());
+	auto edgeKey = [&point](uint32_t a, uint32_t b)
+	{
+		uint32_t pa = point[a], pb = point[b];
+		return pa < pb ? (static_cast<uint64_t>(pa) << 32) | pb : (static_cast<uint64_t>(pb) << 32) | pa;
+	};
+	for (size_t i = 0; i < result.size(); i += 3)
+	{
+		for (uint32_t e = 0; e < 3; ++e)
+		{
+			++edgeUse[edgeKey(result[i + e], result[i + (e + 1) % 3])];
+		}
+	}
+	for (size_t i = 0; i < result.size(); i += 3)
+	{
+		for (uint32_t e = 0; e < 3; ++e)
+		{
+			uint32_t a = result[i + e], b = result[i + (e + 1) % 3];
+			if (edgeUse[edgeKey(a, b)] == 1)
+			{
+				locked[a] = 1;
+				locked[b] = 1;
+			}
+		}
+	}
+
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t i = 0; i < result.size(); i += 3)
+	{
+		glm::dvec3 p0 = positions[result[i]], p1 = positions[result[i + 1]], p2 = positions[result[i + 2]];
+		glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+		double length = glm::length(normal);
+		if (length <= 0.0)
+		{
+			continue;
+		}
+		normal /= length;
+		glm::dvec4 plane(normal, -glm::dot(normal, p0));
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			quadrics[point[result[i + corner]]].AddPlane(plane, length * 0.5);
+		}
+	}
+
+	const double maxCost = static_cast<double>(maxError) * maxError;
+	double worstCost = 0.0;
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<Collapse> collapses;
+	std::vector<uint8_t> touched(vertexCount);
+
+	//Each round collapses a set of edges far enough apart that none of them sees another's changes
+	while (result.size() > targetIndexCount)
+	{
+		//Triangles around every vertex
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32_t index : result)
+		{
+			++adjacencyOffsets[index + 1];
+		}
+		for (uint32_t v = 0; v < vertexCount; ++v)
+		{
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		}
+		adjacency.resize(result.size());
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < result.size(); ++i)
+		{
+			adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		collapses.clear();
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			for (uint32_t e = 0; e < 3; ++e)
+			{
+				uint32_t a = result[i + e], b = result[i + (e + 1) % 3];
+				if (locked[a] == 0)
+				{
+					Quadric merged = quadrics[point[a]];
+					merged.Add(quadrics[point[b]]);
+					collapses.push_back({ a, b, merged.Evaluate(positions[b]) });
+				}
+				if (locked[b] == 0)
+				{
+					Quadric merged = quadrics[point[b]];
+					merged.Add(quadrics[point[a]]);
+					collapses.push_back({ b, a, merged.Evaluate(positions[a]) });
+				}
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r) { return l.cost < r.cost; });
+
+		std::fill(touched.begin(), touched.end(), 0);
+		size_t triangleCount = result.size() / 3;
+		const size_t targetTriangles = targetIndexCount / 3;
+		uint32_t collapsed = 0;
+		for (const Collapse& collapse : collapses)
+		{
+			if (collapse.cost > maxCost || triangleCount <= targetTriangles)
+			{
+				break;
+			}
+			if (touched[collapse.from] != 0 || touched[collapse.to] != 0)
+			{
+				continue;
+			}
+
+			//Triangles that stay must not turn over or get squashed flat
+			const glm::vec3& target = positions[collapse.to];
+			bool flips = false;
+			for (uint32_t t = adjacencyOffsets[collapse.from]; t < adjacencyOffsets[collapse.from + 1] && flips == false; ++t)
+			{
+				const uint32_t* triangle = &result[adjacency[t] * 3];
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+				{
+					continue;
+				}
+				glm::vec3 before[3], after[3];
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					before[corner] = positions[triangle[corner]];
+					after[corner] = triangle[corner] == collapse.from ? target : before[corner];
+				}
+				glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+				glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+				float lengths = glm::length(normalBefore) * glm::length(normalAfter);
+				flips = !(glm::dot(normalBefore, normalAfter) > 0.25f * lengths);
+			}
+			if (flips == true)
+			{
+				continue;
+			}
+
+			for (uint32_t t = adjacencyOffsets[collapse.from]; t < adjacencyOffsets[collapse.from + 1]; ++t)
+			{
+				uint32_t* triangle = &result[adjacency[t] * 3];
+				bool degenerate = false;
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					degenerate = degenerate || triangle[corner] == collapse.to;
+					touched[triangle[corner]] = 1;
+				}
+				for (uint32_t corner = 0; corner < 3; ++corner)
+				{
+					if (triangle[corner] == collapse.from)
+					{
+						triangle[corner] = collapse.to;
+					}
+				}
+				triangleCount -= degenerate == true ? 1 : 0;
+			}
+			quadrics[point[collapse.to]].Add(quadrics[point[collapse.from]]);
+			worstCost = std::max(worstCost, collapse.cost);
+			++collapsed;
+		}
+
+		//Triangles that lost a corner are gone
+		size_t write = 0;
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			uint32_t a = result[i], b = result[i + 1], c = result[i + 2];
+			if (a != b && b != c && a != c)
+			{
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+		}
+		result.resize(write);
+
+		if (collapsed == 0)
+		{
+			break;
+		}
+	}
+
+	*error = static_cast<float>(std::sqrt(worstCost));
+	return result;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+//Quadric error edge collapse. A vertex only ever moves onto one of its neighbors, so every level it produces
+//indexes the original vertex buffer. Vertices on open borders and attribute seams, where one position has
+//several vertices with different normals or UVs, stay where they are so no cracks open up
+class MeshSimplifier
+{
+public:
+	//Collapses the cheapest edges until at most targetIndexCount indices are left or the next collapse would move
+	//the surface further than maxError. error receives the largest such distance in the units of positions
+	static std::vector<uint32_t> Simplify(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices,
+		size_t targetIndexCount, float maxError, float* error);
+
+private:
+	//Sum of squared distances to the planes of the surrounding triangles, weighted by their area
+	struct Quadric
+	{
+		double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0;
+		double b2 = 0.0, bc = 0.0, bd = 0.0;
+		double c2 = 0.0, cd = 0.0;
+		double d2 = 0.0;
+		double weight = 0.0;
+
+		void AddPlane(const glm::dvec4& plane, double planeWeight);
+		void Add(const Quadric& other);
+		//Mean squared distance of point to the planes
+		double Evaluate(const glm::vec3& point) const;
+	};
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+};
@@ -0,0 +1,169 @@
+#include "MeshletBuilder.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+void MeshletBuilder::Build(const std::vector<glm::vec3>& positions, uint32_t* indices, uint32_t indexCount, std::vector<Meshlet>& meshlets)
+{
+	const uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+	const uint32_t triangleCount = indexCount / 3;
+
+	//Triangles around every vertex
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		++adjacencyOffsets[indices[i] + 1];
+	}
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+	}
+	std::vector<uint32_t> adjacency(indexCount);
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		adjacency[fill[indices[i]]++] = i / 3;
+	}
+
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	std::vector<uint32_t> vertexMeshlet(vertexCount, UINT32_MAX);//Last meshlet that took the vertex
+	std::vector<uint32_t> meshletVertices;
+	meshletVertices.reserve(MESHLET_MAX_VERTICES);
+	std::vector<uint32_t> order;
+	order.reserve(indexCount);
+	uint32_t meshletId = 0;
+	uint32_t meshletTriangles = 0;
+	uint32_t nextSeed = 0;
+
+	auto newVertices = [&](uint32_t triangle)
+	{
+		uint32_t count = 0;
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			count += vertexMeshlet[indices[triangle * 3 + corner]] != meshletId ? 1 : 0;
+		}
+		return count;
+	};
+	auto close = [&]()
+	{
+		if (meshletTriangles == 0)
+		{
+			return;
+		}
+		const uint32_t firstIndex = static_cast<uint32_t>(order.size()) - meshletTriangles * 3;
+		Meshlet meshlet = ComputeBounds(positions, &order[firstIndex], meshletTriangles);
+		meshlet.firstIndex = firstIndex;
+		meshlets.push_back(meshlet);
+		meshletVertices.clear();
+		meshletTriangles = 0;
+		++meshletId;
+	};
+
+	for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+	{
+		//The neighbor that adds the fewest vertices, one adding none can't be beaten
+		uint32_t best = UINT32_MAX;
+		uint32_t bestNew = 4;
+		for (size_t i = 0; i < meshletVertices.size() && bestNew > 0; ++i)
+		{
+			const uint32_t v = meshletVertices[i];
+			for (uint32_t t = adjacencyOffsets[v]; t < adjacencyOffsets[v + 1]; ++t)
+			{
+				const uint32_t triangle = adjacency[t];
+				if (emitted[triangle] != 0)
+				{
+					continue;
+				}
+				uint32_t added = newVertices(triangle);
+				if (added < bestNew)
+				{
+					best = triangle;
+					bestNew = added;
+				}
+			}
+		}
+
+		//A full meshlet goes on with that neighbor in a new one, a patch with no neighbors left with the next triangle in order
+		if (best == UINT32_MAX)
+		{
+			while (emitted[nextSeed] != 0)
+			{
+				++nextSeed;
+			}
+			best = nextSeed;
+			close();
+		}
+		else if (meshletVertices.size() + bestNew > MESHLET_MAX_VERTICES || meshletTriangles == MESHLET_MAX_TRIANGLES)
+		{
+			close();
+		}
+
+		emitted[best] = 1;
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			const uint32_t v = indices[best * 3 + corner];
+			if (vertexMeshlet[v] != meshletId)
+			{
+				vertexMeshlet[v] = meshletId;
+				meshletVertices.push_back(v);
+			}
+			order.push_back(v);
+		}
+		++meshletTriangles;
+	}
+	close();
+
+	std::copy(order.begin(), order.end(), indices);
+}
+
+Meshlet MeshletBuilder::ComputeBounds(const std::vector<glm::vec3>& positions, const uint32_t* indices, uint32_t triangleCount)
+{
+	Meshlet meshlet{};
+	meshlet.triangleCount = triangleCount;
+
+	glm::vec3 minimum(FLT_MAX);
+	glm::vec3 maximum(-FLT_MAX);
+	for (uint32_t i = 0; i < triangleCount * 3; ++i)
+	{
+		minimum = glm::min(minimum, positions[indices[i]]);
+		maximum = glm::max(maximum, positions[indices[i]]);
+	}
+	glm::vec3 center = (minimum + maximum) * 0.5f;
+	float radius = 0.f;
+	for (uint32_t i = 0; i < triangleCount * 3; ++i)
+	{
+		radius = std::max(radius, glm::length(positions[indices[i]] - center));
+	}
+	meshlet.sphere = glm::vec4(center, radius);
+
+	//The cone around the face normals. Beyond a hemisphere some triangle faces every direction and nothing can be culled
+	glm::vec3 normals[MESHLET_MAX_TRIANGLES];
+	uint32_t normalCount = 0;
+	glm::vec3 axis(0.f);
+	for (uint32_t t = 0; t < triangleCount; ++t)
+	{
+		const glm::vec3& p0 = positions[indices[t * 3]];
+		glm::vec3 normal = glm::cross(positions[indices[t * 3 + 1]] - p0, positions[indices[t * 3 + 2]] - p0);
+		float length = glm::length(normal);
+		if (length > 0.f)
+		{
+			normals[normalCount] = normal / length;
+			axis += normals[normalCount];
+			++normalCount;
+		}
+	}
+	float axisLength = glm::length(axis);
+	if (normalCount == 0 || axisLength <= 0.f)
+	{
+		meshlet.cone = glm::vec4(0.f, 0.f, 1.f, 1.f);
+		return meshlet;
+	}
+	axis /= axisLength;
+	float minDot = 1.f;
+	for (uint32_t n = 0; n < normalCount; ++n)
+	{
+		minDot = std::min(minDot, glm::dot(normals[n], axis));
+	}
+	meshlet.cone = glm::vec4(axis, minDot <= 0.1f ? 1.f : std::sqrt(1.f - minDot * minDot));
+	return meshlet;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "UniformStructure.h"
+
+//Greedy clustering of a triangle list into meshlets of at most MESHLET_MAX_VERTICES vertices and
+//MESHLET_MAX_TRIANGLES triangles. Each meshlet grows by the neighbor that adds the fewest new vertices,
+//so it stays a compact patch with tight bounds for the GPU culling pass
+class MeshletBuilder
+{
+public:
+	//Reorders the indexCount indices in place so every meshlet is a contiguous range of them and appends the meshlets.
+	//Their firstIndex is relative to indices, their bounds are in the units of positions
+	static void Build(const std::vector<glm::vec3>& positions, uint32_t* indices, uint32_t indexCount, std::vector<Meshlet>& meshlets);
+
+private:
+	static Meshlet ComputeBounds(const std::vector<glm::vec3>& positions, const uint32_t* indices, uint32_t triangleCount);
+};
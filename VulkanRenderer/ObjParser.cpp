@@ -0,0 +1,552 @@
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "ObjParser.h"
+#include "JobSystem.h"
+#include <tiny_obj_loader.h>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//Smaller files are not worth another job
+#define OBJ_MIN_CHUNK_BYTES (64 * 1024)
+
+namespace
+{
+	//Read only view of a whole file, unmapped when it goes out of scope
+	class MappedFile
+	{
+	public:
+		explicit MappedFile(const char* filename)
+		{
+#ifdef _WIN32
+			mFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (mFile == INVALID_HANDLE_VALUE)
+			{
+				return;
+			}
+			LARGE_INTEGER size;
+			if (GetFileSizeEx(mFile, &size) == FALSE || size.QuadPart == 0)
+			{
+				return;
+			}
+			mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mMapping == nullptr)
+			{
+				return;
+			}
+			mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+			mSize = mData != nullptr ? static_cast<size_t>(size.QuadPart) : 0;
+#else
+			mFile = open(filename, O_RDONLY);
+			if (mFile < 0)
+			{
+				return;
+			}
+			struct stat status;
+			if (fstat(mFile, &status) != 0 || status.st_size == 0)
+			{
+				return;
+			}
+			void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, mFile, 0);
+			if (data == MAP_FAILED)
+			{
+				return;
+			}
+			mData = static_cast<const char*>(data);
+			mSize = static_cast<size_t>(status.st_size);
+			//Every chunk is read front to back once
+			madvise(data, mSize, MADV_SEQUENTIAL);
+#endif
+		}
+
+		~MappedFile()
+		{
+#ifdef _WIN32
+			if (mData != nullptr)
+			{
+				UnmapViewOfFile(mData);
+			}
+			if (mMapping != nullptr)
+			{
+				CloseHandle(mMapping);
+			}
+			if (mFile != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(mFile);
+			}
+#else
+			if (mData != nullptr)
+			{
+				munmap(const_cast<char*>(mData), mSize);
+			}
+			if (mFile >= 0)
+			{
+				close(mFile);
+			}
+#endif
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const char* Data() const { return mData; }
+		size_t Size() const { return mSize; }
+
+	private:
+#ifdef _WIN32
+		HANDLE mFile = INVALID_HANDLE_VALUE;
+		HANDLE mMapping = nullptr;
+#else
+		int mFile = -1;
+#endif
+		const char* mData = nullptr;
+		size_t mSize = 0;
+	};
+
+	bool IsDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	bool IsBlank(char c)
+	{
+		return c == ' ' || c == '\t';
+	}
+
+	void SetError(std::string* error, const std::string& message)
+	{
+		if (error != nullptr)
+		{
+			*error = message;
+		}
+	}
+}
+
+bool ObjParser::Parse(const char* filename, JobSystem* jobSystem, Result& result, std::string* error, uint32_t maxThreads)
+{
+	result = Result{};
+	MappedFile file(filename);
+	if (file.Data() == nullptr)
+	{
+		SetError(error, std::string("failed to open ") + filename + "!");
+		return false;
+	}
+	const char* data = file.Data();
+	const size_t size = file.Size();
+
+	uint32_t threads = 1;
+	if (jobSystem != nullptr)
+	{
+		threads = maxThreads == 0 ? jobSystem->GetThreadCount() : std::min(maxThreads, jobSystem->GetThreadCount());
+	}
+	const uint32_t chunkCount = static_cast<uint32_t>(std::max<size_t>(std::min<size_t>(threads, size / OBJ_MIN_CHUNK_BYTES), 1));
+
+	//Even byte ranges, each moved forward to the next line start
+	std::vector<Chunk> chunks(chunkCount);
+	size_t begin = 0;
+	for (uint32_t i = 0; i < chunkCount; ++i)
+	{
+		size_t end = size;
+		if (i + 1 < chunkCount)
+		{
+			end = std::max(size * (i + 1) / chunkCount, begin);
+			while (end < size && data[end - 1] != '\n')
+			{
+				++end;
+			}
+		}
+		chunks[i].begin = data + begin;
+		chunks[i].end = data + end;
+		begin = end;
+	}
+
+	auto forEachChunk = [&](const JobSystem::RangeFunc& func)
+	{
+		if (chunkCount == 1)
+		{
+			func(0, 1);
+			return;
+		}
+		JobCounter done;
+		jobSystem->ParallelFor(chunkCount, 1, func, &done);
+		jobSystem->Wait(done);
+	};
+
+	forEachChunk([&chunks](uint32_t first, uint32_t last)
+	{
+		for (uint32_t i = first; i < last; ++i)
+		{
+			ParseChunk(chunks[i]);
+		}
+	});
+
+	//Where every chunk's elements start in the outputs
+	struct Offsets
+	{
+		size_t position, normal, texcoord, corner;
+	};
+	std::vector<Offsets> offsets(chunkCount);
+	Offsets total{ 0, 0, 0, 0 };
+	for (uint32_t i = 0; i < chunkCount; ++i)
+	{
+		if (chunks[i].failed == true)
+		{
+			SetError(error, std::string("failed to parse ") + filename + "!");
+			return false;
+		}
+		offsets[i] = total;
+		total.position += chunks[i].positions.size();
+		total.normal += chunks[i].normals.size();
+		total.texcoord += chunks[i].texcoords.size();
+		total.corner += chunks[i].corners.size();
+	}
+	if (total.position > INT32_MAX || total.normal > INT32_MAX || total.texcoord > INT32_MAX)
+	{
+		SetError(error, std::string(filename) + " has too many vertex attributes!");
+		return false;
+	}
+	result.positions.resize(total.position);
+	result.normals.resize(total.normal);
+	result.texcoords.resize(total.texcoord);
+	result.corners.resize(total.corner);
+
+	std::atomic<bool> outOfRange{ false };
+	forEachChunk([&](uint32_t first, uint32_t last)
+	{
+		for (uint32_t i = first; i < last; ++i)
+		{
+			Chunk& chunk = chunks[i];
+			const Offsets& offset = offsets[i];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), result.positions.begin() + offset.position);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), result.normals.begin() + offset.normal);
+			std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), result.texcoords.begin() + offset.texcoord);
+
+			Index* corners = result.corners.data() + offset.corner;
+			std::copy(chunk.corners.begin(), chunk.corners.end(), corners);
+			for (uint32_t entry : chunk.relative)
+			{
+				Index& corner = corners[entry / 3];
+				switch (entry % 3)
+				{
+				case 0:
+					corner.position += static_cast<int32_t>(offset.position);
+					break;
+				case 1:
+					corner.texcoord += static_cast<int32_t>(offset.texcoord);
+					break;
+				default:
+					corner.normal += static_cast<int32_t>(offset.normal);
+					break;
+				}
+			}
+
+			for (size_t c = 0; c < chunk.corners.size(); ++c)
+			{
+				const Index& corner = corners[c];
+				if (corner.position < 0 || corner.position >= static_cast<int32_t>(total.position)
+					|| corner.normal < -1 || corner.normal >= static_cast<int32_t>(total.normal)
+					|| corner.texcoord < -1 || corner.texcoord >= static_cast<int32_t>(total.texcoord))
+				{
+					outOfRange = true;
+					break;
+				}
+			}
+			//Peak memory stays near one copy of the outputs
+			chunk = Chunk{};
+		}
+	});
+	if (outOfRange == true)
+	{
+		SetError(error, std::string(filename) + " indexes a missing vertex attribute!");
+		return false;
+	}
+	return true;
+}
+
+void ObjParser::ParseChunk(Chunk& chunk)
+{
+	const char* cursor = chunk.begin;
+	const char* end = chunk.end;
+	//A rough guess, a scan is mostly "v x y z" and "f a b c" lines of 30 bytes or so
+	const size_t lineGuess = static_cast<size_t>(end - cursor) / 32;
+	chunk.positions.reserve(lineGuess / 2);
+	chunk.corners.reserve(lineGuess * 3);
+
+	//Converts an OBJ index of the given attribute, 1 based or negative from the back, 0 means there is none
+	auto resolve = [](int32_t value, size_t count, bool& relative)
+	{
+		relative = value < 0;
+		if (value < 0)
+		{
+			return static_cast<int32_t>(count) + value;
+		}
+		return value - 1;
+	};
+
+	while (cursor < end)
+	{
+		while (cursor < end && IsBlank(*cursor) == true)
+		{
+			++cursor;
+		}
+		const size_t remaining = static_cast<size_t>(end - cursor);
+		if (remaining >= 2 && cursor[0] == 'v' && IsBlank(cursor[1]) == true)
+		{
+			cursor += 2;
+			glm::vec3 position;
+			position.x = ParseFloat(cursor, end);
+			position.y = ParseFloat(cursor, end);
+			position.z = ParseFloat(cursor, end);
+			chunk.positions.push_back(position);
+		}
+		else if (remaining >= 3 && cursor[0] == 'v' && cursor[1] == 'n' && IsBlank(cursor[2]) == true)
+		{
+			cursor += 3;
+			glm::vec3 normal;
+			normal.x = ParseFloat(cursor, end);
+			normal.y = ParseFloat(cursor, end);
+			normal.z = ParseFloat(cursor, end);
+			chunk.normals.push_back(normal);
+		}
+		else if (remaining >= 3 && cursor[0] == 'v' && cursor[1] == 't' && IsBlank(cursor[2]) == true)
+		{
+			cursor += 3;
+			glm::vec2 texcoord;
+			texcoord.x = ParseFloat(cursor, end);
+			texcoord.y = ParseFloat(cursor, end);
+			chunk.texcoords.push_back(texcoord);
+		}
+		else if (remaining >= 2 && cursor[0] == 'f' && IsBlank(cursor[1]) == true)
+		{
+			cursor += 2;
+			//Polygons are fanned around their first corner
+			Index first{}, previous{};
+			uint8_t firstRelative = 0, previousRelative = 0;
+			uint32_t cornerCount = 0;
+			while (true)
+			{
+				while (cursor < end && IsBlank(*cursor) == true)
+				{
+					++cursor;
+				}
+				if (cursor == end || *cursor == '\n' || *cursor == '\r' || *cursor == '#')
+				{
+					break;
+				}
+
+				int32_t values[3] = { ParseInt(cursor, end), 0, 0 };
+				if (cursor < end && *cursor == '/')
+				{
+					++cursor;
+					if (cursor < end && *cursor != '/')
+					{
+						values[1] = ParseInt(cursor, end);
+					}
+					if (cursor < end && *cursor == '/')
+					{
+						++cursor;
+						values[2] = ParseInt(cursor, end);
+					}
+				}
+				if (values[0] == 0 || (cursor < end && IsBlank(*cursor) == false && *cursor != '\n' && *cursor != '\r'))
+				{
+					chunk.failed = true;
+					return;
+				}
+
+				bool relative[3] = {};
+				Index corner;
+				corner.position = resolve(values[0], chunk.positions.size(), relative[0]);
+				corner.texcoord = resolve(values[1], chunk.texcoords.size(), relative[1]);
+				corner.normal = resolve(values[2], chunk.normals.size(), relative[2]);
+				const uint8_t relativeMask = static_cast<uint8_t>((relative[0] ? 1 : 0) | (relative[1] ? 2 : 0) | (relative[2] ? 4 : 0));
+
+				if (cornerCount >= 2)
+				{
+					const Index triangle[3] = { first, previous, corner };
+					const uint8_t masks[3] = { firstRelative, previousRelative, relativeMask };
+					for (uint32_t k = 0; k < 3; ++k)
+					{
+						const uint32_t slot = static_cast<uint32_t>(chunk.corners.size());
+						for (uint32_t attribute = 0; attribute < 3; ++attribute)
+						{
+							if ((masks[k] >> attribute) & 1u)
+							{
+								chunk.relative.push_back(slot * 3 + attribute);
+							}
+						}
+						chunk.corners.push_back(triangle[k]);
+					}
+				}
+				if (cornerCount == 0)
+				{
+					first = corner;
+					firstRelative = relativeMask;
+				}
+				previous = corner;
+				previousRelative = relativeMask;
+				++cornerCount;
+			}
+		}
+
+		//Whatever is left of the line, comments and unsupported statements included
+		while (cursor < end && *cursor != '\n')
+		{
+			++cursor;
+		}
+		++cursor;
+	}
+}
+
+float ObjParser::ParseFloat(const char*& cursor, const char* end)
+{
+	while (cursor < end && IsBlank(*cursor) == true)
+	{
+		++cursor;
+	}
+	bool negative = false;
+	if (cursor < end && (*cursor == '-' || *cursor == '+'))
+	{
+		negative = *cursor == '-';
+		++cursor;
+	}
+
+	//Up to 19 significant digits fit in the mantissa, far more than a float keeps
+	uint64_t mantissa = 0;
+	int32_t digits = 0;
+	int32_t exponent = 0;
+	while (cursor < end && IsDigit(*cursor) == true)
+	{
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+			digits += mantissa != 0 ? 1 : 0;
+		}
+		else
+		{
+			++exponent;
+		}
+		++cursor;
+	}
+	if (cursor < end && *cursor == '.')
+	{
+		++cursor;
+		while (cursor < end && IsDigit(*cursor) == true)
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+				digits += mantissa != 0 ? 1 : 0;
+				--exponent;
+			}
+			++cursor;
+		}
+	}
+	if (cursor < end && (*cursor == 'e' || *cursor == 'E'))
+	{
+		++cursor;
+		bool negativeExponent = false;
+		if (cursor < end && (*cursor == '-' || *cursor == '+'))
+		{
+			negativeExponent = *cursor == '-';
+			++cursor;
+		}
+		int32_t value = 0;
+		while (cursor < end && IsDigit(*cursor) == true)
+		{
+			value = std::min(value * 10 + (*cursor - '0'), 10000);
+			++cursor;
+		}
+		exponent += negativeExponent ? -value : value;
+	}
+
+	//Powers of ten up to 1e22 are exact doubles, one multiply or divide by them rounds correctly
+	static const double powers[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	double value = static_cast<double>(mantissa);
+	if (mantissa != 0 && exponent != 0)
+	{
+		const int32_t magnitude = std::abs(exponent);
+		const double scale = magnitude <= 22 ? powers[magnitude] : std::pow(10.0, magnitude);
+		value = exponent < 0 ? value / scale : value * scale;
+	}
+	return static_cast<float>(negative ? -value : value);
+}
+
+int32_t ObjParser::ParseInt(const char*& cursor, const char* end)
+{
+	bool negative = false;
+	if (cursor < end && (*cursor == '-' || *cursor == '+'))
+	{
+		negative = *cursor == '-';
+		++cursor;
+	}
+	int64_t value = 0;
+	while (cursor < end && IsDigit(*cursor) == true)
+	{
+		value = std::min<int64_t>(value * 10 + (*cursor - '0'), INT32_MAX);
+		++cursor;
+	}
+	return static_cast<int32_t>(negative ? -value : value);
+}
+
+std::vector<ObjParser::BenchmarkResult> ObjParser::RunBenchmarks(const char* filename, JobSystem* jobSystem, uint32_t repeats)
+{
+	using Clock = std::chrono::steady_clock;
+	std::vector<BenchmarkResult> results;
+
+	float bestMs = FLT_MAX;
+	for (uint32_t repeat = 0; repeat < repeats; ++repeat)
+	{
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warning;
+		std::string error;
+		Clock::time_point start = Clock::now();
+		tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, filename, nullptr);
+		bestMs = std::min(bestMs, std::chrono::duration<float, std::milli>(Clock::now() - start).count());
+	}
+	results.push_back({ "tinyobjloader", 1, bestMs });
+
+	//Powers of two and every thread
+	const uint32_t maxThreads = jobSystem != nullptr ? jobSystem->GetThreadCount() : 1;
+	std::vector<uint32_t> threadCounts;
+	for (uint32_t threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+	for (uint32_t threads : threadCounts)
+	{
+		bestMs = FLT_MAX;
+		for (uint32_t repeat = 0; repeat < repeats; ++repeat)
+		{
+			Result result;
+			Clock::time_point start = Clock::now();
+			Parse(filename, jobSystem, result, nullptr, threads);
+			bestMs = std::min(bestMs, std::chrono::duration<float, std::milli>(Clock::now() - start).count());
+		}
+		results.push_back({ "ObjParser", threads, bestMs });
+	}
+	return results;
+}
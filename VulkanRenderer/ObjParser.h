@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+class JobSystem;
+
+//Wavefront OBJ reader for large scanned meshes. The file is memory mapped and cut at line starts into one chunk
+//per thread, every chunk is parsed by its own job into local arrays. Prefix sums over the chunk counts give each
+//chunk its place in the outputs, which are allocated once and filled by a second round of jobs.
+//Only v, vn, vt and f are read, polygons are fanned into triangles and everything else is skipped
+class ObjParser
+{
+public:
+	//0 based, -1 where the corner has no such attribute
+	struct Index
+	{
+		int32_t position;
+		int32_t normal;
+		int32_t texcoord;
+	};
+
+	struct Result
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> texcoords;
+		std::vector<Index> corners;//3 per triangle
+	};
+
+	struct BenchmarkResult
+	{
+		std::string name;
+		uint32_t threadCount = 0;
+		float ms = 0.f;
+	};
+
+	//Without jobSystem, or with maxThreads 1, the calling thread parses the whole file. maxThreads 0 uses every thread
+	static bool Parse(const char* filename, JobSystem* jobSystem, Result& result, std::string* error, uint32_t maxThreads = 0);
+
+	//tinyobjloader against Parse on 1, 2, 4... threads, best of repeats. Call while no other jobs are queued
+	static std::vector<BenchmarkResult> RunBenchmarks(const char* filename, JobSystem* jobSystem, uint32_t repeats);
+
+private:
+	struct Chunk
+	{
+		const char* begin;
+		const char* end;
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> texcoords;
+		std::vector<Index> corners;
+		//Negative indices count back from the last element read so far. They are stored relative to the chunk's
+		//first element of their kind, the merge adds where the chunk starts. Entries are corner * 3 + attribute
+		std::vector<uint32_t> relative;
+		bool failed = false;
+	};
+
+	static void ParseChunk(Chunk& chunk);
+	//Moves the cursor past what it read, which stops at the first character that can't be part of the number
+	static float ParseFloat(const char*& cursor, const char* end);
+	static int32_t ParseInt(const char*& cursor, const char* end);
+};
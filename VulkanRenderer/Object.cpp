@@ -1,8 +1,7 @@
 #include "Object.h"
 #include "Mesh.h"
-#include <glm/gtc/matrix_transform.hpp>
-Object::Object(Mesh* mesh, glm::vec3 position, glm::vec3 scale)
-	:mMesh(mesh), mPosition(position), mScale(scale)
+Object::Object(Mesh* mesh, uint32_t transform, MeshHandle meshHandle)
+	:mMesh(mesh), mMeshHandle(meshHandle), mTransform(transform)
 {
 }
 
@@ -10,12 +9,9 @@ void Object::Draw()
 {
 }
 
-glm::mat4 Object::BuildModelMat() const
+glm::vec4 Object::GetWorldBounds(const glm::mat4& world) const
 {
-	glm::mat4 translate = glm::translate(glm::identity<glm::mat4>(), mPosition);
-	glm::mat4 scale = glm::scale(translate, mScale);
-	//glm::mat4 rotation = glm::rotate();
-	
-
-	return scale;
+	glm::vec3 center = glm::vec3(world * glm::vec4(mMesh->boundCenter, 1.f));
+	float maxScale = glm::sqrt(glm::max(glm::dot(world[0], world[0]), glm::max(glm::dot(world[1], world[1]), glm::dot(world[2], world[2]))));
+	return glm::vec4(center, mMesh->boundRadius * maxScale);
 }
@@ -1,15 +1,24 @@
 #pragma once
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
+#include "ResourceManager.h"
 struct Mesh;
 struct Object
 {
-	Object(Mesh* mesh, glm::vec3 position, glm::vec3 scale = glm::vec3(1.f));
-	glm::mat4 BuildModelMat() const;
+	Object(Mesh* mesh, uint32_t transform, MeshHandle meshHandle = {});
 	void Draw(/*Maybe command buffer OR device*/);
 
-	Mesh* mMesh;
-	glm::vec3 mPosition;
-	glm::vec3 mScale;
-};
+	//World space bounding sphere, xyz center & w radius
+	glm::vec4 GetWorldBounds(const glm::mat4& world) const;
+
+	Mesh* mMesh;//The resource manager's placeholder until the mesh of mMeshHandle is loaded
+	MeshHandle mMeshHandle;//Reference released with the object, invalid for meshes the manager doesn't own
+	uint32_t mTransform;//Handle in the TransformStore, also the index into the transform SSBO
+	uint32_t mMaterial = 0;//Index into the material SSBO
+	uint32_t mLod = 0;//Level of the mesh drawn this frame, picked from its screen space error
+	bool mLodChanged = false;
+	bool mMeshChanged = false;//The loaded mesh replaced the placeholder, counts as a level change once
 
+	//Bounds the cached shadows were last checked against
+	glm::vec4 mLastBounds = glm::vec4(0.f);
+};
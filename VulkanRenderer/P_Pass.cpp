@@ -24,13 +24,10 @@ void P_Pass::CreateFrameData()
 	CreateFrameBuffer();
 }
 
-void P_Pass::CreatePipelineData()
+void P_Pass::CreatePipelineData(JobCounter* ready)
 {
 	CreatePipelineLayout();
-	CreatePipeline();
-
-	CreateSkyPipelineLayout();
-	CreateSkyPipeline();
+	mApp->mPipelineBuilder.Build("NormalDebug", [this]() { return CreatePipeline(); }, &mPipeline, ready);
 }
 
 
@@ -46,6 +43,7 @@ void P_Pass::CreateRenderPass()
 		attachmentDescs[i].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		attachmentDescs[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
 		attachmentDescs[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		//The render graph transitions the attachments around the pass
 		if (i == 1)//Deal with depth buffer
 		{
 			attachmentDescs[i].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
@@ -53,8 +51,8 @@ void P_Pass::CreateRenderPass()
 		}
 		else
 		{
-			attachmentDescs[i].initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			attachmentDescs[i].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			attachmentDescs[i].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			attachmentDescs[i].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 		}
 	}
 
@@ -73,33 +71,12 @@ void P_Pass::CreateRenderPass()
 	subpass.colorAttachmentCount = 1;
 	subpass.pDepthStencilAttachment = &depthReference;
 
-	// Use subpass dependencies for attachment layout transitions
-	std::array<VkSubpassDependency, 2> dependencies;
-
-	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependencies[0].dstSubpass = 0;
-	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;//TODO: What's meaning for?
-	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;// color attachment ٿ MTR Ҽ ְ Ѵ.
-	dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-	dependencies[1].srcSubpass = 0;
-	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;//Write color attachment readؼ  lighting shader ִ´.
-	dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
 	VkRenderPassCreateInfo renderPassInfo = {};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	renderPassInfo.pAttachments = attachmentDescs.data();
 	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachmentDescs.size());
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 2;
-	renderPassInfo.pDependencies = dependencies.data();
 	VK_CHECK_RESULT(vkCreateRenderPass(mApp->mVulkanDevice->logicalDevice, &renderPassInfo, nullptr, &mRenderPass));
 }
 
@@ -142,12 +119,6 @@ void P_Pass::CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBindi
 	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(mApp->mVulkanDevice->logicalDevice, &DescriptorLayoutCI, nullptr, &mDescriptorLayout))
 }
 
-void P_Pass::CreateSkyDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings)
-{
-	VkDescriptorSetLayoutCreateInfo DescriptorLayoutCI = initializers::descriptorSetLayoutCreateInfo(setLayoutBindings);
-	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(mApp->mVulkanDevice->logicalDevice, &DescriptorLayoutCI, nullptr, &mSkyDescriptorLayout))
-}
-
 void P_Pass::CreateDescriptorSet()
 {
 	VkDescriptorSetAllocateInfo setAllocInfo{};
@@ -162,51 +133,28 @@ void P_Pass::CreateDescriptorSet()
 	}
 }
 
-void P_Pass::CreateSkyDescriptorSet()
-{
-	VkDescriptorSetAllocateInfo setAllocInfo{};
-	setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	setAllocInfo.descriptorPool = mDescriptorPool;
-	setAllocInfo.descriptorSetCount = 1;
-	setAllocInfo.pSetLayouts = &mSkyDescriptorLayout;
-
-	if (vkAllocateDescriptorSets(mApp->mVulkanDevice->logicalDevice, &setAllocInfo, &mSkyDescriptorSet) != VK_SUCCESS)
-	{
-		throw std::runtime_error("failed to allocate descriptor sets");
-	}
-}
-
 void P_Pass::UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets)
 {
 	vkUpdateDescriptorSets(mApp->mVulkanDevice->logicalDevice, static_cast<uint32_t>(writeDescSets.size()), writeDescSets.data(), 0, nullptr);
 }
 
-void P_Pass::UpdateSkyDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets)
-{
-	vkUpdateDescriptorSets(mApp->mVulkanDevice->logicalDevice, static_cast<uint32_t>(writeDescSets.size()), writeDescSets.data(), 0, nullptr);
-}
-
 void P_Pass::CreatePipelineLayout()
 {
-	VkPushConstantRange pushConstant;
-	pushConstant.offset = 0;
-	pushConstant.size = sizeof(glm::mat4);
-	pushConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_GEOMETRY_BIT;
+	//Transform index of the object whose normals are drawn
+	mPushConstants = mApp->mShaders.ReflectPushConstants({ "Base.vert", "NormalDebug.geom", "Base.frag" });
+	if (mPushConstants.size != sizeof(uint32_t))
+	{
+		throw std::runtime_error("failed to match the normal debug push constant with its shaders!");
+	}
 
 	VkPipelineLayoutCreateInfo pipelinelayoutCI = initializers::pipelineLayoutCreateInfo(&mDescriptorLayout, 1);
 	pipelinelayoutCI.pushConstantRangeCount = 1;
-	pipelinelayoutCI.pPushConstantRanges = &pushConstant;
+	pipelinelayoutCI.pPushConstantRanges = &mPushConstants;
 
 	VK_CHECK_RESULT(vkCreatePipelineLayout(mApp->mVulkanDevice->logicalDevice, &pipelinelayoutCI, nullptr, &mPipelineLayout))
 }
 
-void P_Pass::CreateSkyPipelineLayout()
-{
-	VkPipelineLayoutCreateInfo pipelinelayoutCI = initializers::pipelineLayoutCreateInfo(&mSkyDescriptorLayout, 1);
-	VK_CHECK_RESULT(vkCreatePipelineLayout(mApp->mVulkanDevice->logicalDevice, &pipelinelayoutCI, nullptr, &mSkyPipelineLayout))
-}
-
-void P_Pass::CreatePipeline()
+VkPipeline P_Pass::CreatePipeline()
 {
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState =
 		initializers::pipelineInputAssemblyStateCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
@@ -227,9 +175,9 @@ void P_Pass::CreatePipeline()
 		initializers::pipelineDynamicStateCreateInfo(dynamicStateEnables);
 
 	std::array<VkPipelineShaderStageCreateInfo, 3> geometryShaderStages;
-	geometryShaderStages[0] = createShaderStageCreateInfo("../shaders/BaseVert.spv", VK_SHADER_STAGE_VERTEX_BIT, mApp->mVulkanDevice->logicalDevice);
-	geometryShaderStages[1] = createShaderStageCreateInfo("../shaders/NormalDebug.spv", VK_SHADER_STAGE_GEOMETRY_BIT, mApp->mVulkanDevice->logicalDevice);
-	geometryShaderStages[2] = createShaderStageCreateInfo("../shaders/BaseFrag.spv", VK_SHADER_STAGE_FRAGMENT_BIT, mApp->mVulkanDevice->logicalDevice);
+	geometryShaderStages[0] = mApp->mPipelineBuilder.ShaderStage("Base.vert");
+	geometryShaderStages[1] = mApp->mPipelineBuilder.ShaderStage("NormalDebug.geom");
+	geometryShaderStages[2] = mApp->mPipelineBuilder.ShaderStage("Base.frag");
 
 	VkGraphicsPipelineCreateInfo pipelineCI = initializers::pipelineCreateInfo(mPipelineLayout, mRenderPass);
 	pipelineCI.pInputAssemblyState = &inputAssemblyState;
@@ -260,61 +208,7 @@ void P_Pass::CreatePipeline()
 
 	//TODO: Maybe blend state is problem.
 	colorBlendState = initializers::pipelineColorBlendStateCreateInfo(1, &blendAttachmentState);
-	VK_CHECK_RESULT(vkCreateGraphicsPipelines(mApp->mVulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &mPipeline))
-}
-
-void P_Pass::CreateSkyPipeline()
-{
-	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState =
-		initializers::pipelineInputAssemblyStateCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
-	VkPipelineRasterizationStateCreateInfo rasterizationState =
-		initializers::pipelineRasterizationStateCreateInfo(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
-	VkPipelineColorBlendAttachmentState blendAttachmentState =
-		initializers::pipelineColorBlendAttachmentState(0xf, VK_FALSE);
-	VkPipelineColorBlendStateCreateInfo colorBlendState =
-		initializers::pipelineColorBlendStateCreateInfo(1, &blendAttachmentState);
-	VkPipelineDepthStencilStateCreateInfo depthStencilState =
-		initializers::pipelineDepthStencilStateCreateInfo(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS_OR_EQUAL);
-	VkPipelineViewportStateCreateInfo viewportState =
-		initializers::pipelineViewportStateCreateInfo(1, 1, 0);
-	VkPipelineMultisampleStateCreateInfo multisampleState =
-		initializers::pipelineMultisampleStateCreateInfo(VK_SAMPLE_COUNT_1_BIT, 0);
-	std::vector<VkDynamicState> dynamicStateEnables = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-	VkPipelineDynamicStateCreateInfo dynamicState =
-		initializers::pipelineDynamicStateCreateInfo(dynamicStateEnables);
-
-	std::array<VkPipelineShaderStageCreateInfo, 2> geometryShaderStages;
-	geometryShaderStages[0] = createShaderStageCreateInfo("../shaders/SkyboxVert.spv", VK_SHADER_STAGE_VERTEX_BIT, mApp->mVulkanDevice->logicalDevice);
-	geometryShaderStages[1] = createShaderStageCreateInfo("../shaders/SkyboxFrag.spv", VK_SHADER_STAGE_FRAGMENT_BIT, mApp->mVulkanDevice->logicalDevice);
-
-	VkGraphicsPipelineCreateInfo pipelineCI = initializers::pipelineCreateInfo(mSkyPipelineLayout, mRenderPass);
-	pipelineCI.pInputAssemblyState = &inputAssemblyState;
-	pipelineCI.pRasterizationState = &rasterizationState;
-	pipelineCI.pColorBlendState = &colorBlendState;
-	pipelineCI.pMultisampleState = &multisampleState;
-	pipelineCI.pViewportState = &viewportState;
-	pipelineCI.pDepthStencilState = &depthStencilState;
-	pipelineCI.pDynamicState = &dynamicState;
-	pipelineCI.stageCount = static_cast<uint32_t>(geometryShaderStages.size());
-	pipelineCI.pStages = geometryShaderStages.data();
-	pipelineCI.renderPass = mRenderPass;
-
-	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-	auto bindingDescription = Vertex::getBindingDescription();
-	auto attributeDescriptions = Vertex::getAttributeDescriptions();
-
-	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
-	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-	pipelineCI.pVertexInputState = &vertexInputInfo;
-	rasterizationState.cullMode = VK_CULL_MODE_BACK_BIT;//TODO: Maybe problem.
-
-	//TODO: Maybe blend state is problem.
-	colorBlendState = initializers::pipelineColorBlendStateCreateInfo(1, &blendAttachmentState);
-	VK_CHECK_RESULT(vkCreateGraphicsPipelines(mApp->mVulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &mSkyPipeline))
+	return mApp->mPipelineBuilder.CreateGraphicsPipeline(pipelineCI);
 }
 
 void P_Pass::Update()
@@ -3,6 +3,7 @@
 #include "Attachment.h"
 
 class VkApp;
+class JobCounter;
 class P_Pass
 {
 private:
@@ -14,24 +15,19 @@ public:
 
 	void CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes);
 	void CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings);
-	void CreateSkyDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings);
 	void CreateDescriptorSet();
-	void CreateSkyDescriptorSet();
 
 	void CreateFrameData();
-	void CreatePipelineData();
+	//Layouts are created right away, pipelines are built as jobs that count on ready
+	void CreatePipelineData(JobCounter* ready);
 
 	void UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets);//TODO: Why this function contained Pass? Update in the demo.
-	void UpdateSkyDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets);
 private:
 	void CreateRenderPass();
 	void CreateFrameBuffer();
 
 	void CreatePipelineLayout();
-	void CreatePipeline();
-
-	void CreateSkyPipelineLayout();
-	void CreateSkyPipeline();
+	VkPipeline CreatePipeline();
 
 public:
 	uint32_t mWidth, mHeight;
@@ -50,12 +46,6 @@ public:
 
 	VkPipelineLayout mPipelineLayout;
 	VkPipeline mPipeline;
-
-	//Pipeline for draw skybox
-	VkDescriptorSetLayout mSkyDescriptorLayout;
-	VkDescriptorSet mSkyDescriptorSet;
-
-	VkPipelineLayout mSkyPipelineLayout;
-	VkPipeline mSkyPipeline;
+	VkPushConstantRange mPushConstants{};//Reflected, pushes have to use its stage flags
 };
 
@@ -0,0 +1,265 @@
+#include "PipelineBuildService.h"
+#include "VulkanTools.h"
+
+#include <algorithm>
+
+//Sources the build running on this thread asked for, null outside of first builds
+static thread_local std::vector<std::string>* tBuildSources = nullptr;
+
+void PipelineBuildService::Init(VkDevice device, VkPipelineCache cache, JobSystem* jobSystem, ShaderRegistry* shaders)
+{
+	mDevice = device;
+	mCache = cache;
+	mJobSystem = jobSystem;
+	mShaders = shaders;
+}
+
+void PipelineBuildService::Destroy()
+{
+	mJobSystem->Wait(mRebuilds);
+	for (const Swap& swap : mSwaps)
+	{
+		vkDestroyPipeline(mDevice, swap.pipeline, nullptr);
+	}
+	mSwaps.clear();
+
+	for (auto& module : mModules)
+	{
+		vkDestroyShaderModule(mDevice, module.second, nullptr);
+	}
+	mModules.clear();
+}
+
+VkShaderModule PipelineBuildService::GetShaderModule(const std::string& path)
+{
+	{
+		std::lock_guard<std::mutex> lock(mModuleMutex);
+		auto found = mModules.find(path);
+		if (found != mModules.end())
+		{
+			return found->second;
+		}
+	}
+
+	//Loaded outside the lock so builds that need different files don't queue up behind each other
+	VkShaderModule module = createShaderModule(readFile(path), mDevice);
+
+	std::lock_guard<std::mutex> lock(mModuleMutex);
+	auto inserted = mModules.emplace(path, module);
+	if (inserted.second == false)
+	{
+		//Someone else loaded the same file in the meantime
+		vkDestroyShaderModule(mDevice, module, nullptr);
+	}
+	return inserted.first->second;
+}
+
+VkPipelineShaderStageCreateInfo PipelineBuildService::ShaderStage(const std::string& source)
+{
+	if (tBuildSources != nullptr)
+	{
+		tBuildSources->push_back(source);
+	}
+
+	VkPipelineShaderStageCreateInfo stageInfo{};
+	stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stageInfo.stage = ShaderRegistry::StageOf(source);
+	stageInfo.module = GetShaderModule(mShaders->SpirvPath(source));
+	stageInfo.pName = "main";
+	return stageInfo;
+}
+
+void PipelineBuildService::Build(const std::string& name, CreateFunc create, VkPipeline* target, JobCounter* ready)
+{
+	{
+		std::lock_guard<std::mutex> lock(mTimingMutex);
+		if (mAnyBuild == false)
+		{
+			mFirstBuild = std::chrono::steady_clock::now();
+			mAnyBuild = true;
+		}
+		Entry& entry = mEntries[name];
+		entry.create = create;
+		entry.target = target;
+	}
+	mRunningBuilds.fetch_add(1);
+
+	mJobSystem->Run([this, name, create, target]()
+	{
+		std::vector<std::string> sources;
+		tBuildSources = &sources;
+		auto start = std::chrono::steady_clock::now();
+		try
+		{
+			*target = create();
+		}
+		catch (...)
+		{
+			tBuildSources = nullptr;
+			std::lock_guard<std::mutex> lock(mTimingMutex);
+			if (mFailure == nullptr)
+			{
+				mFailure = std::current_exception();
+			}
+			mRunningBuilds.fetch_sub(1);
+			return;
+		}
+		tBuildSources = nullptr;
+		auto finish = std::chrono::steady_clock::now();
+		float ms = std::chrono::duration<float, std::milli>(finish - start).count();
+
+		{
+			std::lock_guard<std::mutex> lock(mTimingMutex);
+			mTimings.push_back({ name, ms });
+			mLastFinish = std::max(mLastFinish, finish);
+			mEntries[name].sources = sources;
+		}
+		mRunningBuilds.fetch_sub(1);
+	}, ready);
+}
+
+VkPipeline PipelineBuildService::CreateGraphicsPipeline(const VkGraphicsPipelineCreateInfo& info)
+{
+	//The cache is internally synchronized, builds on several threads may use it at once
+	VkPipeline pipeline;
+	VK_CHECK_RESULT(vkCreateGraphicsPipelines(mDevice, mCache, 1, &info, nullptr, &pipeline))
+	return pipeline;
+}
+
+VkPipeline PipelineBuildService::CreateComputePipeline(const VkComputePipelineCreateInfo& info)
+{
+	VkPipeline pipeline;
+	VK_CHECK_RESULT(vkCreateComputePipelines(mDevice, mCache, 1, &info, nullptr, &pipeline))
+	return pipeline;
+}
+
+void PipelineBuildService::RethrowFailure()
+{
+	std::lock_guard<std::mutex> lock(mTimingMutex);
+	if (mFailure != nullptr)
+	{
+		std::rethrow_exception(mFailure);
+	}
+}
+
+void PipelineBuildService::Update()
+{
+	for (const std::string& source : mShaders->TakeRecompiled())
+	{
+		mStaleSources.insert(source);
+	}
+	//Modules are only evicted while no build can be holding on to one
+	if (mRunningBuilds.load() != 0 || mRebuilds.IsDone() == false)
+	{
+		return;
+	}
+
+	std::vector<Swap> swaps;
+	{
+		std::lock_guard<std::mutex> lock(mTimingMutex);
+		swaps.swap(mSwaps);
+	}
+	if (swaps.empty() == false)
+	{
+		//Rare enough that waiting for every frame in flight beats tracking which one last used the old pipeline
+		vkDeviceWaitIdle(mDevice);
+		for (const Swap& swap : swaps)
+		{
+			vkDestroyPipeline(mDevice, *swap.target, nullptr);
+			*swap.target = swap.pipeline;
+		}
+		mRebuildCount += static_cast<uint32_t>(swaps.size());
+	}
+
+	if (mStaleSources.empty() == false)
+	{
+		Rebuild(mStaleSources);
+		mStaleSources.clear();
+	}
+}
+
+std::vector<PipelineBuildService::BuildTiming> PipelineBuildService::GetTimings() const
+{
+	std::lock_guard<std::mutex> lock(mTimingMutex);
+	return mTimings;
+}
+
+float PipelineBuildService::GetWallMs() const
+{
+	std::lock_guard<std::mutex> lock(mTimingMutex);
+	if (mAnyBuild == false || mLastFinish < mFirstBuild)
+	{
+		return 0.f;
+	}
+	return std::chrono::duration<float, std::milli>(mLastFinish - mFirstBuild).count();
+}
+
+uint32_t PipelineBuildService::GetModuleCount() const
+{
+	std::lock_guard<std::mutex> lock(mModuleMutex);
+	return static_cast<uint32_t>(mModules.size());
+}
+
+std::string PipelineBuildService::GetLastRebuildError() const
+{
+	std::lock_guard<std::mutex> lock(mTimingMutex);
+	return mLastRebuildError;
+}
+
+/*************************************************************************************************************/
+
+void PipelineBuildService::Rebuild(const std::unordered_set<std::string>& sources)
+{
+	{
+		//Pipelines don't reference their modules once created, the new binaries load on first use
+		std::lock_guard<std::mutex> lock(mModuleMutex);
+		for (const std::string& source : sources)
+		{
+			auto found = mModules.find(mShaders->SpirvPath(source));
+			if (found != mModules.end())
+			{
+				vkDestroyShaderModule(mDevice, found->second, nullptr);
+				mModules.erase(found);
+			}
+		}
+	}
+
+	std::vector<std::pair<std::string, Entry>> affected;
+	{
+		std::lock_guard<std::mutex> lock(mTimingMutex);
+		for (const auto& entry : mEntries)
+		{
+			for (const std::string& source : entry.second.sources)
+			{
+				if (sources.count(source) != 0)
+				{
+					affected.push_back(entry);
+					break;
+				}
+			}
+		}
+	}
+
+	for (const auto& entry : affected)
+	{
+		const std::string name = entry.first;
+		const CreateFunc create = entry.second.create;
+		VkPipeline* target = entry.second.target;
+		//Nothing in the frame waits on a rebuild, so it stays off the queue Wait drains
+		mJobSystem->RunBackground([this, name, create, target]()
+		{
+			try
+			{
+				VkPipeline pipeline = create();
+				std::lock_guard<std::mutex> lock(mTimingMutex);
+				mSwaps.push_back({ target, pipeline });
+			}
+			catch (const std::exception& exception)
+			{
+				//The old pipeline stays in use
+				std::lock_guard<std::mutex> lock(mTimingMutex);
+				mLastRebuildError = name + ": " + exception.what();
+			}
+		}, &mRebuilds);
+	}
+}
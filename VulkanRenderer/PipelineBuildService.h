@@ -0,0 +1,99 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "JobSystem.h"
+#include "ShaderRegistry.h"
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+//Builds pipelines as jobs against the shared pipeline cache.
+//Shader modules are loaded once per file no matter how many pipelines use them, and stay alive until Destroy.
+//Every build signals its own counter, so a pass can start recording as soon as its pipelines exist
+//instead of waiting for the slowest one.
+//Builds remember the shader sources they used, when the registry recompiles one of them only those
+//pipelines are created again in the background and swapped in by Update.
+class PipelineBuildService
+{
+public:
+	using CreateFunc = std::function<VkPipeline()>;
+
+	struct BuildTiming
+	{
+		std::string name;
+		float ms = 0.f;//Job time, module loading of first use included
+	};
+
+	void Init(VkDevice device, VkPipelineCache cache, JobSystem* jobSystem, ShaderRegistry* shaders);
+	//No build may be running
+	void Destroy();
+
+	//Safe from any thread
+	VkShaderModule GetShaderModule(const std::string& path);
+	//source names a file of the shader registry, "GBuffer.vert", the stage follows its extension
+	VkPipelineShaderStageCreateInfo ShaderStage(const std::string& source);
+
+	//Runs create as a job and stores its pipeline in target, ready is done once it is there.
+	//target has to stay valid, rebuilds write it again later
+	void Build(const std::string& name, CreateFunc create, VkPipeline* target, JobCounter* ready);
+	VkPipeline CreateGraphicsPipeline(const VkGraphicsPipelineCreateInfo& info);
+	VkPipeline CreateComputePipeline(const VkComputePipelineCreateInfo& info);
+	//Builds run on worker threads, the first exception one of them threw is rethrown here
+	void RethrowFailure();
+
+	//Main thread, once a frame outside of recording. Starts rebuilds for recompiled shaders and swaps in
+	//the pipelines of finished ones, waiting for the device to idle before the old ones are destroyed
+	void Update();
+
+	std::vector<BuildTiming> GetTimings() const;
+	//From the first Build until the last one finished
+	float GetWallMs() const;
+	uint32_t GetModuleCount() const;
+	uint32_t GetRebuildCount() const { return mRebuildCount; }
+	//Pipeline name and what went wrong, empty until a rebuild fails
+	std::string GetLastRebuildError() const;
+
+private:
+	struct Entry
+	{
+		CreateFunc create;
+		VkPipeline* target = nullptr;
+		std::vector<std::string> sources;
+	};
+
+	struct Swap
+	{
+		VkPipeline* target = nullptr;
+		VkPipeline pipeline = VK_NULL_HANDLE;
+	};
+
+	void Rebuild(const std::unordered_set<std::string>& sources);
+
+	VkDevice mDevice = VK_NULL_HANDLE;
+	VkPipelineCache mCache = VK_NULL_HANDLE;
+	JobSystem* mJobSystem = nullptr;
+	ShaderRegistry* mShaders = nullptr;
+
+	mutable std::mutex mModuleMutex;
+	std::unordered_map<std::string, VkShaderModule> mModules;
+
+	mutable std::mutex mTimingMutex;
+	std::vector<BuildTiming> mTimings;
+	std::chrono::steady_clock::time_point mFirstBuild;
+	std::chrono::steady_clock::time_point mLastFinish;
+	bool mAnyBuild = false;
+	std::exception_ptr mFailure;
+	std::unordered_map<std::string, Entry> mEntries;
+	std::atomic<uint32_t> mRunningBuilds{ 0 };
+
+	std::unordered_set<std::string> mStaleSources;//Recompiled, waiting for the running rebuilds to finish
+	JobCounter mRebuilds;
+	std::vector<Swap> mSwaps;//Guarded by mTimingMutex
+	std::string mLastRebuildError;//Guarded by mTimingMutex
+	uint32_t mRebuildCount = 0;
+};
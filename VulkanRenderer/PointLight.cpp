@@ -1,5 +1,5 @@
 #include "PointLight.h"
-PointLight::PointLight(glm::vec3 color, glm::vec3 pos)
-	:mColor(color), mPos(pos)
+PointLight::PointLight(glm::vec3 color, glm::vec3 pos, float radius)
+	:mColor(color), mRadius(radius), mPos(pos)
 {
 }
@@ -3,11 +3,11 @@
 #include <glm/glm.hpp>
 struct PointLight
 {
-	PointLight(glm::vec3 color = glm::vec3(0.1f, 0.1f, 0.1f), glm::vec3 pos = glm::vec3(0.f, 1.f, 0.f));
+	PointLight(glm::vec3 color = glm::vec3(0.1f, 0.1f, 0.1f), glm::vec3 pos = glm::vec3(0.f, 1.f, 0.f), float radius = 30.f);
 
 public:
 	glm::vec3 mColor;
-	float pad;
+	float mRadius;//Range of the light and its shadow, also the far plane of the cube shadow
 	glm::vec3 mPos;
-	float pad2;
+	int32_t mShadowIndex = -1;//Slot in the point shadow atlas, -1 when unshadowed
 };
\ No newline at end of file
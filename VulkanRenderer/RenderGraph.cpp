@@ -0,0 +1,815 @@
+#include "RenderGraph.h"
+#include "VulkanDevice.h"
+#include "VulkanInitializers.hpp"
+#include "VulkanTools.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+static const VkAccessFlags WRITE_ACCESS = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+	| VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+void RenderGraph::Init(VulkanDevice* device, JobSystem* jobSystem, VkQueue graphicsQueue, VkQueue computeQueue)
+{
+	mDevice = device;
+	mJobSystem = jobSystem;
+	mGraphicsQueue = graphicsQueue;
+	mComputeQueue = computeQueue;
+	mAsyncTimeline.Init(device->logicalDevice);
+}
+
+void RenderGraph::Destroy()
+{
+	for (Resource& resource : mResources)
+	{
+		if (resource.kind == Kind::Transient && resource.block >= 0)
+		{
+			vkDestroyImageView(mDevice->logicalDevice, resource.target->view, nullptr);
+			vkDestroyImage(mDevice->logicalDevice, resource.target->image, nullptr);
+		}
+	}
+	for (Block& block : mBlocks)
+	{
+		vkFreeMemory(mDevice->logicalDevice, block.memory, nullptr);
+	}
+	mBlocks.clear();
+	mAsyncTimeline.Destroy();
+}
+
+RenderGraph::ResourceHandle RenderGraph::ImportImage(const std::string& name, const FrameBufferAttachment* attachment, VkImageLayout layout)
+{
+	Resource resource;
+	resource.name = name;
+	resource.kind = Kind::Imported;
+	resource.imported = attachment;
+	resource.state.layout = layout;
+	mResources.push_back(resource);
+	return static_cast<ResourceHandle>(mResources.size() - 1);
+}
+
+RenderGraph::ResourceHandle RenderGraph::ImportBuffer(const std::string& name, VkBuffer buffer)
+{
+	Resource resource;
+	resource.name = name;
+	resource.kind = Kind::Buffer;
+	resource.buffer = buffer;
+	mResources.push_back(resource);
+	return static_cast<ResourceHandle>(mResources.size() - 1);
+}
+
+RenderGraph::ResourceHandle RenderGraph::ImportAcquiredImage(const std::string& name, VkFormat format)
+{
+	Resource resource;
+	resource.name = name;
+	resource.kind = Kind::Acquired;
+	resource.desc.format = format;
+	mResources.push_back(resource);
+	return static_cast<ResourceHandle>(mResources.size() - 1);
+}
+
+void RenderGraph::SetImage(ResourceHandle resource, VkImage image)
+{
+	mResources[resource].image = image;
+}
+
+void RenderGraph::SwapImported(ResourceHandle a, ResourceHandle b)
+{
+	Resource& first = mResources[a];
+	Resource& second = mResources[b];
+	if (first.kind != Kind::Imported || second.kind != Kind::Imported)
+	{
+		throw std::runtime_error("failed to swap " + first.name + " and " + second.name + ", both have to be imported images!");
+	}
+	//The state belongs to the image, so barriers keep waiting for what was done to it last frame
+	std::swap(first.imported, second.imported);
+	std::swap(first.state, second.state);
+}
+
+RenderGraph::ResourceHandle RenderGraph::CreateImage(const std::string& name, const ImageDesc& desc, FrameBufferAttachment* target)
+{
+	//Passes create their render passes before Compile, the format is known from here on
+	target->format = desc.format;
+
+	Resource resource;
+	resource.name = name;
+	resource.kind = Kind::Transient;
+	resource.target = target;
+	resource.desc = desc;
+	mResources.push_back(resource);
+	return static_cast<ResourceHandle>(mResources.size() - 1);
+}
+
+void RenderGraph::SetFinalUsage(ResourceHandle resource, Usage usage)
+{
+	mResources[resource].hasFinalUsage = true;
+	mResources[resource].finalUsage = usage;
+}
+
+RenderGraph::PassHandle RenderGraph::AddPass(const std::string& name, VkCommandBuffer* cmd, RecordFunc record, bool mainThread)
+{
+	Pass pass;
+	pass.name = name;
+	pass.cmd = cmd;
+	pass.record = record;
+	pass.mainThread = mainThread;
+	mPasses.push_back(pass);
+	return static_cast<PassHandle>(mPasses.size() - 1);
+}
+
+RenderGraph::PassHandle RenderGraph::AddAsyncComputePass(const std::string& name, VkCommandBuffer* cmd, RecordFunc record)
+{
+	PassHandle pass = AddPass(name, cmd, record);
+	mPasses[pass].queue = Queue::AsyncCompute;
+	return pass;
+}
+
+void RenderGraph::Read(PassHandle pass, ResourceHandle resource, Usage usage)
+{
+	AddAccess(pass, resource, usage, false);
+}
+
+void RenderGraph::Write(PassHandle pass, ResourceHandle resource, Usage usage)
+{
+	AddAccess(pass, resource, usage, true);
+}
+
+void RenderGraph::SetFrameBegin(RecordFunc begin)
+{
+	mFrameBegin = begin;
+}
+
+void RenderGraph::Compile()
+{
+	for (Resource& resource : mResources)
+	{
+		VkFormat format = resource.kind == Kind::Imported ? resource.imported->format : resource.desc.format;
+		resource.aspect = AspectOf(format);
+	}
+
+	Cull();
+
+	mStats.passCount = 0;
+	mStats.asyncPassCount = 0;
+	mStats.culledPasses.clear();
+	std::vector<int> lastWriter(mResources.size(), -1);
+	std::vector<int> lastGraphicsUse(mResources.size(), -1);
+	for (int i = 0; i < static_cast<int>(mPasses.size()); ++i)
+	{
+		const Pass& pass = mPasses[i];
+		if (pass.live == false)
+		{
+			mStats.culledPasses.push_back(pass.name);
+			continue;
+		}
+		++mStats.passCount;
+		if (pass.queue == Queue::AsyncCompute)
+		{
+			++mStats.asyncPassCount;
+		}
+		for (const Access& access : pass.accesses)
+		{
+			Resource& resource = mResources[access.resource];
+			if (resource.firstPass < 0)
+			{
+				if (resource.kind == Kind::Transient && access.write == false)
+				{
+					throw std::runtime_error("render graph: " + resource.name + " is read by " + pass.name + " before anything writes it!");
+				}
+				if (resource.kind == Kind::Acquired)
+				{
+					mAcquireStage = InfoOf(access.usage).stages;
+					mAcquirePass = i;
+				}
+				resource.firstPass = i;
+			}
+			resource.lastPass = i;
+
+			//Async passes start with the frame, so they can't wait for graphics work of the same frame
+			const int writer = lastWriter[access.resource];
+			if (pass.queue == Queue::AsyncCompute && lastGraphicsUse[access.resource] >= 0)
+			{
+				throw std::runtime_error("render graph: async pass " + pass.name + " uses " + resource.name + " after graphics passes of the same frame!");
+			}
+			if (pass.queue == Queue::Graphics && writer >= 0 && mPasses[writer].queue == Queue::AsyncCompute)
+			{
+				if (mComputeWaitPass < 0)
+				{
+					mComputeWaitPass = i;
+				}
+				mComputeWaitStages |= InfoOf(access.usage).stages;
+				resource.crossQueue = true;
+			}
+			if (access.write == true)
+			{
+				lastWriter[access.resource] = i;
+			}
+			if (pass.queue == Queue::Graphics)
+			{
+				lastGraphicsUse[access.resource] = i;
+			}
+		}
+	}
+	mStats.culledCount = static_cast<uint32_t>(mPasses.size()) - mStats.passCount;
+
+	CreateTransients();
+	mCompiled = true;
+}
+
+void RenderGraph::Execute()
+{
+	if (mCompiled == false)
+	{
+		throw std::runtime_error("render graph executed before it was compiled!");
+	}
+	PlanBarriers();
+
+	int firstLive = -1;
+	for (int i = 0; i < static_cast<int>(mPasses.size()); ++i)
+	{
+		if (mPasses[i].live == true && mPasses[i].queue == Queue::Graphics)
+		{
+			firstLive = i;
+			break;
+		}
+	}
+
+	//Every pass has its own command buffer and pool, so they are recorded side by side
+	JobCounter recording;
+	for (int i = 0; i < static_cast<int>(mPasses.size()); ++i)
+	{
+		Pass& pass = mPasses[i];
+		if (pass.live == true && pass.mainThread == false)
+		{
+			bool first = i == firstLive;
+			mJobSystem->Run([this, &pass, first]() { RecordPass(pass, first); }, &recording);
+		}
+	}
+	for (int i = 0; i < static_cast<int>(mPasses.size()); ++i)
+	{
+		Pass& pass = mPasses[i];
+		if (pass.live == true && pass.mainThread == true)
+		{
+			RecordPass(pass, i == firstLive);
+		}
+	}
+	mJobSystem->Wait(recording);
+}
+
+void RenderGraph::Submit(VkSemaphore acquired, VkSemaphore complete, const TimelineSemaphore& timeline, uint64_t timelineValue)
+{
+	//Graphics passes before the first one using async results go out as a batch that doesn't wait for them
+	mSubmitBuffers.clear();
+	mAsyncBuffers.clear();
+	size_t split = 0;
+	bool acquireInFirst = true;
+	for (int i = 0; i < static_cast<int>(mPasses.size()); ++i)
+	{
+		const Pass& pass = mPasses[i];
+		if (pass.live == false)
+		{
+			continue;
+		}
+		if (pass.queue == Queue::AsyncCompute)
+		{
+			mAsyncBuffers.push_back(*pass.cmd);
+			continue;
+		}
+		if (i == mComputeWaitPass)
+		{
+			split = mSubmitBuffers.size();
+		}
+		if (i == mAcquirePass && mComputeWaitPass >= 0 && i >= mComputeWaitPass)
+		{
+			acquireInFirst = false;
+		}
+		mSubmitBuffers.push_back(*pass.cmd);
+	}
+
+	uint64_t asyncValue = 0;
+	if (mAsyncBuffers.empty() == false)
+	{
+		//Last frame's graphics passes may still read what these overwrite
+		const uint64_t previousFrame = timelineValue - 1;
+		const VkSemaphore previousSemaphore = timeline.GetSemaphore();
+		const VkPipelineStageFlags previousStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		asyncValue = mAsyncTimeline.Advance();
+		const VkSemaphore asyncSemaphore = mAsyncTimeline.GetSemaphore();
+		VkTimelineSemaphoreSubmitInfo asyncTimelineInfo = TimelineSemaphore::SubmitInfo(1, &previousFrame, 1, &asyncValue);
+
+		VkSubmitInfo asyncInfo{};
+		asyncInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		asyncInfo.pNext = &asyncTimelineInfo;
+		asyncInfo.waitSemaphoreCount = 1;
+		asyncInfo.pWaitSemaphores = &previousSemaphore;
+		asyncInfo.pWaitDstStageMask = &previousStage;
+		asyncInfo.commandBufferCount = static_cast<uint32_t>(mAsyncBuffers.size());
+		asyncInfo.pCommandBuffers = mAsyncBuffers.data();
+		asyncInfo.signalSemaphoreCount = 1;
+		asyncInfo.pSignalSemaphores = &asyncSemaphore;
+		VK_CHECK_RESULT(vkQueueSubmit(mComputeQueue, 1, &asyncInfo, VK_NULL_HANDLE))
+	}
+
+	//Passes on one queue in one batch are ordered by their barriers alone, no semaphores in between
+	const bool waitsForAsync = asyncValue != 0 && mComputeWaitPass >= 0;
+	const uint32_t batchCount = waitsForAsync == true && split > 0 ? 2 : 1;
+	const uint32_t last = batchCount - 1;
+	VkSemaphore waitSemaphores[2][2];
+	VkPipelineStageFlags waitStages[2][2];
+	uint64_t waitValues[2][2];
+	uint32_t waitCounts[2] = { 0, 0 };
+	if (acquired != VK_NULL_HANDLE)
+	{
+		const uint32_t batch = acquireInFirst == true ? 0 : last;
+		waitSemaphores[batch][waitCounts[batch]] = acquired;
+		waitStages[batch][waitCounts[batch]] = mAcquireStage;
+		waitValues[batch][waitCounts[batch]++] = 0;
+	}
+	if (waitsForAsync == true)
+	{
+		waitSemaphores[last][waitCounts[last]] = mAsyncTimeline.GetSemaphore();
+		waitStages[last][waitCounts[last]] = mComputeWaitStages;
+		waitValues[last][waitCounts[last]++] = asyncValue;
+	}
+
+	//The presentation engine only takes binary semaphores, the CPU waits on the timeline
+	VkSemaphore signalSemaphores[2];
+	uint64_t signalValues[2];
+	uint32_t signalCount = 0;
+	if (complete != VK_NULL_HANDLE)
+	{
+		signalSemaphores[signalCount] = complete;
+		signalValues[signalCount++] = 0;
+	}
+	signalSemaphores[signalCount] = timeline.GetSemaphore();
+	signalValues[signalCount++] = timelineValue;
+
+	VkTimelineSemaphoreSubmitInfo timelineInfos[2];
+	VkSubmitInfo submitInfos[2];
+	for (uint32_t b = 0; b < batchCount; ++b)
+	{
+		const size_t first = b == 0 ? 0 : split;
+		const size_t end = b == last ? mSubmitBuffers.size() : split;
+		const bool signals = b == last;
+		timelineInfos[b] = TimelineSemaphore::SubmitInfo(waitCounts[b], waitValues[b], signals ? signalCount : 0, signalValues);
+
+		submitInfos[b] = {};
+		submitInfos[b].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfos[b].pNext = &timelineInfos[b];
+		submitInfos[b].waitSemaphoreCount = waitCounts[b];
+		submitInfos[b].pWaitSemaphores = waitSemaphores[b];
+		submitInfos[b].pWaitDstStageMask = waitStages[b];
+		submitInfos[b].commandBufferCount = static_cast<uint32_t>(end - first);
+		submitInfos[b].pCommandBuffers = mSubmitBuffers.data() + first;
+		submitInfos[b].signalSemaphoreCount = signals ? signalCount : 0;
+		submitInfos[b].pSignalSemaphores = signalSemaphores;
+	}
+	VK_CHECK_RESULT(vkQueueSubmit(mGraphicsQueue, batchCount, submitInfos, VK_NULL_HANDLE))
+}
+
+/*************************************************************************************************************/
+
+RenderGraph::AccessInfo RenderGraph::InfoOf(Usage usage)
+{
+	switch (usage)
+	{
+	case Usage::ColorAttachment:
+		return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+	case Usage::DepthAttachment:
+		return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+	case Usage::SampledFragment:
+		return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	case Usage::SampledCompute:
+		return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	case Usage::StorageCompute:
+		return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL };
+	case Usage::TransferSrc:
+		return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL };
+	case Usage::TransferDst:
+		return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL };
+	case Usage::StorageBufferCompute:
+		return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED };
+	case Usage::StorageBufferFragment:
+		return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED };
+	case Usage::DrawIndirect:
+		return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED };
+	case Usage::Present:
+	default:
+		return { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR };
+	}
+}
+
+VkImageAspectFlags RenderGraph::AspectOf(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_X8_D24_UNORM_PACK32:
+	case VK_FORMAT_D32_SFLOAT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT;
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	case VK_FORMAT_S8_UINT:
+		return VK_IMAGE_ASPECT_STENCIL_BIT;
+	default:
+		return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+}
+
+VkImage RenderGraph::ImageOf(const Resource& resource) const
+{
+	switch (resource.kind)
+	{
+	case Kind::Imported:
+		return resource.imported->image;
+	case Kind::Acquired:
+		return resource.image;
+	case Kind::Buffer:
+		return VK_NULL_HANDLE;
+	case Kind::Transient:
+	default:
+		return resource.target->image;
+	}
+}
+
+void RenderGraph::AddAccess(PassHandle pass, ResourceHandle resource, Usage usage, bool write)
+{
+	for (Access& access : mPasses[pass].accesses)
+	{
+		if (access.resource == resource)
+		{
+			//One barrier per resource and pass, a second use in another layout can't be served
+			if (access.usage != usage)
+			{
+				throw std::runtime_error("render graph: " + mPasses[pass].name + " uses " + mResources[resource].name + " in two ways!");
+			}
+			access.write = access.write || write;
+			return;
+		}
+	}
+	mPasses[pass].accesses.push_back({ resource, usage, write });
+}
+
+void RenderGraph::Cull()
+{
+	//Outputs leave the frame: imported images and buffers are read again next frame, final usages are handed on
+	std::vector<bool> needed(mResources.size(), false);
+	for (size_t i = 0; i < mResources.size(); ++i)
+	{
+		needed[i] = mResources[i].kind == Kind::Imported || mResources[i].kind == Kind::Buffer || mResources[i].hasFinalUsage == true;
+	}
+
+	//Walking backwards, a pass lives when it writes something a live pass or an output needs
+	for (int i = static_cast<int>(mPasses.size()) - 1; i >= 0; --i)
+	{
+		Pass& pass = mPasses[i];
+		pass.live = false;
+		for (const Access& access : pass.accesses)
+		{
+			if (access.write == true && needed[access.resource] == true)
+			{
+				pass.live = true;
+			}
+		}
+		if (pass.live == true)
+		{
+			//Attachments may be loaded, so whatever it writes needs the earlier writers too
+			for (const Access& access : pass.accesses)
+			{
+				needed[access.resource] = true;
+			}
+		}
+	}
+}
+
+void RenderGraph::CreateTransients()
+{
+	VkDevice device = mDevice->logicalDevice;
+	const uint32_t families[] = { mDevice->queueFamilyIndices.graphics, mDevice->queueFamilyIndices.compute };
+
+	std::vector<ResourceHandle> transients;
+	for (ResourceHandle handle = 0; handle < mResources.size(); ++handle)
+	{
+		Resource& resource = mResources[handle];
+		if (resource.kind != Kind::Transient || resource.firstPass < 0)
+		{
+			continue;
+		}
+
+		VkImageCreateInfo image{};
+		image.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		image.imageType = VK_IMAGE_TYPE_2D;
+		image.format = resource.desc.format;
+		image.extent.width = resource.desc.width;
+		image.extent.height = resource.desc.height;
+		image.extent.depth = 1;
+		image.mipLevels = 1;
+		image.arrayLayers = 1;
+		image.samples = VK_SAMPLE_COUNT_1_BIT;
+		image.tiling = VK_IMAGE_TILING_OPTIMAL;
+		image.usage = resource.desc.usage;
+		image.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (resource.crossQueue == true && families[0] != families[1])
+		{
+			//Semaphores order the queues, concurrent sharing saves the ownership transfers on top
+			image.sharingMode = VK_SHARING_MODE_CONCURRENT;
+			image.queueFamilyIndexCount = 2;
+			image.pQueueFamilyIndices = families;
+		}
+		VK_CHECK_RESULT(vkCreateImage(device, &image, nullptr, &resource.target->image))
+		vkGetImageMemoryRequirements(device, resource.target->image, &resource.requirements);
+		transients.push_back(handle);
+	}
+
+	//Largest first, each one goes into the first block none of whose occupants is alive at the same time.
+	//Everything sits at offset 0 of its block, so alignment always holds
+	std::sort(transients.begin(), transients.end(), [this](ResourceHandle a, ResourceHandle b)
+	{
+		return mResources[a].requirements.size > mResources[b].requirements.size;
+	});
+	for (ResourceHandle handle : transients)
+	{
+		Resource& resource = mResources[handle];
+		int chosen = -1;
+		//The queues don't see each other's barriers, memory handed between them is not shared with anything else
+		for (int b = 0; b < static_cast<int>(mBlocks.size()) && chosen < 0 && resource.crossQueue == false; ++b)
+		{
+			const Block& block = mBlocks[b];
+			if ((block.memoryTypeBits & resource.requirements.memoryTypeBits) == 0 || mResources[block.occupants[0]].crossQueue == true)
+			{
+				continue;
+			}
+			bool overlaps = false;
+			for (ResourceHandle other : block.occupants)
+			{
+				const Resource& occupant = mResources[other];
+				if (resource.firstPass <= occupant.lastPass && occupant.firstPass <= resource.lastPass)
+				{
+					overlaps = true;
+					break;
+				}
+			}
+			if (overlaps == false)
+			{
+				chosen = b;
+			}
+		}
+		if (chosen < 0)
+		{
+			mBlocks.push_back(Block{});
+			mBlocks.back().memoryTypeBits = resource.requirements.memoryTypeBits;
+			chosen = static_cast<int>(mBlocks.size()) - 1;
+		}
+		else
+		{
+			++mStats.aliasedCount;
+		}
+
+		Block& block = mBlocks[chosen];
+		block.size = std::max(block.size, resource.requirements.size);
+		block.memoryTypeBits &= resource.requirements.memoryTypeBits;
+		block.occupants.push_back(handle);
+		resource.block = chosen;
+		mStats.transientBytes += resource.requirements.size;
+		++mStats.transientCount;
+	}
+
+	for (Block& block : mBlocks)
+	{
+		VkMemoryAllocateInfo memAlloc{};
+		memAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		memAlloc.allocationSize = block.size;
+		memAlloc.memoryTypeIndex = mDevice->getMemoryType(block.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		VK_CHECK_RESULT(vkAllocateMemory(device, &memAlloc, nullptr, &block.memory))
+		mStats.allocatedBytes += block.size;
+
+		for (ResourceHandle handle : block.occupants)
+		{
+			Resource& resource = mResources[handle];
+			FrameBufferAttachment* target = resource.target;
+			target->memory = block.memory;
+			VK_CHECK_RESULT(vkBindImageMemory(device, target->image, block.memory, 0))
+
+			VkImageViewCreateInfo imageView = initializers::imageViewCreateInfo();
+			imageView.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			imageView.format = resource.desc.format;
+			imageView.subresourceRange = {};
+			imageView.subresourceRange.aspectMask = resource.aspect;
+			imageView.subresourceRange.baseMipLevel = 0;
+			imageView.subresourceRange.levelCount = 1;
+			imageView.subresourceRange.baseArrayLayer = 0;
+			imageView.subresourceRange.layerCount = 1;
+			imageView.image = target->image;
+			VK_CHECK_RESULT(vkCreateImageView(device, &imageView, nullptr, &target->view))
+		}
+	}
+}
+
+bool RenderGraph::Transition(ResourceHandle handle, Queue queue, const AccessInfo& info, bool write, bool firstUse,
+	VkImageMemoryBarrier* barrier, VkPipelineStageFlags* srcStages)
+{
+	Resource& resource = mResources[handle];
+	State& state = resource.state;
+
+	if (state.queue != queue)
+	{
+		//Handed over by the semaphore wait of this queue's submit, which already made the other queue's writes visible.
+		//Only a layout transition still has to chain onto the stages of that wait
+		const VkPipelineStageFlags handOver = queue == Queue::Graphics ? mComputeWaitStages : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		state.queue = queue;
+		state.writeStages = info.layout != state.layout ? handOver : 0;
+		state.writeAccess = 0;
+		state.readStages = 0;
+	}
+
+	bool needed = false;
+	VkPipelineStageFlags waitStages = 0;
+	VkAccessFlags waitAccess = 0;
+	if (info.layout != state.layout)
+	{
+		//A layout transition rewrites the image, everything before has to be done with it
+		needed = true;
+		waitStages = state.writeStages | state.readStages;
+		waitAccess = state.writeAccess;
+	}
+	else if (write == true)
+	{
+		//Write after write, or after reads that have to see the old contents
+		waitStages = state.writeStages | state.readStages;
+		waitAccess = state.writeAccess;
+		needed = waitStages != 0;
+	}
+	else if ((state.readStages & info.stages) != info.stages)
+	{
+		//Read after write by a stage that hasn't waited for it yet. Reads of the same stage share one barrier
+		waitStages = state.writeStages;
+		waitAccess = state.writeAccess;
+		needed = waitStages != 0;
+	}
+
+	if (firstUse == true && resource.block >= 0)
+	{
+		//The memory was in use by other transients, earlier this frame or in the last one
+		for (ResourceHandle other : mBlocks[resource.block].occupants)
+		{
+			if (other != handle)
+			{
+				const State& occupant = mResources[other].state;
+				waitStages |= occupant.writeStages | occupant.readStages;
+				waitAccess |= occupant.writeAccess;
+			}
+		}
+	}
+
+	if (needed == true)
+	{
+		*barrier = {};
+		barrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier->srcAccessMask = waitAccess;
+		barrier->dstAccessMask = info.access;
+		barrier->oldLayout = state.layout;
+		barrier->newLayout = info.layout;
+		barrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier->image = ImageOf(resource);
+		barrier->subresourceRange = { resource.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+		*srcStages = waitStages;
+		if (*srcStages == 0)
+		{
+			*srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		}
+	}
+
+	if (write == true || info.layout != state.layout)
+	{
+		//Later accesses wait for this one, a transition into a read layout counts as the write they wait for
+		state.layout = info.layout;
+		state.writeStages = info.stages;
+		state.writeAccess = write == true ? info.access & WRITE_ACCESS : 0;
+		state.readStages = write == true ? 0 : info.stages;
+	}
+	else
+	{
+		state.readStages |= info.stages;
+	}
+	return needed;
+}
+
+void RenderGraph::PlanBarriers()
+{
+	//Transients start over every frame. Stages are kept so their first barrier still waits for last frame's work
+	for (Resource& resource : mResources)
+	{
+		if (resource.kind == Kind::Transient)
+		{
+			resource.state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		}
+		else if (resource.kind == Kind::Acquired)
+		{
+			//The submit waits for the acquire at this stage, the first barrier chains onto that wait
+			resource.state = State{};
+			resource.state.writeStages = mAcquireStage;
+		}
+	}
+
+	mStats.barrierCount = 0;
+	mStats.batchCount = 0;
+	for (int i = 0; i < static_cast<int>(mPasses.size()); ++i)
+	{
+		Pass& pass = mPasses[i];
+		pass.barriers.clear();
+		pass.bufferBarriers.clear();
+		pass.srcStages = 0;
+		pass.dstStages = 0;
+		pass.finalBarriers.clear();
+		pass.finalSrcStages = 0;
+		pass.finalDstStages = 0;
+		if (pass.live == false)
+		{
+			continue;
+		}
+
+		for (const Access& access : pass.accesses)
+		{
+			AccessInfo info = InfoOf(access.usage);
+			VkImageMemoryBarrier barrier;
+			VkPipelineStageFlags srcStages;
+			const Resource& resource = mResources[access.resource];
+			bool firstUse = resource.firstPass == i;
+			if (Transition(access.resource, pass.queue, info, access.write, firstUse, &barrier, &srcStages) == true)
+			{
+				if (resource.kind == Kind::Buffer)
+				{
+					VkBufferMemoryBarrier bufferBarrier{};
+					bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+					bufferBarrier.srcAccessMask = barrier.srcAccessMask;
+					bufferBarrier.dstAccessMask = barrier.dstAccessMask;
+					bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					bufferBarrier.buffer = resource.buffer;
+					bufferBarrier.offset = 0;
+					bufferBarrier.size = VK_WHOLE_SIZE;
+					pass.bufferBarriers.push_back(bufferBarrier);
+				}
+				else
+				{
+					pass.barriers.push_back(barrier);
+				}
+				pass.srcStages |= srcStages;
+				pass.dstStages |= info.stages;
+			}
+		}
+		for (const Access& access : pass.accesses)
+		{
+			const Resource& resource = mResources[access.resource];
+			if (resource.hasFinalUsage == false || resource.lastPass != i)
+			{
+				continue;
+			}
+			AccessInfo info = InfoOf(resource.finalUsage);
+			VkImageMemoryBarrier barrier;
+			VkPipelineStageFlags srcStages;
+			if (Transition(access.resource, pass.queue, info, false, false, &barrier, &srcStages) == true)
+			{
+				pass.finalBarriers.push_back(barrier);
+				pass.finalSrcStages |= srcStages;
+				pass.finalDstStages |= info.stages;
+			}
+		}
+
+		const bool anyBarrier = pass.barriers.empty() == false || pass.bufferBarriers.empty() == false;
+		mStats.barrierCount += static_cast<uint32_t>(pass.barriers.size() + pass.bufferBarriers.size() + pass.finalBarriers.size());
+		mStats.batchCount += (anyBarrier ? 1 : 0) + (pass.finalBarriers.empty() ? 0 : 1);
+	}
+}
+
+void RenderGraph::RecordPass(Pass& pass, bool first)
+{
+	VkCommandBuffer cmd = *pass.cmd;
+	VkCommandBufferBeginInfo cmdBufInfo = initializers::commandBufferBeginInfo();
+	VK_CHECK_RESULT(vkBeginCommandBuffer(cmd, &cmdBufInfo))
+
+	if (first == true && mFrameBegin)
+	{
+		mFrameBegin(cmd);
+	}
+	if (pass.barriers.empty() == false || pass.bufferBarriers.empty() == false)
+	{
+		vkCmdPipelineBarrier(cmd, pass.srcStages, pass.dstStages, 0, 0, nullptr,
+			static_cast<uint32_t>(pass.bufferBarriers.size()), pass.bufferBarriers.data(),
+			static_cast<uint32_t>(pass.barriers.size()), pass.barriers.data());
+	}
+
+	pass.record(cmd);
+
+	if (pass.finalBarriers.empty() == false)
+	{
+		vkCmdPipelineBarrier(cmd, pass.finalSrcStages, pass.finalDstStages, 0, 0, nullptr, 0, nullptr,
+			static_cast<uint32_t>(pass.finalBarriers.size()), pass.finalBarriers.data());
+	}
+	VK_CHECK_RESULT(vkEndCommandBuffer(cmd));
+}
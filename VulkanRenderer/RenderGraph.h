@@ -0,0 +1,227 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "Attachment.h"
+#include "JobSystem.h"
+#include "TimelineSemaphore.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct VulkanDevice;
+
+//The frame as a list of passes that declare which images they read and write.
+//Everything in between is worked out here: layout transitions and barriers, passes whose results nobody uses,
+//memory for images that only live within a frame, and a single submit for the whole frame.
+//Render passes of the graph keep their attachments in the attachment layout from start to end and have no
+//external dependencies, the barriers recorded ahead of each pass take care of that.
+//Async compute passes go to the compute queue in a submit of their own and run next to the graphics passes.
+//The graphics work is split in front of the first pass that uses their results, only the part after it waits.
+class RenderGraph
+{
+public:
+	using ResourceHandle = uint32_t;
+	using PassHandle = uint32_t;
+	using RecordFunc = std::function<void(VkCommandBuffer)>;
+
+	enum class Queue
+	{
+		Graphics,
+		AsyncCompute,
+	};
+
+	enum class Usage
+	{
+		ColorAttachment,
+		DepthAttachment,
+		SampledFragment,
+		SampledCompute,
+		StorageCompute,
+		TransferSrc,
+		TransferDst,
+		StorageBufferCompute,//Buffers only
+		StorageBufferFragment,
+		DrawIndirect,//Indirect commands and index data of draws, buffers only
+		Present,//Final usage only
+	};
+
+	struct ImageDesc
+	{
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		VkImageUsageFlags usage = 0;
+	};
+
+	struct Stats
+	{
+		uint32_t passCount = 0;
+		uint32_t culledCount = 0;
+		std::vector<std::string> culledPasses;//Nothing used their results, in the order they were added
+		uint32_t barrierCount = 0;//Image barriers of the last frame
+		uint32_t batchCount = 0;//vkCmdPipelineBarrier calls they were merged into
+		uint32_t asyncPassCount = 0;
+		uint32_t transientCount = 0;
+		uint32_t aliasedCount = 0;//Transients placed in memory another one uses too
+		VkDeviceSize transientBytes = 0;//Needed with one allocation per transient
+		VkDeviceSize allocatedBytes = 0;
+	};
+
+	//computeQueue may be graphicsQueue itself when the device has no separate compute family
+	void Init(VulkanDevice* device, JobSystem* jobSystem, VkQueue graphicsQueue, VkQueue computeQueue);
+	//Frees the transients, the device must be idle
+	void Destroy();
+
+	//Owned elsewhere and kept between frames. layout is the one the image is in right now,
+	//attachment is read when the frame is recorded so it may be filled in after the declaration
+	ResourceHandle ImportImage(const std::string& name, const FrameBufferAttachment* attachment, VkImageLayout layout);
+	//Kept between frames like imported images. Buffers used by both queues have to be created with concurrent sharing
+	ResourceHandle ImportBuffer(const std::string& name, VkBuffer buffer);
+	//Swapchain images: set every frame, contents are discarded and the submit waits for the acquire right before the first use
+	ResourceHandle ImportAcquiredImage(const std::string& name, VkFormat format);
+	void SetImage(ResourceHandle resource, VkImage image);
+	//Exchanges the images behind two imported handles along with their tracked state, for history buffers
+	//that are written one frame and read the next. Call between frames, before Execute
+	void SwapImported(ResourceHandle a, ResourceHandle b);
+	VkImage GetImage(ResourceHandle resource) const { return ImageOf(mResources[resource]); }
+	//Created by Compile into target, contents don't outlive the frame. Transients whose lifetimes don't overlap share memory
+	ResourceHandle CreateImage(const std::string& name, const ImageDesc& desc, FrameBufferAttachment* target);
+	//Leaves the frame in the layout of usage, e.g. Present for the swapchain. Such resources are outputs of the graph
+	void SetFinalUsage(ResourceHandle resource, Usage usage);
+
+	//Passes run in declaration order. The graph begins and ends cmd, record only fills it.
+	//Passes are recorded by jobs at the same time, mainThread ones on the thread calling Execute
+	PassHandle AddPass(const std::string& name, VkCommandBuffer* cmd, RecordFunc record, bool mainThread = false);
+	//cmd comes from a pool of the compute family. The pass may only use what is written before the frame is submitted
+	//or by other async passes, it starts once the previous frame is done instead of after earlier graphics passes
+	PassHandle AddAsyncComputePass(const std::string& name, VkCommandBuffer* cmd, RecordFunc record);
+	void Read(PassHandle pass, ResourceHandle resource, Usage usage);
+	void Write(PassHandle pass, ResourceHandle resource, Usage usage);
+	//Recorded into the first live graphics pass's command buffer before anything else
+	void SetFrameBegin(RecordFunc begin);
+
+	//Once everything is declared. Culls passes, works out lifetimes and creates the transients
+	void Compile();
+	//Records every live pass with its barriers and waits for the recording jobs
+	void Execute();
+	//One submit per queue for all live passes. acquired is waited on at the first use of the acquired image,
+	//complete is the binary semaphore presentation waits on and timeline is signaled at timelineValue once all is done.
+	//Async passes wait for timelineValue - 1, so they never overwrite what the previous frame still reads
+	void Submit(VkSemaphore acquired, VkSemaphore complete, const TimelineSemaphore& timeline, uint64_t timelineValue);
+
+	const Stats& GetStats() const { return mStats; }
+
+private:
+	enum class Kind
+	{
+		Imported,
+		Acquired,
+		Transient,
+		Buffer,
+	};
+
+	struct State
+	{
+		Queue queue = Queue::Graphics;//Of the last access
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags writeStages = 0;//Last write or layout transition
+		VkAccessFlags writeAccess = 0;
+		VkPipelineStageFlags readStages = 0;//Reads since then, already made to wait for it
+	};
+
+	struct Resource
+	{
+		std::string name;
+		Kind kind = Kind::Imported;
+		const FrameBufferAttachment* imported = nullptr;
+		FrameBufferAttachment* target = nullptr;
+		VkImage image = VK_NULL_HANDLE;//Acquired images
+		VkBuffer buffer = VK_NULL_HANDLE;
+		ImageDesc desc;
+		VkImageAspectFlags aspect = 0;
+		bool hasFinalUsage = false;
+		Usage finalUsage = Usage::Present;
+		bool crossQueue = false;//Used by both queues in a frame
+
+		int firstPass = -1;//Lifetime over the live passes
+		int lastPass = -1;
+		int block = -1;//Memory block of a transient
+		VkMemoryRequirements requirements{};
+		State state;
+	};
+
+	struct Access
+	{
+		ResourceHandle resource = 0;
+		Usage usage = Usage::SampledFragment;
+		bool write = false;
+	};
+
+	struct Pass
+	{
+		std::string name;
+		VkCommandBuffer* cmd = nullptr;
+		RecordFunc record;
+		bool mainThread = false;
+		Queue queue = Queue::Graphics;
+		std::vector<Access> accesses;
+		bool live = false;
+
+		//Filled each frame by Execute
+		std::vector<VkImageMemoryBarrier> barriers;
+		std::vector<VkBufferMemoryBarrier> bufferBarriers;
+		VkPipelineStageFlags srcStages = 0;
+		VkPipelineStageFlags dstStages = 0;
+		std::vector<VkImageMemoryBarrier> finalBarriers;
+		VkPipelineStageFlags finalSrcStages = 0;
+		VkPipelineStageFlags finalDstStages = 0;
+	};
+
+	struct Block
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize size = 0;
+		uint32_t memoryTypeBits = 0;
+		std::vector<ResourceHandle> occupants;
+	};
+
+	struct AccessInfo
+	{
+		VkPipelineStageFlags stages;
+		VkAccessFlags access;
+		VkImageLayout layout;
+	};
+
+	static AccessInfo InfoOf(Usage usage);
+	static VkImageAspectFlags AspectOf(VkFormat format);
+	VkImage ImageOf(const Resource& resource) const;
+
+	void AddAccess(PassHandle pass, ResourceHandle resource, Usage usage, bool write);
+	void Cull();
+	void CreateTransients();
+	//Barrier that makes resource ready for info, false when none is needed. Updates the tracked state
+	bool Transition(ResourceHandle resource, Queue queue, const AccessInfo& info, bool write, bool firstUse,
+		VkImageMemoryBarrier* barrier, VkPipelineStageFlags* srcStages);
+	void PlanBarriers();
+	void RecordPass(Pass& pass, bool first);
+
+	VulkanDevice* mDevice = nullptr;
+	JobSystem* mJobSystem = nullptr;
+	VkQueue mGraphicsQueue = VK_NULL_HANDLE;
+	VkQueue mComputeQueue = VK_NULL_HANDLE;
+
+	std::vector<Resource> mResources;
+	std::vector<Pass> mPasses;
+	std::vector<Block> mBlocks;
+	RecordFunc mFrameBegin;
+	bool mCompiled = false;
+
+	std::vector<VkCommandBuffer> mSubmitBuffers;
+	std::vector<VkCommandBuffer> mAsyncBuffers;
+	VkPipelineStageFlags mAcquireStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	int mAcquirePass = -1;//First use of the acquired image
+	TimelineSemaphore mAsyncTimeline;//Signaled by each async submit, the graphics part after mComputeWaitPass waits on it
+	int mComputeWaitPass = -1;//First graphics pass that uses an async result
+	VkPipelineStageFlags mComputeWaitStages = 0;//Stages of the graphics passes using async results
+	Stats mStats;
+};
@@ -0,0 +1,283 @@
+#include "ResourceManager.h"
+#include "Mesh.h"
+#include "TextureStreamer.h"
+#include "VulkanDevice.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+
+void ResourceManager::Init(VulkanDevice* vulkanDevice, JobSystem* jobSystem, TextureStreamer* textureStreamer)
+{
+	mVulkanDevice = vulkanDevice;
+	mJobSystem = jobSystem;
+	mTextureStreamer = textureStreamer;
+	CreatePlaceholderMesh();
+	mReadyMeshes.push_back(mPlaceholder.get());
+}
+
+void ResourceManager::Destroy()
+{
+	mJobSystem->Wait(mLoadJobs);
+	std::lock_guard<std::mutex> lock(mMutex);
+	mMeshes.clear();
+	mFreeMeshes.clear();
+	mMeshKeys.clear();
+	mReleasedMeshes.clear();
+	mReadyMeshes.clear();
+	mTextures.clear();
+	mTextureKeys.clear();
+	mPlaceholder.reset();
+}
+
+std::string ResourceManager::MakeKey(const std::string& file)
+{
+	return std::filesystem::path(file).lexically_normal().generic_string();
+}
+
+MeshHandle ResourceManager::LoadMesh(const std::string& file)
+{
+	const std::string key = MakeKey(file);
+	std::lock_guard<std::mutex> lock(mMutex);
+	++mStats.meshRequests;
+
+	auto found = mMeshKeys.find(key);
+	if (found != mMeshKeys.end())
+	{
+		MeshEntry& entry = *mMeshes[found->second];
+		++entry.refCount;
+		return { found->second, entry.generation };
+	}
+
+	uint32_t index;
+	if (mFreeMeshes.empty() == false)
+	{
+		index = mFreeMeshes.back();
+		mFreeMeshes.pop_back();
+	}
+	else
+	{
+		index = static_cast<uint32_t>(mMeshes.size());
+		mMeshes.push_back(std::make_unique<MeshEntry>());
+	}
+	MeshEntry* entry = mMeshes[index].get();
+	entry->key = key;
+	entry->refCount = 1;
+	entry->state = LOAD_QUEUED;
+	entry->mesh.reset();
+	mMeshKeys.emplace(key, index);
+	++mStats.meshCount;
+	++mStats.meshesLoading;
+
+	//Background jobs, a frame never waits for a load it picked up while helping
+	mJobSystem->RunBackground([this, entry]() { LoadMeshJob(entry); }, &mLoadJobs);
+	return { index, entry->generation };
+}
+
+void ResourceManager::LoadMeshJob(MeshEntry* entry)
+{
+	//The key is only rewritten once the entry was freed, which waits for this job
+	auto start = std::chrono::steady_clock::now();
+	std::unique_ptr<Mesh> mesh = std::make_unique<Mesh>();
+	const bool loaded = mesh->loadAndCreateMesh(entry->key.c_str(), mVulkanDevice, glm::vec3(1.f), mJobSystem);
+	const float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	--mStats.meshesLoading;
+	if (loaded == false)
+	{
+		++mStats.meshesFailed;
+		entry->state = LOAD_FAILED;
+		return;
+	}
+	entry->mesh = std::move(mesh);
+	mReadyMeshes.push_back(entry->mesh.get());
+	mStats.lastLoadMs = ms;
+	entry->state = LOAD_DONE;
+}
+
+TextureHandle ResourceManager::LoadTexture(const std::string& file, bool cubemap)
+{
+	const std::string key = MakeKey(file);
+	std::lock_guard<std::mutex> lock(mMutex);
+	++mStats.textureRequests;
+
+	auto found = mTextureKeys.find(key);
+	if (found != mTextureKeys.end())
+	{
+		++mTextures[found->second].refCount;
+		return { found->second, 0 };
+	}
+
+	const uint32_t index = static_cast<uint32_t>(mTextures.size());
+	mTextures.push_back({ key, 1, mTextureStreamer->Request(key, cubemap) });
+	mTextureKeys.emplace(key, index);
+	++mStats.textureCount;
+	return { index, 0 };
+}
+
+void ResourceManager::AddRef(MeshHandle handle)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	MeshEntry* entry = FindMesh(handle);
+	if (entry != nullptr)
+	{
+		++entry->refCount;
+	}
+}
+
+void ResourceManager::Release(MeshHandle handle)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	MeshEntry* entry = FindMesh(handle);
+	if (entry == nullptr || entry->refCount == 0)
+	{
+		return;
+	}
+	if (--entry->refCount == 0)
+	{
+		entry->releaseFrame = mFrame;
+		mReleasedMeshes.push_back(handle.index);
+	}
+}
+
+void ResourceManager::AddRef(TextureHandle handle)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (handle.index < mTextures.size())
+	{
+		++mTextures[handle.index].refCount;
+	}
+}
+
+void ResourceManager::Release(TextureHandle handle)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (handle.index < mTextures.size() && mTextures[handle.index].refCount > 0)
+	{
+		--mTextures[handle.index].refCount;
+	}
+}
+
+Mesh* ResourceManager::GetMesh(MeshHandle handle)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	MeshEntry* entry = FindMesh(handle);
+	if (entry == nullptr || entry->state != LOAD_DONE)
+	{
+		return mPlaceholder.get();
+	}
+	return entry->mesh.get();
+}
+
+bool ResourceManager::IsReady(MeshHandle handle)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	MeshEntry* entry = FindMesh(handle);
+	return entry != nullptr && entry->state == LOAD_DONE;
+}
+
+uint32_t ResourceManager::GetTextureSlot(TextureHandle handle)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (handle.index >= mTextures.size())
+	{
+		throw std::runtime_error("failed to find texture of handle!");
+	}
+	return mTextures[handle.index].slot;
+}
+
+std::vector<Mesh*> ResourceManager::TakeReadyMeshes()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::vector<Mesh*> ready;
+	ready.swap(mReadyMeshes);
+	return ready;
+}
+
+void ResourceManager::Update(uint64_t frame)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mFrame = frame;
+
+	//Taken again in the meantime or still loading, those stay. Stale handles of freed ones read the placeholder
+	std::vector<uint32_t> kept;
+	for (uint32_t index : mReleasedMeshes)
+	{
+		MeshEntry& entry = *mMeshes[index];
+		if (entry.refCount != 0)
+		{
+			continue;
+		}
+		if (entry.releaseFrame >= frame || entry.state == LOAD_QUEUED)
+		{
+			kept.push_back(index);
+			continue;
+		}
+		if (entry.state == LOAD_FAILED)
+		{
+			--mStats.meshesFailed;
+		}
+		mReadyMeshes.erase(std::remove(mReadyMeshes.begin(), mReadyMeshes.end(), entry.mesh.get()), mReadyMeshes.end());
+		mMeshKeys.erase(entry.key);
+		entry.mesh.reset();
+		entry.key.clear();
+		++entry.generation;
+		mFreeMeshes.push_back(index);
+		--mStats.meshCount;
+	}
+	mReleasedMeshes.swap(kept);
+}
+
+ResourceManager::Stats ResourceManager::GetStats()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
+
+ResourceManager::MeshEntry* ResourceManager::FindMesh(MeshHandle handle)
+{
+	if (handle.index >= mMeshes.size() || mMeshes[handle.index]->generation != handle.generation || mMeshes[handle.index]->key.empty() == true)
+	{
+		return nullptr;
+	}
+	return mMeshes[handle.index].get();
+}
+
+void ResourceManager::CreatePlaceholderMesh()
+{
+	//Unit cube with a vertex per face corner, so every face keeps its own normal
+	mPlaceholder = std::make_unique<Mesh>();
+	Mesh& mesh = *mPlaceholder;
+	for (uint32_t axis = 0; axis < 3; ++axis)
+	{
+		for (float side : { -1.f, 1.f })
+		{
+			glm::vec3 normal(0.f);
+			normal[axis] = side;
+			glm::vec3 u(0.f);
+			glm::vec3 v(0.f);
+			u[(axis + 1) % 3] = 0.5f;
+			v[(axis + 2) % 3] = 0.5f * side;
+			const uint32_t first = static_cast<uint32_t>(mesh.vertices.size());
+			const glm::vec2 corners[4] = { { -1.f, -1.f }, { 1.f, -1.f }, { 1.f, 1.f }, { -1.f, 1.f } };
+			for (const glm::vec2& corner : corners)
+			{
+				Vertex vertex;
+				vertex.position = normal * 0.5f + u * corner.x + v * corner.y;
+				vertex.normal = normal;
+				vertex.UV = corner * 0.5f + 0.5f;
+				mesh.vertices.push_back(vertex);
+			}
+			for (uint32_t index : { 0u, 1u, 2u, 0u, 2u, 3u })
+			{
+				mesh.indices.push_back(first + index);
+			}
+		}
+	}
+	mesh.vertexNum = static_cast<int>(mesh.vertices.size());
+	mesh.faceNum = static_cast<int>(mesh.indices.size() / 3);
+	mesh.boundCenter = glm::vec3(0.f);
+	mesh.boundRadius = glm::length(glm::vec3(0.5f));
+	mesh.createMesh(mVulkanDevice);
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include "JobSystem.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Mesh;
+struct VulkanDevice;
+class TextureStreamer;
+
+//Slot in one of the resource manager's tables. The generation tells a reused slot from the one the handle was made for
+template <typename Tag>
+struct AssetHandle
+{
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+
+	bool IsValid() const { return index != UINT32_MAX; }
+	bool operator==(const AssetHandle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const AssetHandle& other) const { return (*this == other) == false; }
+};
+
+struct MeshAssetTag;
+struct TextureAssetTag;
+using MeshHandle = AssetHandle<MeshAssetTag>;
+using TextureHandle = AssetHandle<TextureAssetTag>;
+
+//Loads every file once however often it is asked for. Requests are keyed by the normalized path and counted,
+//the last Release frees the asset once the frames that could still draw it are done.
+//Meshes are parsed and uploaded by background jobs, until then GetMesh hands out a placeholder cube.
+//Textures go to the texture streamer, which already shows placeholders until their levels arrive, so this only
+//dedupes them; their slots stay with the streamer, which drops unused levels by itself.
+//Shaders are not in here, the shader registry already caches them by source name
+class ResourceManager
+{
+public:
+	struct Stats
+	{
+		uint32_t meshRequests = 0;//LoadMesh calls, repeated ones included
+		uint32_t meshCount = 0;//Distinct meshes held
+		uint32_t meshesLoading = 0;
+		uint32_t meshesFailed = 0;
+		uint32_t textureRequests = 0;
+		uint32_t textureCount = 0;
+		float lastLoadMs = 0.f;//Parse to upload of the last mesh that finished
+	};
+
+	void Init(VulkanDevice* vulkanDevice, JobSystem* jobSystem, TextureStreamer* textureStreamer);
+	//Waits for loads still running and frees every mesh, released or not
+	void Destroy();
+
+	//Safe from any thread. Each call takes a reference that has to be released again
+	MeshHandle LoadMesh(const std::string& file);
+	TextureHandle LoadTexture(const std::string& file, bool cubemap = false);
+	void AddRef(MeshHandle handle);
+	void Release(MeshHandle handle);
+	void AddRef(TextureHandle handle);
+	void Release(TextureHandle handle);
+
+	//The loaded mesh, or the placeholder while it is loading, failed or the handle is stale
+	Mesh* GetMesh(MeshHandle handle);
+	Mesh* GetPlaceholderMesh() const { return mPlaceholder.get(); }
+	bool IsReady(MeshHandle handle);
+	//Texture streamer handle, also the bindless slot
+	uint32_t GetTextureSlot(TextureHandle handle);
+
+	//Meshes that finished loading since the last call, the placeholder comes first
+	std::vector<Mesh*> TakeReadyMeshes();
+
+	//Call once per frame after the previous frame completed, meshes released before that are freed here
+	void Update(uint64_t frame);
+
+	Stats GetStats();
+
+	//Paths that name the same file the same way, "a/../b.obj" and "b.obj" share an entry
+	static std::string MakeKey(const std::string& file);
+
+private:
+	enum LoadState
+	{
+		LOAD_QUEUED = 0,
+		LOAD_DONE,
+		LOAD_FAILED
+	};
+
+	struct MeshEntry
+	{
+		std::string key;
+		uint32_t generation = 0;
+		uint32_t refCount = 0;
+		std::atomic<int> state{ LOAD_QUEUED };
+		std::unique_ptr<Mesh> mesh;//Written by the loading job, read only once state is LOAD_DONE
+		uint64_t releaseFrame = 0;
+	};
+
+	//Never freed, so their handles stay at generation 0
+	struct TextureEntry
+	{
+		std::string key;
+		uint32_t refCount = 0;
+		uint32_t slot = 0;
+	};
+
+	void LoadMeshJob(MeshEntry* entry);
+	MeshEntry* FindMesh(MeshHandle handle);
+	void CreatePlaceholderMesh();
+
+	VulkanDevice* mVulkanDevice = nullptr;
+	JobSystem* mJobSystem = nullptr;
+	TextureStreamer* mTextureStreamer = nullptr;
+	JobCounter mLoadJobs;
+	uint64_t mFrame = 0;
+
+	std::mutex mMutex;//Guards everything below
+	std::vector<std::unique_ptr<MeshEntry>> mMeshes;
+	std::vector<uint32_t> mFreeMeshes;
+	std::unordered_map<std::string, uint32_t> mMeshKeys;
+	std::vector<uint32_t> mReleasedMeshes;//Reached zero references, freed by Update unless taken again
+	std::vector<Mesh*> mReadyMeshes;
+	std::vector<TextureEntry> mTextures;
+	std::unordered_map<std::string, uint32_t> mTextureKeys;
+	Stats mStats;
+
+	std::unique_ptr<Mesh> mPlaceholder;
+};
@@ -19,18 +19,40 @@ void S_Pass::CreateFrameData()
 	CreateAttachment();
 	CreateRenderPass();
 	CreateFrameBuffer();
+
+	CreatePointAttachment();
+	CreatePointRenderPass();
+	CreatePointFrameBuffer();
 }
 
-void S_Pass::CreatePipelineData()
+void S_Pass::CreatePipelineData(JobCounter* ready)
 {
 	CreatePipelineLayout();
-	CreatePipeline();
+	mApp->mPipelineBuilder.Build("Shadow", [this]() { return CreatePipeline(); }, &mPipeline, ready);
+
+	CreatePointPipelineLayout();
+	mApp->mPipelineBuilder.Build("PointShadow", [this]() { return CreatePointPipeline(); }, &mPointPipeline, ready);
 }
 
 void S_Pass::CreateAttachment()
 {
 	//VkFormat attDepthFormat = mApp->FindDepthFormat();
-	mApp->CreateDepthOnlyAttachment(VK_FORMAT_D32_SFLOAT, &mDepth);
+	mApp->CreateLayeredDepthAttachment(VK_FORMAT_D32_SFLOAT, mWidth, mHeight, SHADOW_MAP_CASCADE_COUNT, &mDepth);
+
+	for (uint32_t i = 0; i < SHADOW_MAP_CASCADE_COUNT; ++i)
+	{
+		VkImageViewCreateInfo viewInfo = initializers::imageViewCreateInfo();
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+		viewInfo.format = mDepth.format;
+		viewInfo.subresourceRange = {};
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = i;
+		viewInfo.subresourceRange.layerCount = 1;
+		viewInfo.image = mDepth.image;
+		VK_CHECK_RESULT(vkCreateImageView(mApp->mVulkanDevice->logicalDevice, &viewInfo, nullptr, &mCascadeViews[i]))
+	}
 }
 
 void S_Pass::CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes)
@@ -74,6 +96,31 @@ void S_Pass::UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeD
 	vkUpdateDescriptorSets(mApp->mVulkanDevice->logicalDevice, static_cast<uint32_t>(writeDescSets.size()), writeDescSets.data(), 0, nullptr);
 }
 
+void S_Pass::CreatePointDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings)
+{
+	VkDescriptorSetLayoutCreateInfo pointDescriptorLayout = initializers::descriptorSetLayoutCreateInfo(setLayoutBindings);
+	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(mApp->mVulkanDevice->logicalDevice, &pointDescriptorLayout, nullptr, &mPointDescriptorLayout))
+}
+
+void S_Pass::CreatePointDescriptorSet()
+{
+	VkDescriptorSetAllocateInfo setAllocInfo{};
+	setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocInfo.descriptorPool = mDescriptorPool;
+	setAllocInfo.descriptorSetCount = 1;
+	setAllocInfo.pSetLayouts = &mPointDescriptorLayout;
+
+	if (vkAllocateDescriptorSets(mApp->mVulkanDevice->logicalDevice, &setAllocInfo, &mPointDescriptorSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate descriptor sets");
+	}
+}
+
+void S_Pass::UpdatePointDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets)
+{
+	vkUpdateDescriptorSets(mApp->mVulkanDevice->logicalDevice, static_cast<uint32_t>(writeDescSets.size()), writeDescSets.data(), 0, nullptr);
+}
+
 void S_Pass::CreateRenderPass()
 {
 	VkAttachmentDescription depthDesc = {};
@@ -83,8 +130,9 @@ void S_Pass::CreateRenderPass()
 	depthDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 	depthDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
 
-	depthDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	depthDesc.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	//The render graph transitions the cascades around the pass, Lighting samples them in shader read
+	depthDesc.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthDesc.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 	depthDesc.format = mDepth.format;
 
@@ -98,32 +146,149 @@ void S_Pass::CreateRenderPass()
 	subpass.colorAttachmentCount = 0;
 	subpass.pDepthStencilAttachment = &depthReference;
 
-	// Use subpass dependencies for attachment layout transitions
-	// src: Before render
-	// dst: After render
-	std::array<VkSubpassDependency, 2> dependencies;
+	VkRenderPassCreateInfo renderPassInfo = {};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.pAttachments = &depthDesc;
+	renderPassInfo.attachmentCount = 1;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	VK_CHECK_RESULT(vkCreateRenderPass(mApp->mVulkanDevice->logicalDevice, &renderPassInfo, nullptr, &mRenderPass))
+}
+
+void S_Pass::CreateFrameBuffer()
+{
+	for (uint32_t i = 0; i < SHADOW_MAP_CASCADE_COUNT; ++i)
+	{
+		VkImageView attachment = mCascadeViews[i];
+
+		VkFramebufferCreateInfo fbufCreateInfo = {};
+		fbufCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		fbufCreateInfo.pNext = NULL;
+		fbufCreateInfo.renderPass = mRenderPass;
+		fbufCreateInfo.pAttachments = &attachment;
+		fbufCreateInfo.attachmentCount = 1;
+		fbufCreateInfo.width = mWidth;
+		fbufCreateInfo.height = mHeight;
+		fbufCreateInfo.layers = 1;
+		VK_CHECK_RESULT(vkCreateFramebuffer(mApp->mVulkanDevice->logicalDevice, &fbufCreateInfo, nullptr, &mCascadeFrameBuffers[i]));
+	}
+}
+
+void S_Pass::CreatePipelineLayout()
+{
+	mPushConstants = mApp->mShaders.ReflectPushConstants({ "Shadow.vert", "Shadow.frag" });
+	if (mPushConstants.size != sizeof(CascadePushConstant))
+	{
+		throw std::runtime_error("failed to match CascadePushConstant with the shadow shaders!");
+	}
+
+	VkPipelineLayoutCreateInfo pipelinelayoutCI = initializers::pipelineLayoutCreateInfo(&mDescriptorLayout, 1);
+	pipelinelayoutCI.pushConstantRangeCount = 1;
+	pipelinelayoutCI.pPushConstantRanges = &mPushConstants;
+
+	VK_CHECK_RESULT(vkCreatePipelineLayout(mApp->mVulkanDevice->logicalDevice, &pipelinelayoutCI, nullptr, &mPipelineLayout))
+}
+
+VkPipeline S_Pass::CreatePipeline()
+{
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState =
+		initializers::pipelineInputAssemblyStateCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
+	VkPipelineRasterizationStateCreateInfo rasterizationState =
+		initializers::pipelineRasterizationStateCreateInfo(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
+	// Casters between the light and the fitted cascade volume are clamped onto the near plane instead of clipped
+	rasterizationState.depthClampEnable = mApp->mVulkanDevice->enabledFeatures.depthClamp;
+	// Slope scaled bias against acne on the orthographic cascades
+	rasterizationState.depthBiasEnable = VK_TRUE;
+	rasterizationState.depthBiasConstantFactor = 1.25f;
+	rasterizationState.depthBiasSlopeFactor = 1.75f;
+	VkPipelineColorBlendAttachmentState blendAttachmentState =
+		initializers::pipelineColorBlendAttachmentState(0xf, VK_FALSE);
+	VkPipelineColorBlendStateCreateInfo colorBlendState =
+		initializers::pipelineColorBlendStateCreateInfo(0, &blendAttachmentState);
+	VkPipelineDepthStencilStateCreateInfo depthStencilState =
+		initializers::pipelineDepthStencilStateCreateInfo(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS_OR_EQUAL);
+	VkPipelineViewportStateCreateInfo viewportState =
+		initializers::pipelineViewportStateCreateInfo(1, 1, 0);
+	VkPipelineMultisampleStateCreateInfo multisampleState =
+		initializers::pipelineMultisampleStateCreateInfo(VK_SAMPLE_COUNT_1_BIT, 0);
+	std::vector<VkDynamicState> dynamicStateEnables = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamicState =
+		initializers::pipelineDynamicStateCreateInfo(dynamicStateEnables);
+
+	std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages;
 
-	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependencies[0].dstSubpass = 0;
+	VkGraphicsPipelineCreateInfo pipelineCI = initializers::pipelineCreateInfo(mPipelineLayout, mRenderPass);
+	pipelineCI.pInputAssemblyState = &inputAssemblyState;
+	pipelineCI.pRasterizationState = &rasterizationState;
+	pipelineCI.pColorBlendState = &colorBlendState;
+	pipelineCI.pMultisampleState = &multisampleState;
+	pipelineCI.pViewportState = &viewportState;
+	pipelineCI.pDepthStencilState = &depthStencilState;
+	pipelineCI.pDynamicState = &dynamicState;
+	pipelineCI.stageCount = static_cast<uint32_t>(shaderStages.size());
+	pipelineCI.pStages = shaderStages.data();
 
-	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+	auto bindingDescription = Vertex::getBindingDescription();
+	auto attributeDescriptions = Vertex::getAttributeDescriptions();
+	
+	shaderStages[0] = mApp->mPipelineBuilder.ShaderStage("Shadow.vert");
+	shaderStages[1] = mApp->mPipelineBuilder.ShaderStage("Shadow.frag");
 
-	dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputInfo.vertexBindingDescriptionCount = 1;
+	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+	vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+	pipelineCI.pVertexInputState = &vertexInputInfo;
 
-	dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
-	dependencies[1].srcSubpass = 0;
-	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	
+	return mApp->mPipelineBuilder.CreateGraphicsPipeline(pipelineCI);
+}
 
-	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+void S_Pass::CreatePointAttachment()
+{
+	const uint32_t layerCount = POINT_SHADOW_SLOTS * 6;
+	mApp->CreateLayeredDepthAttachment(VK_FORMAT_D32_SFLOAT, mPointSize, mPointSize, layerCount, &mPointDepth, true);
+
+	VkImageViewCreateInfo viewInfo = initializers::imageViewCreateInfo();
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+	viewInfo.format = mPointDepth.format;
+	viewInfo.subresourceRange = {};
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = layerCount;
+	viewInfo.image = mPointDepth.image;
+	VK_CHECK_RESULT(vkCreateImageView(mApp->mVulkanDevice->logicalDevice, &viewInfo, nullptr, &mPointLayeredView))
+}
 
-	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+void S_Pass::CreatePointRenderPass()
+{
+	//Load keeps the slots that are not re-rendered this frame. Dirty slots are cleared with vkCmdClearAttachments
+	VkAttachmentDescription depthDesc = {};
+	depthDesc.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthDesc.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	depthDesc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 
-	dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+	depthDesc.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthDesc.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	depthDesc.format = mPointDepth.format;
+
+	VkAttachmentReference depthReference = {};
+	depthReference.attachment = 0;
+	depthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.pColorAttachments = VK_NULL_HANDLE;
+	subpass.colorAttachmentCount = 0;
+	subpass.pDepthStencilAttachment = &depthReference;
 
 	VkRenderPassCreateInfo renderPassInfo = {};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -131,51 +296,49 @@ void S_Pass::CreateRenderPass()
 	renderPassInfo.attachmentCount = 1;
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 2;
-	renderPassInfo.pDependencies = dependencies.data();
-	VK_CHECK_RESULT(vkCreateRenderPass(mApp->mVulkanDevice->logicalDevice, &renderPassInfo, nullptr, &mRenderPass))
+	VK_CHECK_RESULT(vkCreateRenderPass(mApp->mVulkanDevice->logicalDevice, &renderPassInfo, nullptr, &mPointRenderPass))
 }
 
-void S_Pass::CreateFrameBuffer()
+void S_Pass::CreatePointFrameBuffer()
 {
-	VkImageView attachment = mDepth.view;
-
 	VkFramebufferCreateInfo fbufCreateInfo = {};
 	fbufCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
 	fbufCreateInfo.pNext = NULL;
-	fbufCreateInfo.renderPass = mRenderPass;
-	fbufCreateInfo.pAttachments = &attachment;
+	fbufCreateInfo.renderPass = mPointRenderPass;
+	fbufCreateInfo.pAttachments = &mPointLayeredView;
 	fbufCreateInfo.attachmentCount = 1;
-	fbufCreateInfo.width = mWidth;
-	fbufCreateInfo.height = mHeight;
-	fbufCreateInfo.layers = 1;
-	VK_CHECK_RESULT(vkCreateFramebuffer(mApp->mVulkanDevice->logicalDevice, &fbufCreateInfo, nullptr, &mFrameBuffer));
+	fbufCreateInfo.width = mPointSize;
+	fbufCreateInfo.height = mPointSize;
+	fbufCreateInfo.layers = POINT_SHADOW_SLOTS * 6;//gl_Layer picks slot * 6 + face
+	VK_CHECK_RESULT(vkCreateFramebuffer(mApp->mVulkanDevice->logicalDevice, &fbufCreateInfo, nullptr, &mPointFrameBuffer));
 }
 
-void S_Pass::CreatePipelineLayout()
+void S_Pass::CreatePointPipelineLayout()
 {
-	VkPushConstantRange pushConstant;
-	pushConstant.offset = 0;
-	pushConstant.size = sizeof(glm::mat4);
-	pushConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	mPointPushConstants = mApp->mShaders.ReflectPushConstants({ "PointShadow.vert", "PointShadow.geom", "PointShadow.frag" });
+	if (mPointPushConstants.size != sizeof(PointShadowPushConstant))
+	{
+		throw std::runtime_error("failed to match PointShadowPushConstant with the point shadow shaders!");
+	}
 
-	VkPipelineLayoutCreateInfo pipelinelayoutCI = initializers::pipelineLayoutCreateInfo(&mDescriptorLayout, 1);
+	VkPipelineLayoutCreateInfo pipelinelayoutCI = initializers::pipelineLayoutCreateInfo(&mPointDescriptorLayout, 1);
 	pipelinelayoutCI.pushConstantRangeCount = 1;
-	pipelinelayoutCI.pPushConstantRanges = &pushConstant;
+	pipelinelayoutCI.pPushConstantRanges = &mPointPushConstants;
 
-	VK_CHECK_RESULT(vkCreatePipelineLayout(mApp->mVulkanDevice->logicalDevice, &pipelinelayoutCI, nullptr, &mPipelineLayout))
+	VK_CHECK_RESULT(vkCreatePipelineLayout(mApp->mVulkanDevice->logicalDevice, &pipelinelayoutCI, nullptr, &mPointPipelineLayout))
 }
 
-void S_Pass::CreatePipeline()
+VkPipeline S_Pass::CreatePointPipeline()
 {
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState =
 		initializers::pipelineInputAssemblyStateCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
+	// Cube faces are rendered without the y flip, so winding is reversed. Both sides cast.
 	VkPipelineRasterizationStateCreateInfo rasterizationState =
-		initializers::pipelineRasterizationStateCreateInfo(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
+		initializers::pipelineRasterizationStateCreateInfo(VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
 	VkPipelineColorBlendAttachmentState blendAttachmentState =
 		initializers::pipelineColorBlendAttachmentState(0xf, VK_FALSE);
 	VkPipelineColorBlendStateCreateInfo colorBlendState =
-		initializers::pipelineColorBlendStateCreateInfo(1, &blendAttachmentState);
+		initializers::pipelineColorBlendStateCreateInfo(0, &blendAttachmentState);
 	VkPipelineDepthStencilStateCreateInfo depthStencilState =
 		initializers::pipelineDepthStencilStateCreateInfo(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS_OR_EQUAL);
 	VkPipelineViewportStateCreateInfo viewportState =
@@ -186,9 +349,9 @@ void S_Pass::CreatePipeline()
 	VkPipelineDynamicStateCreateInfo dynamicState =
 		initializers::pipelineDynamicStateCreateInfo(dynamicStateEnables);
 
-	std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages;
+	std::array<VkPipelineShaderStageCreateInfo, 3> shaderStages;
 
-	VkGraphicsPipelineCreateInfo pipelineCI = initializers::pipelineCreateInfo(mPipelineLayout, mRenderPass);
+	VkGraphicsPipelineCreateInfo pipelineCI = initializers::pipelineCreateInfo(mPointPipelineLayout, mPointRenderPass);
 	pipelineCI.pInputAssemblyState = &inputAssemblyState;
 	pipelineCI.pRasterizationState = &rasterizationState;
 	pipelineCI.pColorBlendState = &colorBlendState;
@@ -202,9 +365,11 @@ void S_Pass::CreatePipeline()
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	auto bindingDescription = Vertex::getBindingDescription();
 	auto attributeDescriptions = Vertex::getAttributeDescriptions();
-	
-	shaderStages[0] = createShaderStageCreateInfo("../shaders/ShadowVert.spv", VK_SHADER_STAGE_VERTEX_BIT, mApp->mVulkanDevice->logicalDevice);
-	shaderStages[1] = createShaderStageCreateInfo("../shaders/ShadowFrag.spv", VK_SHADER_STAGE_FRAGMENT_BIT, mApp->mVulkanDevice->logicalDevice);
+
+	//Geometry shader is instanced once per cube face and routes each copy with gl_Layer
+	shaderStages[0] = mApp->mPipelineBuilder.ShaderStage("PointShadow.vert");
+	shaderStages[1] = mApp->mPipelineBuilder.ShaderStage("PointShadow.geom");
+	shaderStages[2] = mApp->mPipelineBuilder.ShaderStage("PointShadow.frag");
 
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 	vertexInputInfo.vertexBindingDescriptionCount = 1;
@@ -213,9 +378,7 @@ void S_Pass::CreatePipeline()
 	vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 	pipelineCI.pVertexInputState = &vertexInputInfo;
 
-
-	
-	VK_CHECK_RESULT(vkCreateGraphicsPipelines(mApp->mVulkanDevice->logicalDevice, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &mPipeline))
+	return mApp->mPipelineBuilder.CreateGraphicsPipeline(pipelineCI);
 }
 
 void S_Pass::Update()
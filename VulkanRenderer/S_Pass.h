@@ -1,8 +1,11 @@
 #pragma once
 #include <vulkan/vulkan.h>
 #include "Attachment.h"
+#include "UniformStructure.h"
+#include <array>
 
 class VkApp;
+class JobCounter;
 class S_Pass
 {
 private:
@@ -16,24 +19,38 @@ public:
 	void CreateDescriptorSet();
 
 	void CreateFrameData();
-	void CreatePipelineData();
+	//Layouts are created right away, pipelines are built as jobs that count on ready
+	void CreatePipelineData(JobCounter* ready);
 
 	void UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets);
 
+	void CreatePointDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings);
+	void CreatePointDescriptorSet();
+	void UpdatePointDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets);
+
 private:
 	void CreateAttachment();
 	void CreateRenderPass();
 	void CreateFrameBuffer();
 
 	void CreatePipelineLayout();
-	void CreatePipeline();
+	VkPipeline CreatePipeline();
+
+	void CreatePointAttachment();
+	void CreatePointRenderPass();
+	void CreatePointFrameBuffer();
+
+	void CreatePointPipelineLayout();
+	VkPipeline CreatePointPipeline();
 
 public:
 	uint32_t mWidth, mHeight;
 
-	VkFramebuffer mFrameBuffer;
+	//One framebuffer per cascade, each rendering into its own layer of mDepth
+	std::array<VkFramebuffer, SHADOW_MAP_CASCADE_COUNT> mCascadeFrameBuffers;
+	std::array<VkImageView, SHADOW_MAP_CASCADE_COUNT> mCascadeViews;
 	VkRenderPass mRenderPass;
-	FrameBufferAttachment mDepth;
+	FrameBufferAttachment mDepth;//Layered depth, mDepth.view covers every cascade
 
 	VkDescriptorPool mDescriptorPool;
 	VkDescriptorSetLayout mDescriptorLayout;
@@ -41,6 +58,21 @@ public:
 
 	VkPipelineLayout mPipelineLayout;
 	VkPipeline mPipeline;
+	VkPushConstantRange mPushConstants{};//Reflected, pushes have to use its stage flags
+
+	//Point light shadows. Each atlas slot is one cube of mPointDepth, all of them rendered by a single layered framebuffer
+	uint32_t mPointSize = POINT_SHADOW_DIM;
+	VkFramebuffer mPointFrameBuffer;
+	VkImageView mPointLayeredView;//2D array view over every face, render target of the geometry shader
+	VkRenderPass mPointRenderPass;
+	FrameBufferAttachment mPointDepth;//mPointDepth.view is the cube array view for sampling
+
+	VkDescriptorSetLayout mPointDescriptorLayout;
+	VkDescriptorSet mPointDescriptorSet;
+
+	VkPipelineLayout mPointPipelineLayout;
+	VkPipeline mPointPipeline;
+	VkPushConstantRange mPointPushConstants{};
 
 	/*VkShaderModule mVertexShader;
 	VkShaderModule mGeometryShader;
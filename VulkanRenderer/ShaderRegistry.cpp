@@ -0,0 +1,717 @@
+#include "ShaderRegistry.h"
+#include "VulkanTools.h"
+#include <shaderc/shaderc.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+	//The parts of the SPIR-V specification reflection needs
+	enum : uint32_t
+	{
+		SPIRV_MAGIC = 0x07230203,
+		SPIRV_HEADER_WORDS = 5,
+
+		OP_ENTRY_POINT = 15,
+		OP_TYPE_BOOL = 20,
+		OP_TYPE_INT = 21,
+		OP_TYPE_FLOAT = 22,
+		OP_TYPE_VECTOR = 23,
+		OP_TYPE_MATRIX = 24,
+		OP_TYPE_IMAGE = 25,
+		OP_TYPE_SAMPLER = 26,
+		OP_TYPE_SAMPLED_IMAGE = 27,
+		OP_TYPE_ARRAY = 28,
+		OP_TYPE_RUNTIME_ARRAY = 29,
+		OP_TYPE_STRUCT = 30,
+		OP_TYPE_POINTER = 32,
+		OP_CONSTANT = 43,
+		OP_VARIABLE = 59,
+		OP_DECORATE = 71,
+		OP_MEMBER_DECORATE = 72,
+
+		DECORATION_BUFFER_BLOCK = 3,
+		DECORATION_ARRAY_STRIDE = 6,
+		DECORATION_MATRIX_STRIDE = 7,
+		DECORATION_BINDING = 33,
+		DECORATION_DESCRIPTOR_SET = 34,
+		DECORATION_OFFSET = 35,
+
+		STORAGE_UNIFORM_CONSTANT = 0,
+		STORAGE_UNIFORM = 2,
+		STORAGE_PUSH_CONSTANT = 9,
+		STORAGE_STORAGE_BUFFER = 12,
+
+		DIM_BUFFER = 5,
+		DIM_SUBPASS_DATA = 6,
+	};
+
+	struct SpirvId
+	{
+		std::vector<uint32_t> words;//Whole defining instruction, opcode word included
+		uint32_t set = 0;
+		uint32_t binding = UINT32_MAX;
+		uint32_t arrayStride = 0;
+		bool bufferBlock = false;
+		std::vector<uint32_t> memberOffsets;
+		std::vector<uint32_t> memberMatrixStrides;
+
+		uint32_t Opcode() const { return words.empty() ? 0 : words[0] & 0xffff; }
+	};
+
+	class SpirvModule
+	{
+	public:
+		explicit SpirvModule(const std::vector<char>& code)
+		{
+			if (code.size() % 4 != 0 || code.size() < SPIRV_HEADER_WORDS * 4)
+			{
+				throw std::runtime_error("failed to reflect shader, not a SPIR-V binary!");
+			}
+			std::vector<uint32_t> words(code.size() / 4);
+			memcpy(words.data(), code.data(), code.size());
+			if (words[0] != SPIRV_MAGIC)
+			{
+				throw std::runtime_error("failed to reflect shader, not a SPIR-V binary!");
+			}
+			mIds.resize(words[3]);
+
+			for (size_t at = SPIRV_HEADER_WORDS; at < words.size();)
+			{
+				const uint32_t opcode = words[at] & 0xffff;
+				const uint32_t count = words[at] >> 16;
+				if (count == 0 || at + count > words.size())
+				{
+					throw std::runtime_error("failed to reflect shader, truncated instruction!");
+				}
+				const uint32_t* op = &words[at];
+				switch (opcode)
+				{
+				case OP_ENTRY_POINT:
+					if (mHasEntryPoint == false)
+					{
+						mExecutionModel = op[1];
+						mHasEntryPoint = true;
+					}
+					break;
+				case OP_DECORATE:
+					Decorate(Id(op[1]), op[2], count > 3 ? op[3] : 0);
+					break;
+				case OP_MEMBER_DECORATE:
+					DecorateMember(Id(op[1]), op[2], op[3], count > 4 ? op[4] : 0);
+					break;
+				case OP_CONSTANT:
+				case OP_VARIABLE:
+					Id(op[2]).words.assign(op, op + count);
+					if (opcode == OP_VARIABLE)
+					{
+						mVariables.push_back(op[2]);
+					}
+					break;
+				default:
+					if (opcode >= OP_TYPE_BOOL && opcode <= OP_TYPE_POINTER)
+					{
+						Id(op[1]).words.assign(op, op + count);
+					}
+					break;
+				}
+				at += count;
+			}
+		}
+
+		ShaderRegistry::Reflection Reflect() const
+		{
+			ShaderRegistry::Reflection reflection;
+			reflection.stage = Stage();
+
+			for (uint32_t variable : mVariables)
+			{
+				const SpirvId& id = mIds[variable];
+				const uint32_t storage = id.words[3];
+				const SpirvId& pointer = mIds[id.words[1]];
+				uint32_t type = pointer.words[3];
+
+				if (storage == STORAGE_PUSH_CONSTANT)
+				{
+					reflection.pushConstantSize = std::max(reflection.pushConstantSize, SizeOf(type, 0));
+					continue;
+				}
+				if (id.binding == UINT32_MAX || (storage != STORAGE_UNIFORM_CONSTANT && storage != STORAGE_UNIFORM && storage != STORAGE_STORAGE_BUFFER))
+				{
+					continue;
+				}
+
+				ShaderRegistry::Binding binding;
+				binding.set = id.set;
+				binding.binding = id.binding;
+				binding.stages = reflection.stage;
+				if (mIds[type].Opcode() == OP_TYPE_ARRAY)
+				{
+					binding.count = ConstantValue(mIds[type].words[3]);
+					type = mIds[type].words[2];
+				}
+				else if (mIds[type].Opcode() == OP_TYPE_RUNTIME_ARRAY)
+				{
+					binding.count = 0;
+					type = mIds[type].words[2];
+				}
+				binding.type = DescriptorType(type, storage);
+				if (binding.type == VK_DESCRIPTOR_TYPE_MAX_ENUM)
+				{
+					continue;
+				}
+
+				auto same = std::find_if(reflection.bindings.begin(), reflection.bindings.end(), [&](const ShaderRegistry::Binding& other)
+					{ return other.set == binding.set && other.binding == binding.binding; });
+				if (same == reflection.bindings.end())
+				{
+					reflection.bindings.push_back(binding);
+				}
+			}
+
+			std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const ShaderRegistry::Binding& a, const ShaderRegistry::Binding& b)
+				{ return a.set != b.set ? a.set < b.set : a.binding < b.binding; });
+			return reflection;
+		}
+
+	private:
+		SpirvId& Id(uint32_t id)
+		{
+			if (id >= mIds.size())
+			{
+				throw std::runtime_error("failed to reflect shader, id out of bounds!");
+			}
+			return mIds[id];
+		}
+
+		void Decorate(SpirvId& id, uint32_t decoration, uint32_t value)
+		{
+			switch (decoration)
+			{
+			case DECORATION_BUFFER_BLOCK: id.bufferBlock = true; break;
+			case DECORATION_ARRAY_STRIDE: id.arrayStride = value; break;
+			case DECORATION_BINDING: id.binding = value; break;
+			case DECORATION_DESCRIPTOR_SET: id.set = value; break;
+			default: break;
+			}
+		}
+
+		void DecorateMember(SpirvId& id, uint32_t member, uint32_t decoration, uint32_t value)
+		{
+			if (decoration != DECORATION_OFFSET && decoration != DECORATION_MATRIX_STRIDE)
+			{
+				return;
+			}
+			std::vector<uint32_t>& values = decoration == DECORATION_OFFSET ? id.memberOffsets : id.memberMatrixStrides;
+			if (values.size() <= member)
+			{
+				values.resize(member + 1, 0);
+			}
+			values[member] = value;
+		}
+
+		VkShaderStageFlagBits Stage() const
+		{
+			switch (mExecutionModel)
+			{
+			case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+			case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+			case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+			case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+			case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+			case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+			default: throw std::runtime_error("failed to reflect shader, unsupported execution model!");
+			}
+		}
+
+		uint32_t ConstantValue(uint32_t id) const
+		{
+			if (mIds[id].Opcode() != OP_CONSTANT)
+			{
+				throw std::runtime_error("failed to reflect shader, array length is a specialization constant!");
+			}
+			return mIds[id].words[3];
+		}
+
+		VkDescriptorType DescriptorType(uint32_t type, uint32_t storage) const
+		{
+			const SpirvId& id = mIds[type];
+			switch (id.Opcode())
+			{
+			case OP_TYPE_SAMPLED_IMAGE:
+				return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			case OP_TYPE_SAMPLER:
+				return VK_DESCRIPTOR_TYPE_SAMPLER;
+			case OP_TYPE_IMAGE:
+			{
+				const uint32_t dim = id.words[3];
+				const bool storageImage = id.words[7] == 2;
+				if (dim == DIM_SUBPASS_DATA)
+				{
+					return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+				}
+				if (dim == DIM_BUFFER)
+				{
+					return storageImage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+				}
+				return storageImage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			}
+			case OP_TYPE_STRUCT:
+				if (storage == STORAGE_STORAGE_BUFFER || id.bufferBlock == true)
+				{
+					return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				}
+				return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			default:
+				return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+			}
+		}
+
+		//Bytes the type occupies with its decorated offsets and strides, what a push constant range has to cover
+		uint32_t SizeOf(uint32_t type, uint32_t matrixStride) const
+		{
+			const SpirvId& id = mIds[type];
+			switch (id.Opcode())
+			{
+			case OP_TYPE_BOOL:
+				return 4;
+			case OP_TYPE_INT:
+			case OP_TYPE_FLOAT:
+				return id.words[2] / 8;
+			case OP_TYPE_VECTOR:
+				return id.words[3] * SizeOf(id.words[2], 0);
+			case OP_TYPE_MATRIX:
+				return id.words[3] * (matrixStride != 0 ? matrixStride : SizeOf(id.words[2], 0));
+			case OP_TYPE_ARRAY:
+				return ConstantValue(id.words[3]) * (id.arrayStride != 0 ? id.arrayStride : SizeOf(id.words[2], 0));
+			case OP_TYPE_POINTER:
+				return 8;
+			case OP_TYPE_STRUCT:
+			{
+				uint32_t size = 0;
+				for (size_t member = 0; member + 2 < id.words.size(); ++member)
+				{
+					const uint32_t offset = member < id.memberOffsets.size() ? id.memberOffsets[member] : 0;
+					const uint32_t stride = member < id.memberMatrixStrides.size() ? id.memberMatrixStrides[member] : 0;
+					size = std::max(size, offset + SizeOf(id.words[member + 2], stride));
+				}
+				return size;
+			}
+			default:
+				return 0;
+			}
+		}
+
+		std::vector<SpirvId> mIds;
+		std::vector<uint32_t> mVariables;
+		uint32_t mExecutionModel = 0;
+		bool mHasEntryPoint = false;
+	};
+}
+
+void ShaderRegistry::Init(const std::string& directory, JobSystem* jobSystem)
+{
+	mDirectory = directory;
+	mJobSystem = jobSystem;
+	mLastPoll = std::chrono::steady_clock::now();
+
+	//A shader whose SPIR-V is missing or older than its source, say edited while the app wasn't running, is built
+	//here on the workers. Nothing below may read a binary before that
+	std::vector<std::string> stale;
+	std::error_code error;
+	for (const std::filesystem::directory_entry& file : std::filesystem::directory_iterator(mDirectory, error))
+	{
+		const std::string source = file.path().filename().string();
+		const std::string extension = file.path().extension().string();
+		if (extension != ".vert" && extension != ".geom" && extension != ".frag" && extension != ".comp")
+		{
+			continue;
+		}
+		std::error_code stampError;
+		auto sourceStamp = std::filesystem::last_write_time(file.path(), stampError);
+		auto spirvStamp = std::filesystem::last_write_time(mDirectory + SpirvName(source), stampError);
+		if (stampError || spirvStamp < sourceStamp)
+		{
+			stale.push_back(source);
+		}
+	}
+	if (error)
+	{
+		throw std::runtime_error("failed to list shaders in " + mDirectory + "!");
+	}
+
+	std::vector<uint8_t> built(stale.size(), 0);
+	std::vector<std::string> errors(stale.size());
+	JobCounter compiles;
+	mJobSystem->ParallelFor(static_cast<uint32_t>(stale.size()), 1, [this, &stale, &built, &errors](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			const std::string spirv = mDirectory + SpirvName(stale[i]);
+			const std::string output = spirv + ".tmp";
+			std::error_code fileError;
+			if (RunCompiler(stale[i], output, errors[i]) == true)
+			{
+				std::filesystem::rename(output, spirv, fileError);
+				built[i] = fileError ? 0 : 1;
+			}
+			if (built[i] == 0)
+			{
+				std::filesystem::remove(output, fileError);
+			}
+		}
+	}, &compiles);
+	mJobSystem->Wait(compiles);
+
+	for (size_t i = 0; i < stale.size(); ++i)
+	{
+		if (built[i] != 0)
+		{
+			AddLog("Shader " + stale[i] + " compiled at startup");
+			continue;
+		}
+		if (std::filesystem::exists(mDirectory + SpirvName(stale[i]), error) == false)
+		{
+			throw std::runtime_error("failed to compile shader " + stale[i] + "!\n" + errors[i]);
+		}
+		mLastError = stale[i] + " failed to compile, running its older binary: " + errors[i];
+		AddLog("Shader " + mLastError);
+	}
+}
+
+void ShaderRegistry::Destroy()
+{
+	mJobSystem->Wait(mCompiles);
+}
+
+std::string ShaderRegistry::SpirvName(const std::string& source)
+{
+	const size_t dot = source.find_last_of('.');
+	if (dot == std::string::npos || dot + 1 == source.size())
+	{
+		throw std::runtime_error("failed to find the compiled name of shader " + source + "!");
+	}
+	std::string stage = source.substr(dot + 1);
+	stage[0] = static_cast<char>(toupper(stage[0]));
+	return source.substr(0, dot) + stage + ".spv";
+}
+
+std::string ShaderRegistry::SpirvPath(const std::string& source)
+{
+	const std::string name = SpirvName(source);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mSources.find(source) == mSources.end())
+	{
+		Source& entry = mSources[source];
+		std::error_code error;
+		entry.stamp = std::filesystem::last_write_time(mDirectory + source, error);
+	}
+	return mDirectory + name;
+}
+
+VkShaderStageFlagBits ShaderRegistry::StageOf(const std::string& source)
+{
+	const std::string extension = source.substr(source.find_last_of('.') + 1);
+	if (extension == "vert") return VK_SHADER_STAGE_VERTEX_BIT;
+	if (extension == "geom") return VK_SHADER_STAGE_GEOMETRY_BIT;
+	if (extension == "frag") return VK_SHADER_STAGE_FRAGMENT_BIT;
+	if (extension == "comp") return VK_SHADER_STAGE_COMPUTE_BIT;
+	throw std::runtime_error("failed to find the stage of shader " + source + "!");
+}
+
+ShaderRegistry::Reflection ShaderRegistry::ReflectSpirv(const std::vector<char>& code)
+{
+	return SpirvModule(code).Reflect();
+}
+
+ShaderRegistry::Reflection ShaderRegistry::Reflect(const std::string& source)
+{
+	const std::string path = SpirvPath(source);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		const Source& entry = mSources[source];
+		if (entry.reflected == true)
+		{
+			return entry.reflection;
+		}
+	}
+
+	Reflection reflection = ReflectSpirv(readFile(path));
+	std::lock_guard<std::mutex> lock(mMutex);
+	Source& entry = mSources[source];
+	entry.reflection = reflection;
+	entry.reflected = true;
+	return reflection;
+}
+
+std::vector<VkDescriptorSetLayoutBinding> ShaderRegistry::ReflectSetLayout(const std::vector<std::string>& sources, uint32_t set,
+	uint32_t runtimeArrayCount, std::vector<VkDescriptorBindingFlags>* flags)
+{
+	std::map<uint32_t, VkDescriptorSetLayoutBinding> merged;
+	std::map<uint32_t, VkDescriptorBindingFlags> mergedFlags;
+	for (const std::string& source : sources)
+	{
+		for (const Binding& binding : Reflect(source).bindings)
+		{
+			if (binding.set != set)
+			{
+				continue;
+			}
+
+			auto found = merged.find(binding.binding);
+			if (found != merged.end())
+			{
+				if (found->second.descriptorType != binding.type)
+				{
+					throw std::runtime_error("failed to merge shader bindings, " + source + " declares another type!");
+				}
+				found->second.stageFlags |= binding.stages;
+				continue;
+			}
+
+			VkDescriptorSetLayoutBinding layoutBinding{};
+			layoutBinding.binding = binding.binding;
+			layoutBinding.descriptorType = binding.type;
+			layoutBinding.descriptorCount = binding.count;
+			layoutBinding.stageFlags = binding.stages;
+			layoutBinding.pImmutableSamplers = nullptr;
+			mergedFlags[binding.binding] = 0;
+			if (binding.count == 0)
+			{
+				if (runtimeArrayCount == 0)
+				{
+					throw std::runtime_error("failed to size the runtime array of " + source + "!");
+				}
+				layoutBinding.descriptorCount = runtimeArrayCount;
+				mergedFlags[binding.binding] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+			}
+			merged[binding.binding] = layoutBinding;
+		}
+	}
+
+	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	for (const auto& binding : merged)
+	{
+		bindings.push_back(binding.second);
+		if (flags != nullptr)
+		{
+			flags->push_back(mergedFlags[binding.first]);
+		}
+	}
+	return bindings;
+}
+
+VkPushConstantRange ShaderRegistry::ReflectPushConstants(const std::vector<std::string>& sources)
+{
+	VkPushConstantRange range{};
+	for (const std::string& source : sources)
+	{
+		Reflection reflection = Reflect(source);
+		if (reflection.pushConstantSize > 0)
+		{
+			range.size = std::max(range.size, reflection.pushConstantSize);
+			range.stageFlags |= reflection.stage;
+		}
+	}
+	return range;
+}
+
+void ShaderRegistry::Poll()
+{
+	auto now = std::chrono::steady_clock::now();
+	if (now - mLastPoll < std::chrono::milliseconds(500))
+	{
+		return;
+	}
+	mLastPoll = now;
+
+	std::vector<std::string> edited;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (auto& source : mSources)
+		{
+			if (source.second.compiling == true)
+			{
+				continue;
+			}
+			std::error_code error;
+			auto stamp = std::filesystem::last_write_time(mDirectory + source.first, error);
+			if (!error && stamp != source.second.stamp)
+			{
+				//Saved again while compiling shows up as another change once this compile is done
+				source.second.stamp = stamp;
+				source.second.compiling = true;
+				edited.push_back(source.first);
+			}
+		}
+	}
+
+	for (const std::string& source : edited)
+	{
+		mJobSystem->RunBackground([this, source]() { Compile(source); }, &mCompiles);
+	}
+}
+
+std::vector<std::string> ShaderRegistry::TakeRecompiled()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::vector<std::string> recompiled;
+	recompiled.swap(mRecompiled);
+	return recompiled;
+}
+
+uint32_t ShaderRegistry::GetSourceCount() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return static_cast<uint32_t>(mSources.size());
+}
+
+uint32_t ShaderRegistry::GetReloadCount() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mReloadCount;
+}
+
+std::string ShaderRegistry::GetLastError() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mLastError;
+}
+
+std::vector<std::string> ShaderRegistry::GetLog() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mLog;
+}
+
+/*************************************************************************************************************/
+
+void ShaderRegistry::Compile(const std::string& source)
+{
+	auto start = std::chrono::steady_clock::now();
+	std::string spirv;
+	std::string output;
+	std::string error;
+	Reflection reflection;
+	try
+	{
+		spirv = SpirvPath(source);
+		//Written next to the old binary first, a failed compile leaves the running version in place
+		output = spirv + ".tmp";
+		std::string compileError;
+		if (RunCompiler(source, output, compileError) == false)
+		{
+			error = source + " failed to compile: " + compileError;
+		}
+		else
+		{
+			reflection = ReflectSpirv(readFile(output));
+		}
+	}
+	catch (const std::exception& exception)
+	{
+		error = source + ": " + exception.what();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		Source& entry = mSources[source];
+		if (error.empty() && entry.reflected == true && (entry.reflection == reflection) == false)
+		{
+			error = source + " changed its bindings or push constants, restart to use it";
+		}
+		if (error.empty())
+		{
+			std::error_code renameError;
+			std::filesystem::rename(output, spirv, renameError);
+			if (renameError)
+			{
+				error = source + ": " + renameError.message();
+			}
+		}
+
+		if (error.empty())
+		{
+			entry.reflection = reflection;
+			entry.reflected = true;
+			mRecompiled.push_back(source);
+			++mReloadCount;
+			std::ostringstream line;
+			line << "Shader " << source << " recompiled in "
+				<< std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms";
+			AddLog(line.str());
+		}
+		else
+		{
+			mLastError = error;
+			AddLog("Shader " + error);
+		}
+		entry.compiling = false;
+	}
+
+	if (error.empty() == false && output.empty() == false)
+	{
+		std::error_code removeError;
+		std::filesystem::remove(output, removeError);
+	}
+}
+
+bool ShaderRegistry::RunCompiler(const std::string& source, const std::string& output, std::string& error) const
+{
+	std::ifstream file(mDirectory + source, std::ios::binary);
+	if (file.is_open() == false)
+	{
+		error = "failed to open " + source;
+		return false;
+	}
+	std::stringstream text;
+	text << file.rdbuf();
+
+	shaderc_shader_kind kind = shaderc_glsl_compute_shader;
+	switch (StageOf(source))
+	{
+	case VK_SHADER_STAGE_VERTEX_BIT: kind = shaderc_glsl_vertex_shader; break;
+	case VK_SHADER_STAGE_GEOMETRY_BIT: kind = shaderc_glsl_geometry_shader; break;
+	case VK_SHADER_STAGE_FRAGMENT_BIT: kind = shaderc_glsl_fragment_shader; break;
+	default: break;
+	}
+
+	//Vulkan 1.2 SPIR-V, the exposure shaders use subgroup operations. A compiler per call, jobs compile side by side
+	shaderc::Compiler compiler;
+	shaderc::CompileOptions options;
+	options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+	options.SetOptimizationLevel(shaderc_optimization_level_performance);
+	shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(text.str(), kind, source.c_str(), options);
+	if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+	{
+		error = result.GetErrorMessage();
+		return false;
+	}
+
+	std::ofstream spirv(output, std::ios::binary | std::ios::trunc);
+	spirv.write(reinterpret_cast<const char*>(result.cbegin()), static_cast<std::streamsize>((result.cend() - result.cbegin()) * sizeof(uint32_t)));
+	spirv.close();
+	if (spirv.fail() == true)
+	{
+		error = "failed to write " + output;
+		return false;
+	}
+	return true;
+}
+
+void ShaderRegistry::AddLog(const std::string& line)
+{
+	//Caller holds mMutex or is Init, before any job could read it. Only the latest lines are kept for the GUI
+	const size_t maxLines = 32;
+	if (mLog.size() == maxLines)
+	{
+		mLog.erase(mLog.begin());
+	}
+	mLog.push_back(line);
+}
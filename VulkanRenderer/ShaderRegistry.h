@@ -0,0 +1,107 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "JobSystem.h"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//Every GLSL source the passes use, named by file ("GBuffer.frag") instead of by compiled path.
+//The SPIR-V of each source is reflected, so descriptor set layouts and push constant ranges come from
+//the shaders themselves rather than from hand written tables that have to be kept in sync.
+//Sources are watched while the app runs, an edited one is recompiled with shaderc on a background job and
+//reported through TakeRecompiled so the pipeline builder can rebuild only the pipelines that use it.
+class ShaderRegistry
+{
+public:
+	struct Binding
+	{
+		uint32_t set = 0;
+		uint32_t binding = 0;
+		VkDescriptorType type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
+		uint32_t count = 1;//0 for runtime sized arrays
+		VkShaderStageFlags stages = 0;
+
+		bool operator==(const Binding& other) const
+		{
+			return set == other.set && binding == other.binding && type == other.type && count == other.count && stages == other.stages;
+		}
+	};
+
+	struct Reflection
+	{
+		VkShaderStageFlagBits stage = VK_SHADER_STAGE_ALL;
+		std::vector<Binding> bindings;//Sorted by set and binding
+		uint32_t pushConstantSize = 0;
+
+		bool operator==(const Reflection& other) const
+		{
+			return stage == other.stage && bindings == other.bindings && pushConstantSize == other.pushConstantSize;
+		}
+	};
+
+	//Compiles every source in directory whose SPIR-V is missing or older than it, before anything gets reflected.
+	//Throws when a missing one can't be built, a stale one that fails keeps running and is logged
+	void Init(const std::string& directory, JobSystem* jobSystem);
+	//Waits for compiles still running
+	void Destroy();
+
+	//Registers source for watching on first use, the output name follows compile.bat: GBuffer.frag -> GBufferFrag.spv
+	std::string SpirvPath(const std::string& source);
+	static VkShaderStageFlagBits StageOf(const std::string& source);
+
+	//Parses the decorations and types of a SPIR-V binary, throws on anything that is not one
+	static Reflection ReflectSpirv(const std::vector<char>& code);
+	//Cached until the source is recompiled. Safe from any thread
+	Reflection Reflect(const std::string& source);
+
+	//Union of the set's bindings over all stages. Runtime sized arrays become bindless tables of runtimeArrayCount
+	//descriptors, flags gets one entry per binding
+	std::vector<VkDescriptorSetLayoutBinding> ReflectSetLayout(const std::vector<std::string>& sources, uint32_t set = 0,
+		uint32_t runtimeArrayCount = 0, std::vector<VkDescriptorBindingFlags>* flags = nullptr);
+	//One range over every stage that declares the block, size 0 when none does
+	VkPushConstantRange ReflectPushConstants(const std::vector<std::string>& sources);
+
+	//Main thread, once a frame. Checks source timestamps twice a second and starts compiles of edited files
+	void Poll();
+	//Sources whose new SPIR-V is in place since the last call. A source whose bindings or push constants changed
+	//is not reported, the layouts built from it can't change while the app runs
+	std::vector<std::string> TakeRecompiled();
+
+	uint32_t GetSourceCount() const;
+	uint32_t GetReloadCount() const;
+	std::string GetLastError() const;
+	//Compiles and failures, oldest first
+	std::vector<std::string> GetLog() const;
+
+private:
+	struct Source
+	{
+		std::filesystem::file_time_type stamp;//Of the version last compiled or loaded
+		bool compiling = false;
+		bool reflected = false;
+		Reflection reflection;
+	};
+
+	void Compile(const std::string& source);
+	//Compiles source in process into output, true once output holds the new binary. Otherwise error says why
+	bool RunCompiler(const std::string& source, const std::string& output, std::string& error) const;
+	static std::string SpirvName(const std::string& source);
+	void AddLog(const std::string& line);
+
+	std::string mDirectory;
+	JobSystem* mJobSystem = nullptr;
+
+	mutable std::mutex mMutex;
+	std::unordered_map<std::string, Source> mSources;
+	std::vector<std::string> mRecompiled;
+	std::string mLastError;
+	std::vector<std::string> mLog;
+	uint32_t mReloadCount = 0;
+
+	JobCounter mCompiles;
+	std::chrono::steady_clock::time_point mLastPoll;
+};
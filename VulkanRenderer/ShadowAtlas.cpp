@@ -0,0 +1,79 @@
+#include "ShadowAtlas.h"
+
+void ShadowAtlas::Init(uint32_t slotCount)
+{
+	mSlots.assign(slotCount, Slot{});
+}
+
+int ShadowAtlas::Acquire(uint32_t lightID, uint64_t frame)
+{
+	int freeSlot = -1;
+	int oldestSlot = -1;
+	for (int i = 0; i < static_cast<int>(mSlots.size()); ++i)
+	{
+		Slot& slot = mSlots[i];
+		if (slot.lightID == lightID)
+		{
+			slot.lastUsedFrame = frame;
+			return i;
+		}
+
+		if (slot.lightID < 0)
+		{
+			if (freeSlot < 0)
+			{
+				freeSlot = i;
+			}
+		}
+		else if (slot.lastUsedFrame != frame && (oldestSlot < 0 || slot.lastUsedFrame < mSlots[oldestSlot].lastUsedFrame))
+		{
+			oldestSlot = i;
+		}
+	}
+
+	int assigned = freeSlot >= 0 ? freeSlot : oldestSlot;
+	if (assigned < 0)
+	{
+		return -1;
+	}
+
+	//Whatever the slot held belongs to another light now
+	Slot& slot = mSlots[assigned];
+	slot.lightID = lightID;
+	slot.lastUsedFrame = frame;
+	slot.dirty = true;
+	return assigned;
+}
+
+void ShadowAtlas::Release(uint32_t lightID)
+{
+	for (Slot& slot : mSlots)
+	{
+		if (slot.lightID == lightID)
+		{
+			slot.lightID = -1;
+			slot.dirty = true;
+		}
+	}
+}
+
+bool ShadowAtlas::IsDirty(int slot) const
+{
+	return mSlots[slot].dirty;
+}
+
+void ShadowAtlas::MarkDirty(int slot)
+{
+	mSlots[slot].dirty = true;
+}
+
+void ShadowAtlas::Store(int slot, const glm::vec4& lightPosRadius)
+{
+	mSlots[slot].cachedLight = lightPosRadius;
+	mSlots[slot].dirty = false;
+}
+
+const glm::vec4& ShadowAtlas::GetCachedLight(int slot) const
+{
+	return mSlots[slot].cachedLight;
+}
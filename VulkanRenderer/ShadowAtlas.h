@@ -0,0 +1,35 @@
+#pragma once
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+//Hands out cube slots of the point shadow map array to lights.
+//A slot remembers what it was last rendered with so unchanged lights can keep their shadow.
+class ShadowAtlas
+{
+public:
+	void Init(uint32_t slotCount);
+
+	//Returns the slot of the light, assigning a free or least recently used one if it has none. -1 when every slot is taken this frame
+	int Acquire(uint32_t lightID, uint64_t frame);
+	void Release(uint32_t lightID);
+
+	bool IsDirty(int slot) const;
+	void MarkDirty(int slot);
+	//Slot now holds a shadow rendered from this light position & radius
+	void Store(int slot, const glm::vec4& lightPosRadius);
+	const glm::vec4& GetCachedLight(int slot) const;
+
+	uint32_t GetSlotCount() const { return static_cast<uint32_t>(mSlots.size()); }
+
+private:
+	struct Slot
+	{
+		int64_t lightID = -1;
+		uint64_t lastUsedFrame = 0;
+		bool dirty = true;
+		glm::vec4 cachedLight = glm::vec4(0.f);
+	};
+	std::vector<Slot> mSlots;
+};
@@ -140,16 +140,16 @@ void SwapChain::CreateSwapChainFrameBuffer()
 void SwapChain::CreateSwapChainRenderPass()
 {
 	//Swap chain framebuffer use only one color attachment.
-	//Color attachment layout: Render(write) -> Read(Present)
+	//The render graph moves it into the attachment layout before the tonemap and to present after it
 	
 	VkAttachmentDescription colorAttachmentDesc = {};
 	colorAttachmentDesc.samples = VK_SAMPLE_COUNT_1_BIT;//Do not deal with multi-sample yet.
-	colorAttachmentDesc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachmentDesc.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;//The tonemap writes every pixel
 	colorAttachmentDesc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;//Store attachment data after rendering for present.
 	colorAttachmentDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachmentDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	colorAttachmentDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachmentDesc.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;//TODO: What if layout changed between the middle of operation?
+	colorAttachmentDesc.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachmentDesc.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 	colorAttachmentDesc.format = mSwapChainFormat.format;
 
 	VkAttachmentReference colorAttachRef = {};
@@ -167,31 +167,12 @@ void SwapChain::CreateSwapChainRenderPass()
 	subpassDesc.pPreserveAttachments = nullptr;
 	subpassDesc.pResolveAttachments = nullptr;
 
-	std::array<VkSubpassDependency, 2> dependencies;
-	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependencies[0].dstSubpass = 0;
-	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-	dependencies[1].srcSubpass = 0;
-	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
 	VkRenderPassCreateInfo swapChainRenderPassCI = {};
 	swapChainRenderPassCI.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	swapChainRenderPassCI.attachmentCount = 1;
 	swapChainRenderPassCI.pAttachments = &colorAttachmentDesc;
 	swapChainRenderPassCI.subpassCount = 1;
 	swapChainRenderPassCI.pSubpasses = &subpassDesc;
-	swapChainRenderPassCI.dependencyCount = static_cast<uint32_t>(dependencies.size());
-	swapChainRenderPassCI.pDependencies = dependencies.data();
 
 	VK_CHECK_RESULT(vkCreateRenderPass(mApp->mVulkanDevice->logicalDevice, &swapChainRenderPassCI, nullptr, &mSwapChainRenderPass));
 
@@ -0,0 +1,207 @@
+#include "T_Pass.h"
+#include "VkApp.h"
+#include "VulkanInitializers.hpp"
+#include "VulkanTools.h"
+
+void T_Pass::Init(VkApp* app, uint32_t width, uint32_t height, VkRenderPass swapchainRenderPass)
+{
+	mApp = app;
+	mWidth = width;
+	mHeight = height;
+	mRenderPass = swapchainRenderPass;
+	mHistogramGroupsX = ((width + 1) / 2 + 15) / 16;
+	mHistogramGroupsY = ((height + 1) / 2 + 15) / 16;
+}
+
+void T_Pass::Destroy()
+{
+	vkDestroyBuffer(mApp->mVulkanDevice->logicalDevice, mExposureBuffer, nullptr);
+	vkFreeMemory(mApp->mVulkanDevice->logicalDevice, mExposureMemory, nullptr);
+}
+
+void T_Pass::CreateFrameData()
+{
+	CreateExposureBuffer();
+}
+
+void T_Pass::CreatePipelineData(JobCounter* ready)
+{
+	CreatePipelineLayout();
+	CreateExposurePipelineLayout();
+	mApp->mPipelineBuilder.Build("Tonemap", [this]() { return CreatePipeline(); }, &mPipeline, ready);
+	mApp->mPipelineBuilder.Build("Histogram", [this]() { return CreateComputePipeline("Histogram.comp"); }, &mHistogramPipeline, ready);
+	mApp->mPipelineBuilder.Build("Exposure", [this]() { return CreateComputePipeline("Exposure.comp"); }, &mExposurePipeline, ready);
+}
+
+void T_Pass::CreateExposureBuffer()
+{
+	VkDevice device = mApp->mVulkanDevice->logicalDevice;
+
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = sizeof(ExposureData);
+	bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	VK_CHECK_RESULT(vkCreateBuffer(device, &bufferInfo, nullptr, &mExposureBuffer))
+
+	//Device local, the histogram is built with atomics
+	VkMemoryRequirements memReqs;
+	vkGetBufferMemoryRequirements(device, mExposureBuffer, &memReqs);
+	VkMemoryAllocateInfo memAlloc = initializers::memoryAllocateInfo();
+	memAlloc.allocationSize = memReqs.size;
+	memAlloc.memoryTypeIndex = mApp->mVulkanDevice->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	VK_CHECK_RESULT(vkAllocateMemory(device, &memAlloc, nullptr, &mExposureMemory))
+	VK_CHECK_RESULT(vkBindBufferMemory(device, mExposureBuffer, mExposureMemory, 0))
+
+	//Empty histogram, and an adapted luminance that starts out at exposure 1
+	ExposureData initial{};
+	initial.exposure = 1.f;
+	initial.averageLuminance = 0.18f;
+	VkCommandBuffer cmd = mApp->CreateTempCmdBuf();
+	vkCmdUpdateBuffer(cmd, mExposureBuffer, 0, sizeof(ExposureData), &initial);
+	mApp->SubmitTempCmdBufToGraphicsQueue(cmd);
+}
+
+void T_Pass::CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes)
+{
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+
+	poolInfo.maxSets = 2;
+
+	if (vkCreateDescriptorPool(mApp->mVulkanDevice->logicalDevice, &poolInfo, nullptr, &mDescriptorPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create descriptor pool!");
+	}
+}
+
+void T_Pass::CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings)
+{
+	VkDescriptorSetLayoutCreateInfo tonemapDescriptorLayout = initializers::descriptorSetLayoutCreateInfo(setLayoutBindings);
+	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(mApp->mVulkanDevice->logicalDevice, &tonemapDescriptorLayout, nullptr, &mDescriptorLayout))
+}
+
+void T_Pass::CreateExposureDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings)
+{
+	VkDescriptorSetLayoutCreateInfo exposureDescriptorLayout = initializers::descriptorSetLayoutCreateInfo(setLayoutBindings);
+	VK_CHECK_RESULT(vkCreateDescriptorSetLayout(mApp->mVulkanDevice->logicalDevice, &exposureDescriptorLayout, nullptr, &mExposureDescriptorLayout))
+}
+
+void T_Pass::CreateDescriptorSet()
+{
+	VkDescriptorSetAllocateInfo setAllocInfo{};
+	setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocInfo.descriptorPool = mDescriptorPool;
+	setAllocInfo.descriptorSetCount = 1;
+	setAllocInfo.pSetLayouts = &mDescriptorLayout;
+
+	if (vkAllocateDescriptorSets(mApp->mVulkanDevice->logicalDevice, &setAllocInfo, &mDescriptorSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate descriptor sets");
+	}
+}
+
+void T_Pass::CreateExposureDescriptorSet()
+{
+	VkDescriptorSetAllocateInfo setAllocInfo{};
+	setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAllocInfo.descriptorPool = mDescriptorPool;
+	setAllocInfo.descriptorSetCount = 1;
+	setAllocInfo.pSetLayouts = &mExposureDescriptorLayout;
+
+	if (vkAllocateDescriptorSets(mApp->mVulkanDevice->logicalDevice, &setAllocInfo, &mExposureDescriptorSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate descriptor sets");
+	}
+}
+
+void T_Pass::UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets)
+{
+	vkUpdateDescriptorSets(mApp->mVulkanDevice->logicalDevice, static_cast<uint32_t>(writeDescSets.size()), writeDescSets.data(), 0, nullptr);
+}
+
+void T_Pass::UpdateExposureDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets)
+{
+	vkUpdateDescriptorSets(mApp->mVulkanDevice->logicalDevice, static_cast<uint32_t>(writeDescSets.size()), writeDescSets.data(), 0, nullptr);
+}
+
+void T_Pass::CreatePipelineLayout()
+{
+	mPushConstants = mApp->mShaders.ReflectPushConstants({ "Lighting.vert", "Tonemap.frag" });
+	if (mPushConstants.size != sizeof(TonemapPushConstant))
+	{
+		throw std::runtime_error("failed to match TonemapPushConstant with the tonemap shader!");
+	}
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCI = initializers::pipelineLayoutCreateInfo(&mDescriptorLayout, 1);
+	pipelineLayoutCI.pushConstantRangeCount = 1;
+	pipelineLayoutCI.pPushConstantRanges = &mPushConstants;
+	VK_CHECK_RESULT(vkCreatePipelineLayout(mApp->mVulkanDevice->logicalDevice, &pipelineLayoutCI, nullptr, &mPipelineLayout))
+}
+
+void T_Pass::CreateExposurePipelineLayout()
+{
+	mExposurePushConstants = mApp->mShaders.ReflectPushConstants({ "Histogram.comp", "Exposure.comp" });
+	if (mExposurePushConstants.size != sizeof(ExposurePushConstant))
+	{
+		throw std::runtime_error("failed to match ExposurePushConstant with the exposure shaders!");
+	}
+
+	VkPipelineLayoutCreateInfo pipelinelayoutCI = initializers::pipelineLayoutCreateInfo(&mExposureDescriptorLayout, 1);
+	pipelinelayoutCI.pushConstantRangeCount = 1;
+	pipelinelayoutCI.pPushConstantRanges = &mExposurePushConstants;
+
+	VK_CHECK_RESULT(vkCreatePipelineLayout(mApp->mVulkanDevice->logicalDevice, &pipelinelayoutCI, nullptr, &mExposurePipelineLayout))
+}
+
+VkPipeline T_Pass::CreatePipeline()
+{
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState =
+		initializers::pipelineInputAssemblyStateCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, 0, VK_FALSE);
+	VkPipelineRasterizationStateCreateInfo rasterizationState =
+		initializers::pipelineRasterizationStateCreateInfo(VK_POLYGON_MODE_FILL, VK_CULL_MODE_FRONT_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE, 0);
+	VkPipelineColorBlendAttachmentState blendAttachmentState =
+		initializers::pipelineColorBlendAttachmentState(0xf, VK_FALSE);
+	VkPipelineColorBlendStateCreateInfo colorBlendState =
+		initializers::pipelineColorBlendStateCreateInfo(1, &blendAttachmentState);
+	VkPipelineDepthStencilStateCreateInfo depthStencilState =
+		initializers::pipelineDepthStencilStateCreateInfo(VK_FALSE, VK_FALSE, VK_COMPARE_OP_ALWAYS);
+	VkPipelineViewportStateCreateInfo viewportState =
+		initializers::pipelineViewportStateCreateInfo(1, 1, 0);
+	VkPipelineMultisampleStateCreateInfo multisampleState =
+		initializers::pipelineMultisampleStateCreateInfo(VK_SAMPLE_COUNT_1_BIT, 0);
+	std::vector<VkDynamicState> dynamicStateEnables = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamicState =
+		initializers::pipelineDynamicStateCreateInfo(dynamicStateEnables);
+
+	//Fullscreen triangle of the lighting pass
+	std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages;
+	shaderStages[0] = mApp->mPipelineBuilder.ShaderStage("Lighting.vert");
+	shaderStages[1] = mApp->mPipelineBuilder.ShaderStage("Tonemap.frag");
+
+	VkGraphicsPipelineCreateInfo pipelineCI = initializers::pipelineCreateInfo(mPipelineLayout, mRenderPass);
+	pipelineCI.pInputAssemblyState = &inputAssemblyState;
+	pipelineCI.pRasterizationState = &rasterizationState;
+	pipelineCI.pColorBlendState = &colorBlendState;
+	pipelineCI.pMultisampleState = &multisampleState;
+	pipelineCI.pViewportState = &viewportState;
+	pipelineCI.pDepthStencilState = &depthStencilState;
+	pipelineCI.pDynamicState = &dynamicState;
+	pipelineCI.stageCount = static_cast<uint32_t>(shaderStages.size());
+	pipelineCI.pStages = shaderStages.data();
+
+	VkPipelineVertexInputStateCreateInfo emptyInput = initializers::pipelineVertexInputStateCreateInfo();
+	pipelineCI.pVertexInputState = &emptyInput;
+	return mApp->mPipelineBuilder.CreateGraphicsPipeline(pipelineCI);
+}
+
+VkPipeline T_Pass::CreateComputePipeline(const char* source)
+{
+	VkComputePipelineCreateInfo pipelineCI{};
+	pipelineCI.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineCI.layout = mExposurePipelineLayout;
+	pipelineCI.stage = mApp->mPipelineBuilder.ShaderStage(source);
+	return mApp->mPipelineBuilder.CreateComputePipeline(pipelineCI);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "UniformStructure.h"
+#include <vector>
+
+class VkApp;
+class JobCounter;
+//Takes the HDR composition to the swapchain. A compute histogram of the composition's luminance drives an
+//exposure that adapts over frames, the tonemap applies it while writing the swapchain image.
+//At dynamic resolution the tonemap also upscales, with optional sharpening
+class T_Pass
+{
+private:
+	VkApp* mApp = nullptr;
+public:
+	void Init(VkApp* app, uint32_t width, uint32_t height, VkRenderPass swapchainRenderPass);
+	void Destroy();
+
+	void CreateDescriptorPool(const std::vector<VkDescriptorPoolSize>& poolSizes);
+	void CreateDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings);
+	void CreateExposureDescriptorLayout(const std::vector<VkDescriptorSetLayoutBinding>& setLayoutBindings);
+	void CreateDescriptorSet();
+	void CreateExposureDescriptorSet();
+
+	void CreateFrameData();
+	//Layouts are created right away, pipelines are built as jobs that count on ready
+	void CreatePipelineData(JobCounter* ready);
+
+	void UpdateDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets);
+	void UpdateExposureDescriptorSet(const std::vector<VkWriteDescriptorSet>& writeDescSets);
+
+private:
+	void CreateExposureBuffer();
+
+	void CreatePipelineLayout();
+	VkPipeline CreatePipeline();
+
+	void CreateExposurePipelineLayout();
+	VkPipeline CreateComputePipeline(const char* source);
+
+public:
+	uint32_t mWidth, mHeight;
+	//Histogram dispatch size, one invocation per 2x2 pixels
+	uint32_t mHistogramGroupsX, mHistogramGroupsY;
+
+	//ExposureData, kept between frames for the adaptation
+	VkBuffer mExposureBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory mExposureMemory = VK_NULL_HANDLE;
+
+	VkDescriptorPool mDescriptorPool;
+
+	//Tonemap into the swapchain
+	VkRenderPass mRenderPass;//The swapchain's, owned by it
+	VkDescriptorSetLayout mDescriptorLayout;
+	VkDescriptorSet mDescriptorSet;
+
+	VkPipelineLayout mPipelineLayout;
+	VkPipeline mPipeline;
+	VkPushConstantRange mPushConstants{};//Reflected, pushes have to use its stage flags
+
+	//Histogram and exposure dispatches share one layout
+	VkDescriptorSetLayout mExposureDescriptorLayout;
+	VkDescriptorSet mExposureDescriptorSet;
+
+	VkPipelineLayout mExposurePipelineLayout;
+	VkPipeline mHistogramPipeline;
+	VkPipeline mExposurePipeline;
+	VkPushConstantRange mExposurePushConstants{};//Reflected, pushes have to use its stage flags
+};
@@ -0,0 +1,774 @@
+#include "TextureStreamer.h"
+#include "VkApp.h"
+#include "VulkanTools.h"
+#include "VulkanInitializers.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb_image_resize.h>
+#include <ktx.h>
+#include "../lib/vk_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+//Streamed images are released this many frames after they were replaced, by then no frame in flight samples them
+#define STREAM_RETIRE_FRAMES 3
+
+//Faces of a level arrive in order, so each level ends up packed face after face
+static KTX_error_code KTXAPIENTRY CopyKtxFace(int miplevel, int face, int width, int height, int depth,
+	ktx_uint32_t faceLodSize, void* pixels, void* userdata)
+{
+	std::vector<uint8_t>& level = (*static_cast<std::vector<std::vector<uint8_t>>*>(userdata))[miplevel];
+	const uint8_t* bytes = static_cast<const uint8_t*>(pixels);
+	level.insert(level.end(), bytes, bytes + faceLodSize);
+	return KTX_SUCCESS;
+}
+
+void TextureStreamer::Init(VkApp* app, JobSystem* jobSystem, VkQueue transferQueue, const Settings& settings)
+{
+	mApp = app;
+	mJobSystem = jobSystem;
+	mDevice = app->mVulkanDevice->logicalDevice;
+	mTransferQueue = transferQueue;
+	mSettings = settings;
+
+	//Images are written on the transfer queue and sampled on the graphics queue.
+	//Concurrent sharing avoids ownership transfers when those are different families
+	const uint32_t graphicsFamily = app->mVulkanDevice->queueFamilyIndices.graphics;
+	const uint32_t transferFamily = app->mVulkanDevice->queueFamilyIndices.transfer;
+	mQueueFamilies = { graphicsFamily };
+	if (transferFamily != graphicsFamily)
+	{
+		mQueueFamilies.push_back(transferFamily);
+	}
+	mCommandPool = app->mVulkanDevice->createCommandPool(transferFamily);
+	mTransferTimeline.Init(mDevice);
+
+	mApp->mVulkanDevice->createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		mSettings.stagingBytes, &mStagingBuffer, &mStagingMemory);
+	VK_CHECK_RESULT(vkMapMemory(mDevice, mStagingMemory, 0, mSettings.stagingBytes, 0, reinterpret_cast<void**>(&mStagingMapped)))
+
+	VkSamplerCreateInfo samplerInfo = initializers::samplerCreateInfo();
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+	samplerInfo.minLod = 0.f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;//Level 0 of a view is always the finest resident level
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	samplerInfo.maxAnisotropy = 1.f;
+	if (mApp->mVulkanDevice->features.samplerAnisotropy)
+	{
+		samplerInfo.anisotropyEnable = VK_TRUE;
+		samplerInfo.maxAnisotropy = mApp->mVulkanDevice->properties.limits.maxSamplerAnisotropy;
+	}
+	VK_CHECK_RESULT(vkCreateSampler(mDevice, &samplerInfo, nullptr, &mSampler))
+
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	VK_CHECK_RESULT(vkCreateSampler(mDevice, &samplerInfo, nullptr, &mCubeSampler))
+
+	CreatePlaceholder(mPlaceholder, false);
+	CreatePlaceholder(mCubePlaceholder, true);
+	mCancelDecodes = false;
+}
+
+void TextureStreamer::Destroy()
+{
+	//Queued decodes skip their work, the ones already running finish
+	mCancelDecodes = true;
+	mJobSystem->Wait(mDecodeJobs);
+
+	vkQueueWaitIdle(mTransferQueue);
+	RetireBatches(mFrame);
+	for (Garbage& garbage : mGarbage)
+	{
+		DestroyImage(garbage.image);
+	}
+	mGarbage.clear();
+	for (std::unique_ptr<Texture>& texture : mTextures)
+	{
+		DestroyImage(texture->gpu);
+	}
+	mTextures.clear();
+	mTransferTimeline.Destroy();
+
+	DestroyImage(mPlaceholder);
+	DestroyImage(mCubePlaceholder);
+	vkDestroySampler(mDevice, mSampler, nullptr);
+	vkDestroySampler(mDevice, mCubeSampler, nullptr);
+	vkUnmapMemory(mDevice, mStagingMemory);
+	vkDestroyBuffer(mDevice, mStagingBuffer, nullptr);
+	vkFreeMemory(mDevice, mStagingMemory, nullptr);
+	vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
+}
+
+uint32_t TextureStreamer::Request(const std::string& file, bool cubemap)
+{
+	std::unique_ptr<Texture> texture = std::make_unique<Texture>();
+	texture->file = file;
+	texture->handle = static_cast<uint32_t>(mTextures.size());
+	texture->cubemap = cubemap;
+	Texture* queued = texture.get();
+	mTextures.push_back(std::move(texture));
+	mChanged.push_back(queued->handle);
+
+	mJobSystem->RunBackground([this, queued]()
+	{
+		if (mCancelDecodes == true)
+		{
+			queued->state.store(DECODE_FAILED);
+			return;
+		}
+		stbi_set_flip_vertically_on_load_thread(true);
+		queued->state.store(Decode(*queued) ? DECODE_DONE : DECODE_FAILED);
+	}, &mDecodeJobs);
+	return queued->handle;
+}
+
+void TextureStreamer::RequestMip(uint32_t handle, float mip, uint64_t frame)
+{
+	Texture& texture = *mTextures[handle];
+	if (texture.hasDemand == false || texture.demandFrame != frame)
+	{
+		texture.demandMip = mip;
+	}
+	else
+	{
+		texture.demandMip = std::min(texture.demandMip, mip);
+	}
+	texture.demandFrame = frame;
+	texture.hasDemand = true;
+}
+
+void TextureStreamer::RequestPixels(uint32_t handle, float screenPixels, uint64_t frame)
+{
+	const Texture& texture = *mTextures[handle];
+	if (texture.state.load() != DECODE_DONE)
+	{
+		return;
+	}
+	const float texels = static_cast<float>(std::max(texture.width, texture.height));
+	RequestMip(handle, std::log2(texels / std::max(screenPixels, 1.f)), frame);
+}
+
+VkDescriptorImageInfo TextureStreamer::Descriptor(uint32_t handle) const
+{
+	const Texture& texture = *mTextures[handle];
+	if (texture.gpu.imageView == VK_NULL_HANDLE)
+	{
+		return texture.cubemap ? mCubePlaceholder.Descriptor() : mPlaceholder.Descriptor();
+	}
+	return texture.gpu.Descriptor();
+}
+
+std::vector<uint32_t> TextureStreamer::TakeChangedTextures()
+{
+	std::vector<uint32_t> changed;
+	changed.swap(mChanged);
+	return changed;
+}
+
+TextureStreamer::TextureInfo TextureStreamer::GetTextureInfo(uint32_t handle) const
+{
+	const Texture& texture = *mTextures[handle];
+	TextureInfo info;
+	info.file = texture.file;
+	info.failed = texture.state.load() == DECODE_FAILED;
+	if (texture.state.load() == DECODE_DONE)
+	{
+		info.mipLevels = texture.mipLevels;
+		info.residentMip = std::min(texture.residentMip, texture.mipLevels);
+		info.wantedMip = WantedMip(texture, mFrame);
+	}
+	return info;
+}
+
+/*************************************************************************************************************/
+
+bool TextureStreamer::Decode(Texture& texture)
+{
+	namespace fs = std::filesystem;
+	const fs::path path(texture.file);
+	if (path.extension() == ".ktx")
+	{
+		return DecodeKtx(texture.file, texture);
+	}
+
+	//TextureBaker output is preferred as long as it is not older than its source
+	std::error_code ec;
+	const fs::path bakedPath = fs::path(path).replace_extension(".ktx");
+	if (fs::exists(bakedPath, ec) && fs::last_write_time(bakedPath, ec) >= fs::last_write_time(path, ec))
+	{
+		if (DecodeKtx(bakedPath.string(), texture) == true)
+		{
+			return true;
+		}
+	}
+	return DecodeImage(texture);
+}
+
+bool TextureStreamer::DecodeKtx(const std::string& file, Texture& texture)
+{
+	ktxTexture* ktxTexture;
+	if (ktxTexture_CreateFromNamedFile(file.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &ktxTexture) != KTX_SUCCESS)
+	{
+		return false;
+	}
+
+	const VkFormat format = vkGetFormatFromOpenGLInternalFormat(ktxTexture->glInternalformat);
+	const uint32_t expectedFaces = texture.cubemap ? 6 : 1;
+	if (ktxTexture->numFaces != expectedFaces || ktxTexture->numLayers != 1 || mApp->IsSampledFormatSupported(format) == false)
+	{
+		ktxTexture_Destroy(ktxTexture);
+		return false;
+	}
+
+	texture.format = format;
+	texture.width = ktxTexture->baseWidth;
+	texture.height = ktxTexture->baseHeight;
+	texture.mipLevels = ktxTexture->numLevels;
+	texture.faceCount = ktxTexture->numFaces;
+	texture.levels.assign(texture.mipLevels, {});
+
+	const KTX_error_code result = ktxTexture_IterateLevelFaces(ktxTexture, CopyKtxFace, &texture.levels);
+	ktxTexture_Destroy(ktxTexture);
+	return result == KTX_SUCCESS;
+}
+
+bool TextureStreamer::DecodeImage(Texture& texture)
+{
+	if (texture.cubemap == true)
+	{
+		return false;
+	}
+
+	int width, height, channels;
+	stbi_uc* pixels = stbi_load(texture.file.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+	if (pixels == nullptr)
+	{
+		return false;
+	}
+
+	texture.format = VK_FORMAT_R8G8B8A8_SRGB;
+	texture.width = static_cast<uint32_t>(width);
+	texture.height = static_cast<uint32_t>(height);
+	texture.mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+	texture.faceCount = 1;
+	texture.levels.resize(texture.mipLevels);
+	texture.levels[0].assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+	stbi_image_free(pixels);
+
+	//Mips are filtered on the worker so any level can be uploaded on its own later
+	uint32_t levelWidth = texture.width;
+	uint32_t levelHeight = texture.height;
+	for (uint32_t i = 1; i < texture.mipLevels; ++i)
+	{
+		const uint32_t nextWidth = std::max(1u, levelWidth / 2);
+		const uint32_t nextHeight = std::max(1u, levelHeight / 2);
+		texture.levels[i].resize(static_cast<size_t>(nextWidth) * nextHeight * 4);
+		stbir_resize_uint8_srgb(texture.levels[i - 1].data(), levelWidth, levelHeight, 0,
+			texture.levels[i].data(), nextWidth, nextHeight, 0, 4, 3, 0);
+		levelWidth = nextWidth;
+		levelHeight = nextHeight;
+	}
+	return true;
+}
+
+/*************************************************************************************************************/
+
+void TextureStreamer::Update(uint64_t frame)
+{
+	mFrame = frame;
+	RetireBatches(frame);
+	CollectGarbage(frame);
+
+	mStats = Stats{};
+	mStats.textureCount = static_cast<uint32_t>(mTextures.size());
+	mStats.decodesPending = mDecodeJobs.Pending();
+
+	//Candidates: first residency (coarse tail) before anything else, then refinement by largest deficit
+	std::vector<Texture*> firstUploads;
+	std::vector<Texture*> refinements;
+	std::vector<Texture*> overResident;
+	for (std::unique_ptr<Texture>& ptr : mTextures)
+	{
+		Texture& texture = *ptr;
+		if (texture.state.load() != DECODE_DONE)
+		{
+			continue;
+		}
+		if (texture.residentMip == UINT32_MAX && texture.mipLevels > 0)
+		{
+			texture.tailMip = 0;
+			while (texture.tailMip + 1 < texture.mipLevels &&
+				std::max(texture.width >> texture.tailMip, texture.height >> texture.tailMip) > mSettings.tailSize)
+			{
+				++texture.tailMip;
+			}
+			//Each refinement stages a single level, one larger than the whole ring could never be uploaded
+			texture.finestMip = 0;
+			while (texture.finestMip < texture.tailMip && ((texture.levels[texture.finestMip].size() + 15) & ~size_t(15)) > mSettings.stagingBytes)
+			{
+				++texture.finestMip;
+			}
+		}
+		if (texture.gpu.image != VK_NULL_HANDLE)
+		{
+			++mStats.residentCount;
+			mStats.residentBytes += texture.residentBytes;
+		}
+		if (texture.uploading == true)
+		{
+			continue;
+		}
+
+		const uint32_t wanted = WantedMip(texture, frame);
+		if (texture.residentMip == UINT32_MAX)
+		{
+			firstUploads.push_back(&texture);
+		}
+		else if (wanted < texture.residentMip)
+		{
+			refinements.push_back(&texture);
+		}
+		else if (wanted > texture.residentMip)
+		{
+			overResident.push_back(&texture);
+		}
+	}
+	std::sort(refinements.begin(), refinements.end(), [this, frame](const Texture* a, const Texture* b)
+		{
+			return a->residentMip - WantedMip(*a, frame) > b->residentMip - WantedMip(*b, frame);
+		});
+	//Least recently wanted levels go first
+	std::sort(overResident.begin(), overResident.end(), [](const Texture* a, const Texture* b)
+		{
+			return a->demandFrame < b->demandFrame;
+		});
+
+	Batch batch;
+	const VkDeviceSize stagingBefore = mStagingInUse;
+	VkDeviceSize uploaded = 0;
+	auto fitsFrame = [&](VkDeviceSize bytes) { return uploaded == 0 || uploaded + bytes <= mSettings.uploadBytesPerFrame; };
+	auto projected = [&]() { return static_cast<int64_t>(mStats.residentBytes) + mPendingBytes; };
+
+	//Demotes over-resident textures until the projected residency has room for extra bytes
+	size_t nextEviction = 0;
+	auto evict = [&](int64_t needed, bool unusedOnly) -> bool
+	{
+		while (projected() + needed > static_cast<int64_t>(mSettings.budgetBytes) || unusedOnly == true)
+		{
+			if (nextEviction >= overResident.size())
+			{
+				return projected() + needed <= static_cast<int64_t>(mSettings.budgetBytes);
+			}
+			Texture& victim = *overResident[nextEviction];
+			const bool unused = victim.hasDemand == false || victim.demandFrame + mSettings.evictAfterFrames < frame;
+			if (unusedOnly == true && unused == false)
+			{
+				++nextEviction;
+				continue;
+			}
+			//Every level it keeps is resident already, so nothing is staged
+			if (RecordUpload(batch, victim, WantedMip(victim, frame)) == false)
+			{
+				return false;
+			}
+			++nextEviction;
+		}
+		return true;
+	};
+
+	for (Texture* texture : firstUploads)
+	{
+		const VkDeviceSize bytes = ChainBytes(*texture, texture->tailMip);
+		if (fitsFrame(bytes) == false || evict(static_cast<int64_t>(bytes), false) == false)
+		{
+			break;
+		}
+		if (RecordUpload(batch, *texture, texture->tailMip) == true)
+		{
+			uploaded += bytes;
+		}
+	}
+	//One level per step, the resident ones are copied over on the device so only the new level is staged
+	for (Texture* texture : refinements)
+	{
+		const uint32_t target = texture->residentMip - 1;
+		const VkDeviceSize staged = StagedBytes(*texture, target);
+		const int64_t growth = static_cast<int64_t>(ChainBytes(*texture, target)) - static_cast<int64_t>(texture->residentBytes);
+		if (fitsFrame(staged) == false || evict(growth, false) == false)
+		{
+			break;
+		}
+		if (RecordUpload(batch, *texture, target) == true)
+		{
+			uploaded += staged;
+		}
+	}
+	//Without pressure only levels nobody looked at for a while are dropped
+	evict(0, true);
+
+	mStats.uploadedBytes = uploaded;
+	if (batch.cmd != VK_NULL_HANDLE)
+	{
+		VK_CHECK_RESULT(vkEndCommandBuffer(batch.cmd))
+		batch.stagingEnd = mStagingHead;
+		batch.stagingBytes = mStagingInUse - stagingBefore;
+
+		batch.timelineValue = mTransferTimeline.Advance();
+		VkTimelineSemaphoreSubmitInfo timelineInfo = TimelineSemaphore::SubmitInfo(0, nullptr, 1, &batch.timelineValue);
+		VkSemaphore timeline = mTransferTimeline.GetSemaphore();
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &batch.cmd;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &timeline;
+		VK_CHECK_RESULT(vkQueueSubmit(mTransferQueue, 1, &submitInfo, VK_NULL_HANDLE))
+		mBatches.push_back(std::move(batch));
+	}
+	mStats.batchesInFlight = static_cast<uint32_t>(mBatches.size());
+}
+
+void TextureStreamer::RetireBatches(uint64_t frame)
+{
+	//One counter read covers every batch instead of a fence query each
+	const uint64_t completed = mTransferTimeline.GetCompleted();
+	while (mBatches.empty() == false && mBatches.front().timelineValue <= completed)
+	{
+		Batch& batch = mBatches.front();
+		for (Upload& upload : batch.uploads)
+		{
+			Texture& texture = *upload.texture;
+			if (texture.gpu.image != VK_NULL_HANDLE)
+			{
+				mGarbage.push_back({ texture.gpu, frame });
+			}
+			mPendingBytes -= static_cast<int64_t>(upload.bytes) - static_cast<int64_t>(texture.residentBytes);
+			texture.gpu = upload.image;
+			texture.residentMip = upload.baseMip;
+			texture.residentBytes = upload.bytes;
+			texture.uploading = false;
+			mChanged.push_back(texture.handle);
+		}
+
+		mStagingTail = batch.stagingEnd;
+		mStagingInUse -= batch.stagingBytes;
+		vkFreeCommandBuffers(mDevice, mCommandPool, 1, &batch.cmd);
+		mBatches.pop_front();
+	}
+}
+
+void TextureStreamer::CollectGarbage(uint64_t frame)
+{
+	//Replaced images were still sampled by frames up to the one they were retired in
+	auto retired = [this, frame](Garbage& garbage)
+	{
+		if (garbage.frame + STREAM_RETIRE_FRAMES > frame)
+		{
+			return false;
+		}
+		DestroyImage(garbage.image);
+		return true;
+	};
+	mGarbage.erase(std::remove_if(mGarbage.begin(), mGarbage.end(), retired), mGarbage.end());
+}
+
+uint32_t TextureStreamer::WantedMip(const Texture& texture, uint64_t frame) const
+{
+	if (texture.hasDemand == false || texture.demandFrame + mSettings.evictAfterFrames < frame)
+	{
+		return texture.tailMip;
+	}
+	const float mip = std::floor(std::max(texture.demandMip, 0.f));
+	return std::min(std::max(static_cast<uint32_t>(mip), texture.finestMip), texture.tailMip);
+}
+
+VkDeviceSize TextureStreamer::ChainBytes(const Texture& texture, uint32_t baseMip) const
+{
+	VkDeviceSize bytes = 0;
+	for (uint32_t i = baseMip; i < texture.mipLevels; ++i)
+	{
+		bytes += texture.levels[i].size();
+	}
+	return bytes;
+}
+
+VkDeviceSize TextureStreamer::StagedBytes(const Texture& texture, uint32_t baseMip) const
+{
+	if (texture.gpu.image == VK_NULL_HANDLE)
+	{
+		return ChainBytes(texture, baseMip);
+	}
+	return ChainBytes(texture, baseMip) - ChainBytes(texture, std::max(baseMip, texture.residentMip));
+}
+
+bool TextureStreamer::AllocateStaging(VkDeviceSize size, VkDeviceSize& offset)
+{
+	//Offsets must respect the texel block size of compressed formats
+	const VkDeviceSize aligned = (size + 15) & ~VkDeviceSize(15);
+	const VkDeviceSize capacity = mSettings.stagingBytes;
+	if (aligned > capacity)
+	{
+		return false;
+	}
+	if (mStagingInUse == 0)
+	{
+		mStagingHead = 0;
+		mStagingTail = 0;
+	}
+
+	if (mStagingInUse == 0 || mStagingHead > mStagingTail)
+	{
+		if (mStagingHead + aligned <= capacity)
+		{
+			offset = mStagingHead;
+			mStagingHead += aligned;
+			mStagingInUse += aligned;
+			return true;
+		}
+		//Wrap, the unused end of the ring stays reserved until this allocation retires
+		if (aligned <= mStagingTail)
+		{
+			mStagingInUse += capacity - mStagingHead + aligned;
+			offset = 0;
+			mStagingHead = aligned;
+			return true;
+		}
+		return false;
+	}
+	if (mStagingHead + aligned <= mStagingTail)
+	{
+		offset = mStagingHead;
+		mStagingHead += aligned;
+		mStagingInUse += aligned;
+		return true;
+	}
+	return false;
+}
+
+bool TextureStreamer::RecordUpload(Batch& batch, Texture& texture, uint32_t baseMip)
+{
+	const VkDeviceSize bytes = ChainBytes(texture, baseMip);
+	//Levels from copyMip on come from the resident image, the ones above it from the staging ring
+	const uint32_t copyMip = texture.gpu.image != VK_NULL_HANDLE ? std::max(baseMip, texture.residentMip) : texture.mipLevels;
+	const VkDeviceSize staged = StagedBytes(texture, baseMip);
+	VkDeviceSize stagingOffset = 0;
+	if (staged > 0 && AllocateStaging(staged, stagingOffset) == false)
+	{
+		return false;
+	}
+	if (batch.cmd == VK_NULL_HANDLE)
+	{
+		batch.cmd = mApp->mVulkanDevice->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, mCommandPool, true);
+	}
+
+	Upload upload;
+	upload.texture = &texture;
+	upload.baseMip = baseMip;
+	upload.bytes = bytes;
+	ImageWrap& image = upload.image;
+	image.width = std::max(1u, texture.width >> baseMip);
+	image.height = std::max(1u, texture.height >> baseMip);
+	image.mipLevels = texture.mipLevels - baseMip;
+	image.format = texture.format;
+	image.sampler = texture.cubemap ? mCubeSampler : mSampler;
+	//General, so the next upload can read its levels on the transfer queue while frames still sample it
+	image.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	//A new image every time, the old one stays readable by the frame in flight
+	VkImageCreateInfo imageInfo = initializers::imageCreateInfo();
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = image.format;
+	imageInfo.extent = { image.width, image.height, 1 };
+	imageInfo.mipLevels = image.mipLevels;
+	imageInfo.arrayLayers = texture.faceCount;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.flags = texture.cubemap ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+	if (mQueueFamilies.size() > 1)
+	{
+		imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		imageInfo.queueFamilyIndexCount = static_cast<uint32_t>(mQueueFamilies.size());
+		imageInfo.pQueueFamilyIndices = mQueueFamilies.data();
+	}
+	else
+	{
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	}
+	VK_CHECK_RESULT(vkCreateImage(mDevice, &imageInfo, nullptr, &image.image))
+
+	VkMemoryRequirements memReqs;
+	vkGetImageMemoryRequirements(mDevice, image.image, &memReqs);
+	VkMemoryAllocateInfo memAllocInfo = initializers::memoryAllocateInfo();
+	memAllocInfo.allocationSize = memReqs.size;
+	memAllocInfo.memoryTypeIndex = mApp->mVulkanDevice->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	VK_CHECK_RESULT(vkAllocateMemory(mDevice, &memAllocInfo, nullptr, &image.memory))
+	VK_CHECK_RESULT(vkBindImageMemory(mDevice, image.image, image.memory, 0))
+
+	std::vector<VkBufferImageCopy> regions;
+	VkDeviceSize offset = stagingOffset;
+	for (uint32_t level = baseMip; level < copyMip; ++level)
+	{
+		const std::vector<uint8_t>& data = texture.levels[level];
+		std::memcpy(mStagingMapped + offset, data.data(), data.size());
+		const VkDeviceSize faceSize = data.size() / texture.faceCount;
+		for (uint32_t face = 0; face < texture.faceCount; ++face)
+		{
+			VkBufferImageCopy region{};
+			region.bufferOffset = offset + face * faceSize;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = level - baseMip;
+			region.imageSubresource.baseArrayLayer = face;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = { std::max(1u, texture.width >> level), std::max(1u, texture.height >> level), 1 };
+			regions.push_back(region);
+		}
+		offset += data.size();
+	}
+
+	VkImageSubresourceRange subresourceRange = {};
+	subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresourceRange.baseMipLevel = 0;
+	subresourceRange.levelCount = image.mipLevels;
+	subresourceRange.layerCount = texture.faceCount;
+	vks::tools::setImageLayout(batch.cmd, image.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+	if (regions.empty() == false)
+	{
+		vkCmdCopyBufferToImage(batch.cmd, mStagingBuffer, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()), regions.data());
+	}
+
+	if (copyMip < texture.mipLevels)
+	{
+		//Written by an earlier batch on this queue
+		VkImageMemoryBarrier sourceBarrier = initializers::imageMemoryBarrier();
+		sourceBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		sourceBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		sourceBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+		sourceBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+		sourceBarrier.image = texture.gpu.image;
+		sourceBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.gpu.mipLevels, 0, texture.faceCount };
+		vkCmdPipelineBarrier(batch.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &sourceBarrier);
+
+		std::vector<VkImageCopy> copies;
+		for (uint32_t level = copyMip; level < texture.mipLevels; ++level)
+		{
+			VkImageCopy copy{};
+			copy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - texture.residentMip, 0, texture.faceCount };
+			copy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - baseMip, 0, texture.faceCount };
+			copy.extent = { std::max(1u, texture.width >> level), std::max(1u, texture.height >> level), 1 };
+			copies.push_back(copy);
+		}
+		vkCmdCopyImage(batch.cmd, texture.gpu.image, VK_IMAGE_LAYOUT_GENERAL, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(copies.size()), copies.data());
+	}
+
+	//The graphics queue only picks the image up once the batch reached the timeline, the transfer queue just leaves it readable
+	VkImageMemoryBarrier barrier = initializers::imageMemoryBarrier();
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.image = image.image;
+	barrier.subresourceRange = subresourceRange;
+	vkCmdPipelineBarrier(batch.cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	VkImageViewCreateInfo viewInfo = initializers::imageViewCreateInfo();
+	viewInfo.image = image.image;
+	viewInfo.viewType = texture.cubemap ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = image.format;
+	viewInfo.subresourceRange = subresourceRange;
+	VK_CHECK_RESULT(vkCreateImageView(mDevice, &viewInfo, nullptr, &image.imageView))
+
+	mPendingBytes += static_cast<int64_t>(bytes) - static_cast<int64_t>(texture.residentBytes);
+	texture.uploading = true;
+	batch.uploads.push_back(upload);
+	return true;
+}
+
+void TextureStreamer::DestroyImage(ImageWrap& image)
+{
+	//Samplers are shared by every streamed image
+	if (image.imageView != VK_NULL_HANDLE)
+	{
+		vkDestroyImageView(mDevice, image.imageView, nullptr);
+	}
+	if (image.image != VK_NULL_HANDLE)
+	{
+		vkDestroyImage(mDevice, image.image, nullptr);
+	}
+	if (image.memory != VK_NULL_HANDLE)
+	{
+		vkFreeMemory(mDevice, image.memory, nullptr);
+	}
+	image = ImageWrap{};
+}
+
+void TextureStreamer::CreatePlaceholder(ImageWrap& image, bool cubemap)
+{
+	const uint32_t layers = cubemap ? 6 : 1;
+	image.width = 1;
+	image.height = 1;
+	image.mipLevels = 1;
+	image.format = VK_FORMAT_R8G8B8A8_UNORM;
+	image.sampler = cubemap ? mCubeSampler : mSampler;
+	image.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkImageCreateInfo imageInfo = initializers::imageCreateInfo();
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = image.format;
+	imageInfo.extent = { 1, 1, 1 };
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = layers;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.flags = cubemap ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+	VK_CHECK_RESULT(vkCreateImage(mDevice, &imageInfo, nullptr, &image.image))
+
+	VkMemoryRequirements memReqs;
+	vkGetImageMemoryRequirements(mDevice, image.image, &memReqs);
+	VkMemoryAllocateInfo memAllocInfo = initializers::memoryAllocateInfo();
+	memAllocInfo.allocationSize = memReqs.size;
+	memAllocInfo.memoryTypeIndex = mApp->mVulkanDevice->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	VK_CHECK_RESULT(vkAllocateMemory(mDevice, &memAllocInfo, nullptr, &image.memory))
+	VK_CHECK_RESULT(vkBindImageMemory(mDevice, image.image, image.memory, 0))
+
+	VkImageSubresourceRange subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, layers };
+	VkCommandBuffer cmd = mApp->CreateTempCmdBuf();
+	vks::tools::setImageLayout(cmd, image.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresourceRange);
+	//Mid grey for surfaces, black for the sky until the real data arrives
+	VkClearColorValue color = {};
+	if (cubemap == false)
+	{
+		color = { { 0.5f, 0.5f, 0.5f, 1.f } };
+	}
+	vkCmdClearColorImage(cmd, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1, &subresourceRange);
+	vks::tools::setImageLayout(cmd, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresourceRange);
+	mApp->SubmitTempCmdBufToGraphicsQueue(cmd);
+
+	VkImageViewCreateInfo viewInfo = initializers::imageViewCreateInfo();
+	viewInfo.image = image.image;
+	viewInfo.viewType = cubemap ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = image.format;
+	viewInfo.subresourceRange = subresourceRange;
+	VK_CHECK_RESULT(vkCreateImageView(mDevice, &viewInfo, nullptr, &image.imageView))
+}
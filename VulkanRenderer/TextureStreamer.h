@@ -0,0 +1,182 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "ImageWrap.h"
+#include "JobSystem.h"
+#include "TimelineSemaphore.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+class VkApp;
+
+//Loads textures without blocking the frame.
+//Files are decoded as background jobs and uploaded through a persistently mapped staging ring on the transfer queue.
+//The coarse mip tail becomes resident first, finer levels follow screen-space demand under a VRAM budget
+//and levels nobody asked for in a while are dropped again.
+class TextureStreamer
+{
+public:
+	struct Settings
+	{
+		VkDeviceSize budgetBytes = 256ull << 20;
+		VkDeviceSize stagingBytes = 32ull << 20;
+		VkDeviceSize uploadBytesPerFrame = 8ull << 20;
+		uint32_t tailSize = 64;//Levels this size or smaller are resident before anything gets refined
+		uint32_t evictAfterFrames = 120;//Demand is held this long before the extra levels may go
+	};
+
+	struct Stats
+	{
+		uint32_t textureCount = 0;
+		uint32_t decodesPending = 0;
+		uint32_t residentCount = 0;
+		uint32_t batchesInFlight = 0;
+		VkDeviceSize residentBytes = 0;
+		VkDeviceSize uploadedBytes = 0;//Scheduled by the last Update
+	};
+
+	struct TextureInfo
+	{
+		std::string file;
+		uint32_t mipLevels = 0;
+		uint32_t residentMip = 0;//== mipLevels while nothing is resident
+		uint32_t wantedMip = 0;
+		bool failed = false;
+	};
+
+	void Init(VkApp* app, JobSystem* jobSystem, VkQueue transferQueue, const Settings& settings);
+	void Destroy();
+
+	//Returns immediately, the texture reads as a placeholder until its first levels arrive
+	uint32_t Request(const std::string& file, bool cubemap = false);
+
+	//Finest level wanted this frame, the lowest request of the frame wins
+	void RequestMip(uint32_t handle, float mip, uint64_t frame);
+	//Same, from the number of screen pixels the texture spans
+	void RequestPixels(uint32_t handle, float screenPixels, uint64_t frame);
+
+	//Call once per frame after the previous frame completed on the frame timeline, before descriptors are written
+	void Update(uint64_t frame);
+
+	VkDescriptorImageInfo Descriptor(uint32_t handle) const;
+	bool IsCubemap(uint32_t handle) const { return mTextures[handle]->cubemap; }
+	//Handles whose Descriptor() changed since the last call, new requests included
+	std::vector<uint32_t> TakeChangedTextures();
+
+	Settings& GetSettings() { return mSettings; }
+	const Stats& GetStats() const { return mStats; }
+	TextureInfo GetTextureInfo(uint32_t handle) const;
+	uint32_t GetTextureCount() const { return static_cast<uint32_t>(mTextures.size()); }
+
+private:
+	enum DecodeState
+	{
+		DECODE_QUEUED = 0,
+		DECODE_DONE,
+		DECODE_FAILED
+	};
+
+	struct Texture
+	{
+		std::string file;
+		uint32_t handle = 0;
+		bool cubemap = false;
+		std::atomic<int> state{ DECODE_QUEUED };
+
+		//Written by the decoding worker, read only once state is DECODE_DONE
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t mipLevels = 0;
+		uint32_t faceCount = 1;
+		std::vector<std::vector<uint8_t>> levels;//Every face of a level, packed face after face
+
+		//Main thread only
+		ImageWrap gpu;//Holds levels [residentMip, mipLevels)
+		uint32_t residentMip = UINT32_MAX;
+		uint32_t tailMip = 0;
+		uint32_t finestMip = 0;//Finest level whose upload fits the staging ring, finer ones are never streamed
+		VkDeviceSize residentBytes = 0;
+		float demandMip = 0.f;
+		uint64_t demandFrame = 0;
+		bool hasDemand = false;
+		bool uploading = false;
+	};
+
+	struct Upload
+	{
+		Texture* texture = nullptr;
+		ImageWrap image;
+		uint32_t baseMip = 0;
+		VkDeviceSize bytes = 0;
+	};
+
+	//Everything uploaded by one Update, recorded on demand and submitted as the next value of the transfer timeline
+	struct Batch
+	{
+		VkCommandBuffer cmd = VK_NULL_HANDLE;
+		uint64_t timelineValue = 0;
+		VkDeviceSize stagingEnd = 0;
+		VkDeviceSize stagingBytes = 0;
+		std::vector<Upload> uploads;
+	};
+
+	struct Garbage
+	{
+		ImageWrap image;
+		uint64_t frame = 0;
+	};
+
+	bool Decode(Texture& texture);
+	bool DecodeKtx(const std::string& file, Texture& texture);
+	bool DecodeImage(Texture& texture);
+
+	void RetireBatches(uint64_t frame);
+	void CollectGarbage(uint64_t frame);
+	uint32_t WantedMip(const Texture& texture, uint64_t frame) const;
+	VkDeviceSize ChainBytes(const Texture& texture, uint32_t baseMip) const;
+	//What an upload down to baseMip goes through the staging ring with, levels already resident are copied on the device
+	VkDeviceSize StagedBytes(const Texture& texture, uint32_t baseMip) const;
+	bool AllocateStaging(VkDeviceSize size, VkDeviceSize& offset);
+	bool RecordUpload(Batch& batch, Texture& texture, uint32_t baseMip);
+	void DestroyImage(ImageWrap& image);
+	void CreatePlaceholder(ImageWrap& image, bool cubemap);
+
+	VkApp* mApp = nullptr;
+	VkDevice mDevice = VK_NULL_HANDLE;
+	VkQueue mTransferQueue = VK_NULL_HANDLE;
+	Settings mSettings;
+	Stats mStats;
+	uint64_t mFrame = 0;
+
+	std::vector<std::unique_ptr<Texture>> mTextures;
+	std::vector<uint32_t> mChanged;
+
+	//Decoding
+	JobSystem* mJobSystem = nullptr;
+	JobCounter mDecodeJobs;
+	std::atomic<bool> mCancelDecodes{ false };
+
+	//Transfer
+	std::vector<uint32_t> mQueueFamilies;//Families sharing streamed images
+	VkCommandPool mCommandPool = VK_NULL_HANDLE;
+	std::deque<Batch> mBatches;//In submission order
+	TimelineSemaphore mTransferTimeline;//Batches complete in submission order, the staging ring is freed up to the reached value
+	VkBuffer mStagingBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory mStagingMemory = VK_NULL_HANDLE;
+	uint8_t* mStagingMapped = nullptr;
+	VkDeviceSize mStagingHead = 0;
+	VkDeviceSize mStagingTail = 0;
+	VkDeviceSize mStagingInUse = 0;
+
+	int64_t mPendingBytes = 0;//Resident size change of uploads still in flight
+	std::vector<Garbage> mGarbage;
+
+	VkSampler mSampler = VK_NULL_HANDLE;
+	VkSampler mCubeSampler = VK_NULL_HANDLE;
+	ImageWrap mPlaceholder;
+	ImageWrap mCubePlaceholder;
+};
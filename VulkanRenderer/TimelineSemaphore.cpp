@@ -0,0 +1,66 @@
+#include "TimelineSemaphore.h"
+#include "VulkanTools.h"
+
+#include <chrono>
+
+void TimelineSemaphore::Init(VkDevice device)
+{
+	mDevice = device;
+	mSubmitted = 0;
+
+	VkSemaphoreTypeCreateInfo typeInfo{};
+	typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = &typeInfo;
+	if (vkCreateSemaphore(mDevice, &semaphoreInfo, nullptr, &mSemaphore) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create timeline semaphore!");
+	}
+}
+
+void TimelineSemaphore::Destroy()
+{
+	vkDestroySemaphore(mDevice, mSemaphore, nullptr);
+	mSemaphore = VK_NULL_HANDLE;
+}
+
+uint64_t TimelineSemaphore::GetCompleted() const
+{
+	uint64_t value = 0;
+	VK_CHECK_RESULT(vkGetSemaphoreCounterValue(mDevice, mSemaphore, &value))
+	return value;
+}
+
+void TimelineSemaphore::Wait(uint64_t value)
+{
+	mLastWaitMs = 0.f;
+	if (value == 0 || IsCompleted(value) == true)
+	{
+		return;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	VkSemaphoreWaitInfo waitInfo{};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &mSemaphore;
+	waitInfo.pValues = &value;
+	VK_CHECK_RESULT(vkWaitSemaphores(mDevice, &waitInfo, UINT64_MAX))
+	mLastWaitMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+VkTimelineSemaphoreSubmitInfo TimelineSemaphore::SubmitInfo(uint32_t waitCount, const uint64_t* waitValues,
+	uint32_t signalCount, const uint64_t* signalValues)
+{
+	VkTimelineSemaphoreSubmitInfo timelineInfo{};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineInfo.waitSemaphoreValueCount = waitCount;
+	timelineInfo.pWaitSemaphoreValues = waitValues;
+	timelineInfo.signalSemaphoreValueCount = signalCount;
+	timelineInfo.pSignalSemaphoreValues = signalValues;
+	return timelineInfo;
+}
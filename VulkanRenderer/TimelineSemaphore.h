@@ -0,0 +1,38 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+//A Vulkan 1.2 timeline semaphore counting submissions on one queue.
+//Every submit signals the next value, so anything used by a submission can be recycled once
+//GetCompleted() reaches the value it was submitted with, no fence per submission needed.
+class TimelineSemaphore
+{
+public:
+	void Init(VkDevice device);
+	void Destroy();
+
+	//Value the next submit has to signal, counted as submitted from here on
+	uint64_t Advance() { return ++mSubmitted; }
+	//Value of the last Advance
+	uint64_t GetSubmitted() const { return mSubmitted; }
+	uint64_t GetCompleted() const;
+	bool IsCompleted(uint64_t value) const { return value <= GetCompleted(); }
+
+	//Blocks until value is reached, returns right away for 0 and values already reached
+	void Wait(uint64_t value);
+	//Time the last Wait spent blocked
+	float GetLastWaitMs() const { return mLastWaitMs; }
+
+	VkSemaphore GetSemaphore() const { return mSemaphore; }
+
+	//Chained into a VkSubmitInfo that signals the semaphore at value. Binary semaphores of the same
+	//submit take a dummy value, they ignore it
+	static VkTimelineSemaphoreSubmitInfo SubmitInfo(uint32_t waitCount, const uint64_t* waitValues,
+		uint32_t signalCount, const uint64_t* signalValues);
+
+private:
+	VkDevice mDevice = VK_NULL_HANDLE;
+	VkSemaphore mSemaphore = VK_NULL_HANDLE;
+	uint64_t mSubmitted = 0;
+	float mLastWaitMs = 0.f;
+};
@@ -0,0 +1,250 @@
+#include "TransformStore.h"
+#include "VulkanDevice.h"
+#include "VulkanTools.h"
+
+#include <stdexcept>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TRANSFORM_SIMD 1
+#include <emmintrin.h>
+#else
+#define TRANSFORM_SIMD 0
+#endif
+
+//out = a * b, out must not alias a or b
+static void MultiplyMat4(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+#if TRANSFORM_SIMD
+	const __m128 a0 = _mm_loadu_ps(&a[0][0]);
+	const __m128 a1 = _mm_loadu_ps(&a[1][0]);
+	const __m128 a2 = _mm_loadu_ps(&a[2][0]);
+	const __m128 a3 = _mm_loadu_ps(&a[3][0]);
+	for (int column = 0; column < 4; ++column)
+	{
+		__m128 result = _mm_mul_ps(a0, _mm_set1_ps(b[column][0]));
+		result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(b[column][1])));
+		result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(b[column][2])));
+		result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(b[column][3])));
+		_mm_storeu_ps(&out[column][0], result);
+	}
+#else
+	out = a * b;
+#endif
+}
+
+void TransformStore::Init(VulkanDevice* device, uint32_t capacity)
+{
+	mCapacity = capacity;
+	mPositions.reserve(capacity);
+	mRotations.reserve(capacity);
+	mScales.reserve(capacity);
+	mParents.reserve(capacity);
+	mDirty.reserve(capacity);
+	mUpdated.reserve(capacity);
+	mWorld.reserve(capacity);
+
+	VK_CHECK_RESULT(device->createBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		&mBuffer, sizeof(glm::mat4) * capacity * 2))
+	VK_CHECK_RESULT(mBuffer.map())
+	mMapped = static_cast<glm::mat4*>(mBuffer.mapped);
+}
+
+void TransformStore::Destroy()
+{
+	mBuffer.Unmap();
+	mBuffer.destroy();
+	mMapped = nullptr;
+}
+
+uint32_t TransformStore::Create(glm::vec3 position, glm::quat rotation, glm::vec3 scale, uint32_t parent)
+{
+	if (GetCount() == mCapacity)
+	{
+		throw std::runtime_error("failed to create transform, the store is full!");
+	}
+	if (parent != NO_PARENT && parent >= GetCount())
+	{
+		throw std::runtime_error("failed to create transform, parent does not exist!");
+	}
+
+	uint32_t handle = GetCount();
+	mPositions.push_back(position);
+	mRotations.push_back(rotation);
+	mScales.push_back(scale);
+	mParents.push_back(parent);
+	mDirty.push_back(1);
+	mUpdated.push_back(0);
+	mWorld.push_back(glm::mat4(1.f));
+	mCreated.push_back(handle);
+	return handle;
+}
+
+void TransformStore::SetPosition(uint32_t handle, glm::vec3 position)
+{
+	mPositions[handle] = position;
+	mDirty[handle] = 1;
+}
+
+void TransformStore::SetRotation(uint32_t handle, glm::quat rotation)
+{
+	mRotations[handle] = rotation;
+	mDirty[handle] = 1;
+}
+
+void TransformStore::SetScale(uint32_t handle, glm::vec3 scale)
+{
+	mScales[handle] = scale;
+	mDirty[handle] = 1;
+}
+
+uint32_t TransformStore::Update()
+{
+	//Matrices rebuilt last time become the previous ones, the rest already match
+	for (uint32_t handle : mBatch)
+	{
+		mMapped[mCapacity + handle] = mWorld[handle];
+	}
+
+	//Parents precede their children, so a parent's flag is final by the time its children are visited
+	mBatch.clear();
+	const uint32_t count = GetCount();
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const uint32_t parent = mParents[i];
+		const bool rebuild = mDirty[i] != 0 || (parent != NO_PARENT && mUpdated[parent] != 0);
+		mUpdated[i] = rebuild ? 1 : 0;
+		mDirty[i] = 0;
+		if (rebuild == true)
+		{
+			mBatch.push_back(i);
+		}
+	}
+
+	mLocal.resize(mBatch.size());
+	size_t first = 0;
+#if TRANSFORM_SIMD
+	for (; first + 4 <= mBatch.size(); first += 4)
+	{
+		ComposeLocal4(first, &mLocal[first]);
+	}
+#endif
+	for (; first < mBatch.size(); ++first)
+	{
+		mLocal[first] = ComposeLocal(mBatch[first]);
+	}
+
+	for (size_t i = 0; i < mBatch.size(); ++i)
+	{
+		const uint32_t handle = mBatch[i];
+		const uint32_t parent = mParents[handle];
+		if (parent == NO_PARENT)
+		{
+			mWorld[handle] = mLocal[i];
+		}
+		else
+		{
+			MultiplyMat4(mWorld[parent], mLocal[i], mWorld[handle]);
+		}
+		mMapped[handle] = mWorld[handle];
+	}
+	for (uint32_t handle : mCreated)
+	{
+		mMapped[mCapacity + handle] = mWorld[handle];
+	}
+	mCreated.clear();
+
+	mLastUpdateCount = static_cast<uint32_t>(mBatch.size());
+	return mLastUpdateCount;
+}
+
+VkDescriptorBufferInfo TransformStore::Descriptor() const
+{
+	VkDescriptorBufferInfo info{};
+	info.buffer = mBuffer.buffer;
+	info.offset = 0;
+	info.range = sizeof(glm::mat4) * mCapacity;
+	return info;
+}
+
+VkDescriptorBufferInfo TransformStore::PreviousDescriptor() const
+{
+	VkDescriptorBufferInfo info{};
+	info.buffer = mBuffer.buffer;
+	info.offset = sizeof(glm::mat4) * mCapacity;
+	info.range = sizeof(glm::mat4) * mCapacity;
+	return info;
+}
+
+/*************************************************************************************************************/
+
+glm::mat4 TransformStore::ComposeLocal(uint32_t handle) const
+{
+	const glm::vec3& scale = mScales[handle];
+	glm::mat4 local = glm::mat4_cast(mRotations[handle]);
+	local[0] *= scale.x;
+	local[1] *= scale.y;
+	local[2] *= scale.z;
+	local[3] = glm::vec4(mPositions[handle], 1.f);
+	return local;
+}
+
+#if TRANSFORM_SIMD
+void TransformStore::ComposeLocal4(size_t first, glm::mat4* out) const
+{
+	alignas(16) float qx[4], qy[4], qz[4], qw[4], sx[4], sy[4], sz[4];
+	for (int lane = 0; lane < 4; ++lane)
+	{
+		const uint32_t handle = mBatch[first + lane];
+		const glm::quat& rotation = mRotations[handle];
+		const glm::vec3& scale = mScales[handle];
+		qx[lane] = rotation.x;
+		qy[lane] = rotation.y;
+		qz[lane] = rotation.z;
+		qw[lane] = rotation.w;
+		sx[lane] = scale.x;
+		sy[lane] = scale.y;
+		sz[lane] = scale.z;
+	}
+
+	const __m128 x = _mm_load_ps(qx);
+	const __m128 y = _mm_load_ps(qy);
+	const __m128 z = _mm_load_ps(qz);
+	const __m128 w = _mm_load_ps(qw);
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 two = _mm_set1_ps(2.f);
+
+	const __m128 xx = _mm_mul_ps(x, x);
+	const __m128 yy = _mm_mul_ps(y, y);
+	const __m128 zz = _mm_mul_ps(z, z);
+	const __m128 xy = _mm_mul_ps(x, y);
+	const __m128 xz = _mm_mul_ps(x, z);
+	const __m128 yz = _mm_mul_ps(y, z);
+	const __m128 wx = _mm_mul_ps(w, x);
+	const __m128 wy = _mm_mul_ps(w, y);
+	const __m128 wz = _mm_mul_ps(w, z);
+
+	//Rotation columns scaled per axis, the same terms as glm::mat3_cast
+	const __m128 scaleX = _mm_load_ps(sx);
+	const __m128 scaleY = _mm_load_ps(sy);
+	const __m128 scaleZ = _mm_load_ps(sz);
+	alignas(16) float m[9][4];
+	_mm_store_ps(m[0], _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), scaleX));
+	_mm_store_ps(m[1], _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), scaleX));
+	_mm_store_ps(m[2], _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), scaleX));
+	_mm_store_ps(m[3], _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), scaleY));
+	_mm_store_ps(m[4], _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), scaleY));
+	_mm_store_ps(m[5], _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), scaleY));
+	_mm_store_ps(m[6], _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), scaleZ));
+	_mm_store_ps(m[7], _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), scaleZ));
+	_mm_store_ps(m[8], _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), scaleZ));
+
+	for (int lane = 0; lane < 4; ++lane)
+	{
+		out[lane] = glm::mat4(
+			glm::vec4(m[0][lane], m[1][lane], m[2][lane], 0.f),
+			glm::vec4(m[3][lane], m[4][lane], m[5][lane], 0.f),
+			glm::vec4(m[6][lane], m[7][lane], m[8][lane], 0.f),
+			glm::vec4(mPositions[mBatch[first + lane]], 1.f));
+	}
+}
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "VulkanBuffer.h"
+#include <cstdint>
+#include <vector>
+
+struct VulkanDevice;
+
+//Position, rotation and scale of every scene object, kept as separate contiguous arrays.
+//Parents are always created before their children, so one forward pass resolves a whole hierarchy.
+//Update rebuilds only the world matrices of dirty entries and their descendants, four at a time with SSE,
+//and writes them straight into a host visible storage buffer the vertex shaders index by handle.
+//The second half of the buffer keeps last frame's matrices for motion vectors.
+class TransformStore
+{
+public:
+	static const uint32_t NO_PARENT = UINT32_MAX;
+
+	void Init(VulkanDevice* device, uint32_t capacity);
+	void Destroy();
+
+	//parent must be an existing handle, world = parent world * local
+	uint32_t Create(glm::vec3 position, glm::quat rotation = glm::quat(1.f, 0.f, 0.f, 0.f), glm::vec3 scale = glm::vec3(1.f), uint32_t parent = NO_PARENT);
+
+	void SetPosition(uint32_t handle, glm::vec3 position);
+	void SetRotation(uint32_t handle, glm::quat rotation);
+	void SetScale(uint32_t handle, glm::vec3 scale);
+	glm::vec3 GetPosition(uint32_t handle) const { return mPositions[handle]; }
+	glm::quat GetRotation(uint32_t handle) const { return mRotations[handle]; }
+	glm::vec3 GetScale(uint32_t handle) const { return mScales[handle]; }
+
+	//Once per frame, after the GPU finished reading the buffer. Returns the number of matrices rebuilt
+	uint32_t Update();
+
+	const glm::mat4& GetWorld(uint32_t handle) const { return mWorld[handle]; }
+	//Whether the last Update rebuilt this world matrix
+	bool WasUpdated(uint32_t handle) const { return mUpdated[handle] != 0; }
+	uint32_t GetCount() const { return static_cast<uint32_t>(mPositions.size()); }
+	uint32_t GetLastUpdateCount() const { return mLastUpdateCount; }
+
+	VkDescriptorBufferInfo Descriptor() const;
+	//World matrices as of the previous Update, new entries start with their current one
+	VkDescriptorBufferInfo PreviousDescriptor() const;
+
+private:
+	//Local TRS matrices of mBatch[first, first + 4), lane i belongs to mBatch[first + i]
+	void ComposeLocal4(size_t first, glm::mat4* out) const;
+	glm::mat4 ComposeLocal(uint32_t handle) const;
+
+	std::vector<glm::vec3> mPositions;
+	std::vector<glm::quat> mRotations;
+	std::vector<glm::vec3> mScales;
+	std::vector<uint32_t> mParents;
+	std::vector<uint8_t> mDirty;//Local transform changed since the last Update
+	std::vector<uint8_t> mUpdated;//Rebuilt by the last Update, dirty itself or below a dirty parent
+	std::vector<glm::mat4> mWorld;//CPU copy, the mapped buffer is never read back
+
+	std::vector<uint32_t> mBatch;//Entries rebuilt this Update, ascending so parents come first
+	std::vector<glm::mat4> mLocal;//Scratch, indexed like mBatch
+	std::vector<uint32_t> mCreated;//Since the last Update, they have no previous matrix yet
+	uint32_t mLastUpdateCount = 0;
+
+	uint32_t mCapacity = 0;
+	Buffer mBuffer;
+	glm::mat4* mMapped = nullptr;
+};
@@ -3,20 +3,177 @@
 #include <glm/glm.hpp>
 #include "PointLight.h"
 #include "DirLight.h"
+
+#define SHADOW_MAP_CASCADE_COUNT 4
+#define POINT_SHADOW_SLOTS 4
+#define POINT_SHADOW_DIM 512
+#define MAX_BINDLESS_TEXTURES 1024
+#define MAX_MATERIALS 256
+#define MAX_TRANSFORMS 4096
+#define LIGHT_TILE_SIZE 16
+#define LUMINANCE_HISTOGRAM_BINS 256
+#define TAA_JITTER_PHASES 8
+#define BLOOM_MIPS 6
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+#define HIZ_MIPS 8
+
+enum ShadowFilterMode
+{
+	SHADOW_FILTER_HARD = 0,
+	SHADOW_FILTER_HW_PCF,
+	SHADOW_FILTER_POISSON,
+	SHADOW_FILTER_PCSS,
+	SHADOW_FILTER_COUNT
+};
+
+//Shaders that only need view and projection declare just the first two
 struct UniformBufferMat
 {
 	glm::mat4 view;
-	glm::mat4 proj;
+	glm::mat4 proj;//Jittered while TAA is on
+	glm::mat4 viewProj;//Without jitter, motion vectors compare these
+	glm::mat4 prevViewProj;
+	glm::mat4 invViewProj;
 };
 
 struct LightMatUBO
 {
-	glm::mat4 lightMVP;
+	glm::mat4 cascadeViewProj[SHADOW_MAP_CASCADE_COUNT];
+	glm::vec4 cascadeSplits;//View space depth where each cascade ends (negative, camera looks down -z)
+	glm::mat4 cameraView;
+	glm::vec4 shadowFilter;//x: ShadowFilterMode, y: Poisson tap count, z: PCF radius in texels, w: PCSS light size
+};
+
+struct CascadePushConstant
+{
+	uint32_t transformIndex;
+	uint32_t cascadeIndex;
+};
+
+struct PointShadowUBO
+{
+	glm::mat4 faceViewProj[POINT_SHADOW_SLOTS * 6];//Six cube faces per atlas slot
+	glm::vec4 lightPosRadius[POINT_SHADOW_SLOTS];
+};
+
+struct PointShadowPushConstant
+{
+	uint32_t transformIndex;
+	uint32_t shadowSlot;
+};
+
+//std430 layout of the material SSBO, indexed by GPushConstant::materialIndex
+struct Material
+{
+	glm::vec4 baseColor;
+	int32_t diffuseTexture;//Slot in the bindless texture array, -1 for none
+	int32_t pad[3];
+};
+
+//Model matrices live in the transform SSBO, indexed by transformIndex
+struct GPushConstant
+{
+	uint32_t transformIndex;
+	uint32_t materialIndex;
+};
+
+//Light binning dispatch, one invocation per tile
+struct LightBinPushConstant
+{
+	glm::uvec2 tileCount;
+	glm::vec2 screenSize;
+};
+
+//Histogram and exposure dispatches
+struct ExposurePushConstant
+{
+	float minLogLuminance;
+	float logLuminanceRange;
+	float adaptation;//Share of this frame's luminance in the adapted one
+	float compensation;//EV
+	glm::uvec2 renderSize;//Part of the image covered at dynamic resolution
+};
+
+//Upscale to the swapchain
+struct TonemapPushConstant
+{
+	glm::vec2 uvScale;//Render size over image size
+	glm::vec2 uvMax;//Half a texel inside the rendered part
+	glm::vec2 bloomScale;//Same for the bloom chain's first mip, which is half the size
+	glm::vec2 bloomMax;
+	float sharpness;
+	float bloomIntensity;//0 skips the bloom fetch
+};
+
+//TAA resolve
+struct TAAPushConstant
+{
+	glm::uvec2 renderSize;
+	glm::vec2 historyScale;//Last frame's render size over the image size
+	float blend;//Share of the current frame, 1 shows it unfiltered
+	uint32_t reset;//History is not valid, e.g. on the first frame
+};
+
+//Bloom downsample and upsample dispatches, one mip each
+struct BloomPushConstant
+{
+	glm::uvec2 sourceSize;//Rendered part of the mip read
+	glm::uvec2 targetSize;//Rendered part of the mip written
+	uint32_t sourceMip;//Of the chain, the first downsample reads the frame instead
+	uint32_t targetMip;
+	float threshold;//Luminance where bloom starts, first downsample only
+	float knee;//Width of the soft transition below the threshold
+};
+
+//std430 layout of the meshlet SSBO, bounds are in mesh space
+struct Meshlet
+{
+	glm::vec4 sphere;//xyz center, w radius
+	glm::vec4 cone;//xyz average face normal, w sine of the normals' spread. Culled when seen from inside the cone, 1 never is
+	uint32_t firstIndex;//Of its triangles, into the mesh's indices and in the SSBO into the meshlet index SSBO
+	uint32_t triangleCount;
+	uint32_t pad[2];
+};
+
+//std430 layout of the cluster draw SSBO, one per drawn object. The culling dispatch has a group for each
+struct ClusterDraw
+{
+	uint32_t transformIndex;
+	uint32_t firstMeshlet;//Of the object's level in the meshlet SSBO
+	uint32_t meshletCount;
+	uint32_t firstIndex;//Its part of the compacted index buffer, with room for every triangle of the level
+};
+
+//Cluster culling dispatch
+struct ClusterCullPushConstant
+{
+	glm::vec4 cameraPosition;
+	glm::uvec2 hiZSize;//Last frame's render size, the depth pyramid covers that corner
+	uint32_t coneCulling;
+	uint32_t occlusionCulling;//The pyramid holds last frame's depth
+};
+
+//Depth pyramid dispatches, one mip each
+struct DepthPyramidPushConstant
+{
+	glm::uvec2 sourceSize;//Rendered part of the depth or mip read
+	glm::uvec2 targetSize;
+	uint32_t targetMip;
+};
+
+//std430 layout of the exposure SSBO. The exposure dispatch clears the histogram after reading it
+struct ExposureData
+{
+	uint32_t histogram[LUMINANCE_HISTOGRAM_BINS];
+	float exposure;
+	float averageLuminance;
 };
 
 struct UniformBufferLights
 {
 	PointLight point_light[3];
+	DirLight dir_light;
 	glm::vec3 lookVec;
 };
 
@@ -3,9 +3,21 @@
 #include "VulkanTools.h"
 #include "VulkanInitializers.hpp"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
 #include <set>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#define PIPELINE_CACHE_FILE "pipeline.cache"
+#define PIPELINE_CACHE_MAGIC 0x48435056u//"VPCH"
+
+//Written in front of the driver's data. The Vulkan header has no driver version, and a driver update may keep the UUID
+struct PipelineCachePrefix
+{
+	uint32_t magic;
+	uint32_t driverVersion;
+	uint64_t dataSize;//Of the driver's data after this, a file holding less was cut off while being written
+};
 
 void VkApp::Init()
 {
@@ -34,6 +46,7 @@ void VkApp::InitVulkan()
 	SetupDebugMessenger();
 	CreateSurface();
 	CreateDevice();
+	CreatePipelineCache();
 	CreateSwapChain();
 }
 
@@ -49,7 +62,9 @@ void VkApp::Draw()
 
 void VkApp::CleanUp()
 {
-	
+	SavePipelineCache();
+	vkDestroyPipelineCache(mVulkanDevice->logicalDevice, mPipelineCache, nullptr);
+	mPipelineCache = VK_NULL_HANDLE;
 }
 
 void VkApp::FrameStart()
@@ -203,8 +218,71 @@ void VkApp::CreateDevice()
 	VkPhysicalDeviceFeatures deviceFeatures{};
 	deviceFeatures.samplerAnisotropy = VK_TRUE;
 	deviceFeatures.geometryShader = VK_TRUE;
+	deviceFeatures.depthClamp = mVulkanDevice->features.depthClamp;//Keeps shadow casters behind the cascade near plane
+	deviceFeatures.imageCubeArray = VK_TRUE;//Point light shadows live in one cube map array
+	deviceFeatures.shaderStorageImageArrayDynamicIndexing = VK_TRUE;//Bloom picks the mip it writes with a push constant
+	deviceFeatures.textureCompressionBC = mVulkanDevice->features.textureCompressionBC;
+	deviceFeatures.textureCompressionASTC_LDR = mVulkanDevice->features.textureCompressionASTC_LDR;
+	deviceFeatures.textureCompressionETC2 = mVulkanDevice->features.textureCompressionETC2;
+
+	//Core features without a fallback path
+	if (mVulkanDevice->features.imageCubeArray == VK_FALSE)
+	{
+		throw std::runtime_error("cube map arrays are not supported!");
+	}
+	if (mVulkanDevice->features.shaderStorageImageArrayDynamicIndexing == VK_FALSE)
+	{
+		throw std::runtime_error("dynamic indexing of storage image arrays is not supported!");
+	}
 
-	VkResult res = mVulkanDevice->createLogicalDevice(deviceFeatures, deviceExtensions, nullptr);
+	//Vulkan 1.2 features are queried first so a missing one fails here instead of at device creation
+	VkPhysicalDeviceVulkan12Features supported12{};
+	supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	VkPhysicalDeviceFeatures2 supportedFeatures2{};
+	supportedFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	supportedFeatures2.pNext = &supported12;
+	vkGetPhysicalDeviceFeatures2(mVulkanDevice->physicalDevice, &supportedFeatures2);
+
+	//Bindless material textures
+	if (supported12.runtimeDescriptorArray == VK_FALSE || supported12.descriptorBindingPartiallyBound == VK_FALSE
+		|| supported12.descriptorBindingSampledImageUpdateAfterBind == VK_FALSE || supported12.shaderSampledImageArrayNonUniformIndexing == VK_FALSE)
+	{
+		throw std::runtime_error("descriptor indexing is not supported!");
+	}
+	//Frame and upload completion are tracked with timeline semaphores instead of fences
+	if (supported12.timelineSemaphore == VK_FALSE)
+	{
+		throw std::runtime_error("timeline semaphores are not supported!");
+	}
+	//Timestamps are written on more than one queue, so queries are reset from the host instead of a command buffer
+	if (supported12.hostQueryReset == VK_FALSE)
+	{
+		throw std::runtime_error("host query reset is not supported!");
+	}
+	//The luminance histogram and exposure reduce with subgroup operations
+	VkPhysicalDeviceSubgroupProperties subgroupProperties{};
+	subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+	VkPhysicalDeviceProperties2 properties2{};
+	properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties2.pNext = &subgroupProperties;
+	vkGetPhysicalDeviceProperties2(mVulkanDevice->physicalDevice, &properties2);
+	const VkSubgroupFeatureFlags subgroupOperations = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_VOTE_BIT
+		| VK_SUBGROUP_FEATURE_BALLOT_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT;
+	if ((subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) == 0
+		|| (subgroupProperties.supportedOperations & subgroupOperations) != subgroupOperations)
+	{
+		throw std::runtime_error("subgroup operations are not supported in compute shaders!");
+	}
+	mEnabledFeatures12 = {};
+	mEnabledFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	mEnabledFeatures12.runtimeDescriptorArray = VK_TRUE;
+	mEnabledFeatures12.descriptorBindingPartiallyBound = VK_TRUE;
+	mEnabledFeatures12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+	mEnabledFeatures12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+	mEnabledFeatures12.timelineSemaphore = VK_TRUE;
+	mEnabledFeatures12.hostQueryReset = VK_TRUE;
+
+	VkResult res = mVulkanDevice->createLogicalDevice(deviceFeatures, deviceExtensions, &mEnabledFeatures12);
 	if (res == VK_FALSE)
 	{
 		assert("Failed to create Logical Device!");
@@ -212,10 +290,94 @@ void VkApp::CreateDevice()
 
 	vkGetDeviceQueue(mVulkanDevice->logicalDevice, mVulkanDevice->getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT), 0, &mGraphicsQueue);
 	vkGetDeviceQueue(mVulkanDevice->logicalDevice, mVulkanDevice->getQueueFamilyIndex(VK_QUEUE_TRANSFER_BIT), 0, &mTransferQueue);
+	//The same queue as graphics when the device has no compute only family
+	vkGetDeviceQueue(mVulkanDevice->logicalDevice, mVulkanDevice->queueFamilyIndices.compute, 0, &mComputeQueue);
 
 	mPresentQueue = mGraphicsQueue;//TODO: PlaceHolder
 }
 
+void VkApp::CreatePipelineCache()
+{
+	std::vector<char> data;
+	std::ifstream file(PIPELINE_CACHE_FILE, std::ios::ate | std::ios::binary);
+	if (file.is_open() == true)
+	{
+		data.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(data.data(), data.size());
+	}
+
+	//A cache from another GPU or driver is dropped here, drivers are not required to reject it themselves
+	bool stale = false;
+	if (data.empty() == false)
+	{
+		const VkPhysicalDeviceProperties& properties = mVulkanDevice->properties;
+		PipelineCachePrefix prefix{};
+		VkPipelineCacheHeaderVersionOne header{};
+		bool valid = data.size() >= sizeof(prefix) + sizeof(header);
+		if (valid == true)
+		{
+			memcpy(&prefix, data.data(), sizeof(prefix));
+			memcpy(&header, data.data() + sizeof(prefix), sizeof(header));
+			valid = prefix.magic == PIPELINE_CACHE_MAGIC && prefix.driverVersion == properties.driverVersion
+				&& prefix.dataSize == data.size() - sizeof(prefix)
+				&& header.headerSize >= sizeof(header) && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+				&& header.vendorID == properties.vendorID && header.deviceID == properties.deviceID
+				&& memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+		}
+		if (valid == true)
+		{
+			data.erase(data.begin(), data.begin() + sizeof(prefix));
+		}
+		else
+		{
+			std::cout << "Pipeline cache: " << PIPELINE_CACHE_FILE << " belongs to another device or driver, rebuilding\n";
+			data.clear();
+			stale = true;
+		}
+	}
+
+	VkPipelineCacheCreateInfo cacheInfo{};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheInfo.initialDataSize = data.size();
+	cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+	VK_CHECK_RESULT(vkCreatePipelineCache(mVulkanDevice->logicalDevice, &cacheInfo, nullptr, &mPipelineCache))
+	std::cout << "Pipeline cache: " << data.size() << " bytes loaded\n";
+
+	//Replaced right away, a run that never reaches CleanUp would otherwise leave the stale file in place
+	if (stale == true)
+	{
+		SavePipelineCache();
+	}
+}
+
+void VkApp::SavePipelineCache()
+{
+	size_t size = 0;
+	VK_CHECK_RESULT(vkGetPipelineCacheData(mVulkanDevice->logicalDevice, mPipelineCache, &size, nullptr))
+	std::vector<char> data(size);
+	VK_CHECK_RESULT(vkGetPipelineCacheData(mVulkanDevice->logicalDevice, mPipelineCache, &size, data.data()))
+
+	PipelineCachePrefix prefix{};
+	prefix.magic = PIPELINE_CACHE_MAGIC;
+	prefix.driverVersion = mVulkanDevice->properties.driverVersion;
+	prefix.dataSize = size;
+
+	//Written next to the old one and swapped in, so a crash mid write never leaves a truncated cache behind
+	const std::string tempFile = std::string(PIPELINE_CACHE_FILE) + ".tmp";
+	{
+		std::ofstream file(tempFile, std::ios::binary | std::ios::trunc);
+		if (file.is_open() == false)
+		{
+			return;
+		}
+		file.write(reinterpret_cast<const char*>(&prefix), sizeof(prefix));
+		file.write(data.data(), size);
+	}
+	std::error_code error;
+	std::filesystem::rename(tempFile, PIPELINE_CACHE_FILE, error);
+}
+
 void VkApp::CreateSwapChain()
 {
 	mSwapChain = new SwapChain(this);
@@ -333,6 +495,55 @@ void VkApp::CreateDepthOnlyAttachment(VkFormat format, FrameBufferAttachment* at
 	VK_CHECK_RESULT(vkCreateImageView(mVulkanDevice->logicalDevice, &imageView, nullptr, &attachment->view));
 }
 
+void VkApp::CreateLayeredDepthAttachment(VkFormat format, uint32_t width, uint32_t height, uint32_t layerCount, FrameBufferAttachment* attachment, bool cubeArray)
+{
+	attachment->format = format;
+
+	VkImageCreateInfo image{};
+	image.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	image.imageType = VK_IMAGE_TYPE_2D;
+	image.format = format;
+	image.extent.width = width;
+	image.extent.height = height;
+	image.extent.depth = 1;
+	image.mipLevels = 1;
+	image.arrayLayers = layerCount;
+	image.samples = VK_SAMPLE_COUNT_1_BIT;
+	image.tiling = VK_IMAGE_TILING_OPTIMAL;
+	image.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	image.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if (cubeArray == true)
+	{
+		//Every 6 layers form one cube
+		image.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+	}
+
+	VkMemoryAllocateInfo memAlloc{};
+	memAlloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+
+	VkMemoryRequirements memReqs;
+
+	VK_CHECK_RESULT(vkCreateImage(mVulkanDevice->logicalDevice, &image, nullptr, &attachment->image));
+	vkGetImageMemoryRequirements(mVulkanDevice->logicalDevice, attachment->image, &memReqs);
+	memAlloc.allocationSize = memReqs.size;
+	memAlloc.memoryTypeIndex = mVulkanDevice->getMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	VK_CHECK_RESULT(vkAllocateMemory(mVulkanDevice->logicalDevice, &memAlloc, nullptr, &attachment->memory));
+	VK_CHECK_RESULT(vkBindImageMemory(mVulkanDevice->logicalDevice, attachment->image, attachment->memory, 0));
+
+	//Array view over every layer for sampling. Per-layer views for rendering are owned by the pass.
+	VkImageViewCreateInfo imageView = initializers::imageViewCreateInfo();
+	imageView.viewType = cubeArray ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+	imageView.format = format;
+	imageView.subresourceRange = {};
+	imageView.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	imageView.subresourceRange.baseMipLevel = 0;
+	imageView.subresourceRange.levelCount = 1;
+	imageView.subresourceRange.baseArrayLayer = 0;
+	imageView.subresourceRange.layerCount = layerCount;
+	imageView.image = attachment->image;
+	VK_CHECK_RESULT(vkCreateImageView(mVulkanDevice->logicalDevice, &imageView, nullptr, &attachment->view));
+}
+
 VkFormat VkApp::FindDepthFormat()
 {
 	return FindSupportedFormat({ VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
@@ -340,6 +551,13 @@ VkFormat VkApp::FindDepthFormat()
 		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
 }
 
+VkFormat VkApp::FindHDRFormat()
+{
+	return FindSupportedFormat({ VK_FORMAT_B10G11R11_UFLOAT_PACK32, VK_FORMAT_R16G16B16A16_SFLOAT },
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+}
+
 VkFormat VkApp::FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling,
 	VkFormatFeatureFlags features)
 {
@@ -580,35 +798,19 @@ void VkApp::CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, ui
 	SubmitTempCmdBufToGraphicsQueue(commandBuffer);
 }
 
-void VkApp::CreateTextureImage(const std::string& file, VkImage& image, VkDeviceMemory& memory)
+bool VkApp::IsSampledFormatSupported(VkFormat format)
 {
-	int texWidth, texHeight, texChannels;
-	stbi_set_flip_vertically_on_load(true);
-	stbi_uc* pixels = stbi_load(file.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-	VkDeviceSize imageSize = texWidth * texHeight * 4;//4 bytes per pixel
-
-	VkBuffer stagingBuffer;//TODO: Delete staging buffer after copy image.
-	VkDeviceMemory stagingBufferMemory;
-
-	mVulkanDevice->createBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		imageSize, &stagingBuffer, &stagingBufferMemory);
-
-	void* data;
-	vkMapMemory(mVulkanDevice->logicalDevice, stagingBufferMemory, 0, imageSize, 0, &data);
-	memcpy(data, pixels, static_cast<size_t>(imageSize));
-	vkUnmapMemory(mVulkanDevice->logicalDevice, stagingBufferMemory);
-	stbi_image_free(pixels);
-
-	CreateImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
-
-	ImageLayoutTransition(image, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-	CopyBufferToImage(stagingBuffer, image, static_cast<uint32_t>(texWidth), static_cast <uint32_t> (texHeight));
-	ImageLayoutTransition(image, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	if (format == VK_FORMAT_UNDEFINED)
+	{
+		return false;
+	}
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(mVulkanDevice->physicalDevice, format, &formatProperties);
+	return (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
 }
 
 void VkApp::CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-	VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
+	VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t mipLevels)
 {
 	VkImageCreateInfo imageInfo{};
 	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -616,7 +818,7 @@ void VkApp::CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImag
 	imageInfo.extent.width = width;
 	imageInfo.extent.height = height;
 	imageInfo.extent.depth = 1;
-	imageInfo.mipLevels = 1;
+	imageInfo.mipLevels = mipLevels;
 	imageInfo.arrayLayers = 1;
 	imageInfo.format = format;
 	imageInfo.tiling = tiling;
@@ -646,7 +848,7 @@ void VkApp::CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImag
 	vkBindImageMemory(mVulkanDevice->logicalDevice, image, imageMemory, 0);
 }
 
-VkImageView VkApp::CreateImageView(VkImage& image, VkFormat imageFormat, VkImageAspectFlagBits aspect)
+VkImageView VkApp::CreateImageView(VkImage& image, VkFormat imageFormat, VkImageAspectFlagBits aspect, uint32_t mipLevels)
 {
 	VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
 	viewInfo.image = image;
@@ -654,7 +856,7 @@ VkImageView VkApp::CreateImageView(VkImage& image, VkFormat imageFormat, VkImage
 	viewInfo.format = imageFormat;
 	viewInfo.subresourceRange.aspectMask = aspect;
 	viewInfo.subresourceRange.baseMipLevel = 0;
-	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.levelCount = mipLevels;
 	viewInfo.subresourceRange.baseArrayLayer = 0;
 	viewInfo.subresourceRange.layerCount = 1;
 
@@ -675,13 +877,15 @@ VkSampler VkApp::CreateTextureSampler()
 	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
 	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerInfo.anisotropyEnable = VK_TRUE;
+	samplerInfo.anisotropyEnable = mVulkanDevice->features.samplerAnisotropy;
 	samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
 	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
 	samplerInfo.unnormalizedCoordinates = VK_FALSE;
 	samplerInfo.compareEnable = VK_FALSE;
 	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
 	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.minLod = 0.f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;//Whole mip chain of whatever texture is bound
 
 	VkSampler textureSampler;
 	if (vkCreateSampler(mVulkanDevice->logicalDevice, &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS) {
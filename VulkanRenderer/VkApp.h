@@ -7,11 +7,14 @@
 #include "VulkanDevice.h"
 
 #include "SwapChain.h"
+#include "ImageWrap.h"
 #include "VulkanDevice.h"
+#include "PipelineBuildService.h"
 #include <chrono>
 
 const uint32_t WIDTH = 1920;
 const uint32_t HEIGHT = 1055;
+const uint32_t MAX_FRAMES_IN_FLIGHT = 1;
 
 #define TEX_DIM 2048
 #define TEX_FILTER VK_FILTER_LINEAR
@@ -48,6 +51,8 @@ private:
 	void CreateInstance();
 	void CreateSurface();
 	void CreateDevice();
+	void CreatePipelineCache();
+	void SavePipelineCache();
 	void CreateSwapChain();
 
 	VkPhysicalDevice PickPhysicalDevice();
@@ -58,7 +63,10 @@ private:
 public:
 	void CreateAttachment(VkFormat format, VkImageUsageFlagBits usage, FrameBufferAttachment* attachment);
 	void CreateDepthOnlyAttachment(VkFormat format, FrameBufferAttachment* attachment);
+	void CreateLayeredDepthAttachment(VkFormat format, uint32_t width, uint32_t height, uint32_t layerCount, FrameBufferAttachment* attachment, bool cubeArray = false);
 	VkFormat FindDepthFormat();
+	//Float color target for lighting, the smallest one that can be rendered to and filtered
+	VkFormat FindHDRFormat();
 	VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
 	VkCommandBuffer CreateTempCmdBuf();
@@ -71,10 +79,10 @@ public:
 	void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 	void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
 
-	void CreateTextureImage(const std::string& file, VkImage& image, VkDeviceMemory& memory);
+	bool IsSampledFormatSupported(VkFormat format);
 	void CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-		VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
-	VkImageView CreateImageView(VkImage& image, VkFormat imageFormat, VkImageAspectFlagBits aspect);
+		VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t mipLevels = 1);
+	VkImageView CreateImageView(VkImage& image, VkFormat imageFormat, VkImageAspectFlagBits aspect, uint32_t mipLevels = 1);
 	VkSampler CreateTextureSampler();
 
 
@@ -92,6 +100,9 @@ private:
 
 public:
 	VulkanDevice* mVulkanDevice;
+	VkPipelineCache mPipelineCache = VK_NULL_HANDLE;//Shared by every pipeline, persisted across runs
+	ShaderRegistry mShaders;
+	PipelineBuildService mPipelineBuilder;
 
 protected:
 	SwapChain* mSwapChain;
@@ -111,6 +122,9 @@ protected:
 	VkQueue mGraphicsQueue;
 	VkQueue mPresentQueue;
 	VkQueue mTransferQueue;
+	VkQueue mComputeQueue;//Async compute
 
 	VkDebugUtilsMessengerEXT debugMessenger;
+
+	VkPhysicalDeviceVulkan12Features mEnabledFeatures12{};//Chained into device creation, must outlive it
 };
\ No newline at end of file
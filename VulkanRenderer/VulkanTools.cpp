@@ -283,22 +283,6 @@ namespace vks
 	}
 }
 
-VkPipelineShaderStageCreateInfo createShaderStageCreateInfo(const std::string& path,
-	VkShaderStageFlagBits stage, VkDevice device)
-{
-	auto shaderCode = readFile(path.c_str());
-
-	VkShaderModule shaderModule = createShaderModule(shaderCode, device);
-
-	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	vertShaderStageInfo.stage = stage;
-	vertShaderStageInfo.module = shaderModule;
-	vertShaderStageInfo.pName = "main";
-
-	return vertShaderStageInfo;
-}
-
 VkShaderModule createShaderModule(const std::vector<char>& code, VkDevice logicalDevice)
 {
 	VkShaderModuleCreateInfo createInfo{};
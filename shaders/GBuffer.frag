@@ -1,22 +1,51 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout (location = 0) in vec3 inNormal;
 layout (location = 1) in vec2 inUV;
 layout (location = 2) in vec3 inWorldPos;
+layout (location = 3) in vec4 inClipPos;
+layout (location = 4) in vec4 inPrevClipPos;
 
 layout (location = 0) out vec4 outPosition;
 layout (location = 1) out vec4 outNormal;
 layout (location = 2) out vec4 outAlbedo;
+layout (location = 3) out vec2 outVelocity;
 
-layout (binding = 5) uniform sampler2D modelDiffuse;
+layout (push_constant) uniform constants
+{
+	uint transformIndex;
+	uint materialIndex;
+} PushConstants;
+
+struct Material
+{
+	vec4 baseColor;
+	int diffuseTexture;
+};
+
+layout (binding = 5) uniform sampler2D textures[];
+
+layout (std430, binding = 12) readonly buffer Materials
+{
+	Material materials[];
+};
 
 void main() 
 {
 	outPosition = vec4(inWorldPos, 1.0);
 
+	// Screen UV offset from last frame, the resolve finds the history at uv - velocity
+	outVelocity = (inClipPos.xy / inClipPos.w - inPrevClipPos.xy / inPrevClipPos.w) * 0.5;
+
 	// Calculate normal in tangent space
 	vec3 N = normalize(inNormal);
 	outNormal = vec4(N, 1.0);
 
-	outAlbedo = texture(modelDiffuse, inUV);
+	Material material = materials[PushConstants.materialIndex];
+	outAlbedo = material.baseColor;
+	if (material.diffuseTexture >= 0)
+	{
+		outAlbedo *= texture(textures[nonuniformEXT(material.diffuseTexture)], inUV);
+	}
 }
\ No newline at end of file
@@ -7,29 +7,51 @@ layout (location = 2) in vec2 inUV;
 layout (location = 0) out vec3 outNormal;
 layout (location = 1) out vec2 outUV;
 layout (location = 2) out vec3 outWorldPos;
+layout (location = 3) out vec4 outClipPos;
+layout (location = 4) out vec4 outPrevClipPos;
 
 
 layout (push_constant) uniform constants
 {
-	mat4 model;
+	uint transformIndex;
+	uint materialIndex;
 } PushConstants;
 
+layout (std430, binding = 13) readonly buffer Transforms
+{
+	mat4 world[];
+} transforms;
+
+// Last frame's world matrices, for motion vectors
+layout (std430, binding = 17) readonly buffer PrevTransforms
+{
+	mat4 world[];
+} prevTransforms;
+
 layout (binding = 0) uniform UBO 
 {
 	mat4 view;
 	mat4 projection;
+	mat4 viewProj;
+	mat4 prevViewProj;
 } Mat;
 
 
 void main() 
 {
-	gl_Position = Mat.projection * Mat.view * PushConstants.model * vec4(inPos, 1.0);
+	mat4 model = transforms.world[PushConstants.transformIndex];
+	gl_Position = Mat.projection * Mat.view * model * vec4(inPos, 1.0);
+
+	// Both without jitter, so a still object has no motion
+	mat4 prevModel = prevTransforms.world[PushConstants.transformIndex];
+	outClipPos = Mat.viewProj * model * vec4(inPos, 1.0);
+	outPrevClipPos = Mat.prevViewProj * prevModel * vec4(inPos, 1.0);
 
 	// Vertex position in world space
-	outWorldPos = vec3(PushConstants.model * vec4(inPos, 1.0));
+	outWorldPos = vec3(model * vec4(inPos, 1.0));
 	
 	// Normal in world space
-	mat3 mNormal = transpose(inverse(mat3(PushConstants.model)));
+	mat3 mNormal = transpose(inverse(mat3(model)));
 	outNormal = mNormal * normalize(inNormal);	
 	
 	// Currently just vertex color
@@ -1,9 +1,39 @@
 #version 450
 
+#define SHADOW_MAP_CASCADE_COUNT 4
+#define POINT_SHADOW_BIAS 0.01
+#define SHADOW_BIAS 0.001
+
+#define SHADOW_FILTER_HARD 0
+#define SHADOW_FILTER_HW_PCF 1
+#define SHADOW_FILTER_POISSON 2
+#define SHADOW_FILTER_PCSS 3
+#define POISSON_TAPS_MAX 32
+
+layout (binding = 0) uniform UBO
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProj;
+	mat4 prevViewProj;
+	mat4 invViewProj;
+} Mat;
+
 layout (binding = 2) uniform sampler2D samplerposition;
 layout (binding = 3) uniform sampler2D samplerNormal;
 layout (binding = 4) uniform sampler2D samplerAlbedo;
-layout (binding = 8) uniform sampler2D shadowDepth;
+layout (binding = 8) uniform sampler2DArray shadowDepth;
+layout (binding = 9) uniform samplerCubeArray pointShadowDepth;
+layout (binding = 11) uniform sampler2DArrayShadow shadowDepthCompare;//Same cascades, compare enabled linear sampler
+layout (binding = 6) uniform samplerCube skybox;
+
+#define LIGHT_TILE_SIZE 16
+
+// Point lights reaching into each screen tile, written by LightBinning.comp on the compute queue
+layout (std430, binding = 14) readonly buffer LightBins
+{
+	uint tileMask[];
+} bins;
 
 layout (location = 0) in vec2 inUV;
 
@@ -11,68 +41,238 @@ layout (location = 0) out vec4 outFragcolor;
 
 struct PointLight {
 	vec3 color;
-    float pad;
+    float radius;
 	vec3 pos;
+    int shadowIndex;
+};
+
+struct DirLight {
+	vec3 color;
+    float pad;
+	vec3 dir;
     float pad2;
 };
 
 layout (binding = 7) uniform LightMatUBO 
 {
-	mat4 lightMVP;
+	mat4 cascadeViewProj[SHADOW_MAP_CASCADE_COUNT];
+	vec4 cascadeSplits;
+	mat4 cameraView;
+	vec4 shadowFilter;//x: mode, y: Poisson taps, z: PCF radius in texels, w: PCSS light size
 } LightMat;
 
-layout (binding = 1) uniform PointLightsUBO {
+layout (binding = 1) uniform LightsUBO {
     PointLight pointlights[3];
+    DirLight dirLight;
     vec3 lookvec;
-} pointLight;
+} lights;
+
+// Ordered so that any prefix of the set is still well spread, the tap count can be cut anywhere
+const vec2 poissonDisk[POISSON_TAPS_MAX] = vec2[](
+    vec2(-0.0507,  0.0055), vec2( 0.9810,  0.1547), vec2(-0.2233, -0.9321), vec2( 0.2813,  0.9128),
+    vec2(-0.7534,  0.6517), vec2(-0.8791, -0.3256), vec2( 0.6766, -0.7084), vec2( 0.4440,  0.2604),
+    vec2(-0.2606,  0.9250), vec2(-0.5960,  0.1710), vec2( 0.1905, -0.4894), vec2(-0.3948, -0.4650),
+    vec2(-0.0122,  0.5137), vec2( 0.6847,  0.6584), vec2( 0.9439, -0.2904), vec2( 0.5249, -0.2723),
+    vec2( 0.1835, -0.8444), vec2(-0.9860,  0.0538), vec2(-0.7274, -0.6512), vec2(-0.4492,  0.4897),
+    vec2(-0.5539, -0.1474), vec2( 0.3313,  0.5571), vec2( 0.7201, -0.0122), vec2( 0.1752, -0.1919),
+    vec2(-0.8955,  0.3531), vec2(-0.2532,  0.2409), vec2(-0.0973, -0.6039), vec2(-0.1964, -0.2692),
+    vec2(-0.4430, -0.7414), vec2( 0.0056,  0.8450), vec2( 0.7249,  0.3494), vec2( 0.2330,  0.1129)
+);
 
-float ShadowCalc(vec4 shadowCoord)
+float InterleavedGradientNoise(vec2 pixel)
 {
-    float shadow = 1.0;
-    vec2 uv = vec2(shadowCoord.x, shadowCoord.y);
-    float currentDepth = shadowCoord.z;
-	if ( currentDepth > -1.0 && currentDepth < 1.0 ) 
-	{
-		float closestDepth = texture( shadowDepth, uv).r;
-		if ( shadowCoord.w > 0.0 && closestDepth < (currentDepth-0.005) ) 
-		{
-			shadow = 0.0;
-		}
-	}
-	return shadow;
+    return fract(52.9829189 * fract(dot(pixel, vec2(0.06711056, 0.00583715))));
+}
+
+// Per pixel rotation of the disk trades banding for noise
+mat2 PoissonRotation()
+{
+    float angle = 6.2831853 * InterleavedGradientNoise(gl_FragCoord.xy);
+    float s = sin(angle);
+    float c = cos(angle);
+    return mat2(c, s, -s, c);
+}
+
+float HardShadow(vec3 coord, uint cascadeIndex)
+{
+    float closestDepth = texture(shadowDepth, vec3(coord.xy, cascadeIndex)).r;
+    return (closestDepth < coord.z - SHADOW_BIAS) ? 0.0 : 1.0;
+}
+
+float HardwarePCF(vec3 coord, uint cascadeIndex, float radiusTexels)
+{
+    // Every compare tap is already a bilinear 2x2 PCF, a 3x3 grid of them spreads it over the radius
+    vec2 texel = radiusTexels / vec2(textureSize(shadowDepth, 0).xy);
+    float sum = 0.0;
+    for(int x = -1; x <= 1; ++x)
+    {
+        for(int y = -1; y <= 1; ++y)
+        {
+            sum += texture(shadowDepthCompare, vec4(coord.xy + vec2(x, y) * texel, cascadeIndex, coord.z - SHADOW_BIAS));
+        }
+    }
+    return sum / 9.0;
+}
+
+float PoissonPCF(vec3 coord, uint cascadeIndex, float radiusUV, int taps)
+{
+    mat2 rotation = PoissonRotation();
+    float sum = 0.0;
+    for(int i = 0; i < taps; ++i)
+    {
+        vec2 offset = rotation * poissonDisk[i] * radiusUV;
+        sum += texture(shadowDepthCompare, vec4(coord.xy + offset, cascadeIndex, coord.z - SHADOW_BIAS));
+    }
+    return sum / float(taps);
+}
+
+float PCSS(vec3 coord, uint cascadeIndex, float lightSize, int taps)
+{
+    // Blocker search. The cascades are orthographic with depth range equal to their width,
+    // so light size works directly as the uv spread per unit of depth in every cascade
+    mat2 rotation = PoissonRotation();
+    float searchRadius = lightSize * coord.z;
+    float blockerSum = 0.0;
+    int blockerCount = 0;
+    for(int i = 0; i < taps; ++i)
+    {
+        vec2 offset = rotation * poissonDisk[i] * searchRadius;
+        float depth = texture(shadowDepth, vec3(coord.xy + offset, cascadeIndex)).r;
+        if(depth < coord.z - SHADOW_BIAS)
+        {
+            blockerSum += depth;
+            ++blockerCount;
+        }
+    }
+
+    if(blockerCount == 0)
+    {
+        return 1.0;
+    }
+
+    // Penumbra grows with the receiver to blocker distance, which gives the contact hardening
+    float avgBlockerDepth = blockerSum / float(blockerCount);
+    float penumbra = (coord.z - avgBlockerDepth) * lightSize;
+    float texel = 1.0 / float(textureSize(shadowDepth, 0).x);
+    return PoissonPCF(coord, cascadeIndex, max(penumbra, texel), taps);
+}
+
+float ShadowCalc(vec4 shadowCoord, uint cascadeIndex)
+{
+    if(shadowCoord.w <= 0.0 || shadowCoord.z <= -1.0 || shadowCoord.z >= 1.0)
+    {
+        return 1.0;
+    }
+
+    int mode = int(LightMat.shadowFilter.x);
+    int taps = clamp(int(LightMat.shadowFilter.y), 1, POISSON_TAPS_MAX);
+    vec3 coord = shadowCoord.xyz;
+    if(mode == SHADOW_FILTER_HW_PCF)
+    {
+        return HardwarePCF(coord, cascadeIndex, LightMat.shadowFilter.z);
+    }
+    else if(mode == SHADOW_FILTER_POISSON)
+    {
+        float radiusUV = LightMat.shadowFilter.z / float(textureSize(shadowDepth, 0).x);
+        return PoissonPCF(coord, cascadeIndex, radiusUV, taps);
+    }
+    else if(mode == SHADOW_FILTER_PCSS)
+    {
+        return PCSS(coord, cascadeIndex, LightMat.shadowFilter.w, taps);
+    }
+    return HardShadow(coord, cascadeIndex);
+}
+
+// Smooth window that reaches zero at the light's radius, so nothing is lost outside of its bins
+float PointAttenuation(PointLight light, float dist)
+{
+    float ratio = dist / light.radius;
+    float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+    return window * window;
+}
+
+float PointShadowCalc(PointLight light, vec3 fragPos)
+{
+    // Lights that didn't get an atlas slot and fragments out of range are unshadowed
+    vec3 lightToFrag = fragPos - light.pos;
+    float currentDist = length(lightToFrag) / light.radius;
+    if(light.shadowIndex < 0 || currentDist >= 1.0)
+    {
+        return 1.0;
+    }
+
+    float closestDist = texture(pointShadowDepth, vec4(lightToFrag, light.shadowIndex)).r;
+    return (closestDist < currentDist - POINT_SHADOW_BIAS) ? 0.0 : 1.0;
+}
+
+// View direction through the pixel, from its points on the near and far planes
+vec3 SkyDirection(vec2 uv)
+{
+    vec4 nearPoint = Mat.invViewProj * vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+    vec4 farPoint = Mat.invViewProj * vec4(uv * 2.0 - 1.0, 1.0, 1.0);
+    return farPoint.xyz / farPoint.w - nearPoint.xyz / nearPoint.w;
 }
 
 void main() 
 {
-	// Get G-Buffer values
-	vec3 fragPos = texture(samplerposition, inUV).rgb;//Each pixel of sample position contain world position
-	vec3 normal = texture(samplerNormal, inUV).rgb;
-	vec4 albedo = texture(samplerAlbedo, inUV);
+	// Get G-Buffer values. Fetched by pixel, the scene only covers the corner of the G-buffer it was rendered to
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec4 position = texelFetch(samplerposition, pixel, 0);
+	// Nothing was drawn here, so the sky shows through and none of the lighting is needed
+	if (position.w == 0.0)
+	{
+		outFragcolor = vec4(texture(skybox, SkyDirection(inUV)).rgb, 1.0);
+		return;
+	}
+	vec3 fragPos = position.rgb;//Each pixel of sample position contain world position
+	vec3 normal = texelFetch(samplerNormal, pixel, 0).rgb;
+	vec4 albedo = texelFetch(samplerAlbedo, pixel, 0);
 	vec3 norm_n = normalize(normal);
 
-    // Shadow values
-    vec4 lightSpaceFragPos = LightMat.lightMVP * vec4(fragPos, 1.0);
-    lightSpaceFragPos.xyz /= lightSpaceFragPos.w;
-    lightSpaceFragPos.xy = lightSpaceFragPos.xy * 0.5 + 0.5;
+    // Pick the cascade from the view space depth of the fragment
+    vec3 viewPos = (LightMat.cameraView * vec4(fragPos, 1.0)).xyz;
+    uint cascadeIndex = 0;
+    for(uint i = 0; i < SHADOW_MAP_CASCADE_COUNT - 1; ++i)
+    {
+        if(viewPos.z < LightMat.cascadeSplits[i])
+        {
+            cascadeIndex = i + 1;
+        }
+    }
 
-    float shadow = ShadowCalc(lightSpaceFragPos);
+    // Shadow values, nothing past the last cascade is shadowed
+    float shadow = 1.0;
+    if(viewPos.z >= LightMat.cascadeSplits[SHADOW_MAP_CASCADE_COUNT - 1])
+    {
+        vec4 lightSpaceFragPos = LightMat.cascadeViewProj[cascadeIndex] * vec4(fragPos, 1.0);
+        lightSpaceFragPos.xyz /= lightSpaceFragPos.w;
+        lightSpaceFragPos.xy = lightSpaceFragPos.xy * 0.5 + 0.5;
+        shadow = ShadowCalc(lightSpaceFragPos, cascadeIndex);
+    }
 
     //Light calculation
     vec3 result = vec3(0, 0, 0);
-    
-    //Currently, Shadowing working on only first light
-    vec3 norm_l = normalize(pointLight.pointlights[0].pos - fragPos);
-    float diff = max(dot(norm_l, norm_n), 0.2f);
-    vec3 diffuse = diff * pointLight.pointlights[0].color;
-    result += (diffuse) * (shadow);
-
-    for(int i = 1; i < 3; ++i)
+
+    vec3 dir_l = normalize(-lights.dirLight.dir);
+    float dirDiff = max(dot(dir_l, norm_n), 0.0f);
+    result += dirDiff * lights.dirLight.color * shadow;
+
+    uvec2 tile = uvec2(gl_FragCoord.xy) / LIGHT_TILE_SIZE;
+    uint tilesX = (uint(textureSize(samplerposition, 0).x) + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+    uint mask = bins.tileMask[tile.y * tilesX + tile.x];
+    for(int i = 0; i < 3; ++i)
     {
-        vec3 norm_l = normalize(pointLight.pointlights[i].pos - fragPos);
+        if((mask & (1u << i)) == 0)
+        {
+            continue;
+        }
+
+        vec3 toLight = lights.pointlights[i].pos - fragPos;
+        vec3 norm_l = normalize(toLight);
         float diff = max(dot(norm_l, norm_n), 0.2f);
-        vec3 diffuse = diff * pointLight.pointlights[i].color;
+        vec3 diffuse = diff * lights.pointlights[i].color * PointAttenuation(lights.pointlights[i], length(toLight));
 
-        result += (diffuse);
+        result += diffuse * PointShadowCalc(lights.pointlights[i], fragPos);
     }
 
     outFragcolor = vec4(result, 1.0f);
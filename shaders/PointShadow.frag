@@ -0,0 +1,24 @@
+#version 450
+
+#define POINT_SHADOW_SLOTS 4
+
+layout (push_constant) uniform constants
+{
+	uint transformIndex;
+	uint shadowSlot;
+} PushConstants;
+
+layout (binding = 10) uniform PointShadowUBO 
+{
+	mat4 faceViewProj[POINT_SHADOW_SLOTS * 6];
+	vec4 lightPosRadius[POINT_SHADOW_SLOTS];
+} PointShadow;
+
+layout (location = 0) in vec3 inWorldPos;
+
+void main()
+{
+    // Store linear distance to the light so lighting can compare it against any direction of the cube
+    vec4 light = PointShadow.lightPosRadius[PushConstants.shadowSlot];
+    gl_FragDepth = length(inWorldPos - light.xyz) / light.w;
+}
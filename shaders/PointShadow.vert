@@ -0,0 +1,21 @@
+#version 450
+layout (location = 0) in vec3 inPos;
+layout (location = 1) in vec3 inNormal;
+layout (location = 2) in vec2 inUV;
+
+layout (push_constant) uniform constants
+{
+	uint transformIndex;
+	uint shadowSlot;
+} PushConstants;
+
+layout (std430, binding = 13) readonly buffer Transforms
+{
+	mat4 world[];
+} transforms;
+
+void main()
+{
+    // World space, the geometry shader projects it once per cube face
+    gl_Position = transforms.world[PushConstants.transformIndex] * vec4(inPos, 1.0);
+}
@@ -3,17 +3,28 @@ layout (location = 0) in vec3 inPos;
 layout (location = 1) in vec3 inNormal;
 layout (location = 2) in vec2 inUV;
 
+#define SHADOW_MAP_CASCADE_COUNT 4
+
 layout (push_constant) uniform constants
 {
-	mat4 model;
+	uint transformIndex;
+	uint cascadeIndex;
 } PushConstants;
 
+layout (std430, binding = 13) readonly buffer Transforms
+{
+	mat4 world[];
+} transforms;
+
 layout (binding = 7) uniform LightMatUBO 
 {
-	mat4 lightMVP;
+	mat4 cascadeViewProj[SHADOW_MAP_CASCADE_COUNT];
+	vec4 cascadeSplits;
+	mat4 cameraView;
+	vec4 shadowFilter;
 } LightMat;
 
 void main()
 {
-    gl_Position = LightMat.lightMVP * PushConstants.model * vec4(inPos, 1.0);
+    gl_Position = LightMat.cascadeViewProj[PushConstants.cascadeIndex] * transforms.world[PushConstants.transformIndex] * vec4(inPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+#version 450
+
+layout (binding = 15) uniform sampler2D samplerComposition;
+layout (binding = 21) uniform sampler2D samplerBloom;
+
+layout (std430, binding = 16) readonly buffer ExposureData
+{
+	uint histogram[256];
+	float exposure;
+	float averageLuminance;
+} data;
+
+// The frame covers a corner of the image at dynamic resolution, the bilinear fetch upscales it to the swapchain
+layout (push_constant) uniform constants
+{
+	vec2 uvScale;// Render size over image size
+	vec2 uvMax;// Half a texel inside the rendered corner
+	vec2 bloomScale;// Same for the first mip of the bloom chain
+	vec2 bloomMax;
+	float sharpness;// 0 leaves the upscaled image as it is
+	float bloomIntensity;
+} PushConstants;
+
+layout (location = 0) in vec2 inUV;
+
+layout (location = 0) out vec4 outFragcolor;
+
+// Narkowicz's fit of the ACES filmic curve
+vec3 ACESFilm(vec3 x)
+{
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+
+vec3 Tonemapped(vec2 uv)
+{
+    vec3 color = textureLod(samplerComposition, min(uv, PushConstants.uvMax), 0.0).rgb;
+    if (PushConstants.bloomIntensity > 0.0)
+    {
+        color += textureLod(samplerBloom, min(uv * PushConstants.bloomScale, PushConstants.bloomMax), 0.0).rgb * PushConstants.bloomIntensity;
+    }
+    return ACESFilm(color * data.exposure);
+}
+
+void main()
+{
+    // The swapchain is sRGB, encoding happens on write
+    vec2 uv = inUV * PushConstants.uvScale;
+    vec3 color = Tonemapped(uv);
+    if (PushConstants.sharpness > 0.0)
+    {
+        // Contrast adaptive sharpening on the tonemapped cross, flat areas get the most and edges near the limits the least
+        vec2 texel = 1.0 / vec2(textureSize(samplerComposition, 0));
+        vec3 north = Tonemapped(uv - vec2(0.0, texel.y));
+        vec3 south = Tonemapped(uv + vec2(0.0, texel.y));
+        vec3 west = Tonemapped(uv - vec2(texel.x, 0.0));
+        vec3 east = Tonemapped(uv + vec2(texel.x, 0.0));
+        vec3 minimum = min(color, min(min(north, south), min(west, east)));
+        vec3 maximum = max(color, max(max(north, south), max(west, east)));
+        vec3 amount = sqrt(clamp(min(minimum, 1.0 - maximum) / max(maximum, 0.0001), 0.0, 1.0));
+        vec3 weight = -amount * mix(0.125, 0.2, PushConstants.sharpness);
+        color = clamp((color + (north + south + west + east) * weight) / (1.0 + 4.0 * weight), 0.0, 1.0);
+    }
+    outFragcolor = vec4(color, 1.0);
+}
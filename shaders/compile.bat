@@ -7,12 +7,27 @@ C:/VulkanSDK/1.3.211.0/Bin/glslc.exe Lighting.frag -o LightingFrag.spv
 C:/VulkanSDK/1.3.211.0/Bin/glslc.exe Base.vert -o BaseVert.spv
 C:/VulkanSDK/1.3.211.0/Bin/glslc.exe Base.frag -o BaseFrag.spv
 
-C:/VulkanSDK/1.3.211.0/Bin/glslc.exe NormalDebug.geom -o NormalDebug.spv
-
-C:/VulkanSDK/1.3.211.0/Bin/glslc.exe Skybox.vert -o SkyboxVert.spv
-C:/VulkanSDK/1.3.211.0/Bin/glslc.exe Skybox.frag -o SkyboxFrag.spv
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe NormalDebug.geom -o NormalDebugGeom.spv
 
 C:/VulkanSDK/1.3.211.0/Bin/glslc.exe Shadow.vert -o ShadowVert.spv
 C:/VulkanSDK/1.3.211.0/Bin/glslc.exe Shadow.frag -o ShadowFrag.spv
 
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe PointShadow.vert -o PointShadowVert.spv
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe PointShadow.geom -o PointShadowGeom.spv
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe PointShadow.frag -o PointShadowFrag.spv
+
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe LightBinning.comp -o LightBinningComp.spv
+
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe --target-env=vulkan1.2 Histogram.comp -o HistogramComp.spv
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe --target-env=vulkan1.2 Exposure.comp -o ExposureComp.spv
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe Tonemap.frag -o TonemapFrag.spv
+
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe TAA.comp -o TAAComp.spv
+
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe BloomDownsample.comp -o BloomDownsampleComp.spv
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe BloomUpsample.comp -o BloomUpsampleComp.spv
+
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe ClusterCull.comp -o ClusterCullComp.spv
+C:/VulkanSDK/1.3.211.0/Bin/glslc.exe DepthPyramid.comp -o DepthPyramidComp.spv
+
 pause
\ No newline at end of file